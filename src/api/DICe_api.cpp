@@ -44,6 +44,9 @@
 #include <DICe_Parser.h>
 #include <DICe_ParameterUtilities.h>
 
+#include <algorithm>
+#include <iostream>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -281,6 +284,180 @@ DICE_LIB_DLL_EXPORT const int_t dice_correlate_conformal(scalar_t points[],
   return 0;
 }
 
+/// state that persists between calls for a correlation context
+struct dice_context_data{
+  /// the schema that holds the subsets, the field values and the images
+  Teuchos::RCP<DICe::Schema> schema;
+  /// the correlation parameters
+  Teuchos::RCP<Teuchos::ParameterList> params;
+  /// copy of the reference intensities owned by the context
+  Teuchos::ArrayRCP<intensity_t> ref_intensities;
+  /// copy of the last deformed image of the previous call (used as the previous image by the initializers)
+  Teuchos::ArrayRCP<intensity_t> prev_intensities;
+  /// number of points
+  int_t n_points;
+  /// image width
+  int_t width;
+  /// image height
+  int_t height;
+};
+
+DICE_LIB_DLL_EXPORT dice_context dice_create_context(const scalar_t points[], int_t n_points,
+                        int_t subset_size,
+                        const intensity_t ref_img[], int_t ref_w, int_t ref_h,
+                        Teuchos::ParameterList * input_params){
+  DEBUG_MSG("dice_create_context() called with the following values:");
+  DEBUG_MSG("n_points               " << n_points);
+  DEBUG_MSG("subset_size            " << subset_size);
+  DEBUG_MSG("ref_w                  " << ref_w);
+  DEBUG_MSG("ref_h                  " << ref_h);
+  if(points==0||ref_img==0) return 0;
+  if(subset_size < 1 || n_points < 1 || ref_w < 1 || ref_h < 1) return 0;
+  dice_context context = new dice_context_data();
+  try{
+    context->n_points = n_points;
+    context->width = ref_w;
+    context->height = ref_h;
+    context->params = rcp(new Teuchos::ParameterList());
+    if(input_params!=0){
+      DEBUG_MSG("Using user specified input parameters in dice_create_context()");
+      context->params->setParameters(*input_params);
+    }
+    else{
+      DEBUG_MSG("Using default parameters in dice_create_context()");
+      DICe::tracking_default_params(context->params.getRawPtr());
+    }
+    Teuchos::ArrayRCP<scalar_t> coords_x(n_points,0.0);
+    Teuchos::ArrayRCP<scalar_t> coords_y(n_points,0.0);
+    for(int_t i=0;i<n_points;++i){
+      coords_x[i] = points[i*DICE_API_STRIDE + 0];
+      coords_y[i] = points[i*DICE_API_STRIDE + 1];
+    }
+    context->schema = Teuchos::rcp(new DICe::Schema(coords_x,coords_y,subset_size,Teuchos::null,Teuchos::null,context->params));
+    TEUCHOS_TEST_FOR_EXCEPTION(context->schema->shape_function_type()!=DICe::AFFINE_SF,std::runtime_error,
+      "Error, can only use AFFINE shape function for the api routines");
+    context->ref_intensities = Teuchos::ArrayRCP<intensity_t>(ref_w*ref_h,0.0);
+    std::copy(ref_img,ref_img+ref_w*ref_h,context->ref_intensities.getRawPtr());
+    context->schema->set_ref_image(ref_w,ref_h,context->ref_intensities);
+    // the initial guess for the first frame
+    for(int_t i=0;i<n_points;++i){
+      context->schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS) = points[i*DICE_API_STRIDE + 2];
+      context->schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS) = points[i*DICE_API_STRIDE + 3];
+      context->schema->local_field_value(i,DICe::field_enums::ROTATION_Z_FS)     = points[i*DICE_API_STRIDE + 4];
+      context->schema->local_field_value(i,DICe::field_enums::SIGMA_FS)          = points[i*DICE_API_STRIDE + 5];
+      context->schema->local_field_value(i,DICe::field_enums::GAMMA_FS)          = points[i*DICE_API_STRIDE + 6];
+      context->schema->local_field_value(i,DICe::field_enums::BETA_FS)           = points[i*DICE_API_STRIDE + 7];
+      context->schema->local_field_value(i,DICe::field_enums::STATUS_FLAG_FS)    = points[i*DICE_API_STRIDE + 8];
+    }
+  }
+  catch(std::exception & e){
+    std::cerr << "Error, dice_create_context() failed: " << e.what() << std::endl;
+    delete context;
+    return 0;
+  }
+  return context;
+}
+
+DICE_LIB_DLL_EXPORT const int_t dice_set_context_reference(dice_context context,
+                        const intensity_t ref_img[], int_t ref_w, int_t ref_h){
+  if(context==0||ref_img==0) return -1;
+  if(ref_w!=context->width||ref_h!=context->height) return -1;
+  try{
+    // a new array is allocated since the previous reference image may still be shared by the schema's previous image
+    context->ref_intensities = Teuchos::ArrayRCP<intensity_t>(ref_w*ref_h,0.0);
+    std::copy(ref_img,ref_img+ref_w*ref_h,context->ref_intensities.getRawPtr());
+    context->schema->set_ref_image(ref_w,ref_h,context->ref_intensities);
+    // the objectives hold the reference subsets, so they have to be rebuilt from the new reference image
+    context->schema->obj_vec()->clear();
+  }
+  catch(std::exception & e){
+    std::cerr << "Error, dice_set_context_reference() failed: " << e.what() << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+/// keep an owned copy of the last correlated frame as the schema's previous image and swap out the deformed
+/// image that wraps the caller's buffer, the caller's buffers are only valid for the duration of the call
+/// (last_frame is 0 if no frame of the call was correlated, the previous image of the last call is kept)
+static void
+release_caller_frames(dice_context context,
+  const intensity_t * last_frame){
+  const int_t img_size = context->width*context->height;
+  if(last_frame!=0){
+    if(context->prev_intensities.size()!=img_size)
+      context->prev_intensities = Teuchos::ArrayRCP<intensity_t>(img_size,0.0);
+    std::copy(last_frame,last_frame+img_size,context->prev_intensities.getRawPtr());
+  }
+  if(context->prev_intensities.size()==img_size){
+    context->schema->set_prev_image(Teuchos::rcp(new DICe::Image(context->width,context->height,context->prev_intensities)));
+    context->schema->set_def_image(context->width,context->height,context->prev_intensities);
+  }
+  else{
+    // nothing has been correlated yet with this context, the reference image is the previous image
+    context->schema->set_prev_image(context->schema->ref_img());
+    context->schema->set_def_image(context->width,context->height,context->ref_intensities);
+  }
+}
+
+DICE_LIB_DLL_EXPORT const int_t dice_correlate_frames(dice_context context,
+                        intensity_t * const def_imgs[], int_t n_frames,
+                        int_t def_w, int_t def_h,
+                        scalar_t results[]){
+  DEBUG_MSG("dice_correlate_frames() called with the following values:");
+  DEBUG_MSG("n_frames               " << n_frames);
+  DEBUG_MSG("def_w                  " << def_w);
+  DEBUG_MSG("def_h                  " << def_h);
+  if(context==0||def_imgs==0||results==0) return -1;
+  if(n_frames < 1) return -1;
+  if(def_w!=context->width||def_h!=context->height) return -1;
+  // check all of the frames before the schema is touched
+  for(int_t frame=0;frame<n_frames;++frame)
+    if(def_imgs[frame]==0) return -1;
+  const int_t n_points = context->n_points;
+  const int_t img_size = def_w*def_h;
+  int_t num_failed_frames = 0;
+  const intensity_t * last_frame = 0;
+  try{
+    for(int_t frame=0;frame<n_frames;++frame){
+      // wrap the caller's buffer without copying it
+      Teuchos::ArrayRCP<intensity_t> defRCP(def_imgs[frame],0,img_size,false);
+      context->schema->set_def_image(def_w,def_h,defRCP);
+      if(context->schema->execute_correlation())
+        num_failed_frames++;
+      last_frame = def_imgs[frame];
+      scalar_t * frame_results = results + (size_t)frame*n_points*DICE_API_STRIDE;
+      for(int_t i=0;i<n_points;++i){
+        frame_results[i*DICE_API_STRIDE + 0] = context->schema->local_field_value(i,DICe::field_enums::SUBSET_COORDINATES_X_FS);
+        frame_results[i*DICE_API_STRIDE + 1] = context->schema->local_field_value(i,DICe::field_enums::SUBSET_COORDINATES_Y_FS);
+        frame_results[i*DICE_API_STRIDE + 2] = context->schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+        frame_results[i*DICE_API_STRIDE + 3] = context->schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+        frame_results[i*DICE_API_STRIDE + 4] = context->schema->local_field_value(i,DICe::field_enums::ROTATION_Z_FS);
+        frame_results[i*DICE_API_STRIDE + 5] = context->schema->local_field_value(i,DICe::field_enums::SIGMA_FS);
+        frame_results[i*DICE_API_STRIDE + 6] = context->schema->local_field_value(i,DICe::field_enums::GAMMA_FS);
+        frame_results[i*DICE_API_STRIDE + 7] = context->schema->local_field_value(i,DICe::field_enums::BETA_FS);
+        frame_results[i*DICE_API_STRIDE + 8] = context->schema->local_field_value(i,DICe::field_enums::STATUS_FLAG_FS);
+      }
+    }
+    release_caller_frames(context,last_frame);
+  }
+  catch(std::exception & e){
+    std::cerr << "Error, dice_correlate_frames() failed: " << e.what() << std::endl;
+    try{
+      release_caller_frames(context,last_frame);
+    }
+    catch(std::exception & release_error){
+      std::cerr << "Error, dice_correlate_frames() could not release the deformed images: " << release_error.what() << std::endl;
+    }
+    return -1;
+  }
+  return num_failed_frames;
+}
+
+DICE_LIB_DLL_EXPORT void dice_destroy_context(dice_context context){
+  delete context;
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -174,6 +174,76 @@ DICE_LIB_DLL_EXPORT const int_t dice_correlate_conformal(scalar_t points[],
                         const char* subset_file, const char* param_file=0,
                         const bool write_output=false);
 
+/// Opaque correlation context that holds the schema, the reference image (and its gradients)
+/// and the reference subsets between calls to dice_correlate_frames()
+typedef struct dice_context_data * dice_context;
+
+/// \brief Create a correlation context for a set of points and a reference image
+///
+/// The context replaces the static schema used by dice_correlate() so that several point sets
+/// (or several cameras) can be correlated independently. The reference intensities are copied
+/// into the context so the caller's ref_img buffer can be reused as soon as this function returns.
+///
+/// \param points:       An array of (n_points * DICE_API_STRIDE) type Real values (same layout as dice_correlate())
+///                      used for the subset coordinates and the initial guess for the first frame
+/// \param n_points:     The number of points.
+/// \param subset_size:  The subset size to use for correlation.
+/// \param ref_img:      The reference image as (ref_w) * (ref_h) type Real values.
+/// \param ref_w:        The width of the reference image.
+/// \param ref_h:        The height of the reference image.
+/// \param input_params  Optional ParameterList to change the default correlation parameters (the tracking defaults are used otherwise)
+///
+/// Return values:
+/// The function returns the new context on success, otherwise a null pointer
+DICE_LIB_DLL_EXPORT dice_context dice_create_context(const scalar_t points[], int_t n_points,
+                        int_t subset_size,
+                        const intensity_t ref_img[], int_t ref_w, int_t ref_h,
+                        Teuchos::ParameterList * input_params=0);
+
+/// \brief Replace the reference image of a context (the subsets and the current solution are kept)
+///
+/// \param context:      The context to modify
+/// \param ref_img:      The reference image as (ref_w) * (ref_h) type Real values (copied into the context).
+/// \param ref_w:        The width of the reference image, must match the width used to create the context.
+/// \param ref_h:        The height of the reference image, must match the height used to create the context.
+///
+/// Return values:
+/// The function returns 0 on success, otherwise an error code is
+/// returned.
+DICE_LIB_DLL_EXPORT const int_t dice_set_context_reference(dice_context context,
+                        const intensity_t ref_img[], int_t ref_w, int_t ref_h);
+
+/// \brief Correlate a batch of deformed images in one call
+///
+/// The deformed images are used in place (they are not copied) and only need to remain valid
+/// for the duration of this call. The frames are correlated in order and the solution of each
+/// frame is used as the initial guess for the next one (and for the first frame of the next call).
+///
+/// \param context:      The context created by dice_create_context()
+/// \param def_imgs:     An array of n_frames pointers, each to a deformed image of (def_w) * (def_h) type Real values.
+/// \param n_frames:     The number of deformed images.
+/// \param def_w:        The width of the deformed images (must match the reference image).
+/// \param def_h:        The height of the deformed images (must match the reference image).
+/// \param results:      An array of (n_frames * n_points * DICE_API_STRIDE) type Real values that is filled
+///                      with the solution of every frame. The values for point i of frame f start at
+///                      results[(f*n_points + i)*DICE_API_STRIDE] and have the same layout as the points
+///                      array of dice_correlate().
+///
+/// Return values:
+/// The function returns 0 on success, -1 for invalid arguments, or the number of frames
+/// that had a failed correlation step (the results of all frames are still filled in).
+/// If any of the def_imgs pointers is null nothing is correlated. If an error occurs part way
+/// through the batch -1 is returned, the results of the frames correlated before the error are
+/// filled in and the context continues from the last of those frames on the next call.
+DICE_LIB_DLL_EXPORT const int_t dice_correlate_frames(dice_context context,
+                        intensity_t * const def_imgs[], int_t n_frames,
+                        int_t def_w, int_t def_h,
+                        scalar_t results[]);
+
+/// \brief Destroy a correlation context and release its memory
+/// \param context:      The context to destroy (may be null)
+DICE_LIB_DLL_EXPORT void dice_destroy_context(dice_context context);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -160,6 +160,18 @@ const char* const gradient_method = "gradient_method";
 /// String parameter name
 const char* const compute_laplacian_image = "compute_laplacian_image";
 /// String parameter name
+const char* const compact_image_storage = "compact_image_storage";
+/// String parameter name
+const char* const use_huge_pages = "use_huge_pages";
+/// String parameter name
+const char* const buffer_pool_megabytes = "buffer_pool_megabytes";
+/// String parameter name
+const char* const tiled_image_layout = "tiled_image_layout";
+/// String parameter name
+const char* const subset_execution_order = "subset_execution_order";
+/// String parameter name
+const char* const decomposition_method = "decomposition_method";
+/// String parameter name
 const char* const initialization_method = "initialization_method";
 /// String parameter name
 const char* const optimization_method = "optimization_method";
@@ -358,6 +370,18 @@ const char* const write_exodus_output = "write_exodus_output";
 /// String parameter name
 const char* const threshold_block_size = "threshold_block_size";
 /// String parameter name
+const char* const num_threads = "num_threads";
+/// String parameter name
+const char* const write_binary_output = "write_binary_output";
+/// String parameter name
+const char* const compress_binary_output = "compress_binary_output";
+/// String parameter name
+const char* const rebalance_interval = "rebalance_interval";
+/// String parameter name
+const char* const frame_parallel = "frame_parallel";
+/// String parameter name
+const char* const share_images_on_node = "share_images_on_node";
+/// String parameter name
 const char* const subimage_width = "subimage_width";
 /// String parameter name
 const char* const subimage_height = "subimage_height";
@@ -460,6 +484,8 @@ enum Initialization_Method {
   USE_FEATURE_MATCHING,
   USE_IMAGE_REGISTRATION,
   USE_SATELLITE_GEOMETRY,
+  USE_IMAGE_PYRAMID,
+  USE_FFT_CROSS_CORRELATION,
   INITIALIZATION_METHOD_NOT_APPLICABLE,
   // DON'T ADD ANY BELOW MAX
   MAX_INITIALIZATION_METHOD,
@@ -476,6 +502,8 @@ const static char * initializationMethodStrings[] = {
   "USE_FEATURE_MATCHING",
   "USE_IMAGE_REGISTRATION",
   "USE_SATELLITE_GEOMETRY",
+  "USE_IMAGE_PYRAMID",
+  "USE_FFT_CROSS_CORRELATION",
   "INITIALIZATION_METHOD_NOT_APPLICABLE"
 };
 
@@ -504,6 +532,7 @@ enum Optimization_Method {
   GRADIENT_THEN_SEARCH,
   SIMPLEX_THEN_GRADIENT_BASED,
   GRADIENT_BASED_THEN_SIMPLEX,
+  INVERSE_COMPOSITIONAL,
   OPTIMIZATION_METHOD_NOT_APPLICABLE,
   // DON'T ADD ANY BELOW MAX
   MAX_OPTIMIZATION_METHOD,
@@ -516,6 +545,7 @@ const static char * optimizationMethodStrings[] = {
   "GRADIENT_THEN_SEARCH",
   "SIMPLEX_THEN_GRADIENT_BASED",
   "GRADIENT_BASED_THEN_SIMPLEX",
+  "INVERSE_COMPOSITIONAL",
   "OPTIMIZATION_METHOD_NOT_APPLICABLE"
 };
 
@@ -524,6 +554,7 @@ enum Interpolation_Method {
   BILINEAR=0,
   BICUBIC,
   KEYS_FOURTH,
+  BSPLINE_CUBIC,
   // DON'T ADD ANY BELOW MAX
   MAX_INTERPOLATION_METHOD,
   NO_SUCH_INTERPOLATION_METHOD
@@ -532,7 +563,8 @@ enum Interpolation_Method {
 const static char * interpolationMethodStrings[] = {
   "BILINEAR",
   "BICUBIC",
-  "KEYS_FOURTH"
+  "KEYS_FOURTH",
+  "BSPLINE_CUBIC"
 };
 
 /// Gradient method
@@ -549,6 +581,36 @@ const static char * gradientMethodStrings[] = {
   "CONVOLUTION_5_POINT"
 };
 
+/// Order in which each processor executes its subsets
+enum Subset_Execution_Order {
+  INPUT_ORDER=0,
+  MORTON_ORDER,
+  HILBERT_ORDER,
+  // DON'T ADD ANY BELOW MAX
+  MAX_SUBSET_EXECUTION_ORDER,
+  NO_SUCH_SUBSET_EXECUTION_ORDER
+};
+
+const static char * subsetExecutionOrderStrings[] = {
+  "INPUT_ORDER",
+  "MORTON_ORDER",
+  "HILBERT_ORDER"
+};
+
+/// How the subsets are split across processors
+enum Decomposition_Method {
+  EVEN_SPLIT_DECOMPOSITION=0,
+  HILBERT_CURVE_DECOMPOSITION,
+  // DON'T ADD ANY BELOW MAX
+  MAX_DECOMPOSITION_METHOD,
+  NO_SUCH_DECOMPOSITION_METHOD
+};
+
+const static char * decompositionMethodStrings[] = {
+  "EVEN_SPLIT_DECOMPOSITION",
+  "HILBERT_CURVE_DECOMPOSITION"
+};
+
 
 /// Correlation routine (determines how the correlation steps are executed).
 /// Can be customized for a particular application
@@ -556,6 +618,7 @@ enum Correlation_Routine {
   GENERIC_ROUTINE=0,
   TRACKING_ROUTINE,
   CORRELATION_ROUTINE_NOT_APPLICABLE,
+  RELIABILITY_GUIDED_ROUTINE,
   // DON'T ADD ANY BELOW MAX
   MAX_CORRELATION_ROUTINE,
   NO_SUCH_CORRELATION_ROUTINE
@@ -564,7 +627,8 @@ enum Correlation_Routine {
 const static char * correlationRoutineStrings[] = {
   "GENERIC_ROUTINE",
   "TRACKING_ROUTINE",
-  "CORRELATION_ROUTINE_NOT_APPLICABLE"
+  "CORRELATION_ROUTINE_NOT_APPLICABLE",
+  "RELIABILITY_GUIDED_ROUTINE"
 };
 
 
@@ -855,6 +919,41 @@ const Correlation_Parameter threshold_block_size_param(threshold_block_size,
   SIZE_PARAM,
   true,
   "The block size to use for the feature matching initializer when thresholding is enabled.");
+/// Correlation parameter and properties
+const Correlation_Parameter num_threads_param(num_threads,
+  SIZE_PARAM,
+  true,
+  "The number of threads to use to correlate subsets concurrently on each process (GENERIC_ROUTINE and RELIABILITY_GUIDED_ROUTINE only, requires OpenMP). "
+  "The image filter and gradient kernels use the same number of threads. A value of 0 divides the cores of each compute node evenly "
+  "between the processes on the node (for running a few processes per node, each with a pool of threads).");
+/// Correlation parameter and properties
+const Correlation_Parameter write_binary_output_param(write_binary_output,
+  BOOL_PARAM,
+  true,
+  "Write the output fields for all frames to a single chunked binary file (.dbin) in addition to (or, with no_text_output_files, instead of) the text files.");
+/// Correlation parameter and properties
+const Correlation_Parameter compress_binary_output_param(compress_binary_output,
+  BOOL_PARAM,
+  true,
+  "Losslessly compress the fields in the binary output file.");
+/// Correlation parameter and properties
+const Correlation_Parameter rebalance_interval_param(rebalance_interval,
+  SIZE_PARAM,
+  true,
+  "Number of frames between rebalancing the subsets across processes based on the measured cost of each subset "
+  "(0 turns rebalancing off, GENERIC_ROUTINE only, the subsets keep their solution state when they move).");
+/// Correlation parameter and properties
+const Correlation_Parameter frame_parallel_param(frame_parallel,
+  BOOL_PARAM,
+  true,
+  "Distribute the frames instead of the subsets across the processes, each process correlates all the subsets for a "
+  "contiguous block of frames (non-incremental GENERIC_ROUTINE only, the initialization method cannot depend on the previous frame).");
+/// Correlation parameter and properties
+const Correlation_Parameter share_images_on_node_param(share_images_on_node,
+  BOOL_PARAM,
+  true,
+  "Read, filter and compute the gradients of the images once per compute node and share them between the processes on "
+  "the node through MPI shared memory (each image covers the union of the windows needed by the processes on the node).");
 
 /// Correlation parameter and properties
 const Correlation_Parameter obstruction_skin_factor_param(obstruction_skin_factor,
@@ -996,7 +1095,8 @@ const Correlation_Parameter initialization_method_param(initialization_method,
 const Correlation_Parameter optimization_method_param(optimization_method,
   STRING_PARAM,
   true,
-  "Determines if gradient based (fast, but not as robust) or simplex based (no gradients needed, but requires more iterations) optimization algorithm will be used",
+  "Determines if gradient based (fast, but not as robust) or simplex based (no gradients needed, but requires more iterations) optimization algorithm will be used. "
+  "INVERSE_COMPOSITIONAL is a gradient based method that computes the Hessian once per subset from the reference image (affine shape functions only)",
   optimizationMethodStrings,
   MAX_OPTIMIZATION_METHOD);
 /// Correlation parameter and properties
@@ -1247,6 +1347,45 @@ const Correlation_Parameter compute_laplacian_image_param(compute_laplacian_imag
   false,
   "Compute the laplacian of the image");
 /// Correlation parameter and properties
+const Correlation_Parameter compact_image_storage_param(compact_image_storage,
+  BOOL_PARAM,
+  false,
+  "Store the image intensities as 8 or 16 bit integers and the gradients as 16 bit integers (reduces the memory per frame, not available with Kokkos)");
+/// Correlation parameter and properties
+const Correlation_Parameter use_huge_pages_param(use_huge_pages,
+  BOOL_PARAM,
+  false,
+  "Request transparent huge pages for the pooled image buffers (Linux only, helps with very large frames)");
+/// Correlation parameter and properties
+const Correlation_Parameter buffer_pool_megabytes_param(buffer_pool_megabytes,
+  SIZE_PARAM,
+  true,
+  "The number of megabytes of released image buffers each process keeps for reuse by the next frames (default 256, 0 turns off the reuse). "
+  "The least recently released buffers are freed first when the limit is reached");
+/// Correlation parameter and properties
+const Correlation_Parameter tiled_image_layout_param(tiled_image_layout,
+  BOOL_PARAM,
+  false,
+  "Keep an extra copy of the image intensities and gradients in square tiles so that the Keys fourth order interpolation "
+  "for a subset reads from a few contiguous blocks of memory (uses more memory, not available with compact storage or Kokkos)");
+/// Correlation parameter and properties
+const Correlation_Parameter subset_execution_order_param(subset_execution_order,
+  STRING_PARAM,
+  true,
+  "Determines the order in which each processor executes its subsets. MORTON_ORDER and HILBERT_ORDER sort the subsets along "
+  "a space filling curve so that consecutive subsets touch nearby pixels (the neighbor dependencies for initialization are preserved)",
+  subsetExecutionOrderStrings,
+  MAX_SUBSET_EXECUTION_ORDER);
+/// Correlation parameter and properties
+const Correlation_Parameter decomposition_method_param(decomposition_method,
+  STRING_PARAM,
+  true,
+  "Determines how the subsets are split across processors. HILBERT_CURVE_DECOMPOSITION gives each processor a compact "
+  "block of subsets along a Hilbert curve and finds the ghosted neighbors for the strain windows in parallel "
+  "(seed and obstruction groupings still take precedence)",
+  decompositionMethodStrings,
+  MAX_DECOMPOSITION_METHOD);
+/// Correlation parameter and properties
 const Correlation_Parameter filter_failed_cine_pixels_param(filter_failed_cine_pixels,
   BOOL_PARAM,
   false,
@@ -1261,7 +1400,7 @@ const Correlation_Parameter remove_outlier_pixels_param(remove_outlier_pixels,
 // TODO don't forget to update this when adding a new one
 /// The total number of valid correlation parameters
 /// Vector of valid parameter names
-const int_t num_valid_correlation_params = 90;
+const int_t num_valid_correlation_params = 102;
 /// Vector oIf valid parameter names
 const Correlation_Parameter valid_correlation_params[num_valid_correlation_params] = {
   correlation_routine_param,
@@ -1351,9 +1490,21 @@ const Correlation_Parameter valid_correlation_params[num_valid_correlation_param
   num_image_integration_points_param,
   use_fixed_point_iterations_param,
   compute_laplacian_image_param,
+  compact_image_storage_param,
+  use_huge_pages_param,
+  buffer_pool_megabytes_param,
+  tiled_image_layout_param,
+  subset_execution_order_param,
+  decomposition_method_param,
   enable_projection_shape_function_param,
   write_exodus_output_param,
-  threshold_block_size_param
+  threshold_block_size_param,
+  num_threads_param,
+  write_binary_output_param,
+  compress_binary_output_param,
+  rebalance_interval_param,
+  frame_parallel_param,
+  share_images_on_node_param
 };
 
 // TODO don't forget to update this when adding a new one
@@ -0,0 +1,230 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe_BufferPool.h>
+
+#include <Teuchos_TestForException.hpp>
+
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <mutex>
+
+#if defined(_WIN32)
+#  include <malloc.h>
+#else
+#  include <sys/mman.h>
+#endif
+
+namespace DICe {
+
+namespace buffer_pool {
+
+namespace {
+
+/// size of a transparent huge page on x86_64 Linux
+const size_t huge_page_bytes = 2*1024*1024;
+
+/// cached buffers (size class in bytes and pointer)
+typedef std::list<std::pair<size_t,void*> > Buffer_List;
+/// positions in a Buffer_List keyed by size class
+typedef std::multimap<size_t,Buffer_List::iterator> Buffer_Map;
+
+/// the state of the pool, this is allocated once and never deleted so that arrays released
+/// during static destruction can still be handed back safely
+struct Pool{
+  Pool():
+    cached_bytes(0),
+    max_cached_bytes(default_max_cached_bytes),
+    huge_pages(false),
+    num_reused(0){}
+  std::mutex mutex;
+  /// cached buffers (size class in bytes and pointer), the most recently released first
+  Buffer_List lru;
+  /// positions in the lru list keyed by size class
+  Buffer_Map buffers;
+  size_t cached_bytes;
+  size_t max_cached_bytes;
+  bool huge_pages;
+  size_t num_reused;
+};
+
+Pool & pool(){
+  static Pool * the_pool = new Pool();
+  return *the_pool;
+}
+
+/// free a buffer allocated by allocate_buffer()
+void free_buffer(void * ptr){
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+/// free the least recently released buffers until the cache fits (the caller holds the lock)
+void evict(Pool & p){
+  while(p.cached_bytes>p.max_cached_bytes&&!p.lru.empty()){
+    Buffer_List::iterator oldest = --p.lru.end();
+    std::pair<Buffer_Map::iterator,Buffer_Map::iterator> range = p.buffers.equal_range(oldest->first);
+    for(Buffer_Map::iterator it=range.first;it!=range.second;++it){
+      if(it->second==oldest){
+        p.buffers.erase(it);
+        break;
+      }
+    }
+    p.cached_bytes -= oldest->first;
+    free_buffer(oldest->second);
+    p.lru.erase(oldest);
+  }
+}
+
+/// allocate a new buffer (cache line aligned, or huge page aligned if huge pages are requested)
+void * allocate_buffer(const size_t bytes,
+  const bool huge_pages){
+  const bool use_huge_pages = huge_pages&&bytes>=huge_page_bytes;
+  const size_t alignment = use_huge_pages ? huge_page_bytes : 64;
+  void * ptr = NULL;
+#if defined(_WIN32)
+  ptr = _aligned_malloc(bytes,alignment);
+#else
+  if(posix_memalign(&ptr,alignment,bytes)!=0)
+    ptr = NULL;
+#endif
+  TEUCHOS_TEST_FOR_EXCEPTION(ptr==NULL,std::runtime_error,"Error, buffer_pool could not allocate " << bytes << " bytes");
+#if defined(MADV_HUGEPAGE)
+  if(use_huge_pages)
+    madvise(ptr,bytes,MADV_HUGEPAGE); // only a hint, the buffer is fine without huge pages
+#endif
+  return ptr;
+}
+
+}
+
+size_t
+size_class(const size_t bytes){
+  if(bytes<min_pooled_bytes) return bytes;
+  // four classes per power of two: round up to a multiple of a quarter of the largest power of two <= bytes
+  size_t top = 1;
+  while(top<=bytes/2) top <<= 1;
+  const size_t step = top/4;
+  return ((bytes + step - 1)/step)*step;
+}
+
+void *
+acquire(const size_t bytes){
+  const size_t class_bytes = size_class(bytes);
+  Pool & p = pool();
+  bool huge_pages = false;
+  {
+    std::lock_guard<std::mutex> lock(p.mutex);
+    Buffer_Map::iterator it = p.buffers.find(class_bytes);
+    if(it!=p.buffers.end()){
+      void * ptr = it->second->second;
+      p.lru.erase(it->second);
+      p.buffers.erase(it);
+      p.cached_bytes -= class_bytes;
+      p.num_reused++;
+      return ptr;
+    }
+    huge_pages = p.huge_pages;
+  }
+  // allocate outside the lock
+  return allocate_buffer(class_bytes,huge_pages);
+}
+
+void
+release(void * ptr,
+  const size_t bytes){
+  if(ptr==NULL) return;
+  const size_t class_bytes = size_class(bytes);
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  p.lru.push_front(std::pair<size_t,void*>(class_bytes,ptr));
+  p.buffers.insert(std::pair<size_t,Buffer_List::iterator>(class_bytes,p.lru.begin()));
+  p.cached_bytes += class_bytes;
+  evict(p);
+}
+
+void
+set_max_cached_bytes(const size_t bytes){
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  p.max_cached_bytes = bytes;
+  evict(p);
+}
+
+void
+use_huge_pages(const bool flag){
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  p.huge_pages = flag;
+}
+
+void
+clear(){
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  for(Buffer_List::iterator it=p.lru.begin();it!=p.lru.end();++it)
+    free_buffer(it->second);
+  p.lru.clear();
+  p.buffers.clear();
+  p.cached_bytes = 0;
+}
+
+size_t
+cached_bytes(){
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  return p.cached_bytes;
+}
+
+size_t
+num_reused(){
+  Pool & p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  return p.num_reused;
+}
+
+}// End buffer_pool namespace
+
+}// End DICe Namespace
@@ -0,0 +1,154 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#ifndef DICE_BUFFERPOOL_H
+#define DICE_BUFFERPOOL_H
+
+#include <DICe.h>
+
+#include <Teuchos_ArrayRCP.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+namespace DICe {
+
+/// \namespace DICe::buffer_pool
+/// \brief Recycles the large pixel arrays of images
+///
+/// Every frame of an analysis allocates intensity, gradient and mask arrays of the same size and
+/// frees the arrays of the previous frame. For large frames the allocation and the page faults
+/// from touching the fresh memory for the first time show up as system time. Arrays allocated through
+/// the pool are handed back to it when the last reference is released and reused for the next
+/// array in the same size class (four classes per power of two, so a buffer is at most 25% larger
+/// than requested and images that differ by a few rows or columns still share buffers). When the cache
+/// is over its limit the least recently released buffers are freed first. Small arrays are allocated
+/// normally. The pool is shared by all threads.
+namespace buffer_pool {
+
+/// arrays smaller than this many bytes are not pooled
+const size_t min_pooled_bytes = 1<<20;
+
+/// default limit on the number of bytes kept in the pool for reuse
+const size_t default_max_cached_bytes = (size_t)256<<20;
+
+/// returns the size of the buffer that is allocated for a request (the request rounded up to its size class)
+/// \param bytes the size of the request in bytes
+DICE_LIB_DLL_EXPORT
+size_t size_class(const size_t bytes);
+
+/// returns an uninitialized buffer of size_class(bytes) bytes, reusing a cached buffer if one is available
+/// (use array() instead, the buffer must be returned with release())
+/// \param bytes the size of the request in bytes
+DICE_LIB_DLL_EXPORT
+void * acquire(const size_t bytes);
+
+/// return a buffer to the pool (the least recently released buffers are freed if the pool is over its limit)
+/// \param ptr pointer to the buffer
+/// \param bytes the size of the request the buffer was acquired for
+DICE_LIB_DLL_EXPORT
+void release(void * ptr,
+  const size_t bytes);
+
+/// set the maximum number of bytes kept in the pool for reuse (buffers in use do not count,
+/// the default is default_max_cached_bytes)
+/// \param bytes the limit, 0 turns off the reuse of buffers
+DICE_LIB_DLL_EXPORT
+void set_max_cached_bytes(const size_t bytes);
+
+/// request transparent huge pages for new buffers that are at least one huge page (only has an effect on Linux)
+/// \param flag true if huge pages should be used
+DICE_LIB_DLL_EXPORT
+void use_huge_pages(const bool flag=true);
+
+/// free all of the cached buffers (buffers in use are not affected)
+DICE_LIB_DLL_EXPORT
+void clear();
+
+/// returns the number of bytes currently cached for reuse
+DICE_LIB_DLL_EXPORT
+size_t cached_bytes();
+
+/// returns the number of requests that were served from the cache
+DICE_LIB_DLL_EXPORT
+size_t num_reused();
+
+/// \class DICe::buffer_pool::Deallocator
+/// \brief Teuchos deallocation policy that returns the buffer to the pool
+template <typename T>
+class Deallocator{
+public:
+  /// pointer type required by Teuchos
+  typedef T ptr_t;
+  /// constructor
+  /// \param bytes the size of the buffer in bytes
+  Deallocator(const size_t bytes):
+  bytes_(bytes){}
+  /// called by Teuchos when the last reference is released
+  /// \param ptr the buffer
+  void free(T * ptr){
+    release(ptr,bytes_);
+  }
+private:
+  /// size of the buffer in bytes
+  size_t bytes_;
+};
+
+/// drop in replacement for Teuchos::ArrayRCP<T>(size,value) that uses the pool for large arrays
+/// (only for plain data types since no constructors or destructors are called)
+/// \param size the number of entries
+/// \param value the initial value of each entry
+template <typename T>
+Teuchos::ArrayRCP<T> array(const size_t size,
+  const T & value){
+  const size_t bytes = size*sizeof(T);
+  if(bytes<min_pooled_bytes)
+    return Teuchos::ArrayRCP<T>(size,value);
+  T * ptr = static_cast<T*>(acquire(bytes));
+  std::fill(ptr,ptr+size,value);
+  return Teuchos::arcp(ptr,0,size,Deallocator<T>(bytes),true);
+}
+
+}// End buffer_pool namespace
+
+}// End DICe Namespace
+
+#endif
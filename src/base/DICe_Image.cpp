@@ -40,6 +40,7 @@
 // @HEADER
 
 #include <DICe_Image.h>
+#include <DICe_BufferPool.h>
 #include <DICe_ImageIO.h>
 #include <DICe_Shape.h>
 #if DICE_KOKKOS
@@ -95,24 +96,33 @@ Image::Image(const int_t width,
 /// post allocation tasks
 void
 Image::post_allocation_tasks(const Teuchos::RCP<Teuchos::ParameterList> & params){
+  // any pyramid, spline coefficients or tiles built from the previous intensity values are stale
+  pyramid_.clear();
+  discard_bspline_coefficients();
+  tiles_ = Teuchos::null;
   gauss_filter_mask_size_ = 7; // default sizes
   gauss_filter_half_mask_ = 4;
   if(params==Teuchos::null) return;
+  num_threads_ = params->get<int>(DICe::num_threads,num_threads_);
   gradient_method_ = params->get<Gradient_Method>(DICe::gradient_method,FINITE_DIFFERENCE);
   const bool gauss_filter_image =  params->get<bool>(DICe::gauss_filter_images,false);
   const bool gauss_filter_use_hierarchical_parallelism = params->get<bool>(DICe::gauss_filter_use_hierarchical_parallelism,false);
   const int gauss_filter_team_size = params->get<int>(DICe::gauss_filter_team_size,256);
   gauss_filter_mask_size_ = params->get<int>(DICe::gauss_filter_mask_size,7);
   gauss_filter_half_mask_ = gauss_filter_mask_size_/2+1;
-  if(gauss_filter_image){
-    gauss_filter(-1,gauss_filter_use_hierarchical_parallelism,gauss_filter_team_size);
-  }
   const bool compute_image_gradients = params->get<bool>(DICe::compute_image_gradients,false);
   DEBUG_MSG("Image::post_allocation_tasks(): compute_image_gradients is " << compute_image_gradients);
   const bool image_grad_use_hierarchical_parallelism = params->get<bool>(DICe::image_grad_use_hierarchical_parallelism,false);
   const int image_grad_team_size = params->get<int>(DICe::image_grad_team_size,256);
-  if(compute_image_gradients)
-    compute_gradients(image_grad_use_hierarchical_parallelism,image_grad_team_size);
+  if(!gauss_filter_use_hierarchical_parallelism&&!image_grad_use_hierarchical_parallelism){
+    filter_and_compute_gradients(gauss_filter_image,compute_image_gradients);
+  }
+  else{
+    if(gauss_filter_image)
+      gauss_filter(-1,gauss_filter_use_hierarchical_parallelism,gauss_filter_team_size);
+    if(compute_image_gradients)
+      compute_gradients(image_grad_use_hierarchical_parallelism,image_grad_team_size);
+  }
   if(params->isParameter(DICe::compute_laplacian_image)){
     if(params->get<bool>(DICe::compute_laplacian_image)==true){
       TEUCHOS_TEST_FOR_EXCEPTION(laplacian_==Teuchos::null,std::runtime_error,"");
@@ -128,6 +138,16 @@ Image::post_allocation_tasks(const Teuchos::RCP<Teuchos::ParameterList> & params
       }
     }
   }
+  if(params->isType<Interpolation_Method>(DICe::interpolation_method)){
+    if(params->get<Interpolation_Method>(DICe::interpolation_method)==BSPLINE_CUBIC)
+      compute_bspline_coefficients();
+  }
+  // the tiles would be thrown away by compact()
+  if(params->get<bool>(DICe::tiled_image_layout,false)&&!params->get<bool>(DICe::compact_image_storage,false))
+    compute_tiled_layout();
+  // compact storage is applied last so the filter and gradients work on the full precision values
+  if(params->get<bool>(DICe::compact_image_storage,false))
+    compact();
 }
 
 /// returns true if the image is a frame from a video sequence cine or netcdf file
@@ -216,7 +236,7 @@ Image::mean()const{
 void
 Image::write(const std::string & file_name){
   try{
-    utils::write_image(file_name.c_str(),width_,height_,intensities().getRawPtr(),default_is_layout_right());
+    utils::write_image(file_name.c_str(),width_,height_,decoded_intensities().getRawPtr(),default_is_layout_right());
   }
   catch(...){
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, write image failure.");
@@ -228,7 +248,7 @@ Image::write_overlap_image(const std::string & file_name,
   Teuchos::RCP<Image> top_img){
   TEUCHOS_TEST_FOR_EXCEPTION(top_img->height()!=height_||top_img->width()!=width_,std::runtime_error,"Error, dimensions must match for top and bottom image");
   try{
-    utils::write_color_overlap_image(file_name.c_str(),width_,height_,intensities().getRawPtr(),top_img->intensities().getRawPtr());
+    utils::write_color_overlap_image(file_name.c_str(),width_,height_,decoded_intensities().getRawPtr(),top_img->decoded_intensities().getRawPtr());
   }
   catch(...){
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, write color overlap image failure.");
@@ -241,7 +261,7 @@ Image::write_overlap_image(const std::string & file_name,
 void
 Image::write_grad_x(const std::string & file_name){
   try{
-    utils::write_image(file_name.c_str(),width_,height_,grad_x_array().getRawPtr(),default_is_layout_right());
+    utils::write_image(file_name.c_str(),width_,height_,decoded_grad_x().getRawPtr(),default_is_layout_right());
   }
   catch(...){
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, write image grad_x failure.");
@@ -251,7 +271,7 @@ Image::write_grad_x(const std::string & file_name){
 void
 Image::write_grad_y(const std::string & file_name){
   try{
-    utils::write_image(file_name.c_str(),width_,height_,grad_y_array().getRawPtr(),default_is_layout_right());
+    utils::write_image(file_name.c_str(),width_,height_,decoded_grad_y().getRawPtr(),default_is_layout_right());
   }
   catch(...){
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, write image grad_y failure.");
@@ -267,7 +287,7 @@ Image::apply_rotation(const Rotation_Value rotation,
     params->set(DICe::gauss_filter_images,false);
   }
   Teuchos::RCP<Image> result;
-  Teuchos::ArrayRCP<intensity_t> new_intensities(width_*height_,0.0);
+  Teuchos::ArrayRCP<intensity_t> new_intensities = buffer_pool::array<intensity_t>(width_*height_,0.0);
   if(rotation==NINTY_DEGREES){
     for(int_t y=0;y<height_;++y){
       for(int_t x=0;x<width_;++x){
@@ -297,6 +317,31 @@ Image::apply_rotation(const Rotation_Value rotation,
   return result;
 }
 
+void
+Image::build_pyramid(const int_t num_levels){
+  TEUCHOS_TEST_FOR_EXCEPTION(num_levels<0,std::invalid_argument,"Error, invalid number of pyramid levels " << num_levels);
+  if((int_t)pyramid_.size()>num_levels)
+    pyramid_.resize(num_levels);
+  while((int_t)pyramid_.size()<num_levels){
+    const Image & fine = pyramid_.empty() ? *this : *pyramid_.back();
+    const int_t fine_w = fine.width();
+    const int_t coarse_w = fine.width()/2;
+    const int_t coarse_h = fine.height()/2;
+    TEUCHOS_TEST_FOR_EXCEPTION(coarse_w<2||coarse_h<2,std::runtime_error,
+      "Error, image is too small (" << width_ << "x" << height_ << ") for " << num_levels << " pyramid levels");
+    // odd trailing rows and columns of the finer level are dropped
+    Teuchos::ArrayRCP<intensity_t> coarse_intensities(coarse_w*coarse_h,0.0);
+    for(int_t y=0;y<coarse_h;++y){
+      for(int_t x=0;x<coarse_w;++x){
+        const int_t i = 2*y*fine_w + 2*x;
+        coarse_intensities[y*coarse_w+x] = 0.25*(fine(i) + fine(i+1) + fine(i+fine_w) + fine(i+fine_w+1));
+      }
+    }
+    pyramid_.push_back(Teuchos::rcp(new Image(coarse_w,coarse_h,coarse_intensities,Teuchos::null,
+      fine.offset_x()/2,fine.offset_y()/2)));
+  }
+}
+
 
 
 }// End DICe Namespace
@@ -46,6 +46,12 @@
   #include <DICe_Kokkos.h>
 #endif
 #include <Teuchos_ParameterList.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+
 namespace DICe {
 
 /// forward declaration of the conformal_area_def
@@ -120,6 +126,35 @@ public:
     const int_t offset_x = 0,
     const int_t offset_y = 0);
 
+  /// constructor that uses intensity values, gradients and mask that have already been computed
+  /// (for example by another process on the same node), the arrays are not copied and the filter and gradients
+  /// are not applied again. Since the arrays are shared, in place operations (filtering, masking, computing
+  /// the gradients, etc.) throw for this image (see is_adopted()).
+  /// \param width image width
+  /// \param height image height
+  /// \param intensities image intensity values
+  /// \param grad_x image x gradients
+  /// \param grad_y image y gradients
+  /// \param mask mask coefficients
+  /// \param has_gradients true if the gradients have been computed
+  /// \param has_gauss_filter true if the intensity values have been filtered
+  /// \param params optional image parameters (only used for the interpolation specific storage)
+  /// \param offset_x the x offset for a sub image
+  /// \param offset_y the y offset for a sub image
+  /// \param file_name name of the file the values were read from (empty if they did not come from a file)
+  Image(const int_t width,
+    const int_t height,
+    Teuchos::ArrayRCP<intensity_t> intensities,
+    Teuchos::ArrayRCP<scalar_t> grad_x,
+    Teuchos::ArrayRCP<scalar_t> grad_y,
+    Teuchos::ArrayRCP<scalar_t> mask,
+    const bool has_gradients,
+    const bool has_gauss_filter,
+    const Teuchos::RCP<Teuchos::ParameterList> & params=Teuchos::null,
+    const int_t offset_x = 0,
+    const int_t offset_y = 0,
+    const std::string & file_name="");
+
   //
   // Empty (zero) image
   //
@@ -171,6 +206,15 @@ public:
   /// post allocation tasks
   void post_allocation_tasks(const Teuchos::RCP<Teuchos::ParameterList> & params=Teuchos::null);
 
+  /// prefilter the cubic B-spline coefficients and publish them (the caller holds bspline_mutex_)
+  void publish_bspline_coefficients();
+
+  /// drop the cubic B-spline coefficients (the intensities are about to change)
+  void discard_bspline_coefficients(){
+    bspline_ready_.store(false,std::memory_order_release);
+    bspline_coeffs_ = Teuchos::null;
+  }
+
   /// virtual destructor
   virtual ~Image(){};
 
@@ -238,23 +282,35 @@ public:
   /// y is row, x is column
   /// \param x image coordinate x
   /// \param y image coordinate y
-  const intensity_t& operator()(const int_t x, const int_t y) const;
+  intensity_t operator()(const int_t x, const int_t y) const;
 
   /// intensity accessors:
   /// note the internal arrays are stored as (row,column) so the indices have to be switched from coordinates x,y to y,x
   /// y is row, x is column
   /// \param i pixel index
-  const intensity_t& operator()(const int_t i) const;
+  intensity_t operator()(const int_t i) const;
 
   /// returns a copy of the intenisity values as an array
+  /// (throws for a compact image, see decoded_intensities())
   Teuchos::ArrayRCP<intensity_t> intensities()const;
 
   /// returns a copy of the grad_x values as an array
+  /// (throws for a compact image, see decoded_grad_x())
   Teuchos::ArrayRCP<scalar_t> grad_x_array()const;
 
   /// returns a copy of the grad_y values as an array
+  /// (throws for a compact image, see decoded_grad_y())
   Teuchos::ArrayRCP<scalar_t> grad_y_array()const;
 
+  /// returns read-only intensity values, for a compact image these are decoded into a new array
+  Teuchos::ArrayRCP<const intensity_t> decoded_intensities()const;
+
+  /// returns read-only grad_x values, for a compact image these are decoded into a new array
+  Teuchos::ArrayRCP<const scalar_t> decoded_grad_x()const;
+
+  /// returns read-only grad_y values, for a compact image these are decoded into a new array
+  Teuchos::ArrayRCP<const scalar_t> decoded_grad_y()const;
+
   /// replaces the intensity values of the image
   /// \param intensities the new intensity value array
   void replace_intensities(Teuchos::ArrayRCP<intensity_t> intensities);
@@ -353,18 +409,74 @@ public:
   scalar_t interpolate_grad_y_bicubic(const scalar_t & local_x,
     const scalar_t & local_y);
 
+  /// interpolate intensity and gradients using the cubic B-spline coefficients of the image
+  /// (see compute_bspline_coefficients()), the value and both gradients come from the same 4x4 neighborhood.
+  /// The gradients are the derivatives of the spline (the image gradient arrays are not used)
+  /// except near the edges of the image where this falls back to bilinear interpolation
+  void interpolate_bspline_all(intensity_t& intensity_val,
+       scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
+       const scalar_t& local_x, const scalar_t& local_y);
+
+  /// prefilter the image intensities into cubic B-spline coefficients (recursive filter with mirror boundary
+  /// conditions) so that the spline interpolates the pixel values. Called when the image is created if the
+  /// interpolation_method parameter is BSPLINE_CUBIC (the schema also does this for every image it installs),
+  /// otherwise the first time the BSPLINE_CUBIC interpolant is used. The coefficients are filled in a separate
+  /// array and only published once complete, so threads interpolating the image never see a partial array.
+  /// The coefficients are discarded whenever the intensity values are changed in place.
+  void compute_bspline_coefficients();
+
+  /// returns true if the cubic B-spline coefficients have been computed
+  bool has_bspline_coefficients()const{
+    return bspline_ready_.load(std::memory_order_acquire);
+  }
+
+  /// copy the intensities and gradients into square tiles stored one after the other. Each tile also
+  /// holds the pixels the Keys fourth order interpolant reads past its edges, so interpolate_all() reads the
+  /// whole 6x6 neighborhood of a point from one small block of memory instead of six image rows.
+  /// Called when the image is created if the tiled_image_layout parameter is set. The tiles are discarded
+  /// whenever the intensity or gradient values are changed in place. Not available for compact images.
+  void compute_tiled_layout();
+
+  /// returns true if the tiled copy of the intensities and gradients has been computed
+  bool has_tiled_layout()const{
+    return tiles_.size()>0;
+  }
+
+  /// \brief interpolate the intensity (and optionally the gradients) for a set of points in one call
+  /// \param num_points the number of points
+  /// \param local_x array of local image coordinates x
+  /// \param local_y array of local image coordinates y
+  /// \param skip optional array of flags, points with a true flag are not interpolated (can be NULL)
+  /// \param intensity_vals [out] array of interpolated intensity values
+  /// \param grad_x_vals [out] array of interpolated x gradient values (only set if compute_gradient is true)
+  /// \param grad_y_vals [out] array of interpolated y gradient values (only set if compute_gradient is true)
+  /// \param compute_gradient true if the gradients should be interpolated as well
+  /// \param interp the interpolation method to use
+  ///
+  /// This is the same as calling one of the interpolate_*_all() methods for each point,
+  /// but the loop is inside the image class so the interpolation weights stay in registers
+  void interpolate_all(const int_t num_points,
+    const scalar_t * local_x,
+    const scalar_t * local_y,
+    const bool * skip,
+    intensity_t * intensity_vals,
+    scalar_t * grad_x_vals,
+    scalar_t * grad_y_vals,
+    const bool compute_gradient,
+    const Interpolation_Method interp);
+
   /// gradient accessors:
   /// note the internal arrays are stored as (row,column) so the indices have to be switched from coordinates x,y to y,x
   /// y is row, x is column
   /// \param x image coordinate x
   /// \param y image coordinate y
-  const scalar_t& grad_x(const int_t x,
+  scalar_t grad_x(const int_t x,
     const int_t y) const;
 
   /// gradient accessor for y
   /// \param x image coordinate x
   /// \param y image coordinate y
-  const scalar_t& grad_y(const int_t x,
+  scalar_t grad_y(const int_t x,
     const int_t y) const ;
 
   /// laplacian accessor:
@@ -378,7 +490,7 @@ public:
   /// mask value accessor
   /// \param x image coordinate x
   /// \param y image coordinate y
-  const scalar_t& mask(const int_t x,
+  scalar_t mask(const int_t x,
     const int_t y) const ;
 
   /// create the image mask field, but don't apply it to the image
@@ -432,6 +544,26 @@ public:
   Teuchos::RCP<Image> apply_rotation(const Rotation_Value rotation,
       const Teuchos::RCP<Teuchos::ParameterList> & params=Teuchos::null);
 
+  /// build a multi-resolution pyramid of this image where each level is a 2x2 box average
+  /// of the level above it (levels that already exist are reused so this is cheap to call
+  /// once per frame). The pyramid is discarded whenever the intensity values are changed in place.
+  /// \param num_levels the number of coarse levels to build (not counting this image)
+  void build_pyramid(const int_t num_levels);
+
+  /// returns the number of coarse levels that have been built
+  int_t num_pyramid_levels()const{
+    return pyramid_.size();
+  }
+
+  /// returns a pointer to a coarse level of the pyramid, level 1 is half resolution,
+  /// level 2 quarter resolution, etc. (level 0 is not valid, use this image instead)
+  /// \param level the pyramid level
+  Teuchos::RCP<Image> pyramid_level(const int_t level)const{
+    TEUCHOS_TEST_FOR_EXCEPTION(level<1||level>(int_t)pyramid_.size(),std::invalid_argument,
+      "Error, invalid pyramid level " << level << " (" << pyramid_.size() << " levels have been built)");
+    return pyramid_[level-1];
+  }
+
   /// compute the image gradients
   void compute_gradients(const bool use_hierarchical_parallelism=false,
     const int_t team_size=256);
@@ -464,6 +596,17 @@ public:
   void gauss_filter(const int_t mask_size=-1,const bool use_hierarchical_parallelism=false,
     const int_t team_size=256);
 
+  /// filter the image and compute the gradients in a single sweep over the pixels (the serial
+  /// version streams bands of rows through the separable filter, gradient stencil, and gradient
+  /// smoothing so each pixel is only loaded from memory once). Gives the same result
+  /// as calling gauss_filter() and then compute_gradients()
+  /// \param apply_gauss_filter true if the image should be filtered
+  /// \param apply_gradients true if the gradients should be computed
+  /// \param mask_size the size of the filter mask (-1 keeps the current size)
+  void filter_and_compute_gradients(const bool apply_gauss_filter,
+    const bool apply_gradients,
+    const int_t mask_size=-1);
+
   /// sets the file name of the image
   void set_file_name(const std::string & file_name) {
     file_name_ = file_name;
@@ -488,6 +631,41 @@ public:
     return gauss_filter_mask_size_;
   }
 
+  /// switch the image to compact storage: the intensities are stored as 8 bit integers if they are all
+  /// whole numbers in [0,255], otherwise as 16 bit integers with a scale factor, the gradients are stored
+  /// as 16 bit integers with a scale factor and the mask as 8 bit integers (the laplacian is not changed).
+  /// The full precision arrays are released and the interpolants convert the values on the fly.
+  /// Images with negative intensities are left in full precision. Operations that modify the image in place
+  /// (filtering, gradients, masks, in place transformations, reading a new frame) call expand() first.
+  /// Call this after the image has been filtered and the gradients computed since the filter is applied to the
+  /// rounded values otherwise.
+  void compact();
+
+  /// switch a compact image back to full precision storage (no-op if the image is not compact)
+  void expand();
+
+  /// returns true if the image uses compact storage (see compact())
+  bool is_compact()const{
+    return intensities_8_.size()>0||intensities_16_.size()>0;
+  }
+
+  /// returns true if the image adopted arrays owned by someone else (the in place operations are not allowed)
+  bool is_adopted()const{
+    return is_adopted_;
+  }
+
+  /// set the number of threads used by the filter, gradient and tile kernels of this image
+  /// (also set by the num_threads image parameter, 0 uses the OpenMP default)
+  /// \param num_threads the number of threads
+  void set_num_threads(const int_t num_threads){
+    num_threads_ = num_threads;
+  }
+
+  /// returns the number of threads used by the image kernels (0 for the OpenMP default)
+  int_t num_threads()const{
+    return num_threads_;
+  }
+
 #if DICE_KOKKOS
   /// tag
   struct Init_Mask_Tag {};
@@ -533,6 +711,21 @@ public:
 #endif
 
 private:
+  /// interpolate the values of a compact image, uses the same interpolants and treatment
+  /// of the pixels near the edges of the image as the full precision methods
+  /// \param interp the interpolation method
+  /// \param local_x local image coordinate x
+  /// \param local_y local image coordinate y
+  /// \param intensity_val [out] the interpolated intensity (not computed if NULL)
+  /// \param grad_x_val [out] the interpolated x gradient (not computed if NULL)
+  /// \param grad_y_val [out] the interpolated y gradient (not computed if NULL)
+  void interpolate_compact(const Interpolation_Method interp,
+    const scalar_t & local_x,
+    const scalar_t & local_y,
+    intensity_t * intensity_val,
+    scalar_t * grad_x_val,
+    scalar_t * grad_y_val)const;
+
   /// pixel container width_
   int_t width_;
   /// pixel container height_
@@ -561,8 +754,6 @@ private:
 #else
   /// pixel container
   Teuchos::ArrayRCP<intensity_t> intensities_;
-  /// device intensity work array
-  Teuchos::ArrayRCP<intensity_t> intensities_temp_;
   /// mask coefficients
   Teuchos::ArrayRCP<scalar_t> mask_;
   /// image gradient x container
@@ -592,6 +783,34 @@ private:
   bool has_file_name_;
   /// gradient method
   Gradient_Method gradient_method_;
+  /// coarse levels of the multi-resolution pyramid (empty until build_pyramid() is called)
+  std::vector<Teuchos::RCP<Image> > pyramid_;
+  /// compact intensity storage for 8 bit images (empty unless compact() has been called)
+  Teuchos::ArrayRCP<uint8_t> intensities_8_;
+  /// compact intensity storage for all other images (empty unless compact() has been called)
+  Teuchos::ArrayRCP<uint16_t> intensities_16_;
+  /// intensity value of one compact intensity unit
+  scalar_t intensity_scale_;
+  /// compact image gradient x container (empty if the image is not compact or has no gradients)
+  Teuchos::ArrayRCP<int16_t> grad_x_16_;
+  /// compact image gradient y container (empty if the image is not compact or has no gradients)
+  Teuchos::ArrayRCP<int16_t> grad_y_16_;
+  /// gradient value of one compact gradient unit
+  scalar_t grad_scale_;
+  /// compact mask coefficients (in steps of 1/255)
+  Teuchos::ArrayRCP<uint8_t> mask_8_;
+  /// cubic B-spline coefficients (empty until compute_bspline_coefficients() is called)
+  Teuchos::ArrayRCP<scalar_t> bspline_coeffs_;
+  /// set once bspline_coeffs_ is completely filled
+  std::atomic<bool> bspline_ready_{false};
+  /// true if the intensity, gradient and mask arrays were adopted from another image or process
+  bool is_adopted_ = false;
+  /// number of threads for the image kernels (0 for the OpenMP default)
+  int_t num_threads_ = 0;
+  /// serializes computing and publishing bspline_coeffs_
+  std::mutex bspline_mutex_;
+  /// tiled copy of the intensities and gradients (empty until compute_tiled_layout() is called)
+  Teuchos::ArrayRCP<scalar_t> tiles_;
 };
 
 }// End DICe Namespace
@@ -41,6 +41,7 @@
 
 #include <DICe_Image.h>
 #include <DICe_ImageIO.h>
+#include <DICe_Profiler.h>
 #include <DICe_Shape.h>
 #include <DICe_ImageFunctors.h>
 
@@ -60,6 +61,7 @@ Image::Image(const char * file_name,
   gradient_method_(FINITE_DIFFERENCE)
 {
   try{
+    profiler::Scope read_scope(profiler::IMAGE_READ);
     utils::read_image_dimensions(file_name,width_,height_);
     TEUCHOS_TEST_FOR_EXCEPTION(width_<=0,std::runtime_error,"");
     TEUCHOS_TEST_FOR_EXCEPTION(height_<=0,std::runtime_error,"");
@@ -95,6 +97,7 @@ Image::Image(const char * file_name,
   int_t img_width = 0;
   int_t img_height = 0;
   try{
+    profiler::Scope read_scope(profiler::IMAGE_READ);
     utils::read_image_dimensions(file_name,img_width,img_height);
     TEUCHOS_TEST_FOR_EXCEPTION(width_<=0||offset_x_+width_>img_width,std::runtime_error,"");
     TEUCHOS_TEST_FOR_EXCEPTION(height_<=0||offset_y_+height_>img_height,std::runtime_error,"");
@@ -231,6 +234,32 @@ Image::Image(Teuchos::RCP<Image> img,
   }
 }
 
+Image::Image(const int_t width,
+  const int_t height,
+  Teuchos::ArrayRCP<intensity_t> intensities,
+  Teuchos::ArrayRCP<scalar_t> grad_x,
+  Teuchos::ArrayRCP<scalar_t> grad_y,
+  Teuchos::ArrayRCP<scalar_t> mask,
+  const bool has_gradients,
+  const bool has_gauss_filter,
+  const Teuchos::RCP<Teuchos::ParameterList> & params,
+  const int_t offset_x,
+  const int_t offset_y,
+  const std::string & file_name):
+  width_(width),
+  height_(height),
+  offset_x_(offset_x),
+  offset_y_(offset_y),
+  intensity_rcp_(Teuchos::null),
+  has_gradients_(has_gradients),
+  has_gauss_filter_(has_gauss_filter),
+  file_name_(file_name.empty() ? "(from array)" : file_name),
+  has_file_name_(!file_name.empty()),
+  gradient_method_(FINITE_DIFFERENCE)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, images with precomputed gradients are not available with Kokkos.");
+}
+
 void
 Image::initialize_array_image(intensity_t * intensities){
   assert(width_>0);
@@ -276,31 +305,31 @@ Image::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & pa
   post_allocation_tasks(params);
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t x, const int_t y) const {
   return intensities_.h_view(y,x);
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t i) const {
   const int_t y = i / width_;
   const int_t x = i - y*width_;
   return intensities_.h_view(y,x);
 }
 
-const scalar_t&
+scalar_t
 Image::grad_x(const int_t x,
   const int_t y) const {
   return grad_x_.h_view(y,x);
 }
 
-const scalar_t&
+scalar_t
 Image::grad_y(const int_t x,
   const int_t y) const {
   return grad_y_.h_view(y,x);
 }
 
-const scalar_t&
+scalar_t
 Image::mask(const int_t x,
   const int_t y) const {
   return mask_.h_view(y,x);
@@ -324,6 +353,48 @@ Image::intensities()const{
   return array;
 }
 
+Teuchos::ArrayRCP<const intensity_t>
+Image::decoded_intensities()const{
+  return intensities();
+}
+
+Teuchos::ArrayRCP<const scalar_t>
+Image::decoded_grad_x()const{
+  return grad_x_array();
+}
+
+Teuchos::ArrayRCP<const scalar_t>
+Image::decoded_grad_y()const{
+  return grad_y_array();
+}
+
+void
+Image::compact(){
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, compact image storage is not available with Kokkos.");
+}
+
+void
+Image::expand(){
+  // images are never compact with Kokkos
+}
+
+void
+Image::compute_bspline_coefficients(){
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, method not implemented yet.");
+}
+
+void
+Image::compute_tiled_layout(){
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, the tiled image layout is not available with Kokkos.");
+}
+
+void
+Image::interpolate_bspline_all(intensity_t& intensity_val,
+       scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
+       const scalar_t& local_x, const scalar_t& local_y) {
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, method not implemented yet.");
+}
+
 intensity_t
 Image::interpolate_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
   TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, method not implemented yet.");
@@ -382,6 +453,7 @@ Image::compute_gradients_finite_difference(){
 
 void
 Image::compute_gradients(const bool use_hierarchical_parallelism, const int_t team_size){
+  profiler::Scope gradient_scope(profiler::IMAGE_GRADIENTS);
   TEUCHOS_TEST_FOR_EXCEPTION(gradient_method_!=FINITE_DIFFERENCE,std::runtime_error,
     "Error, gradient method must be FINITE_DIFFERENCE (this is the only method implemented for Kokkos");
   // Flat gradients:
@@ -410,6 +482,7 @@ Image::apply_mask(const Conformal_Area_Def & area_def,
 
 void
 Image::apply_mask(const bool smooth_edges){
+  pyramid_.clear();
   // make sure the mask is synced from host to device
   mask_.modify<host_space>();
   mask_.sync<device_space>();
@@ -485,6 +558,7 @@ Image::apply_transformation(Teuchos::RCP<Local_Shape_Function> shape_function,
   Teuchos::RCP<std::vector<scalar_t> > deformation = shape_function->rcp();
 
   if(apply_in_place){
+    pyramid_.clear();
     // deep copy the intesity array to the device temporary container
     Kokkos::deep_copy(intensities_temp_,intensities_.d_view);
     Transform_Functor trans_functor(intensities_temp_,
@@ -517,9 +591,22 @@ Image::apply_transformation(Teuchos::RCP<Local_Shape_Function> shape_function,
   }
 }
 
+void
+Image::filter_and_compute_gradients(const bool apply_gauss_filter,
+  const bool apply_gradients,
+  const int_t mask_size){
+  // the Kokkos functors are already data parallel so the two passes are kept separate here
+  if(apply_gauss_filter)
+    gauss_filter(mask_size);
+  if(apply_gradients)
+    compute_gradients();
+}
+
 void
 Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelism,
   const int_t team_size){
+  profiler::Scope filter_scope(profiler::IMAGE_FILTER);
+  pyramid_.clear();
 
   if(mask_size>0) gauss_filter_mask_size_ = mask_size;
 
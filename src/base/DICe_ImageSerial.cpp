@@ -43,9 +43,23 @@
 #include <DICe_ImageUtils.h>
 #include <DICe_LocalShapeFunction.h>
 #include <DICe_ImageIO.h>
+#include <DICe_Profiler.h>
+#include <DICe_BufferPool.h>
 #include <DICe_Shape.h>
 
 #include <cassert>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+#if (defined(_OPENMP) && _OPENMP >= 201307) || defined(DICE_OPENMP_SIMD)
+#define DICE_SIMD_LOOP _Pragma("omp simd")
+#else
+#define DICE_SIMD_LOOP
+#endif
 
 namespace DICe {
 
@@ -59,6 +73,252 @@ inline scalar_t keys_f2(const scalar_t & s){
   return 0.08333333333333*s*s*s - 0.66666666666666*s*s + 1.75*s - 1.5;
 }
 
+/// fill the six Keys fourth order weights for the fractional part of a coordinate
+/// \param d the fractional part of the coordinate (0 <= d < 1)
+/// \param coeffs [out] the weights for the pixels at offsets -2 to 3
+inline void keys_fourth_coeffs(const scalar_t & d, scalar_t * coeffs){
+  coeffs[0] = keys_f2(d+2.0);
+  coeffs[1] = keys_f1(d+1.0);
+  coeffs[2] = keys_f0(d);
+  coeffs[3] = keys_f0(1.0-d);
+  coeffs[4] = keys_f1(2.0-d);
+  coeffs[5] = keys_f2(3.0-d);
+}
+
+/// Keys fourth order sum over the 6x6 neighborhood of pixel (ix,iy). The sum is done
+/// separably: each row is reduced with the x weights first so the inner loop is a
+/// fixed length dot product over contiguous memory that the compiler can vectorize
+template <typename T>
+inline scalar_t keys_fourth_sum(const T * data,
+  const int_t width,
+  const int_t ix,
+  const int_t iy,
+  const scalar_t * coeffs_x,
+  const scalar_t * coeffs_y){
+  const T * row = data + (iy-2)*width + ix-2;
+  scalar_t value = 0.0;
+  for(int_t m=0;m<6;++m){
+    scalar_t row_value = 0.0;
+    for(int_t n=0;n<6;++n)
+      row_value += coeffs_x[n]*row[n];
+    value += coeffs_y[m]*row_value;
+    row += width;
+  }
+  return value;
+}
+
+/// same as keys_fourth_sum, but the intensity and both gradients are summed in one pass
+inline intensity_t keys_fourth_sum_all(const intensity_t * intensities,
+  const scalar_t * grad_x,
+  const scalar_t * grad_y,
+  const int_t width,
+  const int_t ix,
+  const int_t iy,
+  const scalar_t * coeffs_x,
+  const scalar_t * coeffs_y,
+  scalar_t & grad_x_val,
+  scalar_t & grad_y_val){
+  const int_t start = (iy-2)*width + ix-2;
+  scalar_t value = 0.0, gx = 0.0, gy = 0.0;
+  for(int_t m=0;m<6;++m){
+    const int_t row = start + m*width;
+    scalar_t row_value = 0.0, row_gx = 0.0, row_gy = 0.0;
+    for(int_t n=0;n<6;++n){
+      row_value += coeffs_x[n]*intensities[row+n];
+      row_gx += coeffs_x[n]*grad_x[row+n];
+      row_gy += coeffs_x[n]*grad_y[row+n];
+    }
+    value += coeffs_y[m]*row_value;
+    gx += coeffs_y[m]*row_gx;
+    gy += coeffs_y[m]*row_gy;
+  }
+  grad_x_val = gx;
+  grad_y_val = gy;
+  return value;
+}
+
+/// fill the four bicubic (Catmull-Rom) weights for the fractional part of a coordinate,
+/// the bicubic interpolant is the outer product of these weights in x and y
+/// \param d the fractional part of the coordinate (0 <= d < 1)
+/// \param coeffs [out] the weights for the pixels at offsets -1 to 2
+inline void bicubic_coeffs(const scalar_t & d, scalar_t * coeffs){
+  const scalar_t d_2 = d*d;
+  const scalar_t d_3 = d_2*d;
+  coeffs[0] = 0.5*(-d_3 + 2.0*d_2 - d);
+  coeffs[1] = 0.5*(3.0*d_3 - 5.0*d_2 + 2.0);
+  coeffs[2] = 0.5*(-3.0*d_3 + 4.0*d_2 + d);
+  coeffs[3] = 0.5*(d_3 - d_2);
+}
+
+/// separable weighted sum over the N x N pixels starting at (x_begin,y_begin) of a compact (integer) field,
+/// the values are converted on the fly so only the narrow type is loaded from memory
+template <int_t N, typename T>
+inline scalar_t compact_separable_sum(const T * data,
+  const int_t width,
+  const int_t x_begin,
+  const int_t y_begin,
+  const scalar_t * coeffs_x,
+  const scalar_t * coeffs_y){
+  const T * row = data + y_begin*width + x_begin;
+  scalar_t value = 0.0;
+  for(int_t m=0;m<N;++m){
+    scalar_t row_value = 0.0;
+    for(int_t n=0;n<N;++n)
+      row_value += coeffs_x[n]*row[n];
+    value += coeffs_y[m]*row_value;
+    row += width;
+  }
+  return value;
+}
+
+/// dispatch to the fixed size sum for the support of the interpolant (2 bilinear, 4 bicubic, 6 Keys fourth)
+template <typename T>
+inline scalar_t compact_sum(const T * data,
+  const int_t width,
+  const int_t support,
+  const int_t x_begin,
+  const int_t y_begin,
+  const scalar_t * coeffs_x,
+  const scalar_t * coeffs_y){
+  if(support==6)
+    return compact_separable_sum<6>(data,width,x_begin,y_begin,coeffs_x,coeffs_y);
+  else if(support==4)
+    return compact_separable_sum<4>(data,width,x_begin,y_begin,coeffs_x,coeffs_y);
+  return compact_separable_sum<2>(data,width,x_begin,y_begin,coeffs_x,coeffs_y);
+}
+
+/// number of terms used to initialize the causal B-spline prefilter (the pole to this power is below float precision)
+static const int_t bspline_init_horizon = 16;
+
+/// fill the four cubic B-spline weights and their derivatives for the fractional part of a coordinate
+/// \param d the fractional part of the coordinate (0 <= d < 1)
+/// \param coeffs [out] the weights for the coefficients at offsets -1 to 2
+/// \param d_coeffs [out] the derivatives of the weights
+inline void bspline_weights(const scalar_t & d, scalar_t * coeffs, scalar_t * d_coeffs){
+  const scalar_t d_2 = d*d;
+  const scalar_t d_3 = d_2*d;
+  const scalar_t one_m_d = 1.0 - d;
+  coeffs[0] = one_m_d*one_m_d*one_m_d/6.0;
+  coeffs[1] = (3.0*d_3 - 6.0*d_2 + 4.0)/6.0;
+  coeffs[2] = (-3.0*d_3 + 3.0*d_2 + 3.0*d + 1.0)/6.0;
+  coeffs[3] = d_3/6.0;
+  d_coeffs[0] = -0.5*one_m_d*one_m_d;
+  d_coeffs[1] = 1.5*d_2 - 2.0*d;
+  d_coeffs[2] = -1.5*d_2 + d + 0.5;
+  d_coeffs[3] = 0.5*d_2;
+}
+
+/// cubic B-spline sum over the 4x4 coefficients starting at (x_begin,y_begin), each row is reduced with the
+/// value and derivative weights in x so the value and both derivatives share the same loads
+inline intensity_t bspline_sum(const scalar_t * coeffs,
+  const int_t width,
+  const int_t x_begin,
+  const int_t y_begin,
+  const scalar_t * w_x,
+  const scalar_t * dw_x,
+  const scalar_t * w_y,
+  const scalar_t * dw_y,
+  const bool compute_gradient,
+  scalar_t & grad_x_val,
+  scalar_t & grad_y_val){
+  const scalar_t * row = coeffs + y_begin*width + x_begin;
+  scalar_t value = 0.0, gx = 0.0, gy = 0.0;
+  for(int_t m=0;m<4;++m){
+    const scalar_t row_value = w_x[0]*row[0] + w_x[1]*row[1] + w_x[2]*row[2] + w_x[3]*row[3];
+    value += w_y[m]*row_value;
+    if(compute_gradient){
+      gx += w_y[m]*(dw_x[0]*row[0] + dw_x[1]*row[1] + dw_x[2]*row[2] + dw_x[3]*row[3]);
+      gy += dw_y[m]*row_value;
+    }
+    row += width;
+  }
+  if(compute_gradient){
+    grad_x_val = gx;
+    grad_y_val = gy;
+  }
+  return value;
+}
+
+/// cubic B-spline prefilter (Unser's recursive filter with mirror boundary conditions) applied to num_lines lines
+/// of length n at once, element k of line j is at data[k*stride + j]. With stride 1 and num_lines 1 this filters
+/// a single contiguous line, with stride equal to the image width it filters every column at once, running the
+/// recursion down the rows so the inner loop is over contiguous memory
+/// \param data the values to filter in place
+/// \param n the length of the lines
+/// \param stride the distance between consecutive elements of a line
+/// \param num_lines the number of lines (consecutive lines are adjacent in memory)
+/// \param work scratch space of size num_lines
+static void bspline_prefilter(scalar_t * data,
+  const int_t n,
+  const int_t stride,
+  const int_t num_lines,
+  scalar_t * work){
+  if(n<2) return;
+  const scalar_t z = std::sqrt(3.0) - 2.0;
+  const scalar_t gain = (1.0 - z)*(1.0 - 1.0/z);
+  for(int_t k=0;k<n;++k){
+    scalar_t * line_k = data + k*stride;
+    DICE_SIMD_LOOP
+    for(int_t j=0;j<num_lines;++j)
+      line_k[j] *= gain;
+  }
+  // causal initialization
+  std::copy(data,data+num_lines,work);
+  scalar_t z_k = z;
+  for(int_t k=1;k<std::min(n,bspline_init_horizon);++k){
+    const scalar_t * line_k = data + k*stride;
+    DICE_SIMD_LOOP
+    for(int_t j=0;j<num_lines;++j)
+      work[j] += z_k*line_k[j];
+    z_k *= z;
+  }
+  std::copy(work,work+num_lines,data);
+  // causal pass
+  for(int_t k=1;k<n;++k){
+    scalar_t * line_k = data + k*stride;
+    const scalar_t * line_km1 = line_k - stride;
+    DICE_SIMD_LOOP
+    for(int_t j=0;j<num_lines;++j)
+      line_k[j] += z*line_km1[j];
+  }
+  // anti-causal initialization
+  scalar_t * last = data + (n-1)*stride;
+  const scalar_t * second_last = last - stride;
+  const scalar_t init_coeff = z/(z*z - 1.0);
+  DICE_SIMD_LOOP
+  for(int_t j=0;j<num_lines;++j)
+    last[j] = init_coeff*(last[j] + z*second_last[j]);
+  // anti-causal pass
+  for(int_t k=n-2;k>=0;--k){
+    scalar_t * line_k = data + k*stride;
+    const scalar_t * line_kp1 = line_k + stride;
+    DICE_SIMD_LOOP
+    for(int_t j=0;j<num_lines;++j)
+      line_k[j] = z*(line_kp1[j] - line_k[j]);
+  }
+}
+
+/// images smaller than this are not worth spreading across threads
+static const int_t fused_min_parallel_pixels = 512*512;
+
+/// number of threads for the image kernels, the pool size set on the image or the OpenMP default if none was set
+/// (passed as a num_threads clause so the thread count of the process is left alone)
+static int kernel_num_threads(const int_t num_threads){
+#ifdef _OPENMP
+  return num_threads>0 ? num_threads : omp_get_max_threads();
+#else
+  (void)num_threads;
+  return 1;
+#endif
+}
+
+/// edge length of the square tiles of the tiled image layout
+static const int_t tile_size = 32;
+/// row stride of a tile, the Keys fourth order interpolant reads two pixels before and three after a tile
+static const int_t tile_stride = tile_size + 5;
+/// number of values in each tile (the intensities followed by the x and y gradients)
+static const int_t tile_values = 3*tile_stride*tile_stride;
+
 Image::Image(const char * file_name,
   const Teuchos::RCP<Teuchos::ParameterList> & params):
   offset_x_(0),
@@ -71,10 +331,11 @@ Image::Image(const char * file_name,
   gradient_method_(FINITE_DIFFERENCE)
 {
   try{
+    profiler::Scope read_scope(profiler::IMAGE_READ);
     utils::read_image_dimensions(file_name,width_,height_);
     TEUCHOS_TEST_FOR_EXCEPTION(width_<=0,std::runtime_error,"");
     TEUCHOS_TEST_FOR_EXCEPTION(height_<=0,std::runtime_error,"");
-    intensities_ = Teuchos::ArrayRCP<intensity_t>(width_*height_,0.0);
+    intensities_ = buffer_pool::array<intensity_t>(width_*height_,0.0);
     utils::read_image(file_name,intensities_.getRawPtr(),params);
   }
   catch(...){
@@ -105,11 +366,12 @@ Image::Image(const char * file_name,
   int_t img_width = 0;
   int_t img_height = 0;
   try{
+    profiler::Scope read_scope(profiler::IMAGE_READ);
     utils::read_image_dimensions(file_name,img_width,img_height);
     TEUCHOS_TEST_FOR_EXCEPTION(width_<=0||offset_x_+width_>img_width,std::runtime_error,"");
     TEUCHOS_TEST_FOR_EXCEPTION(height_<=0||offset_y_+height_>img_height,std::runtime_error,"");
     // initialize the pixel containers
-    intensities_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
+    intensities_ = buffer_pool::array<intensity_t>(height_*width_,0.0);
     // read in the image
     Teuchos::RCP<Teuchos::ParameterList> subimage_params;
     if(params!=Teuchos::null)
@@ -146,7 +408,7 @@ Image::Image(const int_t width,
 {
   assert(height_>0);
   assert(width_>0);
-  intensities_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,intensity);
+  intensities_ = buffer_pool::array<intensity_t>(height_*width_,intensity);
   default_constructor_tasks(Teuchos::null);
 }
 
@@ -179,11 +441,10 @@ Image::Image(Teuchos::RCP<Image> img,
   const int_t src_height = img->height();
 
   // initialize the pixel containers
-  intensities_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
-  intensities_temp_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
-  grad_x_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  grad_y_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  mask_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
+  intensities_ = buffer_pool::array<intensity_t>(height_*width_,0.0);
+  grad_x_ = buffer_pool::array<scalar_t>(height_*width_,0.0);
+  grad_y_ = buffer_pool::array<scalar_t>(height_*width_,0.0);
+  mask_ = buffer_pool::array<scalar_t>(height_*width_,0.0);
   // deep copy values over
   int_t src_y=0, src_x=0;
   for(int_t y=0;y<height_;++y){
@@ -233,23 +494,74 @@ Image::Image(Teuchos::RCP<Image> img,
   }
 }
 
+Image::Image(const int_t width,
+  const int_t height,
+  Teuchos::ArrayRCP<intensity_t> intensities,
+  Teuchos::ArrayRCP<scalar_t> grad_x,
+  Teuchos::ArrayRCP<scalar_t> grad_y,
+  Teuchos::ArrayRCP<scalar_t> mask,
+  const bool has_gradients,
+  const bool has_gauss_filter,
+  const Teuchos::RCP<Teuchos::ParameterList> & params,
+  const int_t offset_x,
+  const int_t offset_y,
+  const std::string & file_name):
+  width_(width),
+  height_(height),
+  offset_x_(offset_x),
+  offset_y_(offset_y),
+  intensity_rcp_(Teuchos::null),
+  has_gradients_(has_gradients),
+  has_gauss_filter_(has_gauss_filter),
+  file_name_(file_name.empty() ? "(from array)" : file_name),
+  has_file_name_(!file_name.empty()),
+  gradient_method_(FINITE_DIFFERENCE)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(width_<=0||height_<=0,std::invalid_argument,"Error, invalid image dimensions " << width_ << " x " << height_);
+  const int_t num_px = width_*height_;
+  TEUCHOS_TEST_FOR_EXCEPTION(intensities.size()!=num_px||grad_x.size()!=num_px||grad_y.size()!=num_px||mask.size()!=num_px,
+    std::invalid_argument,"Error, the intensity, gradient and mask arrays must have one value per pixel");
+  intensities_ = intensities;
+  grad_x_ = grad_x;
+  grad_y_ = grad_y;
+  mask_ = mask;
+  is_adopted_ = true;
+  if(params!=Teuchos::null&&params->get<bool>(DICe::compute_laplacian_image,false))
+    laplacian_ = buffer_pool::array<scalar_t>(num_px,0.0);
+  grad_c1_ = 1.0/12.0;
+  grad_c2_ = -8.0/12.0;
+  // the filter and gradients have already been applied, only set up the storage that depends on the interpolant
+  Teuchos::RCP<Teuchos::ParameterList> storage_params;
+  if(params!=Teuchos::null){
+    storage_params = Teuchos::rcp(new Teuchos::ParameterList(*params));
+    storage_params->set(DICe::gauss_filter_images,false);
+    storage_params->set(DICe::compute_image_gradients,false);
+  }
+  post_allocation_tasks(storage_params);
+}
+
 void
 Image::initialize_array_image(intensity_t * intensities){
   assert(width_>0);
   assert(height_>0);
   intensities_ = Teuchos::ArrayRCP<intensity_t>(intensities,0,width_*height_,false);
+  // any compact storage is stale
+  intensities_8_ = Teuchos::null;
+  intensities_16_ = Teuchos::null;
+  grad_x_16_ = Teuchos::null;
+  grad_y_16_ = Teuchos::null;
+  mask_8_ = Teuchos::null;
 }
 
 void
 Image::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & params){
-  grad_x_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  grad_y_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
-  intensities_temp_ = Teuchos::ArrayRCP<intensity_t>(height_*width_,0.0);
-  mask_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
+  grad_x_ = buffer_pool::array<scalar_t>(height_*width_,0.0);
+  grad_y_ = buffer_pool::array<scalar_t>(height_*width_,0.0);
+  mask_ = buffer_pool::array<scalar_t>(height_*width_,0.0);
   if(params!=Teuchos::null){
     if(params->isParameter(DICe::compute_laplacian_image)){
       if(params->get<bool>(DICe::compute_laplacian_image)==true){
-        laplacian_ = Teuchos::ArrayRCP<scalar_t>(height_*width_,0.0);
+        laplacian_ = buffer_pool::array<scalar_t>(height_*width_,0.0);
       }
     }
   }
@@ -268,7 +580,10 @@ Image::update_image_fields(const char * file_name,
 //    filter_failed = params->get<bool>(DICe::filter_failed_cine_pixels,false);
 //    convert_to_8_bit = params->get<bool>(DICe::convert_cine_to_8_bit,true);
 //  }
+  TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, reading new intensity values in place is not allowed for an image with adopted (shared) arrays");
+  expand();
   try{
+    profiler::Scope read_scope(profiler::IMAGE_READ);
     utils::read_image(file_name,intensities_.getRawPtr(),params);
   }
   catch(...){
@@ -277,43 +592,79 @@ Image::update_image_fields(const char * file_name,
   post_allocation_tasks(params);
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t x, const int_t y) const {
   TEUCHOS_TEST_FOR_EXCEPTION(x<0||x>=width_,std::runtime_error,"x = " << x);
   TEUCHOS_TEST_FOR_EXCEPTION(y<0||y>=height_,std::runtime_error," y = " << y);
-  return intensities_[y*width_+x];
+  return (*this)(y*width_+x);
 }
 
-const intensity_t&
+intensity_t
 Image::operator()(const int_t i) const {
+  if(intensities_8_.size()>0)
+    return intensity_scale_*intensities_8_[i];
+  if(intensities_16_.size()>0)
+    return intensity_scale_*intensities_16_[i];
   return intensities_[i];
 }
 
-const scalar_t&
+scalar_t
 Image::grad_x(const int_t x,
   const int_t y) const {
+  if(is_compact())
+    return grad_x_16_.size()>0 ? grad_scale_*grad_x_16_[y*width_+x] : 0.0;
   return grad_x_[y*width_+x];
 }
 
 Teuchos::ArrayRCP<scalar_t>
 Image::grad_x_array() const {
+  TEUCHOS_TEST_FOR_EXCEPTION(is_compact(),std::runtime_error,
+    "Error, the gradients of a compact image cannot be modified, use decoded_grad_x() to read them");
   return grad_x_;
 }
 
 Teuchos::ArrayRCP<scalar_t>
 Image::grad_y_array() const {
+  TEUCHOS_TEST_FOR_EXCEPTION(is_compact(),std::runtime_error,
+    "Error, the gradients of a compact image cannot be modified, use decoded_grad_y() to read them");
   return grad_y_;
 }
 
-const scalar_t&
+Teuchos::ArrayRCP<const scalar_t>
+Image::decoded_grad_x() const {
+  if(is_compact()){
+    Teuchos::ArrayRCP<scalar_t> grad_x(width_*height_,0.0);
+    for(int_t i=0;i<grad_x_16_.size();++i)
+      grad_x[i] = grad_scale_*grad_x_16_[i];
+    return grad_x;
+  }
+  return grad_x_;
+}
+
+Teuchos::ArrayRCP<const scalar_t>
+Image::decoded_grad_y() const {
+  if(is_compact()){
+    Teuchos::ArrayRCP<scalar_t> grad_y(width_*height_,0.0);
+    for(int_t i=0;i<grad_y_16_.size();++i)
+      grad_y[i] = grad_scale_*grad_y_16_[i];
+    return grad_y;
+  }
+  return grad_y_;
+}
+
+scalar_t
 Image::grad_y(const int_t x,
   const int_t y) const {
+  if(is_compact())
+    return grad_y_16_.size()>0 ? grad_scale_*grad_y_16_[y*width_+x] : 0.0;
   return grad_y_[y*width_+x];
 }
 
-const scalar_t&
+scalar_t
 Image::mask(const int_t x,
   const int_t y) const {
+  if(is_compact())
+    return mask_8_[y*width_+x]/255.0;
   return mask_[y*width_+x];
 }
 
@@ -325,13 +676,171 @@ Image::laplacian(const int_t x,
 
 Teuchos::ArrayRCP<intensity_t>
 Image::intensities()const{
+  TEUCHOS_TEST_FOR_EXCEPTION(is_compact(),std::runtime_error,
+    "Error, the intensities of a compact image cannot be modified, use decoded_intensities() to read them");
+  return intensities_;
+}
+
+Teuchos::ArrayRCP<const intensity_t>
+Image::decoded_intensities()const{
+  if(is_compact()){
+    Teuchos::ArrayRCP<intensity_t> intensities(width_*height_,0.0);
+    for(int_t i=0;i<width_*height_;++i)
+      intensities[i] = (*this)(i);
+    return intensities;
+  }
   return intensities_;
 }
 
+void
+Image::compact(){
+  if(is_compact()) return;
+  const int_t num_px = num_pixels();
+  intensity_t min_intensity = num_px>0 ? intensities_[0] : 0.0;
+  intensity_t max_intensity = min_intensity;
+  bool whole_numbers = true;
+  for(int_t i=0;i<num_px;++i){
+    const intensity_t value = intensities_[i];
+    min_intensity = std::min(min_intensity,value);
+    max_intensity = std::max(max_intensity,value);
+    whole_numbers = whole_numbers && value==std::floor(value);
+  }
+  if(num_px==0||min_intensity<0.0){
+    DEBUG_MSG("Image::compact(): image has negative intensities, keeping full precision storage");
+    return;
+  }
+  if(whole_numbers&&max_intensity<=255.0){
+    intensity_scale_ = 1.0;
+    intensities_8_ = buffer_pool::array<uint8_t>(num_px,0);
+    for(int_t i=0;i<num_px;++i)
+      intensities_8_[i] = static_cast<uint8_t>(intensities_[i]);
+  }
+  else{
+    // whole numbers up to 16 bits are stored exactly, anything else is quantized over the full range
+    intensity_scale_ = (whole_numbers&&max_intensity<=65535.0)||max_intensity==0.0 ? 1.0 : max_intensity/65535.0;
+    intensities_16_ = buffer_pool::array<uint16_t>(num_px,0);
+    for(int_t i=0;i<num_px;++i)
+      intensities_16_[i] = static_cast<uint16_t>(std::min((scalar_t)65535.0,std::floor(intensities_[i]/intensity_scale_ + (scalar_t)0.5)));
+  }
+  grad_scale_ = 1.0;
+  if(has_gradients_){
+    scalar_t max_grad = 0.0;
+    for(int_t i=0;i<num_px;++i)
+      max_grad = std::max(max_grad,std::max(std::abs(grad_x_[i]),std::abs(grad_y_[i])));
+    if(max_grad>0.0)
+      grad_scale_ = max_grad/32767.0;
+    grad_x_16_ = buffer_pool::array<int16_t>(num_px,0);
+    grad_y_16_ = buffer_pool::array<int16_t>(num_px,0);
+    for(int_t i=0;i<num_px;++i){
+      grad_x_16_[i] = static_cast<int16_t>(std::floor(grad_x_[i]/grad_scale_ + 0.5));
+      grad_y_16_[i] = static_cast<int16_t>(std::floor(grad_y_[i]/grad_scale_ + 0.5));
+    }
+  }
+  mask_8_ = buffer_pool::array<uint8_t>(num_px,0);
+  for(int_t i=0;i<num_px;++i)
+    mask_8_[i] = static_cast<uint8_t>(std::floor(std::max(0.0,std::min(1.0,(double)mask_[i]))*255.0 + 0.5));
+  DEBUG_MSG("Image::compact(): " << (intensities_8_.size()>0 ? 8 : 16) << " bit intensities, intensity scale "
+    << intensity_scale_ << ", gradient scale " << grad_scale_);
+  // release the full precision arrays
+  tiles_ = Teuchos::null;
+  intensity_rcp_ = Teuchos::null;
+  intensities_ = Teuchos::null;
+  grad_x_ = Teuchos::null;
+  grad_y_ = Teuchos::null;
+  mask_ = Teuchos::null;
+}
+
+void
+Image::expand(){
+  if(!is_compact()) return;
+  DEBUG_MSG("Image::expand(): restoring full precision storage");
+  const int_t num_px = num_pixels();
+  Teuchos::ArrayRCP<intensity_t> intensities = buffer_pool::array<intensity_t>(num_px,0.0);
+  grad_x_ = buffer_pool::array<scalar_t>(num_px,0.0);
+  grad_y_ = buffer_pool::array<scalar_t>(num_px,0.0);
+  mask_ = buffer_pool::array<scalar_t>(num_px,0.0);
+  for(int_t i=0;i<num_px;++i){
+    intensities[i] = (*this)(i);
+    if(grad_x_16_.size()>0){
+      grad_x_[i] = grad_scale_*grad_x_16_[i];
+      grad_y_[i] = grad_scale_*grad_y_16_[i];
+    }
+    mask_[i] = mask_8_[i]/255.0;
+  }
+  intensities_ = intensities;
+  intensities_8_ = Teuchos::null;
+  intensities_16_ = Teuchos::null;
+  grad_x_16_ = Teuchos::null;
+  grad_y_16_ = Teuchos::null;
+  mask_8_ = Teuchos::null;
+}
+
+void
+Image::interpolate_compact(const Interpolation_Method interp,
+  const scalar_t & local_x,
+  const scalar_t & local_y,
+  intensity_t * intensity_val,
+  scalar_t * grad_x_val,
+  scalar_t * grad_y_val)const{
+  // the higher order interpolants fall back to bilinear near the edges of the image
+  Interpolation_Method method = interp;
+  if(method==KEYS_FOURTH&&(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5))
+    method = BILINEAR;
+  if(method==BICUBIC&&(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0))
+    method = BILINEAR;
+  if(method==BILINEAR&&(local_x<0.0||local_x>=width_-1.5||local_y<0.0||local_y>=height_-1.5)){
+    if(intensity_val) *intensity_val = 0.0;
+    if(grad_x_val) *grad_x_val = 0.0;
+    if(grad_y_val) *grad_y_val = 0.0;
+    return;
+  }
+  const int_t ix = (int_t)local_x;
+  const int_t iy = (int_t)local_y;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  int_t support = 2;
+  int_t x_begin = ix;
+  int_t y_begin = iy;
+  if(method==KEYS_FOURTH){
+    keys_fourth_coeffs(local_x - ix,coeffs_x);
+    keys_fourth_coeffs(local_y - iy,coeffs_y);
+    support = 6;
+    x_begin = ix - 2;
+    y_begin = iy - 2;
+  }
+  else if(method==BICUBIC){
+    bicubic_coeffs(local_x - ix,coeffs_x);
+    bicubic_coeffs(local_y - iy,coeffs_y);
+    support = 4;
+    x_begin = ix - 1;
+    y_begin = iy - 1;
+  }
+  else{
+    coeffs_x[0] = ix + 1 - local_x;
+    coeffs_x[1] = local_x - ix;
+    coeffs_y[0] = iy + 1 - local_y;
+    coeffs_y[1] = local_y - iy;
+  }
+  if(intensity_val){
+    if(intensities_8_.size()>0)
+      *intensity_val = intensity_scale_*compact_sum(intensities_8_.getRawPtr(),width_,support,x_begin,y_begin,coeffs_x,coeffs_y);
+    else
+      *intensity_val = intensity_scale_*compact_sum(intensities_16_.getRawPtr(),width_,support,x_begin,y_begin,coeffs_x,coeffs_y);
+  }
+  if(grad_x_val)
+    *grad_x_val = grad_x_16_.size()>0 ? grad_scale_*compact_sum(grad_x_16_.getRawPtr(),width_,support,x_begin,y_begin,coeffs_x,coeffs_y) : 0.0;
+  if(grad_y_val)
+    *grad_y_val = grad_y_16_.size()>0 ? grad_scale_*compact_sum(grad_y_16_.getRawPtr(),width_,support,x_begin,y_begin,coeffs_x,coeffs_y) : 0.0;
+}
+
 void 
 Image::interpolate_bilinear_all(intensity_t& intensity_val, 
        scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
        const scalar_t& local_x, const scalar_t& local_y) {
+  if(is_compact()){
+    interpolate_compact(BILINEAR,local_x,local_y,&intensity_val,compute_gradient ? &grad_x_val : NULL,compute_gradient ? &grad_y_val : NULL);
+    return;
+  }
   if(local_x<0.0||local_x>=width_-1.5||local_y<0.0||local_y>=height_-1.5) {
     intensity_val = 0.0;
     if (compute_gradient) {
@@ -364,7 +873,11 @@ Image::interpolate_bilinear_all(intensity_t& intensity_val,
 
 intensity_t
 Image::interpolate_bilinear(const scalar_t & local_x, const scalar_t & local_y){
-
+  if(is_compact()){
+    intensity_t value = 0.0;
+    interpolate_compact(BILINEAR,local_x,local_y,&value,NULL,NULL);
+    return value;
+  }
   if(local_x<0.0||local_x>=width_-1.5||local_y<0.0||local_y>=height_-1.5) return 0.0;
   const int_t x1 = (int_t)local_x;
   const int_t x2 = x1+1;
@@ -378,7 +891,11 @@ Image::interpolate_bilinear(const scalar_t & local_x, const scalar_t & local_y){
 
 scalar_t
 Image::interpolate_grad_x_bilinear(const scalar_t & local_x, const scalar_t & local_y){
-
+  if(is_compact()){
+    scalar_t value = 0.0;
+    interpolate_compact(BILINEAR,local_x,local_y,NULL,&value,NULL);
+    return value;
+  }
   if(local_x<0.0||local_x>=width_-1.5||local_y<0.0||local_y>=height_-1.5) return 0.0;
   const int_t x1 = (int_t)local_x;
   const int_t x2 = x1+1;
@@ -392,6 +909,11 @@ Image::interpolate_grad_x_bilinear(const scalar_t & local_x, const scalar_t & lo
 
 scalar_t
 Image::interpolate_grad_y_bilinear(const scalar_t & local_x, const scalar_t & local_y){
+  if(is_compact()){
+    scalar_t value = 0.0;
+    interpolate_compact(BILINEAR,local_x,local_y,NULL,NULL,&value);
+    return value;
+  }
   if(local_x<0.0||local_x>=width_-1.5||local_y<0.0||local_y>=height_-1.5) return 0.0;
   const int_t x1 = (int_t)local_x;
   const int_t x2 = x1+1;
@@ -407,12 +929,17 @@ void
 Image::interpolate_bicubic_all(intensity_t& intensity_val, 
        scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
        const scalar_t& local_x, const scalar_t& local_y) {
+  if(is_compact()){
+    interpolate_compact(BICUBIC,local_x,local_y,&intensity_val,compute_gradient ? &grad_x_val : NULL,compute_gradient ? &grad_y_val : NULL);
+    return;
+  }
   if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) {
     intensity_val = this->interpolate_bilinear(local_x,local_y);
     if (compute_gradient) {
       grad_x_val = this->interpolate_grad_x_bilinear(local_x,local_y);
       grad_y_val = this->interpolate_grad_y_bilinear(local_x,local_y);
     }
+    return;
   }
   const int_t x0  = (int_t)local_x;
   const int_t x1  = x0+1;
@@ -551,6 +1078,11 @@ Image::interpolate_bicubic_all(intensity_t& intensity_val,
 
 intensity_t
 Image::interpolate_bicubic(const scalar_t & local_x, const scalar_t & local_y){
+  if(is_compact()){
+    intensity_t value = 0.0;
+    interpolate_compact(BICUBIC,local_x,local_y,&value,NULL,NULL);
+    return value;
+  }
   if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) return this->interpolate_bilinear(local_x,local_y);
 
   const int_t x0  = (int_t)local_x;
@@ -608,6 +1140,11 @@ Image::interpolate_bicubic(const scalar_t & local_x, const scalar_t & local_y){
 
 scalar_t
 Image::interpolate_grad_x_bicubic(const scalar_t & local_x, const scalar_t & local_y){
+  if(is_compact()){
+    scalar_t value = 0.0;
+    interpolate_compact(BICUBIC,local_x,local_y,NULL,&value,NULL);
+    return value;
+  }
   if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) return this->interpolate_grad_x_bilinear(local_x,local_y);
 
   const int_t x0  = (int_t)local_x;
@@ -665,6 +1202,11 @@ Image::interpolate_grad_x_bicubic(const scalar_t & local_x, const scalar_t & loc
 
 scalar_t
 Image::interpolate_grad_y_bicubic(const scalar_t & local_x, const scalar_t & local_y){
+  if(is_compact()){
+    scalar_t value = 0.0;
+    interpolate_compact(BICUBIC,local_x,local_y,NULL,NULL,&value);
+    return value;
+  }
   if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) return this->interpolate_grad_y_bilinear(local_x,local_y);
 
   const int_t x0  = (int_t)local_x;
@@ -721,179 +1263,283 @@ Image::interpolate_grad_y_bicubic(const scalar_t & local_x, const scalar_t & loc
 }
 
 void
-Image::interpolate_keys_fourth_all(intensity_t& intensity_val, 
+Image::interpolate_keys_fourth_all(intensity_t& intensity_val,
        scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
        const scalar_t& local_x, const scalar_t& local_y) {
-  intensity_val = 0.0;
-  if (compute_gradient) {
-    grad_x_val = 0.0;
-    grad_y_val = 0.0;
-  }
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
-  //static intensity_t value=0.0;
-  static intensity_t cc = 0.0;
-  ix = (int_t)local_x;
-  iy = (int_t)local_y;
+  if(is_compact()){
+    interpolate_compact(KEYS_FOURTH,local_x,local_y,&intensity_val,compute_gradient ? &grad_x_val : NULL,compute_gradient ? &grad_y_val : NULL);
+    return;
+  }
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5) {
     intensity_val  =  this->interpolate_bilinear(local_x,local_y);
     if (compute_gradient) {
       grad_x_val = this->interpolate_grad_x_bilinear(local_x,local_y);
       grad_y_val = this->interpolate_grad_y_bilinear(local_x,local_y);
     }
+    return;
   }
-  dx = local_x - ix;
-  dy = local_y - iy;
-  coeffs_x[0] = keys_f2(dx+2.0);
-  coeffs_x[1] = keys_f1(dx+1.0);
-  coeffs_x[2] = keys_f0(dx);
-  coeffs_x[3] = keys_f0(1.0-dx);
-  coeffs_x[4] = keys_f1(2.0-dx);
-  coeffs_x[5] = keys_f2(3.0-dx);
-  coeffs_y[0] = keys_f2(dy+2.0);
-  coeffs_y[1] = keys_f1(dy+1.0);
-  coeffs_y[2] = keys_f0(dy);
-  coeffs_y[3] = keys_f0(1.0-dy);
-  coeffs_y[4] = keys_f1(2.0-dy);
-  coeffs_y[5] = keys_f2(3.0-dy);
-  //value = 0.0;
-  for(int_t m=0;m<6;++m){
-    for(int_t n=0;n<6;++n){
-      cc = coeffs_y[m]*coeffs_x[n];
-      intensity_val += cc*intensities_[(iy-2+m)*width_ + ix-2+n];
-      if (compute_gradient) {
-        grad_x_val += cc*grad_x_[(iy-2+m)*width_ + ix-2+n];
-        grad_y_val += cc*grad_y_[(iy-2+m)*width_ + ix-2+n];
-      }
-    }
-  }
+  const int_t ix = (int_t)local_x;
+  const int_t iy = (int_t)local_y;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  keys_fourth_coeffs(local_x - ix,coeffs_x);
+  keys_fourth_coeffs(local_y - iy,coeffs_y);
+  if(compute_gradient)
+    intensity_val = keys_fourth_sum_all(intensities_.getRawPtr(),grad_x_.getRawPtr(),grad_y_.getRawPtr(),
+      width_,ix,iy,coeffs_x,coeffs_y,grad_x_val,grad_y_val);
+  else
+    intensity_val = keys_fourth_sum(intensities_.getRawPtr(),width_,ix,iy,coeffs_x,coeffs_y);
 }
 
-
 intensity_t
 Image::interpolate_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
-  static intensity_t value=0.0;
-  ix = (int_t)local_x;
-  iy = (int_t)local_y;
+  if(is_compact()){
+    intensity_t value = 0.0;
+    interpolate_compact(KEYS_FOURTH,local_x,local_y,&value,NULL,NULL);
+    return value;
+  }
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5)
     return this->interpolate_bilinear(local_x,local_y);
-  dx = local_x - ix;
-  dy = local_y - iy;
-  coeffs_x[0] = keys_f2(dx+2.0);
-  coeffs_x[1] = keys_f1(dx+1.0);
-  coeffs_x[2] = keys_f0(dx);
-  coeffs_x[3] = keys_f0(1.0-dx);
-  coeffs_x[4] = keys_f1(2.0-dx);
-  coeffs_x[5] = keys_f2(3.0-dx);
-  coeffs_y[0] = keys_f2(dy+2.0);
-  coeffs_y[1] = keys_f1(dy+1.0);
-  coeffs_y[2] = keys_f0(dy);
-  coeffs_y[3] = keys_f0(1.0-dy);
-  coeffs_y[4] = keys_f1(2.0-dy);
-  coeffs_y[5] = keys_f2(3.0-dy);
-  value = 0.0;
-  for(int_t m=0;m<6;++m){
-    for(int_t n=0;n<6;++n){
-      value += coeffs_y[m]*coeffs_x[n]*intensities_[(iy-2+m)*width_ + ix-2+n];
-    }
-  }
-  return value;
+  const int_t ix = (int_t)local_x;
+  const int_t iy = (int_t)local_y;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  keys_fourth_coeffs(local_x - ix,coeffs_x);
+  keys_fourth_coeffs(local_y - iy,coeffs_y);
+  return keys_fourth_sum(intensities_.getRawPtr(),width_,ix,iy,coeffs_x,coeffs_y);
 }
 
 scalar_t
 Image::interpolate_grad_x_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
-  static intensity_t value=0.0;
-  ix = (int_t)local_x;
-  iy = (int_t)local_y;
+  if(is_compact()){
+    scalar_t value = 0.0;
+    interpolate_compact(KEYS_FOURTH,local_x,local_y,NULL,&value,NULL);
+    return value;
+  }
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5)
     return this->interpolate_grad_x_bilinear(local_x,local_y);
-  dx = local_x - ix;
-  dy = local_y - iy;
-  coeffs_x[0] = keys_f2(dx+2.0);
-  coeffs_x[1] = keys_f1(dx+1.0);
-  coeffs_x[2] = keys_f0(dx);
-  coeffs_x[3] = keys_f0(1.0-dx);
-  coeffs_x[4] = keys_f1(2.0-dx);
-  coeffs_x[5] = keys_f2(3.0-dx);
-  coeffs_y[0] = keys_f2(dy+2.0);
-  coeffs_y[1] = keys_f1(dy+1.0);
-  coeffs_y[2] = keys_f0(dy);
-  coeffs_y[3] = keys_f0(1.0-dy);
-  coeffs_y[4] = keys_f1(2.0-dy);
-  coeffs_y[5] = keys_f2(3.0-dy);
-  value = 0.0;
-  for(int_t m=0;m<6;++m){
-    for(int_t n=0;n<6;++n){
-      value += coeffs_y[m]*coeffs_x[n]*grad_x_[(iy-2+m)*width_ + ix-2+n];
-    }
-  }
-  return value;
+  const int_t ix = (int_t)local_x;
+  const int_t iy = (int_t)local_y;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  keys_fourth_coeffs(local_x - ix,coeffs_x);
+  keys_fourth_coeffs(local_y - iy,coeffs_y);
+  return keys_fourth_sum(grad_x_.getRawPtr(),width_,ix,iy,coeffs_x,coeffs_y);
 }
 
 scalar_t
 Image::interpolate_grad_y_keys_fourth(const scalar_t & local_x, const scalar_t & local_y){
-  static std::vector<scalar_t> coeffs_x(6,0.0);
-  static std::vector<scalar_t> coeffs_y(6,0.0);
-  static scalar_t dx = 0.0;
-  static scalar_t dy = 0.0;
-  static int_t ix=0,iy=0;
-  static intensity_t value=0.0;
-  ix = (int_t)local_x;
-  iy = (int_t)local_y;
+  if(is_compact()){
+    scalar_t value = 0.0;
+    interpolate_compact(KEYS_FOURTH,local_x,local_y,NULL,NULL,&value);
+    return value;
+  }
   if(local_x<=2.5||local_x>=width_-3.5||local_y<=2.5||local_y>=height_-3.5)
     return this->interpolate_grad_y_bilinear(local_x,local_y);
-  dx = local_x - ix;
-  dy = local_y - iy;
-  coeffs_x[0] = keys_f2(dx+2.0);
-  coeffs_x[1] = keys_f1(dx+1.0);
-  coeffs_x[2] = keys_f0(dx);
-  coeffs_x[3] = keys_f0(1.0-dx);
-  coeffs_x[4] = keys_f1(2.0-dx);
-  coeffs_x[5] = keys_f2(3.0-dx);
-  coeffs_y[0] = keys_f2(dy+2.0);
-  coeffs_y[1] = keys_f1(dy+1.0);
-  coeffs_y[2] = keys_f0(dy);
-  coeffs_y[3] = keys_f0(1.0-dy);
-  coeffs_y[4] = keys_f1(2.0-dy);
-  coeffs_y[5] = keys_f2(3.0-dy);
-  value = 0.0;
-  for(int_t m=0;m<6;++m){
-    for(int_t n=0;n<6;++n){
-      value += coeffs_y[m]*coeffs_x[n]*grad_y_[(iy-2+m)*width_ + ix-2+n];
+  const int_t ix = (int_t)local_x;
+  const int_t iy = (int_t)local_y;
+  scalar_t coeffs_x[6];
+  scalar_t coeffs_y[6];
+  keys_fourth_coeffs(local_x - ix,coeffs_x);
+  keys_fourth_coeffs(local_y - iy,coeffs_y);
+  return keys_fourth_sum(grad_y_.getRawPtr(),width_,ix,iy,coeffs_x,coeffs_y);
+}
+
+void
+Image::compute_bspline_coefficients(){
+  std::lock_guard<std::mutex> lock(bspline_mutex_);
+  publish_bspline_coefficients();
+}
+
+void
+Image::publish_bspline_coefficients(){
+  profiler::Scope scope(profiler::IMAGE_FILTER);
+  DEBUG_MSG("Image::compute_bspline_coefficients(): prefiltering " << width_ << " x " << height_ << " image");
+  // filled off to the side, readers only see the array once the flag is set
+  Teuchos::ArrayRCP<scalar_t> coeffs_array = buffer_pool::array<scalar_t>(num_pixels(),0.0);
+  scalar_t * coeffs = coeffs_array.getRawPtr();
+  for(int_t i=0;i<num_pixels();++i)
+    coeffs[i] = (*this)(i);
+  std::vector<scalar_t> work(std::max(width_,1));
+  // rows
+  for(int_t y=0;y<height_;++y)
+    bspline_prefilter(coeffs + y*width_,width_,1,1,&work[0]);
+  // columns (all at once)
+  bspline_prefilter(coeffs,height_,width_,width_,&work[0]);
+  bspline_coeffs_ = coeffs_array;
+  bspline_ready_.store(true,std::memory_order_release);
+}
+
+void
+Image::compute_tiled_layout(){
+  TEUCHOS_TEST_FOR_EXCEPTION(is_compact(),std::runtime_error,"Error, the tiled layout is not available for compact images");
+  const int_t num_tiles_x = (width_ + tile_size - 1)/tile_size;
+  const int_t num_tiles_y = (height_ + tile_size - 1)/tile_size;
+  const int_t num_tiles = num_tiles_x*num_tiles_y;
+  DEBUG_MSG("Image::compute_tiled_layout(): " << num_tiles_x << " x " << num_tiles_y << " tiles");
+  tiles_ = buffer_pool::array<scalar_t>(num_tiles*tile_values,0.0);
+  scalar_t * tiles = tiles_.getRawPtr();
+  const intensity_t * intens = intensities_.getRawPtr();
+  const scalar_t * gx = grad_x_.getRawPtr();
+  const scalar_t * gy = grad_y_.getRawPtr();
+  const bool parallel = num_pixels()>=fused_min_parallel_pixels;
+  const int pool_size = kernel_num_threads(num_threads_);
+  (void)parallel;
+  (void)pool_size;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(pool_size) if(parallel)
+#endif
+  for(int_t tile=0;tile<num_tiles;++tile){
+    // the first pixel stored in the tile (the tiles overlap and the pixels outside the image stay zero)
+    const int_t x0 = (tile%num_tiles_x)*tile_size - 2;
+    const int_t y0 = (tile/num_tiles_x)*tile_size - 2;
+    const int_t x_begin = std::max(0,x0);
+    const int_t x_end = std::min(width_,x0 + tile_stride);
+    scalar_t * tile_intens = tiles + tile*tile_values;
+    scalar_t * tile_gx = tile_intens + tile_stride*tile_stride;
+    scalar_t * tile_gy = tile_gx + tile_stride*tile_stride;
+    for(int_t y=std::max(0,y0);y<std::min(height_,y0 + tile_stride);++y){
+      const int_t tile_row = (y - y0)*tile_stride - x0;
+      const int_t row = y*width_;
+      for(int_t x=x_begin;x<x_end;++x){
+        tile_intens[tile_row + x] = intens[row + x];
+        tile_gx[tile_row + x] = gx[row + x];
+        tile_gy[tile_row + x] = gy[row + x];
+      }
     }
   }
-  return value;
 }
 
 void
-Image::compute_gradients(const bool use_hierarchical_parallelism, const int_t team_size){
-  if(gradient_method_==FINITE_DIFFERENCE){
-    DEBUG_MSG("Image::compute_gradients(): using FINITE_DIFFERENCE");
-    compute_gradients_finite_difference();
+Image::interpolate_bspline_all(intensity_t& intensity_val,
+       scalar_t& grad_x_val, scalar_t& grad_y_val, const bool compute_gradient,
+       const scalar_t& local_x, const scalar_t& local_y) {
+  if(!has_bspline_coefficients()){
+    // more than one thread may be interpolating this image at the same time (OpenMP or std::thread)
+    std::lock_guard<std::mutex> lock(bspline_mutex_);
+    if(!bspline_ready_.load(std::memory_order_relaxed))
+      publish_bspline_coefficients();
   }
-  else if(gradient_method_==CONVOLUTION_5_POINT){
-    DEBUG_MSG("Image::compute_gradients(): using CONVOLUTION_5_POINT");
-    compute_gradients_finite_difference();
-    smooth_gradients_convolution_5_point();
+  if(local_x<1.0||local_x>=width_-2.0||local_y<1.0||local_y>=height_-2.0) {
+    interpolate_bilinear_all(intensity_val,grad_x_val,grad_y_val,compute_gradient,local_x,local_y);
+    return;
   }
-  has_gradients_ = true;
+  const int_t ix = (int_t)local_x;
+  const int_t iy = (int_t)local_y;
+  scalar_t w_x[4], dw_x[4], w_y[4], dw_y[4];
+  bspline_weights(local_x - ix,w_x,dw_x);
+  bspline_weights(local_y - iy,w_y,dw_y);
+  intensity_val = bspline_sum(bspline_coeffs_.getRawPtr(),width_,ix-1,iy-1,w_x,dw_x,w_y,dw_y,compute_gradient,grad_x_val,grad_y_val);
+}
+
+void
+Image::interpolate_all(const int_t num_points,
+  const scalar_t * local_x,
+  const scalar_t * local_y,
+  const bool * skip,
+  intensity_t * intensity_vals,
+  scalar_t * grad_x_vals,
+  scalar_t * grad_y_vals,
+  const bool compute_gradient,
+  const Interpolation_Method interp){
+  // the spline coefficients are always full precision so compact images use the same path
+  if(is_compact()&&interp!=BSPLINE_CUBIC){
+    TEUCHOS_TEST_FOR_EXCEPTION(interp!=KEYS_FOURTH&&interp!=BICUBIC&&interp!=BILINEAR,std::invalid_argument,
+      "Error, unknown interpolation method requested");
+    for(int_t i=0;i<num_points;++i){
+      if(skip&&skip[i]) continue;
+      interpolate_compact(interp,local_x[i],local_y[i],&intensity_vals[i],
+        compute_gradient ? &grad_x_vals[i] : NULL,compute_gradient ? &grad_y_vals[i] : NULL);
+    }
+    return;
+  }
+  if(interp==KEYS_FOURTH&&has_tiled_layout()){
+    const scalar_t * tiles = tiles_.getRawPtr();
+    const int_t num_tiles_x = (width_ + tile_size - 1)/tile_size;
+    scalar_t coeffs_x[6];
+    scalar_t coeffs_y[6];
+    for(int_t i=0;i<num_points;++i){
+      if(skip&&skip[i]) continue;
+      const scalar_t x = local_x[i];
+      const scalar_t y = local_y[i];
+      if(x<=2.5||x>=width_-3.5||y<=2.5||y>=height_-3.5){
+        interpolate_keys_fourth_all(intensity_vals[i],grad_x_vals[i],grad_y_vals[i],compute_gradient,x,y);
+        continue;
+      }
+      const int_t ix = (int_t)x;
+      const int_t iy = (int_t)y;
+      keys_fourth_coeffs(x - ix,coeffs_x);
+      keys_fourth_coeffs(y - iy,coeffs_y);
+      // the 6x6 neighborhood is entirely inside the tile that holds pixel (ix,iy)
+      const scalar_t * tile = tiles + ((iy/tile_size)*num_tiles_x + ix/tile_size)*tile_values;
+      const int_t tx = ix%tile_size + 2;
+      const int_t ty = iy%tile_size + 2;
+      intensity_vals[i] = keys_fourth_sum(tile,tile_stride,tx,ty,coeffs_x,coeffs_y);
+      if(compute_gradient){
+        grad_x_vals[i] = keys_fourth_sum(tile + tile_stride*tile_stride,tile_stride,tx,ty,coeffs_x,coeffs_y);
+        grad_y_vals[i] = keys_fourth_sum(tile + 2*tile_stride*tile_stride,tile_stride,tx,ty,coeffs_x,coeffs_y);
+      }
+    }
+  }
+  else if(interp==KEYS_FOURTH){
+    const intensity_t * intens = intensities_.getRawPtr();
+    const scalar_t * gx = grad_x_.getRawPtr();
+    const scalar_t * gy = grad_y_.getRawPtr();
+    scalar_t coeffs_x[6];
+    scalar_t coeffs_y[6];
+    for(int_t i=0;i<num_points;++i){
+      if(skip&&skip[i]) continue;
+      const scalar_t x = local_x[i];
+      const scalar_t y = local_y[i];
+      if(x<=2.5||x>=width_-3.5||y<=2.5||y>=height_-3.5){
+        interpolate_keys_fourth_all(intensity_vals[i],grad_x_vals[i],grad_y_vals[i],compute_gradient,x,y);
+        continue;
+      }
+      const int_t ix = (int_t)x;
+      const int_t iy = (int_t)y;
+      keys_fourth_coeffs(x - ix,coeffs_x);
+      keys_fourth_coeffs(y - iy,coeffs_y);
+      if(compute_gradient)
+        intensity_vals[i] = keys_fourth_sum_all(intens,gx,gy,width_,ix,iy,coeffs_x,coeffs_y,grad_x_vals[i],grad_y_vals[i]);
+      else
+        intensity_vals[i] = keys_fourth_sum(intens,width_,ix,iy,coeffs_x,coeffs_y);
+    }
+  }
+  else if(interp==BICUBIC){
+    for(int_t i=0;i<num_points;++i){
+      if(skip&&skip[i]) continue;
+      interpolate_bicubic_all(intensity_vals[i],grad_x_vals[i],grad_y_vals[i],compute_gradient,local_x[i],local_y[i]);
+    }
+  }
+  else if(interp==BILINEAR){
+    for(int_t i=0;i<num_points;++i){
+      if(skip&&skip[i]) continue;
+      interpolate_bilinear_all(intensity_vals[i],grad_x_vals[i],grad_y_vals[i],compute_gradient,local_x[i],local_y[i]);
+    }
+  }
+  else if(interp==BSPLINE_CUBIC){
+    for(int_t i=0;i<num_points;++i){
+      if(skip&&skip[i]) continue;
+      interpolate_bspline_all(intensity_vals[i],grad_x_vals[i],grad_y_vals[i],compute_gradient,local_x[i],local_y[i]);
+    }
+  }
+  else{
+    TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,
+      "Error, unknown interpolation method requested");
+  }
+}
+
+void
+Image::compute_gradients(const bool use_hierarchical_parallelism, const int_t team_size){
+  // the finite difference stencil (and the smoothing for CONVOLUTION_5_POINT) is done in one sweep
+  filter_and_compute_gradients(false,true);
 }
 
 void
 Image::smooth_gradients_convolution_5_point(){
+  TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, smoothing the gradients is not allowed for an image with adopted (shared) arrays");
+  expand();
+  tiles_ = Teuchos::null;
 
   static scalar_t smooth_coeffs[][5] = {{0.00390625, 0.015625, 0.0234375, 0.015625, 0.00390625},
                                         {0.015625,   0.0625,   0.09375,   0.0625,   0.015625},
@@ -925,6 +1571,9 @@ Image::smooth_gradients_convolution_5_point(){
 
 void
 Image::compute_gradients_finite_difference(){
+  TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, computing the gradients is not allowed for an image with adopted (shared) arrays");
+  expand();
+  tiles_ = Teuchos::null;
   for(int_t y=0;y<height_;++y){
     for(int_t x=0;x<width_;++x){
       if(x<2){
@@ -957,14 +1606,22 @@ Image::compute_gradients_finite_difference(){
 void
 Image::apply_mask(const Conformal_Area_Def & area_def,
   const bool smooth_edges){
+  TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, applying a mask is not allowed for an image with adopted (shared) arrays");
   // first create the mask:
   create_mask(area_def,smooth_edges);
+  discard_bspline_coefficients();
+  tiles_ = Teuchos::null;
   for(int_t i=0;i<num_pixels();++i)
     intensities_[i] = mask_[i]*intensities_[i];
 }
 
 void
 Image::apply_mask(const bool smooth_edges){
+  TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, applying a mask is not allowed for an image with adopted (shared) arrays");
+  pyramid_.clear();
+  discard_bspline_coefficients();
+  tiles_ = Teuchos::null;
+  expand();
   if(smooth_edges){
     static scalar_t smoothing_coeffs[5][5];
     std::vector<scalar_t> coeffs(5,0.0);
@@ -1002,7 +1659,9 @@ Image::apply_mask(const bool smooth_edges){
 void
 Image::create_mask(const Conformal_Area_Def & area_def,
   const bool smooth_edges){
+  TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, creating a mask is not allowed for an image with adopted (shared) arrays");
   assert(area_def.has_boundary());
+  expand();
   std::set<std::pair<int_t,int_t> > coords;
   for(size_t i=0;i<area_def.boundary()->size();++i){
     std::set<std::pair<int_t,int_t> > shapeCoords = (*area_def.boundary())[i]->get_owned_pixels();
@@ -1064,6 +1723,11 @@ Image::apply_transformation(Teuchos::RCP<Local_Shape_Function> shape_function,
   const bool apply_in_place){
   Teuchos::RCP<Image> this_img = Teuchos::rcp(this,false);
   if(apply_in_place){
+    TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, transforming the image in place is not allowed for an image with adopted (shared) arrays");
+    pyramid_.clear();
+    discard_bspline_coefficients();
+    tiles_ = Teuchos::null;
+    expand();
     Teuchos::RCP<Image> temp_img = Teuchos::rcp(new Image(this_img));
     apply_transform(temp_img,this_img,cx,cy,shape_function);
     return Teuchos::null;
@@ -1075,40 +1739,38 @@ Image::apply_transformation(Teuchos::RCP<Local_Shape_Function> shape_function,
   }
 }
 
-void
-Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelism,
-  const int_t team_size){
-  DEBUG_MSG("Image::gauss_filter: mask_size " << gauss_filter_mask_size_);
-
-  if(mask_size>0){
-    gauss_filter_mask_size_=mask_size;
-    gauss_filter_half_mask_ = gauss_filter_mask_size_/2+1;
-  }
+/// number of rows in each band of the fused filter and gradient sweep (each band is streamed
+/// through a few rows of scratch space so the working set stays in cache)
+static const int_t fused_band_height = 64;
 
-  std::vector<scalar_t> coeffs(13,0.0);
+/// the 5 point gradient smoothing convolution is the outer product of these coefficients
+static const scalar_t smooth_coeffs_1d[] = {0.0625, 0.25, 0.375, 0.25, 0.0625};
 
-  // make sure the mask size is appropriate
-  if(gauss_filter_mask_size_==5){
+/// one dimensional Gauss filter coefficients (the 2D mask is the outer product)
+/// \param mask_size the size of the mask (5,7,9,11, or 13)
+static std::vector<scalar_t> gauss_filter_coeffs_1d(const int_t mask_size){
+  std::vector<scalar_t> coeffs(mask_size,0.0);
+  if(mask_size==5){
     coeffs[0] = 0.0014;coeffs[1] = 0.1574;coeffs[2] = 0.62825;
     coeffs[3] = 0.1574;coeffs[4] = 0.0014;
   }
-  else if (gauss_filter_mask_size_==7){
+  else if (mask_size==7){
     coeffs[0] = 0.0060;coeffs[1] = 0.0606;coeffs[2] = 0.2418;
     coeffs[3] = 0.3831;coeffs[4] = 0.2418;coeffs[5] = 0.0606;
     coeffs[6] = 0.0060;
   }
-  else if (gauss_filter_mask_size_==9){
+  else if (mask_size==9){
     coeffs[0] = 0.0007;coeffs[1] = 0.0108;coeffs[2] = 0.0748;
     coeffs[3] = 0.2384;coeffs[4] = 0.3505;coeffs[5] = 0.2384;
     coeffs[6] = 0.0748;coeffs[7] = 0.0108;coeffs[8] = 0.0007;
   }
-  else if (gauss_filter_mask_size_==11){
+  else if (mask_size==11){
     coeffs[0] = 0.0001;coeffs[1] = 0.0017;coeffs[2] = 0.0168;
     coeffs[3] = 0.0870;coeffs[4] = 0.2328;coeffs[5] = 0.3231;
     coeffs[6] = 0.2328;coeffs[7] = 0.0870;coeffs[8] = 0.0168;
     coeffs[9] = 0.0017;coeffs[10] = 0.0001;
   }
-  else if (gauss_filter_mask_size_==13){
+  else if (mask_size==13){
     coeffs[0] = 0.0001;coeffs[1] = 0.0012;coeffs[2] = 0.0085;
     coeffs[3] = 0.0380;coeffs[4] = 0.1109;coeffs[5] = 0.2108;
     coeffs[6] = 0.2611;coeffs[7] = 0.2108;coeffs[8] = 0.1109;
@@ -1119,33 +1781,278 @@ Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelis
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,
       "Error, the Gauss filter mask size is invalid (options include 5,7,9,11,13)");
   }
-  TEUCHOS_TEST_FOR_EXCEPTION(width_<gauss_filter_mask_size_||height_<gauss_filter_mask_size_,std::runtime_error,
-    "Error, image too small (" << width_ << " x " << height_ << ") for gauss filtering with mask size " << gauss_filter_mask_size_);
+  return coeffs;
+}
 
-  // copy over the old intensities
-  for(int_t i=0;i<num_pixels();++i)
-    intensities_temp_[i] = intensities_[i];
+/// stream the rows [y_begin,y_end) of an image through the (separable) Gauss filter, the finite difference
+/// gradient stencil, and the 5 point gradient smoothing in a single pass. The result is the same (up to round off)
+/// as calling gauss_filter(), compute_gradients_finite_difference() and smooth_gradients_convolution_5_point()
+/// one after the other, including the treatment of the pixels near the edges of the image.
+/// Source rows outside the band are read from the halo arrays since the neighboring bands may
+/// be filtering them in place at the same time.
+/// \param width the image width
+/// \param height the image height
+/// \param y_begin the first row of the band
+/// \param y_end one past the last row of the band
+/// \param intensities the image intensities (filtered in place)
+/// \param halo_above copy of the unfiltered rows [halo_above_begin,y_begin)
+/// \param halo_above_begin the first row stored in halo_above
+/// \param halo_below copy of the unfiltered rows starting at y_end
+/// \param grad_x [out] the x gradients
+/// \param grad_y [out] the y gradients
+/// \param gauss_coeffs the one dimensional Gauss filter coefficients
+/// \param filter true if the intensities should be filtered
+/// \param gradients true if the gradients should be computed
+/// \param smooth true if the gradients should be smoothed
+/// \param grad_c1 first finite difference coefficient
+/// \param grad_c2 second finite difference coefficient
+static void fused_filter_gradient_band(const int_t width,
+  const int_t height,
+  const int_t y_begin,
+  const int_t y_end,
+  intensity_t * intensities,
+  const std::vector<intensity_t> & halo_above,
+  const int_t halo_above_begin,
+  const std::vector<intensity_t> & halo_below,
+  scalar_t * grad_x,
+  scalar_t * grad_y,
+  const std::vector<scalar_t> & gauss_coeffs,
+  const bool filter,
+  const bool gradients,
+  const bool smooth,
+  const scalar_t & grad_c1,
+  const scalar_t & grad_c2){
+  const int_t mask_size = gauss_coeffs.size();
+  const int_t radius = mask_size/2;
+  // pixels closer than this to the edge of the image are not filtered (same as the 2D convolution)
+  const int_t filter_edge = radius + 1;
+  const int_t x_filter_begin = filter_edge;
+  const int_t x_filter_end = std::max(filter_edge,width - filter_edge);
+  // extra rows of filtered intensities needed by the gradient and smoothing stencils
+  const int_t halo = !gradients ? 0 : smooth ? 4 : 2;
+  const int_t f_begin = std::max(0,y_begin-halo);
+  const int_t f_end = std::min(height,y_end+halo);
+  const int_t g_begin = smooth ? std::max(0,y_begin-2) : y_begin;
+  const int_t g_end = smooth ? std::min(height,y_end+2) : y_end;
 
-  for(int_t j=0;j<gauss_filter_mask_size_;++j){
-    for(int_t i=0;i<gauss_filter_mask_size_;++i){
-      gauss_filter_coeffs_[i][j] = coeffs[i]*coeffs[j];
+  // the source rows are only modified when filtering, otherwise they can all be read in place
+  auto source_row = [&](const int_t y)->const intensity_t *{
+    if(filter&&y<y_begin) return &halo_above[(y-halo_above_begin)*width];
+    if(filter&&y>=y_end) return &halo_below[(y-y_end)*width];
+    return intensities + y*width;
+  };
+  // ring of horizontally filtered rows
+  std::vector<intensity_t> h_ring(filter ? mask_size*width : 0);
+  // ring of filtered rows for the gradient stencil
+  const int_t ring_size = 5;
+  std::vector<intensity_t> f_ring(ring_size*width);
+  // ring of gradient rows for the smoothing stencil
+  std::vector<scalar_t> gx_ring(smooth ? ring_size*width : 0);
+  std::vector<scalar_t> gy_ring(smooth ? ring_size*width : 0);
+  std::vector<scalar_t> gx_col(smooth ? width : 0);
+  std::vector<scalar_t> gy_col(smooth ? width : 0);
+  auto f_row = [&](const int_t y)->const intensity_t *{return &f_ring[(y%ring_size)*width];};
+  auto gx_row = [&](const int_t y)->scalar_t *{return smooth ? &gx_ring[(y%ring_size)*width] : grad_x + y*width;};
+  auto gy_row = [&](const int_t y)->scalar_t *{return smooth ? &gy_ring[(y%ring_size)*width] : grad_y + y*width;};
+
+  int_t next_h = 0; // next source row for the horizontal filter pass
+  int_t next_g = g_begin; // next gradient row
+  int_t next_s = y_begin; // next smoothed gradient row
+  for(int_t y=f_begin;y<f_end;++y){
+    intensity_t * f = &f_ring[(y%ring_size)*width];
+    const intensity_t * src = source_row(y);
+    if(filter&&y>=filter_edge&&y<height-filter_edge){
+      // horizontal pass for the source rows that are not in the ring yet
+      next_h = std::max(next_h,y-radius);
+      for(;next_h<=y+radius;++next_h){
+        const intensity_t * h_src = source_row(next_h);
+        intensity_t * h = &h_ring[(next_h%mask_size)*width];
+        DICE_SIMD_LOOP
+        for(int_t x=x_filter_begin;x<x_filter_end;++x){
+          intensity_t value = 0.0;
+          for(int_t i=0;i<mask_size;++i)
+            value += gauss_coeffs[i]*h_src[x+i-radius];
+          h[x] = value;
+        }
+      }
+      // vertical pass
+      for(int_t x=0;x<x_filter_begin;++x)
+        f[x] = src[x];
+      for(int_t x=x_filter_end;x<width;++x)
+        f[x] = src[x];
+      DICE_SIMD_LOOP
+      for(int_t x=x_filter_begin;x<x_filter_end;++x)
+        f[x] = 0.0;
+      for(int_t j=0;j<mask_size;++j){
+        const intensity_t * h = &h_ring[((y+j-radius)%mask_size)*width];
+        const intensity_t c = gauss_coeffs[j];
+        DICE_SIMD_LOOP
+        for(int_t x=x_filter_begin;x<x_filter_end;++x)
+          f[x] += c*h[x];
+      }
     }
-  }
-  for(int_t y=0;y<height_;++y){
-    for(int_t x=0;x<width_;++x){
-      if(x>=gauss_filter_half_mask_&&x<width_-gauss_filter_half_mask_&&y>=gauss_filter_half_mask_&&y<height_-gauss_filter_half_mask_){
-        intensity_t value = 0.0;
-        for(int_t i=0;i<gauss_filter_mask_size_;++i){
-          for(int_t j=0;j<gauss_filter_mask_size_;++j){
-            // assumes intensity values have already been deep copied into intensities_temp_
-            value += gauss_filter_coeffs_[i][j]*intensities_temp_[(y+(j-gauss_filter_half_mask_+1))*width_+x+(i-gauss_filter_half_mask_+1)];
-          } //j
-        } //i
-        intensities_[y*width_+x] = value;
+    else{
+      std::copy(src,src+width,f);
+    }
+    if(filter&&y>=y_begin&&y<y_end)
+      std::copy(f,f+width,intensities+y*width);
+    if(!gradients) continue;
+
+    // gradients for the rows that have their full stencil available
+    for(;next_g<g_end&&std::min(height-1,next_g+2)<=y;++next_g){
+      const int_t gy = next_g;
+      const intensity_t * f0 = f_row(gy);
+      scalar_t * gx_out = gx_row(gy);
+      scalar_t * gy_out = gy_row(gy);
+      for(int_t x=0;x<std::min(2,width);++x)
+        gx_out[x] = f0[x+1] - f0[x];
+      for(int_t x=std::max(2,width-2);x<width;++x)
+        gx_out[x] = f0[x] - f0[x-1];
+      DICE_SIMD_LOOP
+      for(int_t x=2;x<width-2;++x)
+        gx_out[x] = grad_c1*f0[x-2] + grad_c2*f0[x-1] - grad_c2*f0[x+1] - grad_c1*f0[x+2];
+      if(gy<2){
+        const intensity_t * fp1 = f_row(gy+1);
+        DICE_SIMD_LOOP
+        for(int_t x=0;x<width;++x)
+          gy_out[x] = fp1[x] - f0[x];
+      }
+      else if(gy>=height-2){
+        const intensity_t * fm1 = f_row(gy-1);
+        DICE_SIMD_LOOP
+        for(int_t x=0;x<width;++x)
+          gy_out[x] = f0[x] - fm1[x];
+      }
+      else{
+        const intensity_t * fm2 = f_row(gy-2);
+        const intensity_t * fm1 = f_row(gy-1);
+        const intensity_t * fp1 = f_row(gy+1);
+        const intensity_t * fp2 = f_row(gy+2);
+        DICE_SIMD_LOOP
+        for(int_t x=0;x<width;++x)
+          gy_out[x] = grad_c1*fm2[x] + grad_c2*fm1[x] - grad_c2*fp1[x] - grad_c1*fp2[x];
       }
+      if(!smooth) continue;
+
+      // smoothing for the rows that have their full stencil available
+      for(;next_s<y_end&&((next_s>=2&&next_s<height-2) ? next_s+2 : next_s)<=gy;++next_s){
+        const int_t sy = next_s;
+        const scalar_t * gx0 = gx_row(sy);
+        const scalar_t * gy0 = gy_row(sy);
+        scalar_t * gx_out_s = grad_x + sy*width;
+        scalar_t * gy_out_s = grad_y + sy*width;
+        if(sy<2||sy>=height-2){
+          std::copy(gx0,gx0+width,gx_out_s);
+          std::copy(gy0,gy0+width,gy_out_s);
+          continue;
+        }
+        // vertical pass
+        DICE_SIMD_LOOP
+        for(int_t x=0;x<width;++x){
+          gx_col[x] = 0.0;
+          gy_col[x] = 0.0;
+        }
+        for(int_t j=0;j<5;++j){
+          const scalar_t * gxj = gx_row(sy+j-2);
+          const scalar_t * gyj = gy_row(sy+j-2);
+          const scalar_t c = smooth_coeffs_1d[j];
+          DICE_SIMD_LOOP
+          for(int_t x=0;x<width;++x){
+            gx_col[x] += c*gxj[x];
+            gy_col[x] += c*gyj[x];
+          }
+        }
+        // horizontal pass (the two pixels nearest the left and right edges are not smoothed)
+        for(int_t x=0;x<std::min(2,width);++x){
+          gx_out_s[x] = gx0[x];
+          gy_out_s[x] = gy0[x];
+        }
+        for(int_t x=std::max(2,width-2);x<width;++x){
+          gx_out_s[x] = gx0[x];
+          gy_out_s[x] = gy0[x];
+        }
+        DICE_SIMD_LOOP
+        for(int_t x=2;x<width-2;++x){
+          gx_out_s[x] = smooth_coeffs_1d[0]*gx_col[x-2] + smooth_coeffs_1d[1]*gx_col[x-1] + smooth_coeffs_1d[2]*gx_col[x]
+            + smooth_coeffs_1d[3]*gx_col[x+1] + smooth_coeffs_1d[4]*gx_col[x+2];
+          gy_out_s[x] = smooth_coeffs_1d[0]*gy_col[x-2] + smooth_coeffs_1d[1]*gy_col[x-1] + smooth_coeffs_1d[2]*gy_col[x]
+            + smooth_coeffs_1d[3]*gy_col[x+1] + smooth_coeffs_1d[4]*gy_col[x+2];
+        }
+      } // smoothed rows
+    } // gradient rows
+  } // filtered rows
+}
+
+void
+Image::gauss_filter(const int_t mask_size,const bool use_hierarchical_parallelism,
+  const int_t team_size){
+  filter_and_compute_gradients(true,false,mask_size);
+}
+
+void
+Image::filter_and_compute_gradients(const bool apply_gauss_filter,
+  const bool apply_gradients,
+  const int_t mask_size){
+  if(!apply_gauss_filter&&!apply_gradients) return;
+  TEUCHOS_TEST_FOR_EXCEPTION(is_adopted_,std::runtime_error,"Error, filtering the image or computing the gradients is not allowed for an image with adopted (shared) arrays");
+  expand();
+  tiles_ = Teuchos::null;
+  profiler::Scope scope(apply_gauss_filter ? profiler::IMAGE_FILTER : profiler::IMAGE_GRADIENTS);
+  std::vector<scalar_t> coeffs;
+  if(apply_gauss_filter){
+    pyramid_.clear();
+    discard_bspline_coefficients();
+    if(mask_size>0){
+      gauss_filter_mask_size_=mask_size;
+      gauss_filter_half_mask_ = gauss_filter_mask_size_/2+1;
     }
+    DEBUG_MSG("Image::filter_and_compute_gradients(): mask_size " << gauss_filter_mask_size_);
+    coeffs = gauss_filter_coeffs_1d(gauss_filter_mask_size_);
+    TEUCHOS_TEST_FOR_EXCEPTION(width_<gauss_filter_mask_size_||height_<gauss_filter_mask_size_,std::runtime_error,
+      "Error, image too small (" << width_ << " x " << height_ << ") for gauss filtering with mask size " << gauss_filter_mask_size_);
+    for(int_t j=0;j<gauss_filter_mask_size_;++j){
+      for(int_t i=0;i<gauss_filter_mask_size_;++i){
+        gauss_filter_coeffs_[i][j] = coeffs[i]*coeffs[j];
+      }
+    }
+  }
+  const bool smooth = apply_gradients&&gradient_method_==CONVOLUTION_5_POINT;
+  DEBUG_MSG("Image::filter_and_compute_gradients(): filter " << apply_gauss_filter << " gradients " << apply_gradients << " smooth " << smooth);
+
+  // the image is split into bands of rows, since the filter is applied in place, the unfiltered
+  // rows each band reads from its neighbors are copied before any of the bands are processed
+  const int_t reach = apply_gauss_filter ? gauss_filter_mask_size_/2 + (!apply_gradients ? 0 : smooth ? 4 : 2) : 0;
+  const int_t num_bands = (height_ + fused_band_height - 1)/fused_band_height;
+  std::vector<std::vector<intensity_t> > halos_above(num_bands);
+  std::vector<std::vector<intensity_t> > halos_below(num_bands);
+  std::vector<int_t> halo_above_begin(num_bands,0);
+  intensity_t * intensities = intensities_.getRawPtr();
+  for(int_t band=0;band<num_bands;++band){
+    const int_t y_begin = band*fused_band_height;
+    const int_t y_end = std::min(height_,y_begin+fused_band_height);
+    halo_above_begin[band] = std::max(0,y_begin-reach);
+    if(apply_gauss_filter){
+      halos_above[band].assign(intensities+halo_above_begin[band]*width_,intensities+y_begin*width_);
+      halos_below[band].assign(intensities+y_end*width_,intensities+std::min(height_,y_end+reach)*width_);
+    }
+  }
+  const bool parallel = num_bands>1&&num_pixels()>=fused_min_parallel_pixels;
+  const int pool_size = kernel_num_threads(num_threads_);
+  (void)parallel;
+  (void)pool_size;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(pool_size) if(parallel)
+#endif
+  for(int_t band=0;band<num_bands;++band){
+    const int_t y_begin = band*fused_band_height;
+    const int_t y_end = std::min(height_,y_begin+fused_band_height);
+    fused_filter_gradient_band(width_,height_,y_begin,y_end,intensities,halos_above[band],halo_above_begin[band],
+      halos_below[band],grad_x_.getRawPtr(),grad_y_.getRawPtr(),coeffs,apply_gauss_filter,apply_gradients,smooth,grad_c1_,grad_c2_);
   }
-  has_gauss_filter_ = true;
+  if(apply_gauss_filter)
+    has_gauss_filter_ = true;
+  if(apply_gradients)
+    has_gradients_ = true;
 }
 
 }// End DICe Namespace
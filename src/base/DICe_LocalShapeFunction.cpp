@@ -217,10 +217,10 @@ Affine_Shape_Function::map(const scalar_t & x,
   scalar_t & out_x,
   scalar_t & out_y){
 
-  static scalar_t dx=0.0,dy=0.0;
-  static scalar_t Dx=0.0,Dy=0.0;
-  static scalar_t dispx=0.0,dispy=0.0,theta=0.0,dudx=0.0,dvdy=0.0,gxy=0.0;
-  static scalar_t cost=0.0,sint=0.0;
+  scalar_t dx=0.0,dy=0.0;
+  scalar_t Dx=0.0,Dy=0.0;
+  scalar_t dispx=0.0,dispy=0.0,theta=0.0,dudx=0.0,dvdy=0.0,gxy=0.0;
+  scalar_t cost=0.0,sint=0.0;
 
   dispx = parameters_[dx_ind_];
   dispy = parameters_[dy_ind_];
@@ -349,9 +349,9 @@ Affine_Shape_Function::residuals(const scalar_t & x,
   const bool use_ref_grads){
   assert((int_t)residuals.size()==num_params_);
 
-  static scalar_t dx=0.0,dy=0.0,Dx=0.0,Dy=0.0,delTheta=0.0,delEx=0.0,delEy=0.0,delGxy=0.0;
-  static scalar_t Gx=0.0,Gy=0.0;
-  static scalar_t theta=0.0,dudx=0.0,dvdy=0.0,gxy=0.0,cosTheta=0.0,sinTheta=0.0;
+  scalar_t dx=0.0,dy=0.0,Dx=0.0,Dy=0.0,delTheta=0.0,delEx=0.0,delEy=0.0,delGxy=0.0;
+  scalar_t Gx=0.0,Gy=0.0;
+  scalar_t theta=0.0,dudx=0.0,dvdy=0.0,gxy=0.0,cosTheta=0.0,sinTheta=0.0;
   theta = has_rotz_ ? parameters_[rotz_ind_] : 0.0;
   dudx  = has_nsxx_ ? parameters_[nsxx_ind_] : 0.0;
   dvdy  = has_nsyy_ ? parameters_[nsyy_ind_] : 0.0;
@@ -415,6 +415,55 @@ Affine_Shape_Function::test_for_convergence(const std::vector<scalar_t> & old_pa
   return converged;
 }
 
+void
+Affine_Shape_Function::linear_map(const std::vector<scalar_t> & params,
+  scalar_t * A)const{
+  assert((int_t)params.size()==num_params_);
+  const scalar_t theta = has_rotz_ ? params[rotz_ind_] : 0.0;
+  const scalar_t dudx  = has_nsxx_ ? params[nsxx_ind_] : 0.0;
+  const scalar_t dvdy  = has_nsyy_ ? params[nsyy_ind_] : 0.0;
+  const scalar_t gxy   = has_ssxy_ ? params[ssxy_ind_] : 0.0;
+  const scalar_t cost = std::cos(theta);
+  const scalar_t sint = std::sin(theta);
+  A[0] = cost*(1.0+dudx) - sint*gxy;
+  A[1] = cost*gxy - sint*(1.0+dvdy);
+  A[2] = sint*(1.0+dudx) + cost*gxy;
+  A[3] = sint*gxy + cost*(1.0+dvdy);
+}
+
+void
+Affine_Shape_Function::inverse_compositional_update(const std::vector<scalar_t> & update){
+  assert((int_t)update.size()==num_params_);
+  // the map is x' = A*(x-c) + c + t, so the composition W(p) o W(dp)^-1 has
+  // A_new = A*dA^-1 and t_new = t - A_new*dt
+  scalar_t A[4];
+  scalar_t dA[4];
+  linear_map(parameters_,A);
+  linear_map(update,dA);
+  const scalar_t det = dA[0]*dA[3] - dA[1]*dA[2];
+  TEUCHOS_TEST_FOR_EXCEPTION(std::abs(det)<1.0E-12,std::runtime_error,"Error, the incremental map is not invertible");
+  const scalar_t dAi[4] = {dA[3]/det,-dA[1]/det,-dA[2]/det,dA[0]/det};
+  const scalar_t An[4] = {A[0]*dAi[0] + A[1]*dAi[2], A[0]*dAi[1] + A[1]*dAi[3],
+                          A[2]*dAi[0] + A[3]*dAi[2], A[2]*dAi[1] + A[3]*dAi[3]};
+  const scalar_t du = update[dx_ind_];
+  const scalar_t dv = update[dy_ind_];
+  parameters_[dx_ind_] -= An[0]*du + An[1]*dv;
+  parameters_[dy_ind_] -= An[2]*du + An[3]*dv;
+  // split A_new into the rotation and the symmetric stretch (polar decomposition),
+  // any modes that are not enabled are dropped
+  const scalar_t theta = has_rotz_ ? std::atan2(An[2]-An[1],An[0]+An[3]) : 0.0;
+  const scalar_t cost = std::cos(theta);
+  const scalar_t sint = std::sin(theta);
+  const scalar_t S00 = cost*An[0] + sint*An[2];
+  const scalar_t S01 = cost*An[1] + sint*An[3];
+  const scalar_t S10 = -sint*An[0] + cost*An[2];
+  const scalar_t S11 = -sint*An[1] + cost*An[3];
+  if(has_rotz_) parameters_[rotz_ind_] = theta;
+  if(has_nsxx_) parameters_[nsxx_ind_] = S00 - 1.0;
+  if(has_nsyy_) parameters_[nsyy_ind_] = S11 - 1.0;
+  if(has_ssxy_) parameters_[ssxy_ind_] = 0.5*(S01 + S10);
+}
+
 Quadratic_Shape_Function::Quadratic_Shape_Function(){
   spec_map_.insert(std::pair<Field_Spec,size_t>(QUAD_A_FS,spec_map_.size()));
   spec_map_.insert(std::pair<Field_Spec,size_t>(QUAD_B_FS,spec_map_.size()));
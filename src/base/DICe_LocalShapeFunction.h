@@ -48,6 +48,9 @@
 
 #include <Teuchos_RCP.hpp>
 
+#include <cassert>
+#include <cmath>
+
 
 /*!
  *  \namespace DICe
@@ -59,6 +62,14 @@ namespace DICe {
 // forward declaration
 class Schema;
 
+/// compile time residual kernel for a shape function (see the specializations below)
+template<typename Shape_Function, int_t N>
+struct Residual_Kernel;
+
+/// compile time map kernel for a shape function (see the specializations below)
+template<typename Shape_Function>
+struct Map_Kernel;
+
 /// \class DICe:::Local_Shape_Function
 /// \brief A generic class that provides an abstraction of the local DIC shape function
 class DICE_LIB_DLL_EXPORT
@@ -215,6 +226,18 @@ public:
   /// \param update reference to the update vector
   void update(const std::vector<scalar_t> & update);
 
+  /// returns true if the shape function can be updated using inverse_compositional_update()
+  virtual bool has_inverse_compositional_update()const{
+    return false;
+  }
+
+  /// update the parameter values by composing the current map with the inverse of an
+  /// incremental map (the parameters of the incremental map are relative to the identity map)
+  /// \param update reference to the parameters of the incremental map
+  virtual void inverse_compositional_update(const std::vector<scalar_t> & update){
+    TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, the inverse compositional update has not been implemented for this shape function");
+  }
+
   /// returns true if the solution is converged
   /// \param old_parameters vector of the previous guess for the parameters
   /// \param tol the solution tolerance
@@ -337,7 +360,29 @@ public:
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, this method has not been implemented yet for Affine_Shape_Function");
   };
 
+  /// see base class description
+  virtual bool has_inverse_compositional_update()const{
+    return true;
+  }
+
+  /// see base class description
+  virtual void inverse_compositional_update(const std::vector<scalar_t> & update);
+
+  /// the residual kernel reads the enabled modes and parameter indices directly
+  template<typename Shape_Function, int_t N>
+  friend struct Residual_Kernel;
+
+  /// the map kernel reads the parameter indices directly
+  template<typename Shape_Function>
+  friend struct Map_Kernel;
+
 private:
+  /// assemble the linear part of the map A = R(theta)*[1+ex gxy; gxy 1+ey] (stored row major)
+  /// \param params the parameter values to use
+  /// \param A [out] array of size four
+  void linear_map(const std::vector<scalar_t> & params,
+    scalar_t * A)const;
+
   /// flags used to turn off certain parameters in the shape function
   bool has_rotz_ = false;
   bool has_nsxx_ = false;
@@ -421,6 +466,256 @@ public:
 private:
 };
 
+/// \brief Residual kernel for the affine shape function with N enabled parameters (2 to 6)
+///
+/// The kernel is built once per Gauss-Newton iteration from the current parameter values, so the trig
+/// functions are not re-evaluated for every pixel, and fills a fixed size array of residuals.
+/// The values are the same as Affine_Shape_Function::residuals(), but the call is resolved at compile time
+/// so the pixel loop that accumulates the Hessian can be unrolled and vectorized.
+template<int_t N>
+struct Residual_Kernel<Affine_Shape_Function,N>{
+  /// constructor
+  /// \param shape_function the shape function with the current parameter values
+  /// \param cx centroid x coordinate
+  /// \param cy centroid y coordinate
+  /// \param use_ref_grads true if the gradients are from the reference image (so they need to be rotated)
+  Residual_Kernel(const Affine_Shape_Function & shape_function,
+    const scalar_t & cx,
+    const scalar_t & cy,
+    const bool use_ref_grads):
+    cx_(cx),
+    cy_(cy),
+    use_ref_grads_(use_ref_grads),
+    has_rotz_(shape_function.has_rotz_),
+    has_nsxx_(shape_function.has_nsxx_),
+    has_nsyy_(shape_function.has_nsyy_),
+    has_ssxy_(shape_function.has_ssxy_),
+    dx_ind_(shape_function.dx_ind_),
+    dy_ind_(shape_function.dy_ind_),
+    rotz_ind_(shape_function.rotz_ind_),
+    nsxx_ind_(shape_function.nsxx_ind_),
+    nsyy_ind_(shape_function.nsyy_ind_),
+    ssxy_ind_(shape_function.ssxy_ind_){
+    assert(shape_function.num_params()==N);
+    const std::vector<scalar_t> & params = shape_function.parameters_;
+    const scalar_t theta = has_rotz_ ? params[rotz_ind_] : 0.0;
+    dudx_ = has_nsxx_ ? params[nsxx_ind_] : 0.0;
+    dvdy_ = has_nsyy_ ? params[nsyy_ind_] : 0.0;
+    gxy_ = has_ssxy_ ? params[ssxy_ind_] : 0.0;
+    cos_theta_ = std::cos(theta);
+    sin_theta_ = std::sin(theta);
+  }
+
+  /// compute the residuals for one pixel
+  /// \param x x-coordinate of the pixel
+  /// \param y y-coordinate of the pixel
+  /// \param gx x image gradient
+  /// \param gy y image gradient
+  /// \param residuals [out] array of size N
+  void operator()(const scalar_t & x,
+    const scalar_t & y,
+    const scalar_t & gx,
+    const scalar_t & gy,
+    scalar_t * residuals)const{
+    const scalar_t dx = x - cx_;
+    const scalar_t dy = y - cy_;
+    const scalar_t Dx = (1.0+dudx_)*(dx) + gxy_*(dy);
+    const scalar_t Dy = (1.0+dvdy_)*(dy) + gxy_*(dx);
+    const scalar_t Gx = use_ref_grads_ ? cos_theta_*gx - sin_theta_*gy : gx;
+    const scalar_t Gy = use_ref_grads_ ? sin_theta_*gx + cos_theta_*gy : gy;
+    residuals[dx_ind_] = Gx;
+    residuals[dy_ind_] = Gy;
+    if(has_rotz_)
+      residuals[rotz_ind_] = Gx*(-sin_theta_*Dx - cos_theta_*Dy) + Gy*(cos_theta_*Dx - sin_theta_*Dy);
+    if(has_nsxx_)
+      residuals[nsxx_ind_] = Gx*dx*cos_theta_ + Gy*dx*sin_theta_;
+    if(has_nsyy_)
+      residuals[nsyy_ind_] = -Gx*dy*sin_theta_ + Gy*dy*cos_theta_;
+    if(has_ssxy_)
+      residuals[ssxy_ind_] = Gx*(cos_theta_*dy - sin_theta_*dx) + Gy*(sin_theta_*dy + cos_theta_*dx);
+  }
+
+private:
+  const scalar_t cx_;
+  const scalar_t cy_;
+  const bool use_ref_grads_;
+  const bool has_rotz_;
+  const bool has_nsxx_;
+  const bool has_nsyy_;
+  const bool has_ssxy_;
+  const int_t dx_ind_;
+  const int_t dy_ind_;
+  const int_t rotz_ind_;
+  const int_t nsxx_ind_;
+  const int_t nsyy_ind_;
+  const int_t ssxy_ind_;
+  scalar_t dudx_;
+  scalar_t dvdy_;
+  scalar_t gxy_;
+  scalar_t cos_theta_;
+  scalar_t sin_theta_;
+};
+
+/// \brief Residual kernel for the 12 parameter quadratic shape function
+///
+/// The parameter indices and the rotation of the reference gradients are looked up once
+/// per iteration instead of for every pixel (see Quadratic_Shape_Function::residuals())
+template<>
+struct Residual_Kernel<Quadratic_Shape_Function,12>{
+  /// constructor
+  /// \param shape_function the shape function with the current parameter values
+  /// \param cx centroid x coordinate
+  /// \param cy centroid y coordinate
+  /// \param use_ref_grads true if the gradients are from the reference image (so they need to be rotated)
+  Residual_Kernel(Quadratic_Shape_Function & shape_function,
+    const scalar_t & cx,
+    const scalar_t & cy,
+    const bool use_ref_grads):
+    cx_(cx),
+    cy_(cy),
+    use_ref_grads_(use_ref_grads),
+    cos_theta_(1.0),
+    sin_theta_(0.0){
+    assert(shape_function.num_params()==12);
+    const field_enums::Field_Spec specs[12] = {field_enums::QUAD_A_FS,field_enums::QUAD_B_FS,field_enums::QUAD_C_FS,
+      field_enums::QUAD_D_FS,field_enums::QUAD_E_FS,field_enums::QUAD_F_FS,field_enums::QUAD_G_FS,field_enums::QUAD_H_FS,
+      field_enums::QUAD_I_FS,field_enums::QUAD_J_FS,field_enums::QUAD_K_FS,field_enums::QUAD_L_FS};
+    for(int_t i=0;i<12;++i)
+      ind_[i] = shape_function.spec_map()->find(specs[i])->second;
+    if(use_ref_grads){
+      scalar_t u=0.0,v=0.0,theta=0.0;
+      shape_function.map_to_u_v_theta(cx,cy,u,v,theta);
+      cos_theta_ = std::cos(theta);
+      sin_theta_ = std::sin(theta);
+    }
+  }
+
+  /// compute the residuals for one pixel
+  /// \param x x-coordinate of the pixel
+  /// \param y y-coordinate of the pixel
+  /// \param gx x image gradient
+  /// \param gy y image gradient
+  /// \param residuals [out] array of size 12
+  void operator()(const scalar_t & x,
+    const scalar_t & y,
+    const scalar_t & gx,
+    const scalar_t & gy,
+    scalar_t * residuals)const{
+    const scalar_t dx = x - cx_;
+    const scalar_t dy = y - cy_;
+    const scalar_t Gx = use_ref_grads_ ? cos_theta_*gx - sin_theta_*gy : gx;
+    const scalar_t Gy = use_ref_grads_ ? sin_theta_*gx + cos_theta_*gy : gy;
+    residuals[ind_[0]] = Gx*dx;
+    residuals[ind_[1]] = Gx*dy;
+    residuals[ind_[2]] = Gx*dx*dy;
+    residuals[ind_[3]] = Gx*dx*dx;
+    residuals[ind_[4]] = Gx*dy*dy;
+    residuals[ind_[5]] = Gx;
+    residuals[ind_[6]] = Gy*dx;
+    residuals[ind_[7]] = Gy*dy;
+    residuals[ind_[8]] = Gy*dx*dy;
+    residuals[ind_[9]] = Gy*dx*dx;
+    residuals[ind_[10]] = Gy*dy*dy;
+    residuals[ind_[11]] = Gy;
+  }
+
+private:
+  const scalar_t cx_;
+  const scalar_t cy_;
+  const bool use_ref_grads_;
+  scalar_t cos_theta_;
+  scalar_t sin_theta_;
+  int_t ind_[12];
+};
+
+/// \brief Map kernel for the affine shape function
+///
+/// The linear part of the map (rotation and stretch) is assembled once from the current parameter values,
+/// so mapping a pixel is two multiply-adds per coordinate without a virtual call or trig functions.
+/// The values are the same as Affine_Shape_Function::map(). The update of the parameters happens once per
+/// iteration, not once per pixel, so it stays a virtual call.
+template<>
+struct Map_Kernel<Affine_Shape_Function>{
+  /// constructor
+  /// \param shape_function the shape function with the current parameter values
+  /// \param cx centroid x coordinate
+  /// \param cy centroid y coordinate
+  Map_Kernel(const Affine_Shape_Function & shape_function,
+    const scalar_t & cx,
+    const scalar_t & cy):
+    cx_(cx),
+    cy_(cy){
+    shape_function.linear_map(shape_function.parameters_,A_);
+    tx_ = shape_function.parameters_[shape_function.dx_ind_] + cx;
+    ty_ = shape_function.parameters_[shape_function.dy_ind_] + cy;
+  }
+
+  /// map one pixel
+  /// \param x x-coordinate of the pixel
+  /// \param y y-coordinate of the pixel
+  /// \param out_x [out] mapped x-coordinate
+  /// \param out_y [out] mapped y-coordinate
+  void operator()(const scalar_t & x,
+    const scalar_t & y,
+    scalar_t & out_x,
+    scalar_t & out_y)const{
+    const scalar_t dx = x - cx_;
+    const scalar_t dy = y - cy_;
+    out_x = A_[0]*dx + A_[1]*dy + tx_;
+    out_y = A_[2]*dx + A_[3]*dy + ty_;
+  }
+
+private:
+  const scalar_t cx_;
+  const scalar_t cy_;
+  scalar_t A_[4];
+  scalar_t tx_;
+  scalar_t ty_;
+};
+
+/// \brief Map kernel for the 12 parameter quadratic shape function
+///
+/// The coefficients are looked up once instead of through the field spec map for every pixel
+/// (see Quadratic_Shape_Function::map())
+template<>
+struct Map_Kernel<Quadratic_Shape_Function>{
+  /// constructor
+  /// \param shape_function the shape function with the current parameter values
+  /// \param cx centroid x coordinate
+  /// \param cy centroid y coordinate
+  Map_Kernel(Quadratic_Shape_Function & shape_function,
+    const scalar_t & cx,
+    const scalar_t & cy):
+    cx_(cx),
+    cy_(cy){
+    const field_enums::Field_Spec specs[12] = {field_enums::QUAD_A_FS,field_enums::QUAD_B_FS,field_enums::QUAD_C_FS,
+      field_enums::QUAD_D_FS,field_enums::QUAD_E_FS,field_enums::QUAD_F_FS,field_enums::QUAD_G_FS,field_enums::QUAD_H_FS,
+      field_enums::QUAD_I_FS,field_enums::QUAD_J_FS,field_enums::QUAD_K_FS,field_enums::QUAD_L_FS};
+    for(int_t i=0;i<12;++i)
+      coeffs_[i] = shape_function(specs[i]);
+  }
+
+  /// map one pixel
+  /// \param x x-coordinate of the pixel
+  /// \param y y-coordinate of the pixel
+  /// \param out_x [out] mapped x-coordinate
+  /// \param out_y [out] mapped y-coordinate
+  void operator()(const scalar_t & x,
+    const scalar_t & y,
+    scalar_t & out_x,
+    scalar_t & out_y)const{
+    const scalar_t dx = x - cx_;
+    const scalar_t dy = y - cy_;
+    out_x = coeffs_[0]*dx + coeffs_[1]*dy + coeffs_[2]*dx*dy + coeffs_[3]*dx*dx + coeffs_[4]*dy*dy + coeffs_[5] + cx_;
+    out_y = coeffs_[6]*dx + coeffs_[7]*dy + coeffs_[8]*dx*dy + coeffs_[9]*dx*dx + coeffs_[10]*dy*dy + coeffs_[11] + cy_;
+  }
+
+private:
+  const scalar_t cx_;
+  const scalar_t cy_;
+  scalar_t coeffs_[12];
+};
+
 
 //mimic the quadratic shape function for the projection shape function
 /// \class DICe::Projection_Shape_Function
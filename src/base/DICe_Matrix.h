@@ -52,6 +52,8 @@
 #include <iomanip>
 #include <cassert>
 #include <array>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 
 namespace DICe {
@@ -359,6 +361,104 @@ public:
     return rcond==0.0?0.0:1.0/rcond;
   }
 
+  /// in place Cholesky factorization (A = L L^T) of a symmetric positive definite matrix
+  /// Only the lower triangle is referenced and on return it holds the factor L (the strict
+  /// upper triangle is left untouched). Everything is done in the stack storage of the matrix
+  /// so this is cheaper than a LAPACK call for the small systems solved in the subset optimization.
+  /// returns false if a pivot is not positive (the matrix is not positive definite)
+  bool cholesky(){
+    static_assert(std::is_floating_point<Type>::value,"cholesky() requires a floating point type");
+    TEUCHOS_TEST_FOR_EXCEPTION(rows_!=cols_,std::runtime_error,"matrix must be square");
+    const size_t n = rows_;
+    for(size_t j=0;j<n;++j){
+      Type d = data_[j*n+j];
+      for(size_t k=0;k<j;++k)
+        d -= data_[j*n+k]*data_[j*n+k];
+      if(!(d>0.0)) return false;
+      d = std::sqrt(d);
+      data_[j*n+j] = d;
+      for(size_t i=j+1;i<n;++i){
+        Type s = data_[i*n+j];
+        for(size_t k=0;k<j;++k)
+          s -= data_[i*n+k]*data_[j*n+k];
+        data_[i*n+j] = s/d;
+      }
+    }
+    return true;
+  }
+
+  /// solve A x = b in place using the factor computed by cholesky()
+  /// \param b [in/out] the right hand side on input, the solution on output
+  template <size_t VRows>
+  void cholesky_solve(Matrix<Type,VRows,1> & b)const{
+    assert(b.rows()==rows_);
+    const size_t n = rows_;
+    // forward substitution L y = b
+    for(size_t i=0;i<n;++i){
+      Type s = b(i);
+      for(size_t k=0;k<i;++k)
+        s -= data_[i*n+k]*b(k);
+      b(i) = s/data_[i*n+i];
+    }
+    // back substitution L^T x = y
+    for(size_t i=n;i-->0;){
+      Type s = b(i);
+      for(size_t k=i+1;k<n;++k)
+        s -= data_[k*n+i]*b(k);
+      b(i) = s/data_[i*n+i];
+    }
+  }
+
+  /// in place LDL^T factorization of a symmetric matrix (no square roots and no pivoting)
+  /// Only the lower triangle is referenced, on return the strict lower triangle holds the unit
+  /// lower triangular factor L and the diagonal holds D. Unlike cholesky() this also works for
+  /// symmetric matrices that are not positive definite as long as no pivot vanishes.
+  /// returns false if a zero pivot is found
+  bool ldlt(){
+    static_assert(std::is_floating_point<Type>::value,"ldlt() requires a floating point type");
+    TEUCHOS_TEST_FOR_EXCEPTION(rows_!=cols_,std::runtime_error,"matrix must be square");
+    const size_t n = rows_;
+    std::array<Type,Rows> ld{}; // L(j,k)*D(k) for the current row
+    for(size_t j=0;j<n;++j){
+      Type d = data_[j*n+j];
+      for(size_t k=0;k<j;++k){
+        ld[k] = data_[j*n+k]*data_[k*n+k];
+        d -= data_[j*n+k]*ld[k];
+      }
+      if(d==0.0||!std::isfinite(d)) return false;
+      data_[j*n+j] = d;
+      for(size_t i=j+1;i<n;++i){
+        Type s = data_[i*n+j];
+        for(size_t k=0;k<j;++k)
+          s -= data_[i*n+k]*ld[k];
+        data_[i*n+j] = s/d;
+      }
+    }
+    return true;
+  }
+
+  /// solve A x = b in place using the factors computed by ldlt()
+  /// \param b [in/out] the right hand side on input, the solution on output
+  template <size_t VRows>
+  void ldlt_solve(Matrix<Type,VRows,1> & b)const{
+    assert(b.rows()==rows_);
+    const size_t n = rows_;
+    for(size_t i=0;i<n;++i){
+      Type s = b(i);
+      for(size_t k=0;k<i;++k)
+        s -= data_[i*n+k]*b(k);
+      b(i) = s;
+    }
+    for(size_t i=0;i<n;++i)
+      b(i) /= data_[i*n+i];
+    for(size_t i=n;i-->0;){
+      Type s = b(i);
+      for(size_t k=i+1;k<n;++k)
+        s -= data_[k*n+i]*b(k);
+      b(i) = s;
+    }
+  }
+
   /// make a diagonal matrix
   static Matrix<Type,Rows,Cols> diag(const Type & value, const size_t size=Rows){
     static_assert(Rows==Cols,"diag() can only be called for square matrix");
@@ -83,7 +83,7 @@ public:
 #if DICE_MPI
   int mpi_is_initialized = 0;
   MPI_Initialized(&mpi_is_initialized);
-  if(mpi_is_initialized)
+  if(mpi_is_initialized&&!process_local())
     comm_ = Teuchos::rcp(new Epetra_MpiComm(MPI_COMM_WORLD));
   else
     comm_ = Teuchos::rcp(new Epetra_SerialComm);
@@ -100,7 +100,25 @@ public:
 
   /// Returns a pointer to the underlying communicator
   Teuchos::RCP<Epetra_Comm> get()const{return comm_;}
+
+  /// \brief Makes the communicators constructed after this call span only the calling process
+  /// (used when the frames rather than the subsets are distributed so each process owns all the subsets)
+  /// \param flag true if the communicators should only include the calling process
+  static void set_process_local(const bool flag){
+    process_local_flag() = flag;
+  }
+
+  /// Returns true if newly constructed communicators only include the calling process
+  static bool process_local(){
+    return process_local_flag();
+  }
 private:
+  /// Storage for the process local switch
+  static bool & process_local_flag(){
+    static bool flag = false;
+    return flag;
+  }
+
   /// Pointer to the underlying communicator
   Teuchos::RCP<Epetra_Comm> comm_;
 };
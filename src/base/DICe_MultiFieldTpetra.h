@@ -83,7 +83,7 @@ public:
 #if DICE_MPI
     int mpi_is_initialized = 0;
     MPI_Initialized(&mpi_is_initialized);
-    if(mpi_is_initialized)
+    if(mpi_is_initialized&&!process_local())
       comm_ = Tpetra::DefaultPlatform::getDefaultPlatform().getComm ();
     else
       comm_ =  Teuchos::rcp(new Teuchos::SerialComm<int> ());
@@ -105,7 +105,25 @@ public:
   const Teuchos::RCP<const Teuchos::Comm<int> > get()const{
     return comm_;
   }
+
+  /// \brief Makes the communicators constructed after this call span only the calling process
+  /// (used when the frames rather than the subsets are distributed so each process owns all the subsets)
+  /// \param flag true if the communicators should only include the calling process
+  static void set_process_local(const bool flag){
+    process_local_flag() = flag;
+  }
+
+  /// Returns true if newly constructed communicators only include the calling process
+  static bool process_local(){
+    return process_local_flag();
+  }
 private:
+  /// Storage for the process local switch
+  static bool & process_local_flag(){
+    static bool flag = false;
+    return flag;
+  }
+
   /// Pointer to underlying communicator object
   Teuchos::RCP<const Teuchos::Comm<int> > comm_;
 };
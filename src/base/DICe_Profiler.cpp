@@ -0,0 +1,330 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe_Profiler.h>
+
+#include <Teuchos_TestForException.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if DICE_MPI
+#  include <mpi.h>
+#endif
+
+namespace DICe {
+
+namespace profiler {
+
+namespace {
+
+/// counters owned by a single thread, only that thread writes to them
+struct Thread_Counters{
+  Thread_Counters():
+    seconds(num_slots,0.0),
+    calls(num_slots,0){}
+  std::vector<double> seconds;
+  std::vector<double> calls;
+  std::map<int_t,int_t> status_counts;
+  std::map<int_t,int_t> iteration_counts;
+};
+
+std::atomic<bool> enabled_flag(false);
+/// guards the list of thread counters (only taken the first time a thread times something)
+std::mutex registry_mutex;
+/// the counters of every thread that has timed a scope, these outlive the threads
+std::vector<std::shared_ptr<Thread_Counters> > registry;
+
+Thread_Counters &
+thread_counters(){
+  static thread_local Thread_Counters * counters = NULL;
+  if(counters==NULL){
+    std::shared_ptr<Thread_Counters> new_counters = std::make_shared<Thread_Counters>();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back(new_counters);
+    counters = new_counters.get();
+  }
+  return *counters;
+}
+
+std::string
+slot_name(const int_t slot){
+  if(slot<MAX_PHASE) return phaseStrings[slot];
+  // the initializers without a method of their own (search and path file)
+  if(slot-MAX_PHASE==INITIALIZATION_METHOD_NOT_APPLICABLE) return "INITIALIZE_SEARCH_OR_PATH";
+  return std::string("INITIALIZE_") + initializationMethodStrings[slot-MAX_PHASE];
+}
+
+/// sum a histogram over all processors onto processor 0
+void
+reduce_histogram(std::map<int_t,int_t> & histogram){
+#if DICE_MPI
+  int num_procs = 1, rank = 0;
+  MPI_Comm_size(MPI_COMM_WORLD,&num_procs);
+  MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+  std::vector<int_t> local_data;
+  for(std::map<int_t,int_t>::const_iterator it=histogram.begin();it!=histogram.end();++it){
+    local_data.push_back(it->first);
+    local_data.push_back(it->second);
+  }
+  int local_size = local_data.size();
+  std::vector<int> sizes(num_procs,0);
+  MPI_Gather(&local_size,1,MPI_INT,&sizes[0],1,MPI_INT,0,MPI_COMM_WORLD);
+  std::vector<int> displs(num_procs,0);
+  int total_size = 0;
+  for(int_t i=0;i<num_procs;++i){
+    displs[i] = total_size;
+    total_size += sizes[i];
+  }
+  std::vector<int_t> all_data(std::max(total_size,1),0);
+  MPI_Gatherv(local_data.empty()?NULL:&local_data[0],local_size,MPI_INT,&all_data[0],&sizes[0],&displs[0],MPI_INT,0,MPI_COMM_WORLD);
+  if(rank!=0) return;
+  histogram.clear();
+  for(int_t i=0;i+1<total_size;i+=2)
+    histogram[all_data[i]] += all_data[i+1];
+#else
+  (void)histogram;
+#endif
+}
+
+void
+write_json_histogram(std::ofstream & ofs,
+  const std::string & name,
+  const std::map<int_t,int_t> & histogram,
+  const bool last){
+  ofs << "    \"" << name << "\": {";
+  for(std::map<int_t,int_t>::const_iterator it=histogram.begin();it!=histogram.end();++it){
+    if(it!=histogram.begin()) ofs << ", ";
+    ofs << "\"" << it->first << "\": " << it->second;
+  }
+  ofs << "}" << (last ? "" : ",") << "\n";
+}
+
+}// End anonymous namespace
+
+void
+enable(const bool flag){
+  enabled_flag.store(flag);
+}
+
+bool
+is_enabled(){
+  return enabled_flag.load(std::memory_order_relaxed);
+}
+
+void
+reset(){
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for(size_t i=0;i<registry.size();++i)
+    *registry[i] = Thread_Counters();
+}
+
+void
+record_step(const int_t status,
+  const int_t num_iterations){
+  if(!is_enabled()) return;
+  Thread_Counters & counters = thread_counters();
+  counters.status_counts[status]++;
+  counters.iteration_counts[num_iterations]++;
+}
+
+Scope::Scope(const Phase phase):
+  slot_(-1){
+  if(!is_enabled()) return;
+  assert(phase>=0&&phase<MAX_PHASE);
+  slot_ = phase;
+  start_ = std::chrono::steady_clock::now();
+}
+
+Scope::Scope(const Initialization_Method method):
+  slot_(-1){
+  if(!is_enabled()) return;
+  if(method<0||method>=MAX_INITIALIZATION_METHOD) return;
+  slot_ = MAX_PHASE + method;
+  start_ = std::chrono::steady_clock::now();
+}
+
+Scope::~Scope(){
+  if(slot_<0) return;
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+  Thread_Counters & counters = thread_counters();
+  counters.seconds[slot_] += elapsed.count();
+  counters.calls[slot_] += 1.0;
+}
+
+void
+write_report(const std::string & file_name,
+  const std::map<std::string,std::map<int_t,int_t> > & extra_histograms){
+  int num_procs = 1, rank = 0;
+#if DICE_MPI
+  MPI_Comm_size(MPI_COMM_WORLD,&num_procs);
+  MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+#endif
+  // combine the threads on this processor
+  std::vector<double> proc_seconds(num_slots,0.0);
+  std::vector<double> max_thread_seconds(num_slots,0.0);
+  std::vector<double> calls(num_slots,0.0);
+  std::map<int_t,int_t> status_counts;
+  std::map<int_t,int_t> iteration_counts;
+  int_t num_threads = 0;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    num_threads = registry.size();
+    for(size_t t=0;t<registry.size();++t){
+      const Thread_Counters & counters = *registry[t];
+      for(int_t i=0;i<num_slots;++i){
+        proc_seconds[i] += counters.seconds[i];
+        max_thread_seconds[i] = std::max(max_thread_seconds[i],counters.seconds[i]);
+        calls[i] += counters.calls[i];
+      }
+      for(std::map<int_t,int_t>::const_iterator it=counters.status_counts.begin();it!=counters.status_counts.end();++it)
+        status_counts[it->first] += it->second;
+      for(std::map<int_t,int_t>::const_iterator it=counters.iteration_counts.begin();it!=counters.iteration_counts.end();++it)
+        iteration_counts[it->first] += it->second;
+    }
+  }
+  // combine the processors
+  std::vector<double> all_proc_seconds(num_slots*num_procs,0.0);
+  std::vector<int_t> all_num_threads(num_procs,num_threads);
+  std::vector<double> total_calls(calls);
+  std::vector<double> total_max_thread_seconds(max_thread_seconds);
+#if DICE_MPI
+  MPI_Gather(&proc_seconds[0],num_slots,MPI_DOUBLE,&all_proc_seconds[0],num_slots,MPI_DOUBLE,0,MPI_COMM_WORLD);
+  MPI_Gather(&num_threads,1,MPI_INT,&all_num_threads[0],1,MPI_INT,0,MPI_COMM_WORLD);
+  MPI_Reduce(&calls[0],&total_calls[0],num_slots,MPI_DOUBLE,MPI_SUM,0,MPI_COMM_WORLD);
+  MPI_Reduce(&max_thread_seconds[0],&total_max_thread_seconds[0],num_slots,MPI_DOUBLE,MPI_MAX,0,MPI_COMM_WORLD);
+#else
+  all_proc_seconds = proc_seconds;
+#endif
+  reduce_histogram(status_counts);
+  reduce_histogram(iteration_counts);
+  std::map<std::string,std::map<int_t,int_t> > histograms(extra_histograms);
+  for(std::map<std::string,std::map<int_t,int_t> >::iterator it=histograms.begin();it!=histograms.end();++it)
+    reduce_histogram(it->second);
+  if(rank!=0) return;
+
+  std::vector<double> total_seconds(num_slots,0.0);
+  std::vector<double> min_proc_seconds(num_slots,0.0);
+  std::vector<double> max_proc_seconds(num_slots,0.0);
+  for(int_t i=0;i<num_slots;++i){
+    min_proc_seconds[i] = all_proc_seconds[i];
+    for(int_t p=0;p<num_procs;++p){
+      const double value = all_proc_seconds[p*num_slots+i];
+      total_seconds[i] += value;
+      min_proc_seconds[i] = std::min(min_proc_seconds[i],value);
+      max_proc_seconds[i] = std::max(max_proc_seconds[i],value);
+    }
+  }
+  // the fixed phases are always reported, the initializers only if they were used
+  std::vector<int_t> slots;
+  for(int_t i=0;i<num_slots;++i)
+    if(i<MAX_PHASE||total_calls[i]>0.0) slots.push_back(i);
+
+  std::ofstream ofs(file_name.c_str(),std::ofstream::out);
+  TEUCHOS_TEST_FOR_EXCEPTION(!ofs.good(),std::runtime_error,"Error, could not open performance report file " << file_name);
+  ofs << std::setprecision(6);
+  const bool is_csv = file_name.size()>=4 && file_name.compare(file_name.size()-4,4,".csv")==0;
+  if(is_csv){
+    ofs << "# phase,calls,total_seconds,min_processor_seconds,max_processor_seconds,max_thread_seconds\n";
+    for(size_t s=0;s<slots.size();++s){
+      const int_t i = slots[s];
+      ofs << slot_name(i) << "," << (long long)total_calls[i] << "," << total_seconds[i] << "," << min_proc_seconds[i] << ","
+          << max_proc_seconds[i] << "," << total_max_thread_seconds[i] << "\n";
+    }
+    ofs << "# processor,num_threads";
+    for(size_t s=0;s<slots.size();++s)
+      ofs << "," << slot_name(slots[s]);
+    ofs << "\n";
+    for(int_t p=0;p<num_procs;++p){
+      ofs << p << "," << all_num_threads[p];
+      for(size_t s=0;s<slots.size();++s)
+        ofs << "," << all_proc_seconds[p*num_slots+slots[s]];
+      ofs << "\n";
+    }
+    histograms["status"] = status_counts;
+    histograms["iterations"] = iteration_counts;
+    ofs << "# histogram,bin,count\n";
+    for(std::map<std::string,std::map<int_t,int_t> >::const_iterator it=histograms.begin();it!=histograms.end();++it)
+      for(std::map<int_t,int_t>::const_iterator bin=it->second.begin();bin!=it->second.end();++bin)
+        ofs << it->first << "," << bin->first << "," << bin->second << "\n";
+  }
+  else{
+    ofs << "{\n";
+    ofs << "  \"num_processors\": " << num_procs << ",\n";
+    ofs << "  \"phases\": [\n";
+    for(size_t s=0;s<slots.size();++s){
+      const int_t i = slots[s];
+      ofs << "    {\"name\": \"" << slot_name(i) << "\", \"calls\": " << (long long)total_calls[i]
+          << ", \"total_seconds\": " << total_seconds[i] << ", \"min_processor_seconds\": " << min_proc_seconds[i]
+          << ", \"max_processor_seconds\": " << max_proc_seconds[i] << ", \"max_thread_seconds\": " << total_max_thread_seconds[i]
+          << "}" << (s+1<slots.size() ? "," : "") << "\n";
+    }
+    ofs << "  ],\n";
+    ofs << "  \"processors\": [\n";
+    for(int_t p=0;p<num_procs;++p){
+      ofs << "    {\"rank\": " << p << ", \"num_threads\": " << all_num_threads[p] << ", \"seconds\": {";
+      for(size_t s=0;s<slots.size();++s)
+        ofs << (s>0 ? ", " : "") << "\"" << slot_name(slots[s]) << "\": " << all_proc_seconds[p*num_slots+slots[s]];
+      ofs << "}}" << (p+1<num_procs ? "," : "") << "\n";
+    }
+    ofs << "  ],\n";
+    ofs << "  \"histograms\": {\n";
+    write_json_histogram(ofs,"status",status_counts,false);
+    write_json_histogram(ofs,"iterations",iteration_counts,histograms.empty());
+    for(std::map<std::string,std::map<int_t,int_t> >::const_iterator it=histograms.begin();it!=histograms.end();++it){
+      std::map<std::string,std::map<int_t,int_t> >::const_iterator next = it;
+      ++next;
+      write_json_histogram(ofs,it->first,it->second,next==histograms.end());
+    }
+    ofs << "  }\n";
+    ofs << "}\n";
+  }
+  ofs.close();
+}
+
+}// End profiler namespace
+
+}// End DICe Namespace
@@ -0,0 +1,154 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#ifndef DICE_PROFILER_H
+#define DICE_PROFILER_H
+
+#include <DICe.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+
+namespace DICe {
+
+/// \namespace DICe::profiler
+/// \brief Low overhead instrumentation of the phases of an analysis
+///
+/// Each thread accumulates the wall time and number of calls for every phase in its own
+/// counters so timing a scope never takes a lock. The counters are combined over the threads
+/// and the processors when the report is written. The instrumentation is off by default,
+/// in which case a scope only costs a single check of the enabled flag.
+namespace profiler {
+
+/// instrumented phases of an analysis (the initializers are timed separately for each Initialization_Method)
+enum Phase{
+  IMAGE_READ=0,
+  IMAGE_FILTER,
+  IMAGE_GRADIENTS,
+  SUBSET_CONSTRUCTION,
+  SEARCH_INITIALIZATION,
+  GRADIENT_OPTIMIZATION,
+  SIMPLEX_OPTIMIZATION,
+  POST_PROCESSING,
+  WRITE_OUTPUT,
+  // *** DON'T ADD BELOW THIS LINE
+  MAX_PHASE
+};
+
+const static char * phaseStrings[] = {
+  "IMAGE_READ",
+  "IMAGE_FILTER",
+  "IMAGE_GRADIENTS",
+  "SUBSET_CONSTRUCTION",
+  "SEARCH_INITIALIZATION",
+  "GRADIENT_OPTIMIZATION",
+  "SIMPLEX_OPTIMIZATION",
+  "POST_PROCESSING",
+  "WRITE_OUTPUT"
+};
+
+/// number of timer slots: one per phase followed by one per initialization method
+const int_t num_slots = MAX_PHASE + MAX_INITIALIZATION_METHOD;
+
+/// turn the instrumentation on or off
+/// \param flag true if the phases should be timed
+DICE_LIB_DLL_EXPORT
+void enable(const bool flag=true);
+
+/// returns true if the instrumentation is on
+DICE_LIB_DLL_EXPORT
+bool is_enabled();
+
+/// zero the counters of all threads (must not be called while other threads are timing scopes)
+DICE_LIB_DLL_EXPORT
+void reset();
+
+/// record the outcome of a subset solve for the status and iteration count histograms
+/// \param status the Status_Flag of the step
+/// \param num_iterations the number of optimization iterations (negative if the optimization did not run)
+DICE_LIB_DLL_EXPORT
+void record_step(const int_t status,
+  const int_t num_iterations);
+
+/// \class DICe::profiler::Scope
+/// \brief Times the enclosing block and adds it to the calling thread's counters
+///
+/// Scopes may be nested, in which case the inner time is also included in the outer phase.
+class DICE_LIB_DLL_EXPORT
+Scope{
+public:
+  /// constructor, starts the timer
+  /// \param phase the phase to charge the time to
+  Scope(const Phase phase);
+
+  /// constructor, starts the timer for an initializer
+  /// \param method the initialization method to charge the time to
+  Scope(const Initialization_Method method);
+
+  /// destructor, stops the timer
+  ~Scope();
+
+private:
+  /// not copyable
+  Scope(const Scope &);
+  Scope & operator=(const Scope &);
+  /// counter slot (-1 if the instrumentation is off)
+  int_t slot_;
+  /// start time
+  std::chrono::steady_clock::time_point start_;
+};
+
+/// \brief write the performance report, this is a collective call when MPI is enabled
+/// and only processor 0 writes the file. Files with a .csv extension are written as comma
+/// separated records, anything else is written as JSON.
+/// \param file_name the name of the output file
+/// \param extra_histograms additional named histograms to include in the report (for example the
+/// per-subset event counts from the Stat_Container), the values for each key are summed over the processors
+DICE_LIB_DLL_EXPORT
+void write_report(const std::string & file_name,
+  const std::map<std::string,std::map<int_t,int_t> > & extra_histograms=std::map<std::string,std::map<int_t,int_t> >());
+
+}// End profiler namespace
+
+}// End DICe Namespace
+
+#endif
@@ -359,6 +359,10 @@ private:
   Teuchos::ArrayRCP<int_t> x_;
   /// initial x position of the pixels in the reference image
   Teuchos::ArrayRCP<int_t> y_;
+  /// work space for the mapped x coordinates of the pixels (local image coordinates)
+  Teuchos::ArrayRCP<scalar_t> mapped_x_;
+  /// work space for the mapped y coordinates of the pixels (local image coordinates)
+  Teuchos::ArrayRCP<scalar_t> mapped_y_;
 #endif
   /// \brief EXPERIMENTAL Holds the obstruction coordinates if they exist.
   /// NOTE: The coordinates are switched for this (i.e. (Y,X)) so that
@@ -43,9 +43,87 @@
 #include <DICe_ImageUtils.h>
 
 #include <cassert>
+#include <cmath>
 
 namespace DICe {
 
+namespace {
+
+// The reductions below are the inner loops of the correlation (called several times per
+// subset per iteration). The pixel mask is evaluated inline without a branch and the
+// sums are accumulated in double so that the variances can be computed in one pass.
+
+/// count, sum and sum of squares of the active values
+void active_sums(const int_t num_pixels,
+  const intensity_t * values,
+  const bool * is_active,
+  const bool * is_deactivated,
+  double & count,
+  double & sum,
+  double & sum_sq){
+  double c = 0.0, s = 0.0, ss = 0.0;
+#if (defined(_OPENMP) && _OPENMP >= 201307) || defined(DICE_OPENMP_SIMD)
+#pragma omp simd reduction(+:c,s,ss)
+#endif
+  for(int_t i=0;i<num_pixels;++i){
+    const bool use = is_active[i]&!is_deactivated[i];
+    const double v = use ? (double)values[i] : 0.0;
+    c += use ? 1.0 : 0.0;
+    s += v;
+    ss += v*v;
+  }
+  count = c;
+  sum = s;
+  sum_sq = ss;
+}
+
+/// count, sums, sums of squares and the sum of the products of the active reference and deformed values
+void active_cross_sums(const int_t num_pixels,
+  const intensity_t * ref,
+  const intensity_t * def,
+  const bool * is_active,
+  const bool * is_deactivated,
+  double & count,
+  double & sum_ref,
+  double & sum_def,
+  double & sum_ref_sq,
+  double & sum_def_sq,
+  double & sum_ref_def){
+  double c = 0.0, sr = 0.0, sd = 0.0, srr = 0.0, sdd = 0.0, srd = 0.0;
+#if (defined(_OPENMP) && _OPENMP >= 201307) || defined(DICE_OPENMP_SIMD)
+#pragma omp simd reduction(+:c,sr,sd,srr,sdd,srd)
+#endif
+  for(int_t i=0;i<num_pixels;++i){
+    const bool use = is_active[i]&!is_deactivated[i];
+    const double r = use ? (double)ref[i] : 0.0;
+    const double d = use ? (double)def[i] : 0.0;
+    c += use ? 1.0 : 0.0;
+    sr += r;
+    sd += d;
+    srr += r*r;
+    sdd += d*d;
+    srd += r*d;
+  }
+  count = c;
+  sum_ref = sr;
+  sum_def = sd;
+  sum_ref_sq = srr;
+  sum_def_sq = sdd;
+  sum_ref_def = srd;
+}
+
+/// sum of (a_i - mean_a)(b_i - mean_b) from the raw sums, values at the level of the
+/// round off of the raw sums are treated as zero (constant intensities)
+double centered_sum(const double sum_ab,
+  const double sum_a,
+  const double sum_b,
+  const double count){
+  const double centered = sum_ab - sum_a*sum_b/count;
+  return centered > 1.0E-12*std::abs(sum_ab) ? centered : 0.0;
+}
+
+}
+
 Subset::Subset(int_t cx,
   int_t cy,
   Teuchos::ArrayRCP<int_t> x,
@@ -65,6 +143,8 @@ Subset::Subset(int_t cx,
   def_intensities_ = Teuchos::ArrayRCP<intensity_t>(num_pixels_,0.0);
   grad_x_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
   grad_y_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  mapped_x_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  mapped_y_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
   is_active_ = Teuchos::ArrayRCP<bool>(num_pixels_,true);
   is_deactivated_this_step_ = Teuchos::ArrayRCP<bool>(num_pixels_,false);
   reset_is_active();
@@ -102,6 +182,8 @@ Subset::Subset(const int_t cx,
   def_intensities_ = Teuchos::ArrayRCP<intensity_t>(num_pixels_,0.0);
   grad_x_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
   grad_y_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  mapped_x_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  mapped_y_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
   is_active_ = Teuchos::ArrayRCP<bool>(num_pixels_,true);
   is_deactivated_this_step_ = Teuchos::ArrayRCP<bool>(num_pixels_,false);
   reset_is_active();
@@ -144,6 +226,8 @@ Subset::Subset(const int_t cx,
   def_intensities_ = Teuchos::ArrayRCP<intensity_t>(num_pixels_,0.0);
   grad_x_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
   grad_y_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  mapped_x_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
+  mapped_y_ = Teuchos::ArrayRCP<scalar_t>(num_pixels_,0.0);
   is_active_ = Teuchos::ArrayRCP<bool>(num_pixels_,true);
   is_deactivated_this_step_ = Teuchos::ArrayRCP<bool>(num_pixels_,false);
   reset_is_active();
@@ -280,59 +364,41 @@ Subset::round(const Subset_View_Target target){
 
 scalar_t
 Subset::mean(const Subset_View_Target target){
-  scalar_t mean = 0.0;
-  int_t num_active = num_active_pixels();
-  if(target==REF_INTENSITIES){
-    for(int_t i=0;i<num_pixels_;++i){
-      if(is_active_[i]&!is_deactivated_this_step_[i])
-        mean += ref_intensities_[i];
-    }
-  }else{
-    for(int_t i=0;i<num_pixels_;++i)
-      if(is_active_[i]&!is_deactivated_this_step_[i]){
-        mean += def_intensities_[i];
-      }
-  }
-  return num_active != 0 ? mean/num_active : 0.0;
+  double count = 0.0, sum = 0.0, sum_sq = 0.0;
+  active_sums(num_pixels_,target==REF_INTENSITIES ? ref_intensities_.getRawPtr() : def_intensities_.getRawPtr(),
+    is_active_.getRawPtr(),is_deactivated_this_step_.getRawPtr(),count,sum,sum_sq);
+  return count != 0.0 ? sum/count : 0.0;
 }
 
 scalar_t
 Subset::mean(const Subset_View_Target target,
   scalar_t & sum){
-  scalar_t mean_ = mean(target);
-  sum = 0.0;
-  if(target==REF_INTENSITIES){
-    for(int_t i=0;i<num_pixels_;++i){
-      if(is_active_[i]&!is_deactivated_this_step_[i])
-        sum += (ref_intensities_[i]-mean_)*(ref_intensities_[i]-mean_);
-    }
-  }else{
-    for(int_t i=0;i<num_pixels_;++i){
-      if(is_active_[i]&!is_deactivated_this_step_[i])
-        sum += (def_intensities_[i]-mean_)*(def_intensities_[i]-mean_);
-    }
+  double count = 0.0, sum_values = 0.0, sum_sq = 0.0;
+  active_sums(num_pixels_,target==REF_INTENSITIES ? ref_intensities_.getRawPtr() : def_intensities_.getRawPtr(),
+    is_active_.getRawPtr(),is_deactivated_this_step_.getRawPtr(),count,sum_values,sum_sq);
+  if(count==0.0){
+    sum = 0.0;
+    return 0.0;
   }
-  sum = std::sqrt(sum);
-  return mean_;
+  sum = std::sqrt(centered_sum(sum_sq,sum_values,sum_values,count));
+  return sum_values/count;
 }
 
 scalar_t
 Subset::gamma(){
   // assumes obstructed pixels are already turned off
-  scalar_t mean_sum_ref = 0.0;
-  const scalar_t mean_ref = mean(REF_INTENSITIES,mean_sum_ref);
-  scalar_t mean_sum_def = 0.0;
-  const scalar_t mean_def = mean(DEF_INTENSITIES,mean_sum_def);
+  // gamma = sum_i ((d_i-mean_d)/|d-mean_d| - (r_i-mean_r)/|r-mean_r|)^2 = 2 - 2 (d-mean_d).(r-mean_r)/(|d-mean_d||r-mean_r|)
+  // so all the sums needed can be accumulated in one pass over the pixels
+  double count = 0.0, sum_ref = 0.0, sum_def = 0.0, sum_ref_sq = 0.0, sum_def_sq = 0.0, sum_ref_def = 0.0;
+  active_cross_sums(num_pixels_,ref_intensities_.getRawPtr(),def_intensities_.getRawPtr(),is_active_.getRawPtr(),is_deactivated_this_step_.getRawPtr(),
+    count,sum_ref,sum_def,sum_ref_sq,sum_def_sq,sum_ref_def);
+  if(count==0.0) return -1.0;
+  const double mean_sum_ref = std::sqrt(centered_sum(sum_ref_sq,sum_ref,sum_ref,count));
+  const double mean_sum_def = std::sqrt(centered_sum(sum_def_sq,sum_def,sum_def,count));
   if(mean_sum_ref==0.0||mean_sum_def==0.0) return -1.0;
-  scalar_t gamma = 0.0;
-  scalar_t value = 0.0;
-  for(int_t i=0;i<num_pixels_;++i){
-    if(is_active_[i]&!is_deactivated_this_step_[i]){
-      value = (def_intensities_[i]-mean_def)/mean_sum_def - (ref_intensities_[i]-mean_ref)/mean_sum_ref;
-      gamma += value*value;
-    }
-  }
-  return gamma;
+  const double cross = sum_ref_def - sum_ref*sum_def/count;
+  const double gamma = 2.0 - 2.0*cross/(mean_sum_ref*mean_sum_def);
+  return gamma > 0.0 ? gamma : 0.0;
 }
 
 scalar_t
@@ -360,13 +426,36 @@ scalar_t
 Subset::sssig(){
   // assumes obstructed pixels are already turned off
   scalar_t sssig = 0.0;
+  const scalar_t * gx = grad_x_.getRawPtr();
+  const scalar_t * gy = grad_y_.getRawPtr();
+#if (defined(_OPENMP) && _OPENMP >= 201307) || defined(DICE_OPENMP_SIMD)
+#pragma omp simd reduction(+:sssig)
+#endif
   for(int_t i=0;i<num_pixels_;++i){
-    sssig += grad_x_[i]*grad_x_[i] + grad_y_[i]*grad_y_[i];
+    sssig += gx[i]*gx[i] + gy[i]*gy[i];
   }
   sssig /= num_pixels_==0.0?1.0:num_pixels_;
   return sssig;
 }
 
+/// map the pixel coordinates of a subset with a compile time map kernel (see Map_Kernel)
+/// \param kernel the map kernel
+/// \param num_pixels the number of pixels
+/// \param x the x coordinates of the pixels
+/// \param y the y coordinates of the pixels
+/// \param mapped_x [out] the mapped x coordinates
+/// \param mapped_y [out] the mapped y coordinates
+template<typename Kernel>
+static void map_pixels(const Kernel & kernel,
+  const int_t num_pixels,
+  const int_t * x,
+  const int_t * y,
+  scalar_t * mapped_x,
+  scalar_t * mapped_y){
+  for(int_t i=0;i<num_pixels;++i)
+    kernel((scalar_t)x[i],(scalar_t)y[i],mapped_x[i],mapped_y[i]);
+}
+
 void
 Subset::initialize(Teuchos::RCP<Image> image,
   const Subset_View_Target target,
@@ -388,12 +477,22 @@ Subset::initialize(Teuchos::RCP<Image> image,
   else{
     int_t px,py;
     const bool has_blocks = !pixels_blocked_by_other_subsets_.empty();
-    // initialize the work variables
-    scalar_t mapped_x = 0.0;
-    scalar_t mapped_y = 0.0;
     const scalar_t ox=(scalar_t)offset_x,oy=(scalar_t)offset_y;
+    // map the pixels, the affine and quadratic maps are resolved once per subset instead of once per pixel
+    if(Affine_Shape_Function * affine = dynamic_cast<Affine_Shape_Function*>(shape_function.get()))
+      map_pixels(Map_Kernel<Affine_Shape_Function>(*affine,cx_,cy_),num_pixels_,x_.getRawPtr(),y_.getRawPtr(),
+        mapped_x_.getRawPtr(),mapped_y_.getRawPtr());
+    else if(Quadratic_Shape_Function * quadratic = dynamic_cast<Quadratic_Shape_Function*>(shape_function.get()))
+      map_pixels(Map_Kernel<Quadratic_Shape_Function>(*quadratic,cx_,cy_),num_pixels_,x_.getRawPtr(),y_.getRawPtr(),
+        mapped_x_.getRawPtr(),mapped_y_.getRawPtr());
+    else
+      for(int_t i=0;i<num_pixels_;++i)
+        shape_function->map(x_[i],y_[i],cx_,cy_,mapped_x_[i],mapped_y_[i]);
+    // first pass: determine which pixels are active,
+    // the interpolation is done for all the active pixels at once below
     for(int_t i=0;i<num_pixels_;++i){
-      shape_function->map(x_[i],y_[i],cx_,cy_,mapped_x,mapped_y);
+      scalar_t & mapped_x = mapped_x_[i];
+      scalar_t & mapped_y = mapped_y_[i];
       px = ((int_t)(mapped_x + 0.5) == (int_t)(mapped_x)) ? (int_t)(mapped_x) : (int_t)(mapped_x) + 1;
       py = ((int_t)(mapped_y + 0.5) == (int_t)(mapped_y)) ? (int_t)(mapped_y) : (int_t)(mapped_y) + 1;
       // out of image bounds ( 4 pixel buffer to ensure enough room to interpolate away from the sub image boundary)
@@ -414,23 +513,13 @@ Subset::initialize(Teuchos::RCP<Image> image,
       }
       // if the code got here, the pixel is not deactivated
       is_deactivated_this_step(i) = false;
-      if(interp==BILINEAR){
-        image->interpolate_bilinear_all(intensities_[i], grad_x_[i], grad_y_[i],
-               image->has_gradients(), mapped_x-ox, mapped_y-oy);
-      }
-      else if(interp==BICUBIC){
-        image->interpolate_bicubic_all(intensities_[i], grad_x_[i], grad_y_[i],
-               image->has_gradients(), mapped_x-ox, mapped_y-oy);
-      }
-      else if(interp==KEYS_FOURTH){
-        image->interpolate_keys_fourth_all(intensities_[i], grad_x_[i], grad_y_[i],
-               image->has_gradients(), mapped_x-ox, mapped_y-oy);
-      }
-      else{
-        TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,
-          "Error, unknown interpolation method requested");
-      }
+      // convert to local image coordinates for the interpolant
+      mapped_x -= ox;
+      mapped_y -= oy;
     }
+    // second pass: interpolate the intensities (and gradients) of all the active pixels
+    image->interpolate_all(num_pixels_,mapped_x_.getRawPtr(),mapped_y_.getRawPtr(),is_deactivated_this_step_.getRawPtr(),
+      intensities_.getRawPtr(),grad_x_.getRawPtr(),grad_y_.getRawPtr(),image->has_gradients(),interp);
   }
   // now sync up the intensities:
   if(target==REF_INTENSITIES){
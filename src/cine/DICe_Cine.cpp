@@ -46,6 +46,16 @@
 #include <time.h>
 #include <string>
 #include <sstream>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#if !defined(WIN32)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
 
 namespace DICe {
 namespace cine {
@@ -80,12 +90,18 @@ const static uint16_t LinLUT[1024] =
  4064,4095,4095,4095,4095,4095,4095,4095,4095,4095 };
 
 Cine_Reader::Cine_Reader(const std::string & file_name,
-  std::ostream * out_stream):
+  std::ostream * out_stream,
+  const bool use_memory_map):
   out_stream_(out_stream),
   bit_12_warning_(false),
   filter_threshold_(1.0E10),
   conversion_factor_(1.0),
-  filter_initialized_(false)
+  filter_initialized_(false),
+  mapped_data_(NULL),
+  mapped_size_(0),
+  num_frame_reads_(0),
+  num_pending_filter_updates_(0),
+  updating_filter_(false)
 {
   cine_header_ = read_cine_headers(file_name.c_str(),out_stream);
   const int64_t begin = cine_header_->image_offsets_[0];
@@ -94,6 +110,78 @@ Cine_Reader::Cine_Reader(const std::string & file_name,
   long long int buffer_size = end - begin;
   TEUCHOS_TEST_FOR_EXCEPTION(buffer_size<=0,std::runtime_error,"Error, invalid buffer size");
   header_offset_ = (buffer_size - cine_header_->bitmap_header_.biSizeImage) / sizeof(uint8_t);
+
+#if !defined(WIN32)
+  if(use_memory_map){
+    // map the whole file once, the frames are decoded directly from the mapping
+    // (if anything goes wrong here the reader falls back to reading the frames with a stream)
+    const int fd = open(file_name.c_str(),O_RDONLY);
+    struct stat file_stat;
+    if(fd>=0&&fstat(fd,&file_stat)==0&&file_stat.st_size>0&&(uint64_t)file_stat.st_size<=(uint64_t)std::numeric_limits<size_t>::max()){
+      void * mapping = mmap(NULL,(size_t)file_stat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+      if(mapping!=MAP_FAILED){
+        mapped_data_ = static_cast<uint8_t*>(mapping);
+        mapped_size_ = file_stat.st_size;
+        // frames are typically accessed in order, but only a window of each frame may be needed
+        // so the readahead is managed explicitly in prefetch_frame_bytes()
+        madvise(mapping,(size_t)mapped_size_,MADV_RANDOM);
+      }
+    }
+    if(fd>=0) close(fd); // the mapping stays valid after the descriptor is closed
+    if(mapped_data_==NULL&&out_stream_){
+      *out_stream_ << "*** Warning, unable to memory map .cine file: " << file_name << std::endl <<
+          "             frames will be read using file streams instead" << std::endl;
+    }
+  }
+#endif
+  DEBUG_MSG("Cine_Reader::Cine_Reader(): memory mapped: " << (mapped_data_!=NULL) << " mapped size: " << mapped_size_);
+}
+
+Cine_Reader::~Cine_Reader(){
+#if !defined(WIN32)
+  if(mapped_data_!=NULL)
+    munmap(mapped_data_,(size_t)mapped_size_);
+#endif
+}
+
+const uint8_t *
+Cine_Reader::frame_bytes(const int_t frame_index,
+  const int64_t byte_offset,
+  const int64_t num_bytes,
+  std::vector<uint8_t> & buffer){
+  TEUCHOS_TEST_FOR_EXCEPTION(frame_index<0||frame_index>=(int_t)cine_header_->header_.ImageCount,std::runtime_error,
+    "Error, invalid frame index " << frame_index);
+  const int64_t begin = cine_header_->image_offsets_[frame_index] + header_offset_ + byte_offset;
+  if(mapped_data_!=NULL){
+    TEUCHOS_TEST_FOR_EXCEPTION(begin<0||begin+num_bytes>mapped_size_,std::runtime_error,
+      "Error, requested bytes are outside of the cine file: " << cine_header_->file_name_);
+    return mapped_data_ + begin;
+  }
+  buffer.resize(num_bytes);
+  std::ifstream cine_file(cine_header_->file_name_.c_str(), std::ios::in | std::ios::binary);
+  TEUCHOS_TEST_FOR_EXCEPTION(cine_file.fail(),std::runtime_error,"Error, can't open the file: " << cine_header_->file_name_);
+  cine_file.seekg(begin);
+  cine_file.read(reinterpret_cast<char*>(&buffer[0]),num_bytes);
+  TEUCHOS_TEST_FOR_EXCEPTION(cine_file.gcount()!=num_bytes,std::runtime_error,
+    "Error, unable to read frame " << frame_index << " from the file: " << cine_header_->file_name_);
+  cine_file.close();
+  return &buffer[0];
+}
+
+void
+Cine_Reader::prefetch_frame_bytes(const int_t frame_index,
+  const int64_t byte_offset,
+  const int64_t num_bytes){
+#if !defined(WIN32)
+  if(mapped_data_==NULL||frame_index<0||frame_index>=(int_t)cine_header_->header_.ImageCount) return;
+  int64_t begin = cine_header_->image_offsets_[frame_index] + header_offset_ + byte_offset;
+  int64_t end = std::min(begin + num_bytes,mapped_size_);
+  if(begin<0||begin>=end) return;
+  // madvise requires a page aligned address
+  const int64_t page_size = sysconf(_SC_PAGESIZE);
+  begin -= begin % page_size;
+  madvise(mapped_data_ + begin,(size_t)(end-begin),MADV_WILLNEED);
+#endif
 }
 
 void
@@ -137,6 +225,36 @@ Cine_Reader::initialize_filter(const bool filter_failed_pixels,
   filter_initialized_ = true;
 }
 
+bool
+Cine_Reader::begin_filter_access(const bool reinit){
+  std::unique_lock<std::mutex> lock(filter_access_mutex_);
+  // the filter state is only looked at once nobody is changing it
+  filter_access_cv_.wait(lock,[this]{return !updating_filter_;});
+  if(reinit||!filter_initialized_){
+    num_pending_filter_updates_++;
+    filter_access_cv_.wait(lock,[this]{return !updating_filter_&&num_frame_reads_==0;});
+    num_pending_filter_updates_--;
+    updating_filter_ = true;
+    return true;
+  }
+  // a set up that is waiting goes before any new reads
+  filter_access_cv_.wait(lock,[this]{return !updating_filter_&&num_pending_filter_updates_==0;});
+  num_frame_reads_++;
+  return false;
+}
+
+void
+Cine_Reader::end_filter_access(const bool exclusive){
+  {
+    std::lock_guard<std::mutex> lock(filter_access_mutex_);
+    if(exclusive)
+      updating_filter_ = false;
+    else
+      num_frame_reads_--;
+  }
+  filter_access_cv_.notify_all();
+}
+
 void
 Cine_Reader::get_average_frame(const int_t frame_start,
     const int_t frame_end,
@@ -202,25 +320,15 @@ Cine_Reader::get_frame_8_bit(const int_t offset_x,
   const int_t h = cine_header_->bitmap_header_.biHeight;
   const int_t end_x = offset_x + width - 1;
   const int_t end_y = offset_y + height - 1;
-  const int_t sub_buffer_size = (height+1) * w; // + 1 to oversize the buffer
-  char * sub_buffer = new char[sub_buffer_size];
+  const int64_t sub_buffer_size = (int64_t)height * w;
   DEBUG_MSG("Cine_Reader::get_frame_8_bit(): buffer_size: " << sub_buffer_size);
   DEBUG_MSG("Cine_Reader::get_frame_8_bit(): start_x " << offset_x << " end_x " << end_x << " start_y " << offset_y << " end_y " << end_y);
-  uint8_t * sub_buff_ptr_8 = reinterpret_cast<uint8_t*>(sub_buffer);
-  // open the file
-  std::ifstream cine_file(cine_header_->file_name_.c_str(), std::ios::in | std::ios::binary);
-  if (cine_file.fail()){
-    std::cerr << "Error, can't open the file: " << cine_header_->file_name_ << std::endl;
-    throw std::exception();
-  }
-  // position to the first frame in this set:
-  const int64_t begin_frame = cine_header_->image_offsets_[frame_index] + header_offset_ + ((h-end_y-1) * w);
+  // position to the first row in this set (the rows are stored bottom up):
+  const int64_t row_offset = (int64_t)(h-end_y-1) * w;
   DEBUG_MSG("Cine_Reader::get_frame_8_bit(): image offset: " << cine_header_->image_offsets_[frame_index]);
-  DEBUG_MSG("Cine_Reader::get_frame_8_bit(): y offset: " << (h-end_y-1)*w);
-  DEBUG_MSG("Cine_Reader::get_frame_8_bit(): begin frame: " << begin_frame);
-  cine_file.seekg(begin_frame);
-  // read the buffer
-  cine_file.read(sub_buffer,sub_buffer_size);
+  DEBUG_MSG("Cine_Reader::get_frame_8_bit(): y offset: " << row_offset);
+  std::vector<uint8_t> buffer;
+  const uint8_t * sub_buff_ptr_8 = frame_bytes(frame_index,row_offset,sub_buffer_size,buffer);
   int_t failed_pixels=0;
   for(int_t y=0;y<height;++y){
     for(int_t x=offset_x;x<=end_x;++x){
@@ -233,8 +341,7 @@ Cine_Reader::get_frame_8_bit(const int_t offset_x,
         intensities[(height-y-1)*width + x-offset_x] = sub_buff_ptr_8[y*w+x]*conversion_factor_;
     }
   }
-  delete [] sub_buff_ptr_8;
-  cine_file.close();
+  prefetch_frame_bytes(frame_index+1,row_offset,sub_buffer_size);
 #ifdef DICE_DEBUG_MSG
   if(failed_pixels>0&&out_stream_){
     *out_stream_ << "*** Warning, this frame of .cine file: " << cine_header_->file_name_ << std::endl <<
@@ -264,29 +371,21 @@ Cine_Reader::get_frame_16_bit(const int_t offset_x,
   const int_t h = cine_header_->bitmap_header_.biHeight;
   const int_t end_x = offset_x + width - 1;
   const int_t end_y = offset_y + height - 1;
-  const int_t sub_buffer_size = (height+1)*w*2; // + 1 to oversize the buffer
-  char * sub_buffer = new char[sub_buffer_size];
+  const int64_t sub_buffer_size = (int64_t)height*w*2; // times 2 because 2 bytes per 16bit pixel
   DEBUG_MSG("Cine_Reader::get_frame_16_bit(): buffer_size: " << sub_buffer_size);
   DEBUG_MSG("Cine_Reader::get_frame_16_bit(): start_x " << offset_x << " end_x " << end_x << " start_y " << offset_y << " end_y " << end_y);
-  uint16_t * sub_buff_ptr_16 = reinterpret_cast<uint16_t*>(sub_buffer);
-  // open the file
-  std::ifstream cine_file(cine_header_->file_name_.c_str(), std::ios::in | std::ios::binary);
-  if (cine_file.fail()){
-    std::cerr << "Error, can't open the file: " << cine_header_->file_name_ << std::endl;
-    throw std::exception();
-  }
-  // position to the first frame in this set:
-  const int64_t begin_frame = cine_header_->image_offsets_[frame_index] + header_offset_ + ((h-end_y-1) * w * 2); // times 2 because 2 bytes per 16bit pixel
-  cine_file.seekg(begin_frame);
-  // read the buffer
-  cine_file.read(sub_buffer,sub_buffer_size);
+  // position to the first row in this set:
+  const int64_t row_offset = (int64_t)(h-end_y-1) * w * 2;
+  std::vector<uint8_t> buffer;
+  // the mapped frame data is not guaranteed to be 2 byte aligned so the pixels are copied out with memcpy
+  const uint8_t * sub_buff_ptr_8 = frame_bytes(frame_index,row_offset,sub_buffer_size,buffer);
   // the images are stored bottom up, not top down!
   uint16_t pixel_intensity;
   uint16_t max_intens = 0;
   int_t failed_pixels = 0;
   for(int_t y=0;y<height;++y){
     for(int_t x=offset_x;x<=end_x;++x){
-      pixel_intensity = sub_buff_ptr_16[y*w+x];
+      std::memcpy(&pixel_intensity,sub_buff_ptr_8 + 2*(y*w+x),2);
       if(pixel_intensity > max_intens) max_intens = pixel_intensity;
       if(pixel_intensity >= filter_threshold_){
         failed_pixels++;
@@ -297,6 +396,7 @@ Cine_Reader::get_frame_16_bit(const int_t offset_x,
       }
     }
   }
+  prefetch_frame_bytes(frame_index+1,row_offset,sub_buffer_size);
 #ifdef DICE_DEBUG_MSG
   if(failed_pixels>0&&out_stream_){
     *out_stream_ << "*** Warning, this frame of .cine file: " << cine_header_->file_name_ << std::endl <<
@@ -351,22 +451,13 @@ Cine_Reader::get_frame_10_bit(const int_t offset_x,
   assert(offset_y>=0&&offset_y<cine_header_->bitmap_header_.biHeight);
   /// buffer for sub_image reading
   assert(w%8==0);
-  const int_t sub_buffer_size = (height+1) * w * 10 / 8;
-  char * sub_buffer = new char[sub_buffer_size]; // + 1 to oversize the buffer
+  const int64_t sub_buffer_size = (int64_t)height * w * 10 / 8;
   DEBUG_MSG("Cine_Reader::get_frame_10_bit(): buffer_size: " << sub_buffer_size);
   DEBUG_MSG("Cine_Reader::get_frame_10_bit(): start_x " << offset_x << " end_x " << end_x << " start_y " << offset_y << " end_y " << offset_y + height -1);
-  uint8_t * sub_buff_ptr_8 = reinterpret_cast<uint8_t*>(sub_buffer);
-  // open the file
-  std::ifstream cine_file(cine_header_->file_name_.c_str(), std::ios::in | std::ios::binary);
-  if (cine_file.fail()){
-    std::cerr << "Error, can't open the file: " << cine_header_->file_name_ << std::endl;
-    throw std::exception();
-  }
-  // position to the first frame in this set:
-  const int64_t begin_frame = cine_header_->image_offsets_[frame_index] + header_offset_ + (offset_y * w * 10 / 8);
-  cine_file.seekg(begin_frame);
-  // read the buffer
-  cine_file.read(sub_buffer,sub_buffer_size);
+  // position to the first row in this set:
+  const int64_t row_offset = (int64_t)offset_y * w * 10 / 8;
+  std::vector<uint8_t> buffer;
+  const uint8_t * sub_buff_ptr_8 = frame_bytes(frame_index,row_offset,sub_buffer_size,buffer);
   // unpack the 10 bit image data from the array
   uint16_t intensity_16 = 0.0;
   uint16_t intensity_16p1 = 0.0;
@@ -398,8 +489,7 @@ Cine_Reader::get_frame_10_bit(const int_t offset_x,
         intensities[y*width+(x-offset_x)] = two_byte * conversion_factor_;
     }
   }
-  cine_file.close();
-  delete[] sub_buffer;
+  prefetch_frame_bytes(frame_index+1,row_offset,sub_buffer_size);
 #ifdef DICE_DEBUG_MSG
   if(failed_pixels>0&&out_stream_){
     *out_stream_ << "*** Warning, this frame of .cine file: " << cine_header_->file_name_ << std::endl <<
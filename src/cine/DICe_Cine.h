@@ -44,8 +44,12 @@
 
 #include <DICe.h>
 
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 #if defined(WIN32)
   #include <cstdint>
@@ -201,12 +205,13 @@ public:
   /// \brief default constructor
   /// \param file_name the name of the cine file
   /// \param out_stream (optional) output stream
-  /// \param filter_failed_pixels true if failed pixels should be filtered out by taking the next highest value
-  /// \param convert_to_8_bit true if the values should be scaled to 8 bit
+  /// \param use_memory_map true if the cine file should be memory mapped once and the frames decoded directly
+  /// from the mapping (falls back to stream reads if the platform or the file does not support it)
   Cine_Reader(const std::string & file_name,
-    std::ostream * out_stream = NULL);
+    std::ostream * out_stream = NULL,
+    const bool use_memory_map = true);
   /// default destructor
-  virtual ~Cine_Reader(){};
+  virtual ~Cine_Reader();
 
   /// \brief generic frame fetch
   /// \param offset_x offset to first pixel in x
@@ -299,6 +304,19 @@ public:
     const int_t frame_index=0,
     const bool reinit=false);
 
+  /// \brief start using the filter threshold and conversion factor from one thread (a reader/writer lock on the filter state)
+  /// \param reinit true if the filter will be set up again
+  ///
+  /// Blocks until the filter state can be used and returns true if the caller has to set up the filter
+  /// (the first access or reinit). In that case the access is exclusive: it waits for the frame reads in progress
+  /// and holds off new ones until end_filter_access() is called. Otherwise any number of threads can read frames
+  /// at the same time. Every call has to be matched by a call to end_filter_access() with the return value.
+  bool begin_filter_access(const bool reinit);
+
+  /// \brief finish an access started with begin_filter_access()
+  /// \param exclusive the value returned by begin_filter_access()
+  void end_filter_access(const bool exclusive);
+
   /// returns the number of images in the cine file
   int_t num_frames()const{
     return cine_header_->header_.ImageCount;
@@ -315,13 +333,38 @@ public:
   int_t first_image_number()const{
     return cine_header_->header_.FirstImageNo;
   }
+  /// returns true if the frames are being read from a memory mapping of the file
+  bool is_memory_mapped()const{
+    return mapped_data_!=NULL;
+  }
 private:
+  /// \brief returns a pointer to the raw bytes of a section of a frame
+  /// \param frame_index the frame to gather
+  /// \param byte_offset offset in bytes from the beginning of the frame's pixel data
+  /// \param num_bytes the number of bytes needed
+  /// \param buffer storage used for the bytes if the file is not memory mapped
+  ///
+  /// If the file is memory mapped the returned pointer points directly into the mapping,
+  /// otherwise the bytes are read from the file into buffer
+  const uint8_t * frame_bytes(const int_t frame_index,
+    const int64_t byte_offset,
+    const int64_t num_bytes,
+    std::vector<uint8_t> & buffer);
+
+  /// \brief hint to the operating system that a section of a frame will be needed soon (only used for memory mapped files)
+  /// \param frame_index the frame that will be read next
+  /// \param byte_offset offset in bytes from the beginning of the frame's pixel data
+  /// \param num_bytes the number of bytes that will be read
+  void prefetch_frame_bytes(const int_t frame_index,
+    const int64_t byte_offset,
+    const int64_t num_bytes);
+
   /// pointer to the cine file header information
   Teuchos::RCP<Cine_Header> cine_header_;
   /// pointer to the output stream
   std::ostream * out_stream_;
-  /// flag to prevent warnings from appearing multiple times for each frame
-  bool bit_12_warning_;
+  /// flag to prevent warnings from appearing multiple times for each frame (frames may be read on more than one thread)
+  std::atomic<bool> bit_12_warning_;
   /// file offset
   long long int header_offset_;
   /// maximum value of intensity above which the values are filtered (the value is set to the next highest intensity value)
@@ -330,6 +373,20 @@ private:
   intensity_t conversion_factor_;
   /// true if the filter has already been initialized
   bool filter_initialized_;
+  /// pointer to the start of the memory mapped file (NULL if the file is not mapped)
+  uint8_t * mapped_data_;
+  /// size of the memory mapped region in bytes
+  int64_t mapped_size_;
+  /// guards the counters below (see begin_filter_access())
+  std::mutex filter_access_mutex_;
+  /// signaled when a frame read or a filter set up finishes
+  std::condition_variable filter_access_cv_;
+  /// number of frame reads in progress
+  int_t num_frame_reads_;
+  /// number of filter set ups waiting for the reads in progress to finish (new reads wait for them)
+  int_t num_pending_filter_updates_;
+  /// true while a thread is setting up the filter
+  bool updating_filter_;
 };
 
 }// end cine namespace
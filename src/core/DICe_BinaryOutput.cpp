@@ -0,0 +1,441 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe_BinaryOutput.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace DICe {
+
+namespace binary_output{
+
+void
+compress_block(const int_t num_frames,
+  const int_t num_subsets,
+  const float * values,
+  std::vector<char> & output){
+  const size_t num_values = (size_t)num_frames*num_subsets;
+  output.clear();
+  if(num_values==0) return;
+  // XOR each value with the same subset in the previous frame so that unchanged bits become zeros
+  std::vector<uint32_t> words(num_values);
+  std::memcpy(&words[0],values,num_values*sizeof(float));
+  for(size_t i=num_values;i-->(size_t)num_subsets;)
+    words[i] ^= words[i-num_subsets];
+  // shuffle the bytes into planes (least significant byte first) so the zeros line up in long runs
+  const size_t num_bytes = 4*num_values;
+  std::vector<unsigned char> planes(num_bytes);
+  for(size_t b=0;b<4;++b)
+    for(size_t i=0;i<num_values;++i)
+      planes[b*num_values+i] = (unsigned char)((words[i]>>(8*b))&0xFF);
+  // run length encode the zeros: a control byte c < 128 is followed by c+1 literal bytes,
+  // a control byte c >= 128 stands for c-126 zero bytes
+  output.reserve(num_bytes/2);
+  size_t i = 0;
+  while(i<num_bytes){
+    size_t zeros = 0;
+    while(i+zeros<num_bytes&&planes[i+zeros]==0&&zeros<129) zeros++;
+    if(zeros>=2){
+      output.push_back((char)(unsigned char)(128+zeros-2));
+      i += zeros;
+      continue;
+    }
+    size_t num_literals = 0;
+    while(i+num_literals<num_bytes&&num_literals<128){
+      // stop the literal run where a run of zeros begins
+      if(planes[i+num_literals]==0&&i+num_literals+1<num_bytes&&planes[i+num_literals+1]==0) break;
+      num_literals++;
+    }
+    output.push_back((char)(unsigned char)(num_literals-1));
+    output.insert(output.end(),planes.begin()+i,planes.begin()+i+num_literals);
+    i += num_literals;
+  }
+}
+
+void
+decompress_block(const int_t num_frames,
+  const int_t num_subsets,
+  const char * input,
+  const size_t num_bytes,
+  float * values){
+  const size_t num_values = (size_t)num_frames*num_subsets;
+  if(num_values==0) return;
+  const size_t num_plane_bytes = 4*num_values;
+  std::vector<unsigned char> planes(num_plane_bytes);
+  size_t pos = 0;
+  size_t in = 0;
+  while(in<num_bytes){
+    const unsigned char c = (unsigned char)input[in++];
+    if(c>=128){
+      const size_t zeros = c - 126;
+      TEUCHOS_TEST_FOR_EXCEPTION(pos+zeros>num_plane_bytes,std::runtime_error,"Error, corrupt compressed block");
+      std::fill(planes.begin()+pos,planes.begin()+pos+zeros,0);
+      pos += zeros;
+    }
+    else{
+      const size_t num_literals = c + 1;
+      TEUCHOS_TEST_FOR_EXCEPTION(pos+num_literals>num_plane_bytes||in+num_literals>num_bytes,std::runtime_error,
+        "Error, corrupt compressed block");
+      std::memcpy(&planes[pos],input+in,num_literals);
+      pos += num_literals;
+      in += num_literals;
+    }
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(pos!=num_plane_bytes,std::runtime_error,"Error, corrupt compressed block");
+  std::vector<uint32_t> words(num_values,0);
+  for(size_t b=0;b<4;++b)
+    for(size_t i=0;i<num_values;++i)
+      words[i] |= (uint32_t)planes[b*num_values+i] << (8*b);
+  for(size_t i=num_subsets;i<num_values;++i)
+    words[i] ^= words[i-num_subsets];
+  std::memcpy(values,&words[0],num_values*sizeof(float));
+}
+
+} // end binary_output namespace
+
+namespace {
+/// write bytes to the file and throw if the write fails
+void write_bytes(std::FILE * file,
+  const void * data,
+  const size_t num_bytes){
+  if(num_bytes==0) return;
+  TEUCHOS_TEST_FOR_EXCEPTION(std::fwrite(data,1,num_bytes,file)!=num_bytes,std::runtime_error,
+    "Error, failed to write binary output");
+}
+/// read bytes from the file and throw if the read fails
+void read_bytes(std::ifstream & file,
+  void * data,
+  const size_t num_bytes){
+  file.read(reinterpret_cast<char*>(data),num_bytes);
+  TEUCHOS_TEST_FOR_EXCEPTION((size_t)file.gcount()!=num_bytes,std::runtime_error,
+    "Error, unexpected end of binary output file");
+}
+}
+
+Binary_Output_Writer::Binary_Output_Writer(const std::string & file_name,
+  const std::vector<std::string> & field_names,
+  const std::vector<int_t> & subset_ids,
+  const bool compress,
+  const int_t chunk_frames):
+  file_(NULL),
+  file_name_(file_name),
+  num_fields_(field_names.size()),
+  num_subsets_(subset_ids.size()),
+  compress_(compress),
+  chunk_frames_(chunk_frames),
+  closing_(false),
+  closed_(false)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(chunk_frames<=0,std::runtime_error,"Error, the number of frames per chunk must be greater than zero");
+  file_ = std::fopen(file_name.c_str(),"wb");
+  TEUCHOS_TEST_FOR_EXCEPTION(file_==NULL,std::runtime_error,"Error, could not open binary output file " << file_name);
+  DEBUG_MSG("Binary_Output_Writer::Binary_Output_Writer(): writing " << num_fields_ << " fields for " << num_subsets_ <<
+    " subsets to " << file_name << (compress ? " (compressed)" : ""));
+  try{
+    write_bytes(file_,binary_output::magic,sizeof(binary_output::magic));
+    write_bytes(file_,&binary_output::endian_tag,sizeof(uint32_t));
+    const int32_t header[4] = {binary_output::version,(int32_t)num_fields_,(int32_t)num_subsets_,(int32_t)chunk_frames_};
+    write_bytes(file_,header,sizeof(header));
+    for(int_t i=0;i<num_fields_;++i){
+      TEUCHOS_TEST_FOR_EXCEPTION((int_t)field_names[i].size()>=binary_output::field_name_length,std::runtime_error,
+        "Error, field name too long for binary output: " << field_names[i]);
+      char name[binary_output::field_name_length];
+      std::memset(name,0,binary_output::field_name_length);
+      std::memcpy(name,field_names[i].c_str(),field_names[i].size());
+      write_bytes(file_,name,binary_output::field_name_length);
+    }
+    std::vector<int32_t> ids(subset_ids.begin(),subset_ids.end());
+    if(!ids.empty())
+      write_bytes(file_,&ids[0],ids.size()*sizeof(int32_t));
+  }
+  catch(...){
+    std::fclose(file_);
+    throw;
+  }
+  current_.values.resize((size_t)num_fields_*chunk_frames_*num_subsets_);
+  thread_ = std::thread(&Binary_Output_Writer::write_chunks,this);
+}
+
+Binary_Output_Writer::~Binary_Output_Writer(){
+  try{
+    close();
+  }
+  catch(std::exception & e){
+    std::cout << "Error, binary output " << file_name_ << " was not written completely: " << e.what() << std::endl;
+  }
+}
+
+void
+Binary_Output_Writer::write_frame(const int_t frame_id,
+  const std::vector<scalar_t> & values){
+  TEUCHOS_TEST_FOR_EXCEPTION(closed_,std::runtime_error,"Error, binary output " << file_name_ << " is already closed");
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)values.size()!=num_fields_*num_subsets_,std::runtime_error,
+    "Error, expected " << num_fields_*num_subsets_ << " values for the binary output but got " << values.size());
+  const int_t frame = current_.frame_ids.size();
+  for(int_t field=0;field<num_fields_;++field){
+    float * block = &current_.values[((size_t)field*chunk_frames_ + frame)*num_subsets_];
+    for(int_t subset=0;subset<num_subsets_;++subset)
+      block[subset] = values[field*num_subsets_+subset];
+  }
+  current_.frame_ids.push_back(frame_id);
+  if((int_t)current_.frame_ids.size()==chunk_frames_)
+    submit_chunk();
+}
+
+void
+Binary_Output_Writer::submit_chunk(){
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // bound the memory by waiting for the writer thread to catch up
+    cond_.wait(lock,[this]{return pending_.size()<2||error_;});
+    if(error_)
+      std::rethrow_exception(error_);
+    pending_.push_back(Chunk());
+    pending_.back().frame_ids.swap(current_.frame_ids);
+    pending_.back().values.swap(current_.values);
+  }
+  cond_.notify_all();
+  current_.values.resize((size_t)num_fields_*chunk_frames_*num_subsets_);
+}
+
+void
+Binary_Output_Writer::close(){
+  if(closed_) return;
+  closed_ = true;
+  std::exception_ptr error;
+  try{
+    if(!current_.frame_ids.empty())
+      submit_chunk();
+  }
+  catch(...){
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closing_ = true;
+  }
+  cond_.notify_all();
+  if(thread_.joinable())
+    thread_.join();
+  if(std::fclose(file_)!=0&&!error_)
+    error_ = std::make_exception_ptr(std::runtime_error("Error, failed to close binary output file " + file_name_));
+  if(error)
+    std::rethrow_exception(error);
+  if(error_)
+    std::rethrow_exception(error_);
+}
+
+void
+Binary_Output_Writer::write_chunks(){
+  while(true){
+    Chunk chunk;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock,[this]{return !pending_.empty()||closing_;});
+      if(pending_.empty()) return;
+      chunk.frame_ids.swap(pending_.front().frame_ids);
+      chunk.values.swap(pending_.front().values);
+      pending_.pop_front();
+    }
+    cond_.notify_all();
+    try{
+      write_chunk(chunk);
+    }
+    catch(...){
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        pending_.clear();
+      }
+      cond_.notify_all();
+      return;
+    }
+  }
+}
+
+void
+Binary_Output_Writer::write_chunk(const Chunk & chunk){
+  const int32_t num_frames = chunk.frame_ids.size();
+  const int32_t compression = compress_ ? binary_output::DELTA_SHUFFLE_RLE : binary_output::NO_COMPRESSION;
+  const size_t block_values = (size_t)num_frames*num_subsets_;
+  std::vector<std::vector<char> > compressed(compress_ ? num_fields_ : 0);
+  std::vector<int64_t> block_sizes(num_fields_,block_values*sizeof(float));
+  for(int_t field=0;field<num_fields_&&compress_;++field){
+    binary_output::compress_block(num_frames,num_subsets_,&chunk.values[(size_t)field*chunk_frames_*num_subsets_],compressed[field]);
+    block_sizes[field] = compressed[field].size();
+  }
+  write_bytes(file_,&num_frames,sizeof(int32_t));
+  write_bytes(file_,&compression,sizeof(int32_t));
+  write_bytes(file_,&chunk.frame_ids[0],num_frames*sizeof(int32_t));
+  if(num_fields_>0)
+    write_bytes(file_,&block_sizes[0],num_fields_*sizeof(int64_t));
+  for(int_t field=0;field<num_fields_;++field){
+    if(compress_){
+      if(!compressed[field].empty())
+        write_bytes(file_,&compressed[field][0],compressed[field].size());
+    }
+    else
+      write_bytes(file_,&chunk.values[(size_t)field*chunk_frames_*num_subsets_],block_values*sizeof(float));
+  }
+  TEUCHOS_TEST_FOR_EXCEPTION(std::fflush(file_)!=0,std::runtime_error,"Error, failed to write binary output");
+}
+
+Binary_Output_Reader::Binary_Output_Reader(const std::string & file_name):
+  file_name_(file_name)
+{
+  std::ifstream file(file_name.c_str(),std::ios::in|std::ios::binary);
+  TEUCHOS_TEST_FOR_EXCEPTION(!file.is_open(),std::runtime_error,"Error, could not open binary output file " << file_name);
+  file.seekg(0,std::ios::end);
+  const int64_t file_size = file.tellg();
+  file.seekg(0,std::ios::beg);
+  char magic[8];
+  read_bytes(file,magic,sizeof(magic));
+  TEUCHOS_TEST_FOR_EXCEPTION(std::memcmp(magic,binary_output::magic,sizeof(magic))!=0,std::runtime_error,
+    "Error, " << file_name << " is not a DICe binary output file");
+  uint32_t tag = 0;
+  read_bytes(file,&tag,sizeof(uint32_t));
+  TEUCHOS_TEST_FOR_EXCEPTION(tag!=binary_output::endian_tag,std::runtime_error,
+    "Error, " << file_name << " was written on a machine with a different byte order");
+  int32_t header[4];
+  read_bytes(file,header,sizeof(header));
+  TEUCHOS_TEST_FOR_EXCEPTION(header[0]!=binary_output::version,std::runtime_error,
+    "Error, unsupported binary output version " << header[0]);
+  const int_t num_fields = header[1];
+  const int_t num_subsets = header[2];
+  TEUCHOS_TEST_FOR_EXCEPTION(num_fields<0||num_subsets<0,std::runtime_error,"Error, corrupt binary output header");
+  char name[binary_output::field_name_length+1];
+  name[binary_output::field_name_length] = '\0';
+  for(int_t i=0;i<num_fields;++i){
+    read_bytes(file,name,binary_output::field_name_length);
+    field_names_.push_back(name);
+  }
+  std::vector<int32_t> ids(num_subsets);
+  if(num_subsets>0)
+    read_bytes(file,&ids[0],num_subsets*sizeof(int32_t));
+  subset_ids_.assign(ids.begin(),ids.end());
+  // index the chunks
+  while(file.peek()!=EOF){
+    Chunk_Info info;
+    int32_t chunk_header[2];
+    read_bytes(file,chunk_header,sizeof(chunk_header));
+    info.first_frame = frame_ids_.size();
+    info.num_frames = chunk_header[0];
+    info.compression = chunk_header[1];
+    TEUCHOS_TEST_FOR_EXCEPTION(info.num_frames<=0,std::runtime_error,"Error, corrupt chunk in binary output file " << file_name);
+    TEUCHOS_TEST_FOR_EXCEPTION(info.compression!=binary_output::NO_COMPRESSION&&info.compression!=binary_output::DELTA_SHUFFLE_RLE,
+      std::runtime_error,"Error, unknown compression in binary output file " << file_name);
+    std::vector<int32_t> frames(info.num_frames);
+    read_bytes(file,&frames[0],info.num_frames*sizeof(int32_t));
+    frame_ids_.insert(frame_ids_.end(),frames.begin(),frames.end());
+    info.block_sizes.resize(num_fields);
+    if(num_fields>0)
+      read_bytes(file,&info.block_sizes[0],num_fields*sizeof(int64_t));
+    int64_t offset = file.tellg();
+    for(int_t field=0;field<num_fields;++field){
+      TEUCHOS_TEST_FOR_EXCEPTION(info.block_sizes[field]<0,std::runtime_error,"Error, corrupt chunk in binary output file " << file_name);
+      if(info.compression==binary_output::NO_COMPRESSION){
+        TEUCHOS_TEST_FOR_EXCEPTION(info.block_sizes[field]!=(int64_t)info.num_frames*num_subsets*(int64_t)sizeof(float),
+          std::runtime_error,"Error, corrupt chunk in binary output file " << file_name);
+      }
+      info.block_offsets.push_back(offset);
+      offset += info.block_sizes[field];
+    }
+    TEUCHOS_TEST_FOR_EXCEPTION(offset>file_size,std::runtime_error,"Error, binary output file " << file_name << " is truncated");
+    file.seekg(offset,std::ios::beg);
+    chunks_.push_back(info);
+  }
+  DEBUG_MSG("Binary_Output_Reader::Binary_Output_Reader(): " << file_name << " has " << num_fields << " fields, " << num_subsets <<
+    " subsets, " << frame_ids_.size() << " frames in " << chunks_.size() << " chunks");
+}
+
+int_t
+Binary_Output_Reader::field_index(const std::string & field_name)const{
+  for(size_t i=0;i<field_names_.size();++i)
+    if(field_names_[i]==field_name) return i;
+  return -1;
+}
+
+void
+Binary_Output_Reader::read_field(const int_t field,
+  const int_t first_frame,
+  const int_t num_frames,
+  std::vector<scalar_t> & values)const{
+  TEUCHOS_TEST_FOR_EXCEPTION(field<0||field>=num_fields(),std::runtime_error,"Error, invalid field index " << field);
+  TEUCHOS_TEST_FOR_EXCEPTION(first_frame<0||num_frames<0||first_frame+num_frames>this->num_frames(),std::runtime_error,
+    "Error, invalid frame range " << first_frame << " (" << num_frames << " frames)");
+  const int_t num_subsets = this->num_subsets();
+  values.resize((size_t)num_frames*num_subsets);
+  if(num_frames==0||num_subsets==0) return;
+  std::ifstream file(file_name_.c_str(),std::ios::in|std::ios::binary);
+  TEUCHOS_TEST_FOR_EXCEPTION(!file.is_open(),std::runtime_error,"Error, could not open binary output file " << file_name_);
+  std::vector<float> block;
+  std::vector<char> bytes;
+  for(size_t c=0;c<chunks_.size();++c){
+    const Chunk_Info & info = chunks_[c];
+    const int_t begin = std::max(first_frame,info.first_frame);
+    const int_t end = std::min(first_frame+num_frames,info.first_frame+info.num_frames);
+    if(begin>=end) continue;
+    block.resize((size_t)info.num_frames*num_subsets);
+    file.seekg(info.block_offsets[field],std::ios::beg);
+    if(info.compression==binary_output::NO_COMPRESSION){
+      // only read the frames that were requested
+      file.seekg((int64_t)(begin-info.first_frame)*num_subsets*sizeof(float),std::ios::cur);
+      read_bytes(file,&block[(size_t)(begin-info.first_frame)*num_subsets],(size_t)(end-begin)*num_subsets*sizeof(float));
+    }
+    else{
+      bytes.resize(info.block_sizes[field]);
+      if(!bytes.empty())
+        read_bytes(file,&bytes[0],bytes.size());
+      binary_output::decompress_block(info.num_frames,num_subsets,bytes.empty() ? NULL : &bytes[0],bytes.size(),&block[0]);
+    }
+    for(int_t frame=begin;frame<end;++frame){
+      const float * src = &block[(size_t)(frame-info.first_frame)*num_subsets];
+      scalar_t * dst = &values[(size_t)(frame-first_frame)*num_subsets];
+      for(int_t subset=0;subset<num_subsets;++subset)
+        dst[subset] = src[subset];
+    }
+  }
+}
+
+}// End DICe Namespace
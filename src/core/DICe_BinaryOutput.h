@@ -0,0 +1,306 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#ifndef DICE_BINARYOUTPUT_H
+#define DICE_BINARYOUTPUT_H
+
+#include <DICe.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DICe {
+
+/// \brief Binary output file layout
+///
+/// The binary output stores all of the output fields for every frame in a single file
+/// (one per processor) rather than one text file per frame. The values are columnar: the
+/// frames are grouped in chunks and each chunk holds one contiguous block per field
+/// ordered [frame][subset]. All values are stored in the byte order of the writing machine
+/// (the endian tag can be used to detect a mismatch).
+///
+/// <pre>
+/// header:
+///   char[8]   magic "DICEBIN1"
+///   uint32    endian tag 0x01020304
+///   int32     format version
+///   int32     number of fields F
+///   int32     number of subsets S
+///   int32     maximum number of frames per chunk
+///   char[64]  field name (null padded), repeated F times
+///   int32     subset global id, repeated S times
+/// chunk (repeated until the end of the file):
+///   int32     number of frames N in the chunk
+///   int32     compression flag (0 none, 1 delta/shuffle/run length)
+///   int32     frame id, repeated N times
+///   int64     number of bytes in each field block, repeated F times
+///   bytes     field blocks, each either N*S float32 values or the compressed values
+/// </pre>
+///
+/// Uncompressed chunks can be memory mapped and used directly. The compressed blocks XOR each
+/// value with the same subset's value in the previous frame of the chunk, shuffle the bytes of
+/// the resulting words into byte planes and run length encode the runs of zeros. The encoding is
+/// lossless and works well for fields that change slowly from frame to frame.
+namespace binary_output{
+  /// magic string at the start of every binary output file
+  const char magic[8] = {'D','I','C','E','B','I','N','1'};
+  /// tag used to detect the byte order of the file
+  const uint32_t endian_tag = 0x01020304;
+  /// current version of the format
+  const int32_t version = 1;
+  /// fixed length of the field names in the header
+  const int_t field_name_length = 64;
+  /// compression flags
+  enum Compression {
+    NO_COMPRESSION=0,
+    DELTA_SHUFFLE_RLE
+  };
+
+  /// \brief compress a block of values stored [frame][subset]
+  /// \param num_frames the number of frames in the block
+  /// \param num_subsets the number of subsets in the block
+  /// \param values pointer to the values
+  /// \param output the compressed bytes (overwritten)
+  DICE_LIB_DLL_EXPORT
+  void compress_block(const int_t num_frames,
+    const int_t num_subsets,
+    const float * values,
+    std::vector<char> & output);
+
+  /// \brief decompress a block of values stored [frame][subset]
+  /// \param num_frames the number of frames in the block
+  /// \param num_subsets the number of subsets in the block
+  /// \param input pointer to the compressed bytes
+  /// \param num_bytes the number of compressed bytes
+  /// \param values pointer to the output values (must be num_frames*num_subsets long)
+  DICE_LIB_DLL_EXPORT
+  void decompress_block(const int_t num_frames,
+    const int_t num_subsets,
+    const char * input,
+    const size_t num_bytes,
+    float * values);
+}
+
+/// \class DICe::Binary_Output_Writer
+/// \brief Writes the output fields of each frame to a chunked columnar binary file
+///
+/// Frames are accumulated in memory until a chunk is full, then the chunk is handed to a
+/// background thread that compresses (optionally) and writes it so the analysis does not wait
+/// on the file system. At most two chunks are pending at any time. Any error on the writer
+/// thread is re-thrown on the next call to write_frame() or close().
+class DICE_LIB_DLL_EXPORT
+Binary_Output_Writer{
+public:
+  /// \brief constructor, writes the file header and starts the writer thread
+  /// \param file_name the name of the output file (overwritten if it exists)
+  /// \param field_names the names of the fields, in the order the values are given to write_frame()
+  /// \param subset_ids the global ids of the subsets, in the order the values are given to write_frame()
+  /// \param compress true if the field blocks should be compressed
+  /// \param chunk_frames the number of frames in each chunk
+  Binary_Output_Writer(const std::string & file_name,
+    const std::vector<std::string> & field_names,
+    const std::vector<int_t> & subset_ids,
+    const bool compress=false,
+    const int_t chunk_frames=32);
+
+  /// destructor, flushes the remaining frames and closes the file
+  ~Binary_Output_Writer();
+
+  /// \brief add the values for one frame
+  /// \param frame_id the frame id
+  /// \param values the field values ordered [field][subset]
+  void write_frame(const int_t frame_id,
+    const std::vector<scalar_t> & values);
+
+  /// writes the pending frames and closes the file, further writes are not allowed
+  void close();
+
+  /// returns the number of fields
+  int_t num_fields()const{
+    return num_fields_;
+  }
+
+  /// returns the number of subsets
+  int_t num_subsets()const{
+    return num_subsets_;
+  }
+
+private:
+  /// a set of frames to be written together
+  struct Chunk{
+    /// the frame ids
+    std::vector<int32_t> frame_ids;
+    /// the values ordered [field][frame][subset]
+    std::vector<float> values;
+  };
+  /// copy constructor not allowed
+  Binary_Output_Writer(const Binary_Output_Writer &);
+  /// assignment not allowed
+  Binary_Output_Writer & operator=(const Binary_Output_Writer &);
+  /// queue the current chunk for the writer thread
+  void submit_chunk();
+  /// the writer thread's loop
+  void write_chunks();
+  /// write a single chunk to the file (called on the writer thread)
+  void write_chunk(const Chunk & chunk);
+  /// the output file
+  std::FILE * file_;
+  /// the output file name
+  const std::string file_name_;
+  /// the number of fields
+  const int_t num_fields_;
+  /// the number of subsets
+  const int_t num_subsets_;
+  /// true if the blocks should be compressed
+  const bool compress_;
+  /// the maximum number of frames per chunk
+  const int_t chunk_frames_;
+  /// the chunk being filled
+  Chunk current_;
+  /// chunks waiting to be written
+  std::deque<Chunk> pending_;
+  /// exception thrown by the writer thread (if any)
+  std::exception_ptr error_;
+  /// true once no more chunks will be queued
+  bool closing_;
+  /// true once close() has completed
+  bool closed_;
+  /// guards the queue and the state above
+  std::mutex mutex_;
+  /// signaled when the queue changes
+  std::condition_variable cond_;
+  /// the writer thread
+  std::thread thread_;
+};
+
+/// \class DICe::Binary_Output_Reader
+/// \brief Reads a file written by the DICe::Binary_Output_Writer
+///
+/// The header and the chunk index are read when the file is opened, the field values
+/// are only read when they are requested so that a single field or a range of frames can
+/// be sliced out of a large file without reading the rest of it.
+class DICE_LIB_DLL_EXPORT
+Binary_Output_Reader{
+public:
+  /// \brief constructor, reads the header and indexes the chunks
+  /// \param file_name the name of the file to read
+  Binary_Output_Reader(const std::string & file_name);
+
+  /// returns the number of fields
+  int_t num_fields()const{
+    return field_names_.size();
+  }
+
+  /// returns the field names
+  const std::vector<std::string> & field_names()const{
+    return field_names_;
+  }
+
+  /// \brief returns the index of a field, or -1 if the field is not in the file
+  /// \param field_name the name of the field
+  int_t field_index(const std::string & field_name)const;
+
+  /// returns the number of subsets
+  int_t num_subsets()const{
+    return subset_ids_.size();
+  }
+
+  /// returns the global ids of the subsets
+  const std::vector<int_t> & subset_ids()const{
+    return subset_ids_;
+  }
+
+  /// returns the number of frames in the file
+  int_t num_frames()const{
+    return frame_ids_.size();
+  }
+
+  /// returns the frame ids of all the frames in the file
+  const std::vector<int_t> & frame_ids()const{
+    return frame_ids_;
+  }
+
+  /// \brief read the values of a field for a range of frames
+  /// \param field the index of the field
+  /// \param first_frame index of the first frame in the file (not the frame id)
+  /// \param num_frames the number of frames to read
+  /// \param values the output values ordered [frame][subset] (resized)
+  void read_field(const int_t field,
+    const int_t first_frame,
+    const int_t num_frames,
+    std::vector<scalar_t> & values)const;
+
+private:
+  /// location of a chunk in the file
+  struct Chunk_Info{
+    /// index of the first frame of the chunk (among all the frames in the file)
+    int_t first_frame;
+    /// number of frames in the chunk
+    int_t num_frames;
+    /// compression flag
+    int_t compression;
+    /// file offset of each field block
+    std::vector<int64_t> block_offsets;
+    /// size in bytes of each field block
+    std::vector<int64_t> block_sizes;
+  };
+  /// the file name
+  std::string file_name_;
+  /// the field names
+  std::vector<std::string> field_names_;
+  /// the subset global ids
+  std::vector<int_t> subset_ids_;
+  /// the frame ids
+  std::vector<int_t> frame_ids_;
+  /// the chunk index
+  std::vector<Chunk_Info> chunks_;
+};
+
+}// End DICe Namespace
+
+#endif
@@ -48,8 +48,13 @@
 
 #include <Teuchos_oblackholestream.hpp>
 
+#include <algorithm>
+
 namespace DICe {
 
+/// the gids and exchange ids are sent through multifield values, which are only exact integers up to 2^24 in single precision
+static const int_t max_multifield_id = 16777216;
+
 Decomp::Decomp(const Teuchos::RCP<Teuchos::ParameterList> & input_params,
   const Teuchos::RCP<Teuchos::ParameterList> & correlation_params):
     num_global_subsets_(0),
@@ -93,6 +98,69 @@ Decomp::Decomp(Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   initialize(subset_centroids_x,subset_centroids_y,neighbor_ids,obstructing_subset_ids,correlation_params);
 }
 
+Decomp::Decomp(Teuchos::RCP<MultiField> coords,
+  const std::vector<int_t> & dest_procs,
+  const Teuchos::RCP<Teuchos::ParameterList> & correlation_params):
+    num_global_subsets_(0),
+    image_width_(-1),
+    image_height_(-1){
+  TEUCHOS_TEST_FOR_EXCEPTION(coords==Teuchos::null,std::runtime_error,"");
+  TEUCHOS_TEST_FOR_EXCEPTION(coords->get_num_fields()!=4,std::runtime_error,"Error, the coordinates should have 4 fields (x, y, gid, neighbor id)");
+  const int_t num_local = coords->get_map()->get_num_local_elements();
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)dest_procs.size()!=num_local,std::runtime_error,"");
+  comm_ = Teuchos::rcp(new MultiField_Comm());
+  num_global_subsets_ = coords->get_map()->get_num_global_elements();
+  TEUCHOS_TEST_FOR_EXCEPTION(num_global_subsets_>max_multifield_id,std::runtime_error,
+    "Error, moving subsets to new owners is limited to " << max_multifield_id << " subsets (" << num_global_subsets_ << " requested)");
+  const int_t num_procs = comm_->get_size();
+  DEBUG_MSG("Decomp::Decomp(): moving " << num_local << " subsets to their new owners");
+
+  // the subsets go directly to their new owner, only the gids are needed from the received rows
+  std::vector<std::vector<int_t> > send_rows(num_procs);
+  for(int_t i=0;i<num_local;++i){
+    TEUCHOS_TEST_FOR_EXCEPTION(dest_procs[i]<0||dest_procs[i]>=num_procs,std::runtime_error,"Error, invalid destination processor " << dest_procs[i]);
+    send_rows[dest_procs[i]].push_back(i);
+  }
+  Teuchos::RCP<MultiField> received = exchange_rows(coords,send_rows);
+  const int_t num_received = received->get_map()->get_num_local_elements();
+  Teuchos::Array<int_t> owned_gids(num_received);
+  for(int_t i=0;i<num_received;++i)
+    owned_gids[i] = received->local_value(i,2);
+  std::sort(owned_gids.begin(),owned_gids.end());
+  this_proc_gid_order_ = std::vector<int_t>(owned_gids.begin(),owned_gids.end());
+  id_decomp_map_ = Teuchos::rcp(new MultiField_Map(num_global_subsets_,owned_gids,0,*comm_));
+  TEUCHOS_TEST_FOR_EXCEPTION(!id_decomp_map_->is_one_to_one(),std::runtime_error,"");
+
+  // the owned coordinates and the ghosted neighbors are imported by gid from the old owners
+  create_geometric_overlap_map(coords,compute_max_strain_window_size(correlation_params));
+  DEBUG_MSG("[PROC "<< comm_->get_rank() <<"] num local subsets:    " << id_decomp_map_->get_num_local_elements());
+  DEBUG_MSG("[PROC "<< comm_->get_rank() <<"] num overlap subsets:  " << id_decomp_overlap_map_->get_num_local_elements());
+}
+
+scalar_t
+Decomp::compute_max_strain_window_size(const Teuchos::RCP<Teuchos::ParameterList> & correlation_params)const{
+  // TODO find a way to make sure all strain window sizes are captured here
+  //      as it is not, it only checks for NLVC and VSG sizes
+  scalar_t max_strain_window_size = 0.0;
+  scalar_t tmp_strain_window_size = 0.0;
+  if(correlation_params!=Teuchos::null){
+    if(correlation_params->isParameter(DICe::post_process_vsg_strain)){
+      Teuchos::ParameterList vsg_sublist = correlation_params->sublist(DICe::post_process_vsg_strain);
+      TEUCHOS_TEST_FOR_EXCEPTION(!vsg_sublist.isParameter(DICe::strain_window_size_in_pixels),std::runtime_error,"");
+      tmp_strain_window_size = vsg_sublist.get<int_t>(DICe::strain_window_size_in_pixels);
+      if(tmp_strain_window_size > max_strain_window_size) max_strain_window_size = tmp_strain_window_size;
+    }
+    if(correlation_params->isParameter(DICe::post_process_nlvc_strain)){
+      Teuchos::ParameterList nlvc_sublist = correlation_params->sublist(DICe::post_process_nlvc_strain);
+      TEUCHOS_TEST_FOR_EXCEPTION(!nlvc_sublist.isParameter(DICe::horizon_diameter_in_pixels),std::runtime_error,"");
+      tmp_strain_window_size = nlvc_sublist.get<int_t>(DICe::horizon_diameter_in_pixels);
+      if(tmp_strain_window_size > max_strain_window_size) max_strain_window_size = tmp_strain_window_size;
+    }
+  }
+  DEBUG_MSG("Decomp::compute_max_strain_window_size(): max strain window size " << max_strain_window_size);
+  return max_strain_window_size;
+}
+
 void
 Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   const Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
@@ -109,6 +177,26 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   for(int_t i=0;i<id_decomp_map_->get_num_local_elements();++i)
     this_proc_gid_order_[i] = id_decomp_map_->get_global_element(i);
 
+  Decomposition_Method decomp_method = EVEN_SPLIT_DECOMPOSITION;
+  if(correlation_params!=Teuchos::null){
+    if(correlation_params->isParameter(DICe::decomposition_method)){
+      if(correlation_params->isType<std::string>(DICe::decomposition_method)){
+        std::string decomp_string = correlation_params->get<std::string>(DICe::decomposition_method,"EVEN_SPLIT_DECOMPOSITION");
+        decomp_method = DICe::string_to_decomposition_method(decomp_string);
+      }
+      else{
+        decomp_method = correlation_params->get<DICe::Decomposition_Method>(DICe::decomposition_method);
+      }
+    }
+  }
+  // the geometric decomposition keeps the coordinates on the even split map so that the
+  // overlap map can be built in parallel without the neighbor search on processor 0
+  Teuchos::RCP<MultiField> even_data;
+  if(decomp_method==HILBERT_CURVE_DECOMPOSITION){
+    even_data = create_even_split_data(subset_centroids_x,subset_centroids_y,neighbor_ids);
+    create_hilbert_dist_map(even_data);
+  }
+
   // if there are blocking subsets, they need to be on the same processor and put in order:
   create_obstruction_dist_map(obstructing_subset_ids);
 
@@ -121,28 +209,13 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   // lastly, create the overlap vectors of points needed for computing VSG strain, etc.
   const bool is_parallel = comm_->get_size() > 1;
   // determine the max strain window size:
-  // TODO find a way to make sure all strain window sizes are captured here
-  //      as it is not, it only checks for NLVC and VSG sizes
-  scalar_t max_strain_window_size = 0.0;
-  scalar_t tmp_strain_window_size = 0.0;
-  if(correlation_params!=Teuchos::null){
-    if(correlation_params->isParameter(DICe::post_process_vsg_strain)){
-      Teuchos::ParameterList vsg_sublist = correlation_params->sublist(DICe::post_process_vsg_strain);
-      TEUCHOS_TEST_FOR_EXCEPTION(!vsg_sublist.isParameter(DICe::strain_window_size_in_pixels),std::runtime_error,"");
-      scalar_t tmp_strain_window_size = vsg_sublist.get<int_t>(DICe::strain_window_size_in_pixels);
-      if(tmp_strain_window_size > max_strain_window_size) max_strain_window_size = tmp_strain_window_size;
-    }
-    if(correlation_params->isParameter(DICe::post_process_nlvc_strain)){
-      Teuchos::ParameterList nlvc_sublist = correlation_params->sublist(DICe::post_process_nlvc_strain);
-      TEUCHOS_TEST_FOR_EXCEPTION(!nlvc_sublist.isParameter(DICe::horizon_diameter_in_pixels),std::runtime_error,"");
-      tmp_strain_window_size = nlvc_sublist.get<int_t>(DICe::horizon_diameter_in_pixels);
-      if(tmp_strain_window_size > max_strain_window_size) max_strain_window_size = tmp_strain_window_size;
-    }
-  }
-  DEBUG_MSG("Decomp::Decomp(): max strain window size " << max_strain_window_size);
+  const scalar_t max_strain_window_size = compute_max_strain_window_size(correlation_params);
 
+  if(is_parallel&&even_data!=Teuchos::null){
+    create_geometric_overlap_map(even_data,max_strain_window_size);
+  }
   // only do the neighbor searching if neighbors are needed:
-  if(is_parallel){
+  else if(is_parallel){
     Teuchos::Array<int_t> field_zero_owned_ids;
     // communicate the number of global subsets to all processors:
     // this is a dummy field that is used to communicate a value from proc 0 to all procs
@@ -304,6 +377,315 @@ Decomp::initialize(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
   DEBUG_MSG("[PROC "<< comm_->get_rank() <<"] num overlap subsets:  " << id_decomp_overlap_map_->get_num_local_elements());
 }
 
+Teuchos::RCP<MultiField>
+Decomp::create_even_split_data(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
+  const Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
+  const Teuchos::RCP<std::vector<int_t> > & neighbor_ids){
+  const int_t proc_id = comm_->get_rank();
+  TEUCHOS_TEST_FOR_EXCEPTION(num_global_subsets_>max_multifield_id,std::runtime_error,
+    "Error, the geometric decomposition is limited to " << max_multifield_id << " subsets (" << num_global_subsets_ << " requested)");
+  // processor 0 always has the full set of coordinates so it owns all of them to start
+  Teuchos::Array<int_t> zero_owned_ids;
+  if(proc_id==0){
+    TEUCHOS_TEST_FOR_EXCEPTION(subset_centroids_x.size()!=num_global_subsets_||subset_centroids_y.size()!=num_global_subsets_,std::runtime_error,"");
+    zero_owned_ids = Teuchos::Array<int_t>(num_global_subsets_);
+  }
+  for(int_t i=0;i<zero_owned_ids.size();++i){
+    zero_owned_ids[i] = i;
+  }
+  Teuchos::RCP<MultiField_Map> zero_map = Teuchos::rcp (new MultiField_Map(-1, zero_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> even_map = Teuchos::rcp(new MultiField_Map(num_global_subsets_,0,*comm_));
+  // fields are 0: coord_x, 1: coord_y, 2: gid, 3: neigh_id
+  Teuchos::RCP<MultiField> zero_data = Teuchos::rcp(new MultiField(zero_map,4,true));
+  Teuchos::RCP<MultiField> even_data = Teuchos::rcp(new MultiField(even_map,4,true));
+  if(proc_id==0){
+    for(int_t i=0;i<num_global_subsets_;++i){
+      zero_data->local_value(i,0) = subset_centroids_x[i];
+      zero_data->local_value(i,1) = subset_centroids_y[i];
+      zero_data->local_value(i,2) = i;
+      zero_data->local_value(i,3) = neighbor_ids!=Teuchos::null && (int_t)neighbor_ids->size() > i ? (*neighbor_ids)[i] : -1;
+    }
+  }
+  MultiField_Exporter exporter(*even_map,*zero_map);
+  even_data->do_import(zero_data,exporter,INSERT);
+  return even_data;
+}
+
+void
+Decomp::create_hilbert_dist_map(Teuchos::RCP<MultiField> even_data){
+  const int_t proc_id = comm_->get_rank();
+  const int_t num_procs = comm_->get_size();
+  const int_t num_local = even_data->get_map()->get_num_local_elements();
+
+  std::vector<uint64_t> keys(num_local,0);
+  for(int_t i=0;i<num_local;++i){
+    const scalar_t x = even_data->local_value(i,0);
+    const scalar_t y = even_data->local_value(i,1);
+    keys[i] = hilbert_key(x > 0.0 ? (uint32_t)(x + 0.5) : 0,y > 0.0 ? (uint32_t)(y + 0.5) : 0);
+  }
+  std::vector<uint64_t> sorted_keys(keys);
+  std::sort(sorted_keys.begin(),sorted_keys.end());
+
+  // evenly spaced samples of the sorted keys from each processor are gathered on processor 0
+  // (the keys are split into two 16 bit halves so they are exact in a single precision multifield)
+  const int_t samples_per_proc = 64;
+  const int_t num_samples = std::min(samples_per_proc,num_local);
+  Teuchos::Array<int_t> sample_owned_ids(samples_per_proc);
+  for(int_t i=0;i<samples_per_proc;++i)
+    sample_owned_ids[i] = proc_id*samples_per_proc + i;
+  Teuchos::Array<int_t> sample_zero_ids;
+  if(proc_id==0){
+    sample_zero_ids = Teuchos::Array<int_t>(num_procs*samples_per_proc);
+    for(int_t i=0;i<sample_zero_ids.size();++i)
+      sample_zero_ids[i] = i;
+  }
+  Teuchos::RCP<MultiField_Map> sample_map = Teuchos::rcp (new MultiField_Map(-1, sample_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> sample_zero_map = Teuchos::rcp (new MultiField_Map(-1, sample_zero_ids,0,*comm_));
+  // fields are 0: key high bits, 1: key low bits, 2: 1.0 if the sample is valid
+  Teuchos::RCP<MultiField> sample_data = Teuchos::rcp(new MultiField(sample_map,3,true));
+  Teuchos::RCP<MultiField> sample_zero_data = Teuchos::rcp(new MultiField(sample_zero_map,3,true));
+  for(int_t i=0;i<num_samples;++i){
+    const uint64_t key = sorted_keys[((2*i+1)*num_local)/(2*num_samples)];
+    sample_data->local_value(i,0) = (key >> 16) & 0xFFFF;
+    sample_data->local_value(i,1) = key & 0xFFFF;
+    sample_data->local_value(i,2) = 1.0;
+  }
+  MultiField_Exporter sample_exporter(*sample_zero_map,*sample_map);
+  sample_zero_data->do_import(sample_data,sample_exporter,INSERT);
+
+  // processor 0 picks the splitting keys and sends them to all procs (entry 0 is not used)
+  Teuchos::Array<int_t> splitter_zero_ids;
+  Teuchos::Array<int_t> splitter_all_ids(num_procs);
+  for(int_t i=0;i<num_procs;++i){
+    if(proc_id==0) splitter_zero_ids.push_back(i);
+    splitter_all_ids[i] = i;
+  }
+  Teuchos::RCP<MultiField_Map> splitter_zero_map = Teuchos::rcp (new MultiField_Map(-1, splitter_zero_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> splitter_all_map = Teuchos::rcp (new MultiField_Map(-1, splitter_all_ids,0,*comm_));
+  Teuchos::RCP<MultiField> splitter_zero_data = Teuchos::rcp(new MultiField(splitter_zero_map,2,true));
+  Teuchos::RCP<MultiField> splitter_all_data = Teuchos::rcp(new MultiField(splitter_all_map,2,true));
+  if(proc_id==0){
+    std::vector<uint64_t> samples;
+    for(int_t i=0;i<num_procs*samples_per_proc;++i){
+      if(sample_zero_data->local_value(i,2) <= 0.0) continue;
+      samples.push_back(((uint64_t)sample_zero_data->local_value(i,0) << 16) | (uint64_t)sample_zero_data->local_value(i,1));
+    }
+    std::sort(samples.begin(),samples.end());
+    for(int_t proc=1;proc<num_procs&&samples.size()>0;++proc){
+      const uint64_t key = samples[(proc*samples.size())/num_procs];
+      splitter_zero_data->local_value(proc,0) = (key >> 16) & 0xFFFF;
+      splitter_zero_data->local_value(proc,1) = key & 0xFFFF;
+    }
+  }
+  MultiField_Exporter splitter_exporter(*splitter_all_map,*splitter_zero_map);
+  splitter_all_data->do_import(splitter_zero_data,splitter_exporter,INSERT);
+  std::vector<uint64_t> splitters(num_procs>1?num_procs-1:0);
+  for(int_t proc=1;proc<num_procs;++proc)
+    splitters[proc-1] = ((uint64_t)splitter_all_data->local_value(proc,0) << 16) | (uint64_t)splitter_all_data->local_value(proc,1);
+
+  // each subset goes straight from the even split to the processor that owns its stretch of the curve
+  std::vector<std::vector<int_t> > send_rows(num_procs);
+  for(int_t i=0;i<num_local;++i){
+    const int_t dest = std::upper_bound(splitters.begin(),splitters.end(),keys[i]) - splitters.begin();
+    send_rows[dest].push_back(i);
+  }
+  Teuchos::RCP<MultiField> received = exchange_rows(even_data,send_rows);
+  const int_t num_received = received->get_map()->get_num_local_elements();
+  Teuchos::Array<int_t> owned_gids(num_received);
+  for(int_t i=0;i<num_received;++i)
+    owned_gids[i] = received->local_value(i,2);
+  std::sort(owned_gids.begin(),owned_gids.end());
+  DEBUG_MSG("[PROC "<<proc_id <<"] Decomp::create_hilbert_dist_map(): owns " << num_received << " subsets");
+  this_proc_gid_order_ = std::vector<int_t>(owned_gids.begin(),owned_gids.end());
+  id_decomp_map_ = Teuchos::rcp(new MultiField_Map(num_global_subsets_,owned_gids,0,*comm_));
+}
+
+void
+Decomp::create_geometric_overlap_map(Teuchos::RCP<MultiField> even_data,
+  const scalar_t & max_strain_window_size){
+  const int_t proc_id = comm_->get_rank();
+  const int_t num_procs = comm_->get_size();
+
+  // the seed and obstruction maps may have changed the owners, so the owned coordinates are imported by gid
+  Teuchos::RCP<MultiField> owned_data = Teuchos::rcp(new MultiField(id_decomp_map_,4,true));
+  MultiField_Exporter owned_exporter(*id_decomp_map_,*even_data->get_map());
+  owned_data->do_import(even_data,owned_exporter,INSERT);
+  const int_t num_owned = id_decomp_map_->get_num_local_elements();
+
+  Teuchos::RCP<MultiField> ghost_data;
+  std::vector<int_t> ghost_rows;
+  if(max_strain_window_size > 0.0){
+    // share the bounding box of the owned points with every processor
+    Teuchos::Array<int_t> box_owned_ids(1,proc_id);
+    Teuchos::Array<int_t> box_all_ids(num_procs);
+    for(int_t i=0;i<num_procs;++i)
+      box_all_ids[i] = i;
+    Teuchos::RCP<MultiField_Map> box_map = Teuchos::rcp (new MultiField_Map(-1, box_owned_ids,0,*comm_));
+    Teuchos::RCP<MultiField_Map> box_all_map = Teuchos::rcp (new MultiField_Map(-1, box_all_ids,0,*comm_));
+    // fields are 0: min x, 1: max x, 2: min y, 3: max y (an empty box has min > max)
+    Teuchos::RCP<MultiField> box_data = Teuchos::rcp(new MultiField(box_map,4,true));
+    Teuchos::RCP<MultiField> box_all_data = Teuchos::rcp(new MultiField(box_all_map,4,true));
+    const scalar_t big = 1.0E30;
+    box_data->local_value(0,0) = big;
+    box_data->local_value(0,1) = -big;
+    box_data->local_value(0,2) = big;
+    box_data->local_value(0,3) = -big;
+    for(int_t i=0;i<num_owned;++i){
+      box_data->local_value(0,0) = std::min(box_data->local_value(0,0),owned_data->local_value(i,0));
+      box_data->local_value(0,1) = std::max(box_data->local_value(0,1),owned_data->local_value(i,0));
+      box_data->local_value(0,2) = std::min(box_data->local_value(0,2),owned_data->local_value(i,1));
+      box_data->local_value(0,3) = std::max(box_data->local_value(0,3),owned_data->local_value(i,1));
+    }
+    MultiField_Exporter box_exporter(*box_all_map,*box_map);
+    box_all_data->do_import(box_data,box_exporter,INSERT);
+
+    // send each point to the other processors whose box grown by the window radius contains it
+    const scalar_t radius = max_strain_window_size/2.0;
+    std::vector<std::vector<int_t> > send_rows(num_procs);
+    for(int_t i=0;i<num_owned;++i){
+      const scalar_t x = owned_data->local_value(i,0);
+      const scalar_t y = owned_data->local_value(i,1);
+      for(int_t proc=0;proc<num_procs;++proc){
+        if(proc==proc_id) continue;
+        if(x < box_all_data->local_value(proc,0) - radius || x > box_all_data->local_value(proc,1) + radius) continue;
+        if(y < box_all_data->local_value(proc,2) - radius || y > box_all_data->local_value(proc,3) + radius) continue;
+        send_rows[proc].push_back(i);
+      }
+    }
+    ghost_data = exchange_rows(owned_data,send_rows);
+    const int_t num_candidates = ghost_data->get_map()->get_num_local_elements();
+    DEBUG_MSG("[PROC "<<proc_id <<"] Decomp::create_geometric_overlap_map(): received " << num_candidates << " candidate neighbors");
+
+    // keep the candidates that are within the window of an owned point (the same test as the serial neighbor search)
+    if(num_owned>0&&num_candidates>0){
+      Teuchos::RCP<Point_Cloud_2D<scalar_t> > point_cloud = Teuchos::rcp(new Point_Cloud_2D<scalar_t>());
+      point_cloud->pts.resize(num_owned);
+      for(int_t i=0;i<num_owned;++i){
+        point_cloud->pts[i].x = owned_data->local_value(i,0);
+        point_cloud->pts[i].y = owned_data->local_value(i,1);
+      }
+      Teuchos::RCP<kd_tree_2d_t> kd_tree = Teuchos::rcp(new kd_tree_2d_t(2 /*dim*/, *point_cloud.get(), nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */) ) );
+      kd_tree->buildIndex();
+      const scalar_t tiny = 1.0E-5;
+      const scalar_t neigh_rad_2 = radius*radius + tiny;
+      scalar_t query_pt[2];
+      size_t ret_index = 0;
+      scalar_t out_dist_sqr = 0.0;
+      for(int_t i=0;i<num_candidates;++i){
+        query_pt[0] = ghost_data->local_value(i,0);
+        query_pt[1] = ghost_data->local_value(i,1);
+        kd_tree->knnSearch(&query_pt[0],1,&ret_index,&out_dist_sqr);
+        if(out_dist_sqr <= neigh_rad_2)
+          ghost_rows.push_back(i);
+      }
+    }
+  } // end window_size > 0
+
+  // the overlap list is ordered by gid, (gid, row) with the ghosted rows stored as -1-row
+  std::vector<std::pair<int_t,int_t> > overlap_rows;
+  overlap_rows.reserve(num_owned + ghost_rows.size());
+  for(int_t i=0;i<num_owned;++i)
+    overlap_rows.push_back(std::pair<int_t,int_t>(id_decomp_map_->get_global_element(i),i));
+  for(size_t i=0;i<ghost_rows.size();++i)
+    overlap_rows.push_back(std::pair<int_t,int_t>((int_t)ghost_data->local_value(ghost_rows[i],2),-1-ghost_rows[i]));
+  std::sort(overlap_rows.begin(),overlap_rows.end());
+  const int_t num_overlap = overlap_rows.size();
+  Teuchos::Array<int_t> overlap_gids(num_overlap);
+  overlap_coords_x_.resize(num_overlap,0.0);
+  overlap_coords_y_.resize(num_overlap,0.0);
+  neighbor_ids_ = Teuchos::rcp(new std::vector<int_t>(num_overlap,-1));
+  for(int_t i=0;i<num_overlap;++i){
+    const int_t row = overlap_rows[i].second;
+    Teuchos::RCP<MultiField> data = row>=0 ? owned_data : ghost_data;
+    const int_t local_row = row>=0 ? row : -1-row;
+    overlap_gids[i] = overlap_rows[i].first;
+    overlap_coords_x_[i] = data->local_value(local_row,0);
+    overlap_coords_y_[i] = data->local_value(local_row,1);
+    (*neighbor_ids_)[i] = data->local_value(local_row,3);
+  }
+  id_decomp_overlap_map_ = Teuchos::rcp(new MultiField_Map(-1,overlap_gids,0,*comm_));
+  DEBUG_MSG("Decomp::create_geometric_overlap_map(): coordinate list has been trimmed");
+}
+
+Teuchos::RCP<MultiField>
+Decomp::exchange_rows(Teuchos::RCP<MultiField> source,
+  const std::vector<std::vector<int_t> > & send_rows){
+  const int_t proc_id = comm_->get_rank();
+  const int_t num_procs = comm_->get_size();
+  const int_t num_fields = source->get_num_fields();
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)send_rows.size()!=num_procs,std::runtime_error,"");
+
+  // processor 0 gathers the num_procs x num_procs matrix of send counts and assigns each
+  // (source, destination) pair a block of ids in an index space ordered by destination
+  Teuchos::Array<int_t> count_owned_ids(num_procs);
+  for(int_t i=0;i<num_procs;++i)
+    count_owned_ids[i] = proc_id*num_procs + i;
+  Teuchos::Array<int_t> count_zero_ids;
+  if(proc_id==0){
+    count_zero_ids = Teuchos::Array<int_t>(num_procs*num_procs);
+    for(int_t i=0;i<count_zero_ids.size();++i)
+      count_zero_ids[i] = i;
+  }
+  Teuchos::RCP<MultiField_Map> count_map = Teuchos::rcp (new MultiField_Map(-1, count_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> count_zero_map = Teuchos::rcp (new MultiField_Map(-1, count_zero_ids,0,*comm_));
+  // fields are 0: number of rows sent, 1: first id of the block for these rows,
+  // 2: first id received by this processor, 3: number of ids received by this processor (2 and 3 only in the first entry),
+  // 4: total number of ids in the exchange
+  Teuchos::RCP<MultiField> count_data = Teuchos::rcp(new MultiField(count_map,5,true));
+  Teuchos::RCP<MultiField> count_zero_data = Teuchos::rcp(new MultiField(count_zero_map,5,true));
+  for(int_t proc=0;proc<num_procs;++proc)
+    count_data->local_value(proc,0) = send_rows[proc].size();
+  MultiField_Exporter count_exporter(*count_zero_map,*count_map);
+  count_zero_data->do_import(count_data,count_exporter,INSERT);
+  if(proc_id==0){
+    int_t current_index = 0;
+    for(int_t dest=0;dest<num_procs;++dest){
+      count_zero_data->local_value(dest*num_procs,2) = current_index;
+      for(int_t src=0;src<num_procs;++src){
+        count_zero_data->local_value(src*num_procs+dest,1) = current_index;
+        current_index += count_zero_data->local_value(src*num_procs+dest,0);
+      }
+      count_zero_data->local_value(dest*num_procs,3) = current_index - count_zero_data->local_value(dest*num_procs,2);
+    }
+    // the total is only compared to the limit, so it does not matter if it is rounded
+    for(int_t i=0;i<num_procs*num_procs;++i)
+      count_zero_data->local_value(i,4) = current_index;
+  }
+  MultiField_Exporter count_exporter_rev(*count_map,*count_zero_map);
+  count_data->do_import(count_zero_data,count_exporter_rev,INSERT);
+  // every processor sees the same total so they all throw together
+  TEUCHOS_TEST_FOR_EXCEPTION(count_data->local_value(0,4)>max_multifield_id,std::runtime_error,
+    "Error, too many rows in the exchange between processors (" << count_data->local_value(0,4) << "), the limit is " << max_multifield_id);
+
+  // the rows move directly from the sending to the receiving processor
+  Teuchos::Array<int_t> send_ids;
+  for(int_t dest=0;dest<num_procs;++dest){
+    const int_t first_id = count_data->local_value(dest,1);
+    for(size_t i=0;i<send_rows[dest].size();++i)
+      send_ids.push_back(first_id + i);
+  }
+  const int_t first_recv_id = count_data->local_value(0,2);
+  const int_t num_recv = count_data->local_value(0,3);
+  Teuchos::Array<int_t> recv_ids(num_recv);
+  for(int_t i=0;i<num_recv;++i)
+    recv_ids[i] = first_recv_id + i;
+  Teuchos::RCP<MultiField_Map> send_map = Teuchos::rcp (new MultiField_Map(-1, send_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> recv_map = Teuchos::rcp (new MultiField_Map(-1, recv_ids,0,*comm_));
+  Teuchos::RCP<MultiField> send_data = Teuchos::rcp(new MultiField(send_map,num_fields,true));
+  Teuchos::RCP<MultiField> recv_data = Teuchos::rcp(new MultiField(recv_map,num_fields,true));
+  int_t send_index = 0;
+  for(int_t dest=0;dest<num_procs;++dest){
+    for(size_t i=0;i<send_rows[dest].size();++i){
+      for(int_t field=0;field<num_fields;++field)
+        send_data->local_value(send_index,field) = source->local_value(send_rows[dest][i],field);
+      send_index++;
+    }
+  }
+  MultiField_Exporter exporter(*recv_map,*send_map);
+  recv_data->do_import(send_data,exporter,INSERT);
+  return recv_data;
+}
+
 void
 Decomp::create_obstruction_dist_map(Teuchos::RCP<std::map<int_t,std::vector<int_t> > > & obstructing_subset_ids){
   if(obstructing_subset_ids==Teuchos::null) return;
@@ -691,7 +1073,7 @@ Decomp::populate_coordinate_vectors(const std::string & image_file_name,
     }
   }
   const scalar_t grad_threshold = correlation_params->get<double>(DICe::sssig_threshold,50.0);
-  if((optimization_method==GRADIENT_BASED || optimization_method==GRADIENT_BASED_THEN_SIMPLEX)&&grad_threshold > 0.0&&subset_size>0){
+  if((optimization_method==GRADIENT_BASED || optimization_method==GRADIENT_BASED_THEN_SIMPLEX || optimization_method==INVERSE_COMPOSITIONAL)&&grad_threshold > 0.0&&subset_size>0){
     sssig_check_done = true;
     // split up the points across processors and check the SSSIG:
 
@@ -1116,6 +1498,38 @@ bool valid_correlation_point(const int_t x_coord,
   return true;
 }
 
+DICE_LIB_DLL_EXPORT
+uint64_t morton_key(const uint32_t x,
+  const uint32_t y){
+  uint64_t key = 0;
+  for(int_t bit=0;bit<16;++bit){
+    key |= (uint64_t)((x >> bit) & 1) << (2*bit);
+    key |= (uint64_t)((y >> bit) & 1) << (2*bit+1);
+  }
+  return key;
+}
 
+DICE_LIB_DLL_EXPORT
+uint64_t hilbert_key(const uint32_t x,
+  const uint32_t y){
+  const uint32_t n = 1 << 16;
+  uint32_t hx = x & (n-1);
+  uint32_t hy = y & (n-1);
+  uint64_t key = 0;
+  for(uint32_t s=n/2;s>0;s/=2){
+    const uint32_t rx = (hx & s) > 0;
+    const uint32_t ry = (hy & s) > 0;
+    key += (uint64_t)s * s * ((3 * rx) ^ ry);
+    // rotate the quadrant so the curve stays continuous
+    if(ry==0){
+      if(rx==1){
+        hx = s-1 - (hx & (s-1)) + (hx & ~(s-1));
+        hy = s-1 - (hy & (s-1)) + (hy & ~(s-1));
+      }
+      std::swap(hx,hy);
+    }
+  }
+  return key;
+}
 
 }// End DICe Namespace
@@ -54,6 +54,8 @@
 
 #include <Teuchos_RCP.hpp>
 
+#include <cstdint>
+
 /*!
  *  \namespace DICe
  *  @{
@@ -84,6 +86,15 @@ public:
     Teuchos::RCP<std::map<int_t,std::vector<int_t> > > obstructing_subset_ids,
     const Teuchos::RCP<Teuchos::ParameterList> & correlation_params);
 
+  /// constructor that moves a set of already distributed subsets to new owners
+  /// (used to rebalance the subsets between frames)
+  /// \param coords the locally owned subsets on any one-to-one map (fields are 0: x, 1: y, 2: gid, 3: neighbor id)
+  /// \param dest_procs the processor that will own each local row of coords
+  /// \param correlation_params pointer to the parameters used for the correlation
+  Decomp(Teuchos::RCP<MultiField> coords,
+    const std::vector<int_t> & dest_procs,
+    const Teuchos::RCP<Teuchos::ParameterList> & correlation_params);
+
   /// destructor
   ~Decomp(){};
 
@@ -179,6 +190,41 @@ private:
     Teuchos::RCP<std::map<int_t,std::vector<int_t> > > & obstructing_subset_ids,
     const Teuchos::RCP<Teuchos::ParameterList> & correlation_params);
 
+  /// scatter the coordinates and neighbor ids from the input arrays to the evenly split map
+  /// (fields are 0: x, 1: y, 2: gid, 3: neighbor id)
+  /// \param subset_centroids_x x coordinates of all global points (only needed on processor 0)
+  /// \param subset_centroids_y y coordinates of all global points (only needed on processor 0)
+  /// \param neighbor_ids the neighbors in global ids (only needed on processor 0)
+  Teuchos::RCP<MultiField> create_even_split_data(const Teuchos::ArrayRCP<scalar_t> subset_centroids_x,
+    const Teuchos::ArrayRCP<scalar_t> subset_centroids_y,
+    const Teuchos::RCP<std::vector<int_t> > & neighbor_ids);
+
+  /// redo the decomposition so that each processor owns a contiguous stretch of a Hilbert curve through
+  /// the subset centroids. Processor 0 only sees a fixed number of sampled keys from each processor to pick
+  /// the splitting keys, the subsets themselves move directly from the even split to their new owner
+  /// \param even_data the coordinates on the evenly split map from create_even_split_data()
+  void create_hilbert_dist_map(Teuchos::RCP<MultiField> even_data);
+
+  /// create the overlap map and coordinates in parallel: each processor sends its points to the processors
+  /// whose bounding box (grown by the strain window) contains them and the receiver keeps the ones that are
+  /// within the window of one of its own points
+  /// \param even_data the coordinates on any one-to-one map, e.g. the even split from create_even_split_data()
+  /// \param max_strain_window_size the largest strain window in pixels
+  void create_geometric_overlap_map(Teuchos::RCP<MultiField> even_data,
+    const scalar_t & max_strain_window_size);
+
+  /// returns the largest strain window in pixels from the post processor sublists
+  /// (the overlap map has to include all the neighbors within this window)
+  /// \param correlation_params correlation parameters from xml file
+  scalar_t compute_max_strain_window_size(const Teuchos::RCP<Teuchos::ParameterList> & correlation_params)const;
+
+  /// send rows of a multifield to other processors, returns a multifield with the rows received
+  /// by this processor ordered by the sending processor. Only the send counts go through processor 0.
+  /// \param source the multifield with the rows to send
+  /// \param send_rows the local row ids to send to each processor
+  Teuchos::RCP<MultiField> exchange_rows(Teuchos::RCP<MultiField> source,
+    const std::vector<std::vector<int_t> > & send_rows);
+
   /// total number of points in the discretization
   int_t num_global_subsets_;
   /// image width of reference image (used for filtering points out of bounds)
@@ -245,6 +291,21 @@ bool valid_correlation_point(const int_t x_coord,
   const scalar_t & grad_threshold=0.0);
 
 
+/// \brief Morton (Z-order) index of a point, interleaves the bits of the coordinates
+/// \param x x coordinate (only the lower 16 bits are used)
+/// \param y y coordinate (only the lower 16 bits are used)
+DICE_LIB_DLL_EXPORT
+uint64_t morton_key(const uint32_t x,
+  const uint32_t y);
+
+/// \brief Hilbert curve index of a point on a 2^16 x 2^16 grid. Points that are close
+/// along the curve are always close in the plane (unlike the Morton order which has long jumps)
+/// \param x x coordinate (only the lower 16 bits are used)
+/// \param y y coordinate (only the lower 16 bits are used)
+DICE_LIB_DLL_EXPORT
+uint64_t hilbert_key(const uint32_t x,
+  const uint32_t y);
+
 }// End DICe Namespace
 
 /*! @} End of Doxygen namespace*/
@@ -0,0 +1,136 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe_ImagePrefetcher.h>
+
+namespace DICe {
+
+Image_Prefetcher::Image_Prefetcher(const std::vector<std::string> & image_files,
+  const Teuchos::RCP<Teuchos::ParameterList> & image_params,
+  const int_t first_frame,
+  const int_t last_frame,
+  const int_t depth,
+  const std::vector<int_t> & window):
+  image_files_(image_files),
+  image_params_(image_params==Teuchos::null ? Teuchos::ParameterList() : *image_params),
+  last_frame_(last_frame),
+  depth_(depth),
+  window_(window),
+  next_consumed_frame_(first_frame),
+  stop_(false)
+{
+  TEUCHOS_TEST_FOR_EXCEPTION(depth<=0,std::runtime_error,"Error, the prefetch depth must be greater than zero");
+  TEUCHOS_TEST_FOR_EXCEPTION(first_frame<0||last_frame>=(int_t)image_files.size(),std::runtime_error,
+    "Error, invalid frame range for image prefetching " << first_frame << " to " << last_frame);
+  TEUCHOS_TEST_FOR_EXCEPTION(!window.empty()&&window.size()!=4,std::runtime_error,"Error, the prefetch window must have four values");
+  DEBUG_MSG("Image_Prefetcher::Image_Prefetcher(): reading frames " << first_frame << " to " << last_frame << " with depth " << depth);
+  thread_ = std::thread(&Image_Prefetcher::read_frames,this,first_frame);
+}
+
+Image_Prefetcher::~Image_Prefetcher(){
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if(thread_.joinable())
+    thread_.join();
+}
+
+void
+Image_Prefetcher::read_frames(const int_t first_frame){
+  for(int_t frame=first_frame;frame<=last_frame_;++frame){
+    std::vector<int_t> window;
+    {
+      // wait for room in the queue
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock,[this]{return stop_||(int_t)ready_.size()<depth_;});
+      if(stop_) return;
+      window = window_;
+    }
+    Teuchos::RCP<Image> img;
+    try{
+      Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList(image_params_));
+      if(window.empty())
+        img = Teuchos::rcp(new Image(image_files_[frame].c_str(),params));
+      else
+        img = Teuchos::rcp(new Image(image_files_[frame].c_str(),window[0],window[1],window[2],window[3],params));
+    }
+    catch(...){
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+      cond_.notify_all();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.push_back(img);
+    // release this thread's reference while the lock is held so the
+    // reference count is never modified concurrently by both threads
+    img = Teuchos::null;
+    cond_.notify_all();
+  }
+}
+
+Teuchos::RCP<Image>
+Image_Prefetcher::image(const int_t frame){
+  std::unique_lock<std::mutex> lock(mutex_);
+  TEUCHOS_TEST_FOR_EXCEPTION(frame!=next_consumed_frame_||frame>last_frame_,std::runtime_error,
+    "Error, prefetched frames must be requested in order, expected frame " << next_consumed_frame_ << " requested " << frame);
+  cond_.wait(lock,[this]{return !ready_.empty()||error_;});
+  if(ready_.empty()){
+    // the background thread failed before this frame was read
+    std::rethrow_exception(error_);
+  }
+  Teuchos::RCP<Image> img = ready_.front();
+  ready_.pop_front();
+  next_consumed_frame_++;
+  cond_.notify_all();
+  return img;
+}
+
+void
+Image_Prefetcher::set_window(const std::vector<int_t> & window){
+  TEUCHOS_TEST_FOR_EXCEPTION(!window.empty()&&window.size()!=4,std::runtime_error,"Error, the prefetch window must have four values");
+  std::lock_guard<std::mutex> lock(mutex_);
+  window_ = window;
+}
+
+}// End DICe Namespace
@@ -0,0 +1,138 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#ifndef DICE_IMAGEPREFETCHER_H
+#define DICE_IMAGEPREFETCHER_H
+
+#include <DICe.h>
+#include <DICe_Image.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DICe {
+
+/// \class DICe::Image_Prefetcher
+/// \brief Reads a sequence of images on a background thread so that the file read,
+/// filtering and gradient computation overlap with the correlation of the current frame
+///
+/// The prefetcher is a bounded producer/consumer queue: the background thread reads frames
+/// in order and stays at most depth frames ahead of the consumer. Frames must be requested in
+/// the same order they are read. Any exception thrown while reading a frame is re-thrown
+/// on the consumer thread when that frame is requested.
+///
+/// By default the images are read in full. If a window is set, only that portion of each frame
+/// is read (and filtered, etc.). Since the region of interest depends on the solution of the frames
+/// that have not been correlated yet, the window should include a margin for the motion between frames
+/// and the consumer should check that a prefetched frame covers the region it needs.
+class DICE_LIB_DLL_EXPORT
+Image_Prefetcher{
+public:
+  /// \brief constructor, starts the background thread
+  /// \param image_files the list of image file names
+  /// \param image_params parameters used to read each image (filtering, gradients, etc.)
+  /// \param first_frame index in image_files of the first frame to read
+  /// \param last_frame index in image_files of the last frame to read
+  /// \param depth the maximum number of frames read ahead of the frame being consumed
+  /// \param window optional window to read from each frame (offset_x, offset_y, width, height), empty for the full frame
+  Image_Prefetcher(const std::vector<std::string> & image_files,
+    const Teuchos::RCP<Teuchos::ParameterList> & image_params,
+    const int_t first_frame,
+    const int_t last_frame,
+    const int_t depth,
+    const std::vector<int_t> & window=std::vector<int_t>());
+
+  /// destructor, stops and joins the background thread
+  ~Image_Prefetcher();
+
+  /// \brief returns the image for the given frame, blocks until the frame has been read
+  /// \param frame index in image_files of the requested frame (must be the next frame in the sequence)
+  Teuchos::RCP<Image> image(const int_t frame);
+
+  /// \brief sets the window read from the frames that have not been read yet
+  /// \param window the window (offset_x, offset_y, width, height), empty for the full frame
+  void set_window(const std::vector<int_t> & window);
+
+private:
+  /// copy constructor not allowed
+  Image_Prefetcher(const Image_Prefetcher &);
+  /// assignment not allowed
+  Image_Prefetcher & operator=(const Image_Prefetcher &);
+  /// \brief the background thread's read loop
+  /// \param first_frame index in image_files of the first frame to read
+  void read_frames(const int_t first_frame);
+  /// the image file names
+  const std::vector<std::string> image_files_;
+  /// parameters used to read the images (copied for each frame since the image constructor may modify them)
+  const Teuchos::ParameterList image_params_;
+  /// index of the last frame to read
+  const int_t last_frame_;
+  /// maximum number of frames in the queue
+  const int_t depth_;
+  /// window read from each frame (offset_x, offset_y, width, height), empty for the full frame
+  std::vector<int_t> window_;
+  /// index of the next frame to be handed to the consumer
+  int_t next_consumed_frame_;
+  /// frames that have been read but not consumed, in order
+  std::deque<Teuchos::RCP<Image> > ready_;
+  /// exception thrown by the background thread (if any)
+  std::exception_ptr error_;
+  /// true if the background thread should stop
+  bool stop_;
+  /// guards the queue and the state above
+  std::mutex mutex_;
+  /// signaled when the queue changes
+  std::condition_variable cond_;
+  /// the background thread
+  std::thread thread_;
+};
+
+}// End DICe Namespace
+
+#endif
@@ -44,6 +44,7 @@
 #include <DICe_FieldEnums.h>
 #include <DICe_FFT.h>
 #include <DICe_Feature.h>
+#include <DICe_Profiler.h>
 
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_LAPACK.hpp>
@@ -53,6 +54,7 @@
 #include <fstream>
 #include <math.h>
 #include <cassert>
+#include <algorithm>
 
 #include <Teuchos_TimeMonitor.hpp>
 
@@ -333,6 +335,7 @@ Search_Initializer::initial_guess(const int_t subset_gid,
   Teuchos::RCP<Local_Shape_Function> shape_function){
 
   DEBUG_MSG("Search_Initializer::initial_guess(): called for subset " << subset_gid);
+  profiler::Scope search_scope(profiler::SEARCH_INITIALIZATION);
 
   TEUCHOS_TEST_FOR_EXCEPTION(step_size_u_==0.0,std::runtime_error,"Error, step x size must not be 0");
   TEUCHOS_TEST_FOR_EXCEPTION(step_size_v_==0.0,std::runtime_error,"Error, step y size must not be 0");
@@ -395,12 +398,436 @@ Search_Initializer::initial_guess(const int_t subset_gid,
     return INITIALIZE_FAILED;
 };
 
+Image_Pyramid_Initializer::Image_Pyramid_Initializer(Schema * schema,
+  const int_t num_levels,
+  const int_t search_radius):
+  Initializer(schema),
+  num_levels_(num_levels),
+  active_levels_(0),
+  search_radius_(search_radius){
+  TEUCHOS_TEST_FOR_EXCEPTION(num_levels<1,std::invalid_argument,"Error, the image pyramid initializer needs at least one level");
+  TEUCHOS_TEST_FOR_EXCEPTION(search_radius<1,std::invalid_argument,"Error, invalid search radius for the image pyramid initializer");
+  if(schema)
+    TEUCHOS_TEST_FOR_EXCEPTION(schema->shape_function_type()==DICe::RIGID_BODY_SF,std::runtime_error,
+    "Image_Pyramid_Initializer cannot be used with rigid body shape function (only field value init is allowed)");
+};
+
+void
+Image_Pyramid_Initializer::pre_execution_tasks(){
+  assert(schema_->ref_img()!=Teuchos::null);
+  assert(schema_->def_img()!=Teuchos::null);
+  // limit the number of levels so the coarsest image is still a useful size
+  const int_t min_coarse_dim = 16;
+  const int_t min_dim = std::min(std::min(schema_->ref_img()->width(),schema_->ref_img()->height()),
+    std::min(schema_->def_img()->width(),schema_->def_img()->height()));
+  active_levels_ = num_levels_;
+  while(active_levels_>0 && (min_dim >> active_levels_) < min_coarse_dim)
+    active_levels_--;
+  // levels that already exist are reused so the reference pyramid is only built once
+  schema_->ref_img()->build_pyramid(active_levels_);
+  schema_->def_img()->build_pyramid(active_levels_);
+  DEBUG_MSG("Image_Pyramid_Initializer::pre_execution_tasks(): using " << active_levels_ << " pyramid levels");
+}
+
+scalar_t
+Image_Pyramid_Initializer::level_gamma(Subset & subset,
+  Teuchos::RCP<Image> def_level,
+  Teuchos::RCP<Local_Shape_Function> shape_function,
+  const scalar_t & u,
+  const scalar_t & v,
+  const scalar_t & t){
+  scalar_t gamma = 100.0;
+  try{
+    shape_function->insert_motion(u,v,t);
+    subset.initialize(def_level,DEF_INTENSITIES,shape_function,BILINEAR);
+    // a subset mapped mostly off the image can match spuriously well on the few pixels left
+    if(subset.num_active_pixels() < subset.num_pixels()/2) return gamma;
+    gamma = subset.gamma();
+    if(gamma<0.0) gamma = 4.0; // catch a failed gamma eval
+  }
+  catch(...){
+    gamma = 100.0;
+  }
+  return gamma;
+}
+
+Status_Flag
+Image_Pyramid_Initializer::initial_guess(const int_t subset_gid,
+  Teuchos::RCP<Local_Shape_Function> shape_function){
+
+  // start from the previous solution
+  scalar_t u = schema_->global_field_value(subset_gid,SUBSET_DISPLACEMENT_X_FS);
+  scalar_t v = schema_->global_field_value(subset_gid,SUBSET_DISPLACEMENT_Y_FS);
+  scalar_t t = schema_->global_field_value(subset_gid,ROTATION_Z_FS);
+  const scalar_t cx = schema_->global_field_value(subset_gid,SUBSET_COORDINATES_X_FS);
+  const scalar_t cy = schema_->global_field_value(subset_gid,SUBSET_COORDINATES_Y_FS);
+  // conformal subsets do not have a subset dim, use a typical square size on the coarse levels
+  const int_t subset_dim = schema_->subset_dim() > 0 ? schema_->subset_dim() : 41;
+  TEUCHOS_TEST_FOR_EXCEPTION(active_levels_>schema_->def_img()->num_pyramid_levels(),std::runtime_error,
+    "Error, the image pyramid has not been built (pre_execution_tasks() must be called first)");
+
+  // only search in theta on the finest level, the coarse levels do not have enough
+  // pixels in a subset to resolve small rotations and pick up spurious values
+  const int_t num_theta_steps = 2;
+  const scalar_t theta_step = 0.05;
+  Teuchos::RCP<Local_Shape_Function> level_shape_function = shape_function_factory(schema_);
+  scalar_t best_gamma = 100.0;
+  bool coarsest_level = true;
+  for(int_t level=active_levels_;level>=1;--level){
+    const scalar_t scale = static_cast<scalar_t>(1 << level);
+    const int_t level_cx = static_cast<int_t>(std::floor(cx/scale + 0.5));
+    const int_t level_cy = static_cast<int_t>(std::floor(cy/scale + 0.5));
+    const int_t level_dim = std::max(subset_dim >> level,7) | 1;
+    Subset subset(level_cx,level_cy,level_dim,level_dim);
+    try{
+      subset.initialize(schema_->ref_img()->pyramid_level(level));
+    }
+    catch(...){ // the subset does not fit on this level
+      continue;
+    }
+    Teuchos::RCP<Image> def_level = schema_->def_img()->pyramid_level(level);
+    // full search window on the coarsest usable level, the finer levels only correct the rounding
+    const int_t radius = coarsest_level ? search_radius_ : 1;
+    const int_t theta_steps = level==1 ? num_theta_steps : 0;
+    const scalar_t base_u = std::floor(u/scale + 0.5);
+    const scalar_t base_v = std::floor(v/scale + 0.5);
+    scalar_t level_best_gamma = 100.0;
+    scalar_t level_best_u = base_u;
+    scalar_t level_best_v = base_v;
+    scalar_t level_best_t = t;
+    for(int_t dv=-radius;dv<=radius;++dv){
+      for(int_t du=-radius;du<=radius;++du){
+        for(int_t dt=-theta_steps;dt<=theta_steps;++dt){
+          const scalar_t trial_t = t + dt*theta_step;
+          const scalar_t gamma = level_gamma(subset,def_level,level_shape_function,base_u+du,base_v+dv,trial_t);
+          if(gamma < level_best_gamma){
+            level_best_gamma = gamma;
+            level_best_u = base_u + du;
+            level_best_v = base_v + dv;
+            level_best_t = trial_t;
+          }
+        }
+      }
+    }
+    if(level_best_gamma >= 100.0) continue; // nothing could be evaluated on this level
+    coarsest_level = false;
+    u = level_best_u*scale;
+    v = level_best_v*scale;
+    t = level_best_t;
+    best_gamma = level_best_gamma;
+    DEBUG_MSG("Subset " << subset_gid << " pyramid level " << level << " u " << u << " v " << v << " theta " << t << " gamma " << best_gamma);
+  }
+  if(active_levels_==0){ // image too small for a pyramid, fall back to the previous solution
+    shape_function->insert_motion(u,v,t);
+    return INITIALIZE_SUCCESSFUL;
+  }
+  // the finest pyramid level only resolves the motion to 2 pixels, finish with a 1 pixel search on the full
+  // resolution images and a parabolic fit through the neighboring values for the sub-pixel part
+  if(!coarsest_level){
+    Subset subset(static_cast<int_t>(std::floor(cx + 0.5)),static_cast<int_t>(std::floor(cy + 0.5)),subset_dim,subset_dim);
+    bool subset_fits = true;
+    try{
+      subset.initialize(schema_->ref_img());
+    }
+    catch(...){
+      subset_fits = false;
+    }
+    if(subset_fits){
+      scalar_t gammas[3][3];
+      scalar_t full_best_gamma = 100.0;
+      int_t best_du = 0, best_dv = 0;
+      for(int_t dv=-1;dv<=1;++dv){
+        for(int_t du=-1;du<=1;++du){
+          gammas[dv+1][du+1] = level_gamma(subset,schema_->def_img(),level_shape_function,u+du,v+dv,t);
+          if(gammas[dv+1][du+1] < full_best_gamma){
+            full_best_gamma = gammas[dv+1][du+1];
+            best_du = du;
+            best_dv = dv;
+          }
+        }
+      }
+      if(full_best_gamma < 100.0){
+        scalar_t sub_u = 0.0, sub_v = 0.0;
+        // only fit when the minimum is bracketed by evaluated values
+        if(best_du==0&&gammas[1+best_dv][0]<100.0&&gammas[1+best_dv][2]<100.0){
+          const scalar_t denom = gammas[1+best_dv][0] - 2.0*gammas[1+best_dv][1] + gammas[1+best_dv][2];
+          if(denom > 0.0) sub_u = 0.5*(gammas[1+best_dv][0] - gammas[1+best_dv][2])/denom;
+        }
+        if(best_dv==0&&gammas[0][1+best_du]<100.0&&gammas[2][1+best_du]<100.0){
+          const scalar_t denom = gammas[0][1+best_du] - 2.0*gammas[1][1+best_du] + gammas[2][1+best_du];
+          if(denom > 0.0) sub_v = 0.5*(gammas[0][1+best_du] - gammas[2][1+best_du])/denom;
+        }
+        u += best_du + sub_u;
+        v += best_dv + sub_v;
+        best_gamma = full_best_gamma;
+        DEBUG_MSG("Subset " << subset_gid << " full resolution u " << u << " v " << v << " theta " << t << " gamma " << best_gamma);
+      }
+    }
+  }
+  shape_function->insert_motion(u,v,t);
+  if(best_gamma < 1.0)
+    return INITIALIZE_SUCCESSFUL;
+  else
+    return INITIALIZE_FAILED;
+};
+
+/// 2D transform of a square array as 1D transforms along the rows and then the columns
+/// \param cfg the 1D plan
+/// \param P the dimension of the array
+/// \param data [in/out] the row major array
+/// \param in scratch buffer of size P
+/// \param out scratch buffer of size P
+static void
+fft_2d_in_place(kiss_fft_cfg cfg,
+  const int_t P,
+  std::vector<kiss_fft_cpx> & data,
+  std::vector<kiss_fft_cpx> & in,
+  std::vector<kiss_fft_cpx> & out){
+  for(int_t r=0;r<P;++r){
+    kiss_fft(cfg,&data[r*P],&out[0]);
+    std::copy(out.begin(),out.end(),data.begin()+r*P);
+  }
+  for(int_t c=0;c<P;++c){
+    for(int_t r=0;r<P;++r) in[r] = data[r*P+c];
+    kiss_fft(cfg,&in[0],&out[0]);
+    for(int_t r=0;r<P;++r) data[r*P+c] = out[r];
+  }
+}
+
+Cross_Correlation_Initializer::Cross_Correlation_Initializer(Schema * schema,
+  const int_t search_radius,
+  const scalar_t & min_ncc):
+  Initializer(schema),
+  search_radius_(search_radius),
+  min_ncc_(min_ncc),
+  fft_dim_(0),
+  fwd_cfg_(NULL),
+  inv_cfg_(NULL),
+  computed_frame_id_(-1),
+  computed_def_img_(NULL){
+  TEUCHOS_TEST_FOR_EXCEPTION(search_radius<1,std::invalid_argument,"Error, invalid search radius for the cross-correlation initializer");
+  TEUCHOS_TEST_FOR_EXCEPTION(min_ncc<-1.0||min_ncc>1.0,std::invalid_argument,"Error, min_ncc must be between -1 and 1");
+  if(schema)
+    TEUCHOS_TEST_FOR_EXCEPTION(schema->shape_function_type()==DICe::RIGID_BODY_SF,std::runtime_error,
+    "Cross_Correlation_Initializer cannot be used with rigid body shape function (only field value init is allowed)");
+};
+
+Cross_Correlation_Initializer::~Cross_Correlation_Initializer(){
+  free_plans();
+}
+
+void
+Cross_Correlation_Initializer::free_plans(){
+  if(fwd_cfg_) kiss_fft_free(fwd_cfg_);
+  if(inv_cfg_) kiss_fft_free(inv_cfg_);
+  fwd_cfg_ = NULL;
+  inv_cfg_ = NULL;
+  fft_dim_ = 0;
+}
+
+void
+Cross_Correlation_Initializer::allocate_plans(const int_t fft_dim){
+  if(fft_dim==fft_dim_) return;
+  free_plans();
+  fwd_cfg_ = kiss_fft_alloc(fft_dim,0,0,0);
+  inv_cfg_ = kiss_fft_alloc(fft_dim,1,0,0);
+  TEUCHOS_TEST_FOR_EXCEPTION(!fwd_cfg_||!inv_cfg_,std::runtime_error,"Error, could not allocate the fft plans");
+  fft_dim_ = fft_dim;
+}
+
+void
+Cross_Correlation_Initializer::pre_execution_tasks(){
+  assert(schema_->ref_img()!=Teuchos::null);
+  assert(schema_->def_img()!=Teuchos::null);
+  // the tracking routine shares this initializer between subsets and calls this once per subset
+  if(computed_frame_id_==schema_->frame_id() && computed_def_img_==schema_->def_img().get()) return;
+  const Image * ref = schema_->ref_img().get();
+  const Image * def = schema_->def_img().get();
+  const int_t num_subsets = schema_->local_num_subsets();
+  // conformal subsets do not have a subset dim, use a typical square size for the template
+  const int_t subset_dim = schema_->subset_dim() > 0 ? schema_->subset_dim() : 41;
+  const int_t half_dim = subset_dim/2;
+  const int_t num_shifts = 2*search_radius_+1;
+  const int_t window_dim = subset_dim + 2*search_radius_;
+  // the circular correlation does not wrap for any shift in the search window as long as P >= window_dim
+  const int_t P = kiss_fft_next_fast_size(window_dim);
+  allocate_plans(P);
+  peak_u_.assign(num_subsets,0.0);
+  peak_v_.assign(num_subsets,0.0);
+  peak_ncc_.assign(num_subsets,-1.0);
+  const int_t ref_w = ref->width();
+  const int_t ref_h = ref->height();
+  const int_t def_w = def->width();
+  const int_t def_h = def->height();
+  const int_t ref_ox = ref->offset_x();
+  const int_t ref_oy = ref->offset_y();
+  const int_t def_ox = def->offset_x();
+  const int_t def_oy = def->offset_y();
+  const double inv_n = 1.0/(subset_dim*subset_dim);
+  const double inv_pp = 1.0/(P*P);
+  DEBUG_MSG("Cross_Correlation_Initializer::pre_execution_tasks(): " << num_subsets << " subsets, fft size " << P <<
+    " search radius " << search_radius_);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(schema_->num_threads()) if(schema_->num_threads()>1)
+#endif
+  {
+    // per-thread scratch, the plans are shared
+    std::vector<kiss_fft_cpx> z(P*P);
+    std::vector<kiss_fft_cpx> line_in(P);
+    std::vector<kiss_fft_cpx> line_out(P);
+    // summed area tables of the search window with a leading row and column of zeros
+    std::vector<double> sat((window_dim+1)*(window_dim+1),0.0);
+    std::vector<double> sat2((window_dim+1)*(window_dim+1),0.0);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for(int_t lid=0;lid<num_subsets;++lid){
+      const scalar_t u0 = std::floor(schema_->local_field_value(lid,SUBSET_DISPLACEMENT_X_FS) + 0.5);
+      const scalar_t v0 = std::floor(schema_->local_field_value(lid,SUBSET_DISPLACEMENT_Y_FS) + 0.5);
+      peak_u_[lid] = u0;
+      peak_v_[lid] = v0;
+      const int_t cx = static_cast<int_t>(std::floor(schema_->local_field_value(lid,SUBSET_COORDINATES_X_FS) + 0.5));
+      const int_t cy = static_cast<int_t>(std::floor(schema_->local_field_value(lid,SUBSET_COORDINATES_Y_FS) + 0.5));
+      // the template has to be fully inside the reference image
+      const int_t tx0 = cx - half_dim - ref_ox;
+      const int_t ty0 = cy - half_dim - ref_oy;
+      if(tx0<0||ty0<0||tx0+subset_dim>ref_w||ty0+subset_dim>ref_h) continue;
+      // the search window is clamped to the deformed image, shifts that reach past the edges
+      // see a smeared border with little variance and score low
+      const int_t wx0 = cx + static_cast<int_t>(u0) - half_dim - search_radius_ - def_ox;
+      const int_t wy0 = cy + static_cast<int_t>(v0) - half_dim - search_radius_ - def_oy;
+      double t_mean = 0.0;
+      for(int_t r=0;r<subset_dim;++r)
+        for(int_t c=0;c<subset_dim;++c)
+          t_mean += (*ref)(tx0+c,ty0+r);
+      t_mean *= inv_n;
+      double w_mean = 0.0;
+      std::fill(z.begin(),z.end(),kiss_fft_cpx());
+      for(int_t r=0;r<window_dim;++r){
+        const int_t y = std::min(std::max(wy0+r,0),def_h-1);
+        for(int_t c=0;c<window_dim;++c){
+          const int_t x = std::min(std::max(wx0+c,0),def_w-1);
+          const double w = (*def)(x,y);
+          z[r*P+c].i = w;
+          w_mean += w;
+        }
+      }
+      w_mean /= window_dim*window_dim;
+      // the template is zero mean so removing a constant from the window does not change the correlation
+      // but it keeps the summed area tables well conditioned
+      for(int_t r=0;r<window_dim;++r){
+        double row_sum = 0.0;
+        double row_sum2 = 0.0;
+        for(int_t c=0;c<window_dim;++c){
+          const double w = z[r*P+c].i - w_mean;
+          z[r*P+c].i = w;
+          row_sum += w;
+          row_sum2 += w*w;
+          sat[(r+1)*(window_dim+1)+c+1] = sat[r*(window_dim+1)+c+1] + row_sum;
+          sat2[(r+1)*(window_dim+1)+c+1] = sat2[r*(window_dim+1)+c+1] + row_sum2;
+        }
+      }
+      double t_norm2 = 0.0;
+      for(int_t r=0;r<subset_dim;++r){
+        for(int_t c=0;c<subset_dim;++c){
+          const double t = (*ref)(tx0+c,ty0+r) - t_mean;
+          z[r*P+c].r = t;
+          t_norm2 += t*t;
+        }
+      }
+      if(t_norm2<=0.0) continue; // no texture in the template
+      // two real inputs share one complex transform: template in the real part, window in the imaginary part
+      fft_2d_in_place(fwd_cfg_,P,z,line_in,line_out);
+      // separate the spectra with the conjugate symmetry of real signals and form conj(T)*W,
+      // each pair (k,-k) is written together so the input values are read before they are overwritten
+      for(int_t ky=0;ky<P;++ky){
+        const int_t nky = (P-ky)%P;
+        for(int_t kx=0;kx<P;++kx){
+          const int_t nkx = (P-kx)%P;
+          const int_t k = ky*P+kx;
+          const int_t nk = nky*P+nkx;
+          if(nk<k) continue;
+          const kiss_fft_cpx a = z[k];
+          const kiss_fft_cpx b = z[nk];
+          // T(k) = (Z(k) + conj(Z(-k)))/2, W(k) = (Z(k) - conj(Z(-k)))/2i
+          const double tkr = 0.5*(a.r + b.r), tki = 0.5*(a.i - b.i);
+          const double wkr = 0.5*(a.i + b.i), wki = -0.5*(a.r - b.r);
+          // the spectra at -k are the conjugates: T(-k) = conj(T(k)), W(-k) = conj(W(k))
+          // conj(T)*W at k and at -k
+          const double xr = tkr*wkr + tki*wki;
+          const double xi = tkr*wki - tki*wkr;
+          z[k].r = xr; z[k].i = xi;
+          z[nk].r = xr; z[nk].i = -xi;
+        }
+      }
+      fft_2d_in_place(inv_cfg_,P,z,line_in,line_out);
+      double best_ncc = -2.0;
+      int_t best_dx = search_radius_;
+      int_t best_dy = search_radius_;
+      for(int_t dy=0;dy<num_shifts;++dy){
+        for(int_t dx=0;dx<num_shifts;++dx){
+          const int_t i0 = dy*(window_dim+1)+dx;
+          const int_t i1 = (dy+subset_dim)*(window_dim+1)+dx;
+          const double sum = sat[i1+subset_dim] - sat[i1] - sat[i0+subset_dim] + sat[i0];
+          const double sum2 = sat2[i1+subset_dim] - sat2[i1] - sat2[i0+subset_dim] + sat2[i0];
+          const double var = sum2 - sum*sum*inv_n;
+          if(var<=1.0E-8*t_norm2) continue;
+          const double ncc = z[dy*P+dx].r*inv_pp/std::sqrt(t_norm2*var);
+          if(ncc>best_ncc){
+            best_ncc = ncc;
+            best_dx = dx;
+            best_dy = dy;
+          }
+        }
+      }
+      if(best_ncc<-1.0) continue;
+      peak_u_[lid] = u0 + best_dx - search_radius_;
+      peak_v_[lid] = v0 + best_dy - search_radius_;
+      peak_ncc_[lid] = best_ncc;
+    } // end subset loop
+  } // end parallel region
+  computed_frame_id_ = schema_->frame_id();
+  computed_def_img_ = def;
+}
+
+Status_Flag
+Cross_Correlation_Initializer::initial_guess(const int_t subset_gid,
+  Teuchos::RCP<Local_Shape_Function> shape_function){
+  const int_t lid = schema_->subset_local_id(subset_gid);
+  TEUCHOS_TEST_FOR_EXCEPTION(lid<0||lid>=(int_t)peak_ncc_.size(),std::runtime_error,
+    "Error, the correlation peaks have not been computed for subset " << subset_gid << " (pre_execution_tasks() must be called first)");
+  const scalar_t t = schema_->global_field_value(subset_gid,ROTATION_Z_FS);
+  DEBUG_MSG("Subset " << subset_gid << " cross-correlation peak u " << peak_u_[lid] << " v " << peak_v_[lid] << " ncc " << peak_ncc_[lid]);
+  if(peak_ncc_[lid] < min_ncc_){
+    // fall back to the previous solution
+    shape_function->insert_motion(schema_->global_field_value(subset_gid,SUBSET_DISPLACEMENT_X_FS),
+      schema_->global_field_value(subset_gid,SUBSET_DISPLACEMENT_Y_FS),t);
+    return INITIALIZE_FAILED;
+  }
+  shape_function->insert_motion(peak_u_[lid],peak_v_[lid],t);
+  return INITIALIZE_SUCCESSFUL;
+};
+
+Initialization_Method
+Field_Value_Initializer::method()const{
+  if(schema_->initialization_method()==DICe::USE_NEIGHBOR_VALUES ||
+      (schema_->initialization_method()==DICe::USE_NEIGHBOR_VALUES_FIRST_STEP_ONLY && schema_->frame_id()==schema_->first_frame_id()) ||
+      schema_->correlation_routine()==DICe::RELIABILITY_GUIDED_ROUTINE)
+    return USE_NEIGHBOR_VALUES;
+  return USE_FIELD_VALUES;
+}
+
 Status_Flag
 Field_Value_Initializer::initial_guess(const int_t subset_gid,
   Teuchos::RCP<Local_Shape_Function> shape_function){
   int_t sid = subset_gid;
   // logic for using neighbor values
-  if(schema_->initialization_method()==DICe::USE_NEIGHBOR_VALUES ||
+  // (the reliability guided routine picks the best solved neighbor, or -1 for the subset's own previous solution)
+  if(schema_->correlation_routine()==DICe::RELIABILITY_GUIDED_ROUTINE){
+    sid = schema_->reliability_guided_parent(subset_gid);
+  }
+  else if(schema_->initialization_method()==DICe::USE_NEIGHBOR_VALUES ||
       (schema_->initialization_method()==DICe::USE_NEIGHBOR_VALUES_FIRST_STEP_ONLY && schema_->frame_id()==schema_->first_frame_id())){
     sid = schema_->global_field_value(subset_gid,NEIGHBOR_ID_FS);
   }
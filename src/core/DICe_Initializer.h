@@ -47,6 +47,7 @@
 #include <DICe_Subset.h>
 #include <DICe_PointCloud.h>
 #include <DICe_LocalShapeFunction.h>
+#include <kiss_fft.h>
 
 #include <Teuchos_RCP.hpp>
 
@@ -57,6 +58,7 @@
 #include <opencv2/opencv.hpp>
 
 #include <set>
+#include <vector>
 #include <cassert>
 
 
@@ -116,6 +118,12 @@ public:
   /// virtual destructor
   virtual ~Initializer(){};
 
+  /// returns the initialization method this initializer implements (used to charge the time to the initializer
+  /// that actually ran, initializers without a method of their own return INITIALIZATION_METHOD_NOT_APPLICABLE)
+  virtual Initialization_Method method()const{
+    return INITIALIZATION_METHOD_NOT_APPLICABLE;
+  }
+
   /// Tasks that should be performed before the frame is correlated
   virtual void pre_execution_tasks(){
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Base class method should never be called.");
@@ -266,6 +274,11 @@ public:
   /// virtual destructor
   virtual ~Phase_Correlation_Initializer(){};
 
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_PHASE_CORRELATION;
+  }
+
   /// see base class description
   virtual void pre_execution_tasks();
 
@@ -329,6 +342,125 @@ protected:
   scalar_t search_dim_theta_;
 };
 
+/// \class DICe::Image_Pyramid_Initializer
+/// \brief an initializer that handles large displacements by searching for each subset
+/// on the coarsest level of an image pyramid and refining the result level by level.
+/// The search at each level is a small integer window around the upscaled result from
+/// the level below so the cost is nearly independent of the size of the motion. The result
+/// from the finest level is refined to a pixel (plus a parabolic sub-pixel estimate) on the
+/// full resolution images. The reachable displacement from the previous solution is about search_radius*2^num_levels pixels.
+class DICE_LIB_DLL_EXPORT
+Image_Pyramid_Initializer : public Initializer{
+public:
+
+  /// constructor
+  /// \param schema the parent schema
+  /// \param num_levels the number of coarse levels in the pyramid
+  /// \param search_radius the integer search radius in pixels on the coarsest level
+  Image_Pyramid_Initializer(Schema * schema,
+    const int_t num_levels=3,
+    const int_t search_radius=8);
+
+  /// virtual destructor
+  virtual ~Image_Pyramid_Initializer(){};
+
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_IMAGE_PYRAMID;
+  }
+
+  /// builds the pyramids for the reference and deformed images (called once per frame
+  /// before the subsets are processed so that the pyramids are not built inside a threaded loop)
+  virtual void pre_execution_tasks();
+
+  /// see base class description
+  virtual Status_Flag initial_guess(const int_t subset_gid,
+    Teuchos::RCP<Local_Shape_Function> shape_function);
+
+private:
+  /// evaluate gamma for a square subset on one level of the pyramid, returns a large
+  /// value if the subset cannot be evaluated
+  scalar_t level_gamma(Subset & subset,
+    Teuchos::RCP<Image> def_level,
+    Teuchos::RCP<Local_Shape_Function> shape_function,
+    const scalar_t & u,
+    const scalar_t & v,
+    const scalar_t & t);
+  /// number of coarse levels requested
+  int_t num_levels_;
+  /// number of coarse levels actually used (limited by the image size)
+  int_t active_levels_;
+  /// search radius in pixels on the coarsest level
+  int_t search_radius_;
+};
+
+/// \class DICe::Cross_Correlation_Initializer
+/// \brief an initializer that finds the integer pixel zero-normalized cross-correlation (ZNCC) peak
+/// for every local subset in one batch before any of the subsets are correlated.
+/// Each subset is an independent search of +/- search_radius pixels around the previous solution
+/// so the guess does not depend on the neighbors or on a single global shift. The correlation
+/// is computed with FFTs that use plans built once per window size and shared by all threads.
+/// Each thread keeps its own scratch buffers. The denominators come from summed area tables.
+class DICE_LIB_DLL_EXPORT
+Cross_Correlation_Initializer : public Initializer{
+public:
+
+  /// constructor
+  /// \param schema the parent schema
+  /// \param search_radius the integer search radius in pixels around the previous solution
+  /// \param min_ncc the minimum ZNCC peak value for the guess to be accepted
+  Cross_Correlation_Initializer(Schema * schema,
+    const int_t search_radius=24,
+    const scalar_t & min_ncc=0.5);
+
+  /// virtual destructor (frees the fft plans)
+  virtual ~Cross_Correlation_Initializer();
+
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_FFT_CROSS_CORRELATION;
+  }
+
+  /// computes the correlation peak for all local subsets (only once per frame, the tracking
+  /// routine calls this for each subset that shares this initializer)
+  virtual void pre_execution_tasks();
+
+  /// see base class description
+  virtual Status_Flag initial_guess(const int_t subset_gid,
+    Teuchos::RCP<Local_Shape_Function> shape_function);
+
+  /// returns the ZNCC peak value for the given local subset id (-1 if the subset could not be evaluated)
+  /// \param subset_lid the local subset id
+  scalar_t peak_ncc(const int_t subset_lid)const{
+    assert(subset_lid>=0&&subset_lid<(int_t)peak_ncc_.size());
+    return peak_ncc_[subset_lid];
+  }
+
+private:
+  /// (re)allocate the fft plans if the transform size changed
+  /// \param fft_dim the size of the square transform
+  void allocate_plans(const int_t fft_dim);
+  /// free the fft plans
+  void free_plans();
+  /// search radius in pixels
+  int_t search_radius_;
+  /// minimum acceptable peak value
+  scalar_t min_ncc_;
+  /// size of the square transform the plans were built for
+  int_t fft_dim_;
+  /// forward 1D fft plan (read only after allocation so it can be shared by threads)
+  kiss_fft_cfg fwd_cfg_;
+  /// inverse 1D fft plan
+  kiss_fft_cfg inv_cfg_;
+  /// frame and deformed image the peaks were computed for
+  int_t computed_frame_id_;
+  const Image * computed_def_img_;
+  /// peak displacements and values indexed by local subset id
+  std::vector<scalar_t> peak_u_;
+  std::vector<scalar_t> peak_v_;
+  std::vector<scalar_t> peak_ncc_;
+};
+
 
 /// \class DICe::Field_Value_Initializer
 /// \brief an initializer that grabs values from the field values
@@ -346,6 +478,9 @@ public:
   /// virtual destructor
   virtual ~Field_Value_Initializer(){};
 
+  /// see base class description (the neighbor values are reported separately from the subset's own values)
+  virtual Initialization_Method method()const;
+
   /// see base class description
   virtual void pre_execution_tasks(){};
 
@@ -368,6 +503,11 @@ public:
   /// virtual destructor
   virtual ~Feature_Matching_Initializer(){};
 
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_FEATURE_MATCHING;
+  }
+
   /// see base class description
   virtual void pre_execution_tasks();
 
@@ -406,6 +546,11 @@ public:
   /// virtual destructor
   virtual ~Satellite_Geometry_Initializer(){};
 
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_SATELLITE_GEOMETRY;
+  }
+
   /// see base class description
   virtual void pre_execution_tasks(){};
 
@@ -430,6 +575,11 @@ public:
   /// virtual destructor
   virtual ~Image_Registration_Initializer(){};
 
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_IMAGE_REGISTRATION;
+  }
+
   /// see base class description
   virtual void pre_execution_tasks();
 
@@ -463,6 +613,11 @@ public:
   /// virtual destructor
   virtual ~Zero_Value_Initializer(){};
 
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_ZEROS;
+  }
+
   /// see base class description
   virtual void pre_execution_tasks(){};
 
@@ -496,6 +651,11 @@ public:
   /// virtual destructor
   virtual ~Optical_Flow_Initializer(){};
 
+  /// see base class description
+  virtual Initialization_Method method()const{
+    return USE_OPTICAL_FLOW;
+  }
+
   /// see base class description
   virtual void pre_execution_tasks(){};
 
@@ -45,10 +45,13 @@
 #include <DICe_ImageIO.h>
 #include <DICe_Schema.h>
 #include <DICe_Triangulation.h>
+#include <DICe_ImagePrefetcher.h>
+#include <DICe_Profiler.h>
 #ifdef DICE_ENABLE_TRACKLIB
 #include <tracklib.h>
 #endif
 
+#include <algorithm>
 #include <fstream>
 
 #include <Teuchos_TimeMonitor.hpp>
@@ -59,6 +62,17 @@
 
 using namespace DICe;
 
+/// returns the window of the upcoming frames to prefetch (offset_x, offset_y, width, height)
+/// based on the current deformed extents of the schema (empty if the whole frame is needed)
+std::vector<int_t> prefetch_window(Teuchos::RCP<Schema> schema,
+  const std::string & file_name,
+  const int_t margin){
+  std::vector<int_t> window(4,0);
+  if(!schema->def_image_window(file_name,margin,window[0],window[1],window[2],window[3]))
+    window.clear();
+  return window;
+}
+
 int main(int argc, char *argv[]) {
   Teuchos::RCP<Teuchos::Time> total_time  = Teuchos::TimeMonitor::getNewCounter("## Total Time ##");
   Teuchos::RCP<Teuchos::Time> cross_time  = Teuchos::TimeMonitor::getNewCounter("Cross-correlation");
@@ -97,6 +111,10 @@ int main(int argc, char *argv[]) {
         }
         return 1;
       }
+      // the per-phase instrumentation is only turned on if a report was requested
+      const bool write_performance_report = input_params->isParameter(DICe::performance_report_file);
+      if(write_performance_report)
+        profiler::enable();
       *outStream << "Input Parameters: " << std::endl;
       input_params->print(*outStream);
       *outStream << "\n--- Input read successfully ---\n" << std::endl;
@@ -197,11 +215,31 @@ int main(int argc, char *argv[]) {
 #endif
       }
 
+      // if the frames are distributed, each process builds its own schema with all the subsets
+      // and correlates a contiguous block of frames against the shared reference image
+      const bool frame_parallel = correlation_params!=Teuchos::null && correlation_params->get<bool>(DICe::frame_parallel,false);
+      int_t first_block_frame = 1;
+      int_t last_block_frame = num_frames;
+      if(frame_parallel){
+        TEUCHOS_TEST_FOR_EXCEPTION(is_stereo,std::runtime_error,"Error, frame_parallel is not available for stereo");
+        TEUCHOS_TEST_FOR_EXCEPTION(separate_output_file_for_each_subset,std::runtime_error,
+          "Error, frame_parallel cannot be used with separate_output_file_for_each_subset (all frames go to one file)");
+        const int_t block_size = num_frames/proc_size;
+        const int_t remainder = num_frames%proc_size;
+        first_block_frame = 1 + proc_rank*block_size + std::min(proc_rank,remainder);
+        last_block_frame = first_block_frame + block_size + (proc_rank<remainder ? 1 : 0) - 1;
+        *outStream << "Frames will be distributed across " << proc_size << " process(es), this process correlates frames " <<
+            first_block_frame << " to " << last_block_frame << std::endl;
+        MultiField_Comm::set_process_local(true);
+      }
+
       // create schemas:
       Teuchos::RCP<DICe::Schema> schema = Teuchos::rcp(new DICe::Schema(input_params,correlation_params));
       Teuchos::RCP<DICe::Schema> stereo_schema;
       // let the schema know how many images there are in the sequence and the first frame id:
       schema->set_frame_range(first_frame_id,num_frames);
+      if(frame_parallel)
+        schema->set_frame_id(first_frame_id + first_block_frame - 1);
 
       if(input_params->get<bool>(DICe::print_subset_locations_and_exit,false)){
         // write out the subset locations for left camera and exit
@@ -335,22 +373,54 @@ int main(int argc, char *argv[]) {
       // go ahead and set up the model coordinates field
       schema->execute_triangulation(triangulation,stereo_schema);
 
+      // if requested, read the upcoming frames on background threads (one per camera) while the current frame is correlated
+      const int_t prefetch_depth = input_params->get<int_t>(DICe::prefetch_images,0);
+      Teuchos::RCP<Image_Prefetcher> prefetcher;
+      Teuchos::RCP<Image_Prefetcher> stereo_prefetcher;
+      // the prefetched frames only cover the region of interest plus a margin for the motion over the frames read ahead
+      // (a frame is read again if the region of interest moves outside of the prefetched window)
+      const int_t prefetch_margin = 50*prefetch_depth;
+      // the shared images are read collectively by the processes on a node, the prefetch threads read on their own
+      TEUCHOS_TEST_FOR_EXCEPTION(prefetch_depth>0&&schema->share_images_on_node(),std::invalid_argument,
+        "Error, prefetch_images cannot be used with share_images_on_node");
+      // with motion windows each subset reads its own window of the frame into a separate sub-image
+      TEUCHOS_TEST_FOR_EXCEPTION(prefetch_depth>0&&schema->motion_window_params()->size()>0,std::invalid_argument,
+        "Error, prefetch_images cannot be used with motion windows");
+      if(prefetch_depth>0&&last_block_frame>=first_block_frame){
+        *outStream << "Prefetching " << prefetch_depth << " frame(s) ahead of the correlation" << std::endl;
+        prefetcher = Teuchos::rcp(new Image_Prefetcher(image_files,schema->def_image_params(),first_block_frame,last_block_frame,prefetch_depth,
+          prefetch_window(schema,image_files[0],prefetch_margin)));
+        if(is_stereo)
+          stereo_prefetcher = Teuchos::rcp(new Image_Prefetcher(stereo_image_files,stereo_schema->def_image_params(),1,num_frames,prefetch_depth,
+            prefetch_window(stereo_schema,stereo_image_files[0],prefetch_margin)));
+      }
+
       // iterate through the images and perform the correlation:
       bool failed_step = false;
 
-      for(int_t image_it=1;image_it<=num_frames;++image_it){
+      for(int_t image_it=first_block_frame;image_it<=last_block_frame;++image_it){
         *outStream << "Processing frame: " << image_it << " of " << num_frames << ", " << image_files[image_it] << std::endl;
         if(schema->use_incremental_formulation()&&image_it>1){
           schema->set_ref_image(schema->def_img());
         }
         schema->update_extents();
-        schema->set_def_image(image_files[image_it]);
+        if(prefetcher!=Teuchos::null){
+          schema->set_prefetched_def_image(prefetcher->image(image_it),image_files[image_it]);
+          prefetcher->set_window(prefetch_window(schema,image_files[image_it],prefetch_margin));
+        }
+        else
+          schema->set_def_image(image_files[image_it]);
         if(is_stereo){
           if(stereo_schema->use_incremental_formulation()&&image_it>1){
             stereo_schema->set_ref_image(stereo_schema->def_img());
           }
           stereo_schema->update_extents();
-          stereo_schema->set_def_image(stereo_image_files[image_it]);
+          if(stereo_prefetcher!=Teuchos::null){
+            stereo_schema->set_prefetched_def_image(stereo_prefetcher->image(image_it),stereo_image_files[image_it]);
+            stereo_prefetcher->set_window(prefetch_window(stereo_schema,stereo_image_files[image_it],prefetch_margin));
+          }
+          else
+            stereo_schema->set_def_image(stereo_image_files[image_it]);
           //if(stereo_schema->use_nonlinear_projection())
           //  stereo_schema->project_right_image_into_left_frame(triangulation,false);
         }
@@ -373,6 +443,12 @@ int main(int argc, char *argv[]) {
           Teuchos::TimeMonitor write_time_monitor(*write_time);
           schema->write_output(output_folder,file_prefix,separate_output_file_for_each_subset,separate_header_file,no_text_output);
           schema->post_execution_tasks();
+          // move subsets between processes if the load is out of balance (not for stereo since the
+          // left and right schemas have to have the same owners, or one output file per subset since those are per process)
+          if(!is_stereo&&!separate_output_file_for_each_subset&&image_it<num_frames&&schema->rebalance_subsets()){
+            schema->update_extents();
+            schema->set_ref_image(image_files[0]);
+          }
           // print the timing data with or without verbose flag
           if(input_params->get<bool>(DICe::print_stats,false)){
             schema->mesh()->print_field_stats();
@@ -389,10 +465,34 @@ int main(int argc, char *argv[]) {
         }
       } // image loop
 
-      schema->write_stats(output_folder,file_prefix);
+      if(frame_parallel){
+        // the frame files from all processes make up the usual output, only the first process
+        // (which wrote the run info) appends the stats once the events of every block are collected
+        // (the gather also keeps the performance report from counting a subset once per process)
+        schema->stat_container()->gather_events();
+        if(proc_rank==0)
+          schema->write_stats(output_folder,file_prefix);
+      }
+      else
+        schema->write_stats(output_folder,file_prefix);
       if(is_stereo)
         stereo_schema->write_stats(output_folder,stereo_file_prefix);
 
+      if(write_performance_report){
+        // join the tracking statistics to the timing data
+        std::map<std::string,std::map<int_t,int_t> > stat_histograms;
+        schema->stat_container()->event_histograms(stat_histograms);
+        if(is_stereo){
+          std::map<std::string,std::map<int_t,int_t> > stereo_histograms;
+          stereo_schema->stat_container()->event_histograms(stereo_histograms);
+          for(std::map<std::string,std::map<int_t,int_t> >::const_iterator it=stereo_histograms.begin();it!=stereo_histograms.end();++it)
+            stat_histograms["stereo_" + it->first] = it->second;
+        }
+        const std::string report_file = output_folder + input_params->get<std::string>(DICe::performance_report_file);
+        profiler::write_report(report_file,stat_histograms);
+        *outStream << "Performance report written to " << report_file << std::endl;
+      }
+
       if(failed_step)
         *outStream << "\n--- Failed Step Occurred ---\n" << std::endl;
       else
@@ -0,0 +1,256 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe_NodeImageReader.h>
+
+#include <Teuchos_ArrayRCP.hpp>
+
+#if DICE_MPI && defined(MPI_VERSION) && MPI_VERSION >= 3
+#  define DICE_NODE_SHARED_MEMORY 1
+#else
+#  define DICE_NODE_SHARED_MEMORY 0
+#endif
+
+namespace DICe {
+
+int_t
+num_processes_on_node(){
+#if DICE_NODE_SHARED_MEMORY
+  int mpi_is_initialized = 0;
+  MPI_Initialized(&mpi_is_initialized);
+  if(!mpi_is_initialized) return 1;
+  MPI_Comm node_comm;
+  MPI_Comm_split_type(MPI_COMM_WORLD,MPI_COMM_TYPE_SHARED,0,MPI_INFO_NULL,&node_comm);
+  int size = 1;
+  MPI_Comm_size(node_comm,&size);
+  MPI_Comm_free(&node_comm);
+  return size;
+#else
+  return 1;
+#endif
+}
+
+struct Node_Image_Reader::Shared_Window{
+  /// constructor
+  Shared_Window():
+    num_views(0){}
+#if DICE_NODE_SHARED_MEMORY
+  /// the MPI window
+  MPI_Win win;
+#endif
+  /// number of image arrays on this process that still point into the window
+  int_t num_views;
+};
+
+/// \class DICe::Shared_Window_Dealloc
+/// \brief Deallocator for the image arrays that point into a shared window,
+/// the window itself is only freed once every process on the node has released it
+template<typename T>
+class Shared_Window_Dealloc{
+public:
+  /// type of the pointer that is freed
+  typedef T ptr_t;
+  /// constructor
+  /// \param window the shared window the array points into
+  Shared_Window_Dealloc(const Teuchos::RCP<Node_Image_Reader::Shared_Window> & window):
+    window_(window){}
+  /// releases the array
+  void free(T *){
+    --window_->num_views;
+  }
+private:
+  /// the shared window the array points into
+  Teuchos::RCP<Node_Image_Reader::Shared_Window> window_;
+};
+
+Node_Image_Reader::Node_Image_Reader():
+  use_shared_memory_(false),
+  node_rank_(0),
+  node_size_(1)
+{
+#if DICE_NODE_SHARED_MEMORY
+  int mpi_is_initialized = 0;
+  MPI_Initialized(&mpi_is_initialized);
+  if(mpi_is_initialized){
+    MPI_Comm_split_type(MPI_COMM_WORLD,MPI_COMM_TYPE_SHARED,0,MPI_INFO_NULL,&node_comm_);
+    int rank = 0, size = 1;
+    MPI_Comm_rank(node_comm_,&rank);
+    MPI_Comm_size(node_comm_,&size);
+    node_rank_ = rank;
+    node_size_ = size;
+    use_shared_memory_ = true;
+  }
+#endif
+  DEBUG_MSG("Node_Image_Reader::Node_Image_Reader(): node rank " << node_rank_ << " of " << node_size_ <<
+    ", shared memory " << use_shared_memory_);
+}
+
+Node_Image_Reader::~Node_Image_Reader(){
+#if DICE_NODE_SHARED_MEMORY
+  if(!use_shared_memory_) return;
+  // MPI_Finalize has already released the windows and the communicator
+  int mpi_is_finalized = 0;
+  MPI_Finalized(&mpi_is_finalized);
+  if(mpi_is_finalized) return;
+  for(size_t i=0;i<windows_.size();++i)
+    MPI_Win_free(&windows_[i]->win);
+  windows_.clear();
+  MPI_Comm_free(&node_comm_);
+#endif
+}
+
+void
+Node_Image_Reader::free_released_windows(){
+#if DICE_NODE_SHARED_MEMORY
+  if(windows_.empty()) return;
+  const int num_windows = windows_.size();
+  std::vector<int> released(num_windows,0);
+  std::vector<int> released_on_node(num_windows,0);
+  for(int i=0;i<num_windows;++i)
+    released[i] = windows_[i]->num_views==0 ? 1 : 0;
+  MPI_Allreduce(&released[0],&released_on_node[0],num_windows,MPI_INT,MPI_MIN,node_comm_);
+  std::vector<Teuchos::RCP<Shared_Window> > in_use;
+  for(int i=0;i<num_windows;++i){
+    if(released_on_node[i])
+      MPI_Win_free(&windows_[i]->win);
+    else
+      in_use.push_back(windows_[i]);
+  }
+  DEBUG_MSG("Node_Image_Reader::free_released_windows(): freed " << num_windows - in_use.size() << " of " << num_windows << " windows");
+  windows_.swap(in_use);
+#endif
+}
+
+Teuchos::RCP<Image>
+Node_Image_Reader::read(const std::string & file_name,
+  const int_t offset_x,
+  const int_t offset_y,
+  const int_t width,
+  const int_t height,
+  const Teuchos::RCP<Teuchos::ParameterList> & params){
+  TEUCHOS_TEST_FOR_EXCEPTION(offset_x<0||offset_y<0||width<=0||height<=0,std::invalid_argument,
+    "Error, invalid image window " << offset_x << " " << offset_y << " " << width << " " << height);
+  if(!use_shared_memory_)
+    return Teuchos::rcp(new Image(file_name.c_str(),offset_x,offset_y,width,height,params));
+#if DICE_NODE_SHARED_MEMORY
+  // merge the windows of the processes on the node (the far corner is negated so one min reduction does it)
+  int local_window[4] = {offset_x,offset_y,-(offset_x+width),-(offset_y+height)};
+  int node_window[4] = {0,0,0,0};
+  MPI_Allreduce(local_window,node_window,4,MPI_INT,MPI_MIN,node_comm_);
+  const int_t node_offset_x = node_window[0];
+  const int_t node_offset_y = node_window[1];
+  const int_t node_width = -node_window[2] - node_offset_x;
+  const int_t node_height = -node_window[3] - node_offset_y;
+  const int_t num_px = node_width*node_height;
+  DEBUG_MSG("Node_Image_Reader::read(): " << file_name << " node window " << node_offset_x << " " << node_offset_y <<
+    " " << node_width << " " << node_height);
+  free_released_windows();
+
+  // the first process on the node reads the window, filters it and computes the gradients,
+  // the storage that depends on the interpolant is set up by each process when it wraps the shared arrays
+  Teuchos::RCP<Image> node_img;
+  int status[3] = {1,0,0}; // read succeeded, has gradients, has gauss filter
+  if(node_rank_==0){
+    Teuchos::RCP<Teuchos::ParameterList> read_params = params==Teuchos::null ?
+        Teuchos::rcp(new Teuchos::ParameterList()) : Teuchos::rcp(new Teuchos::ParameterList(*params));
+    read_params->set(DICe::compact_image_storage,false);
+    read_params->set(DICe::tiled_image_layout,false);
+    read_params->remove(DICe::interpolation_method,false);
+    try{
+      node_img = Teuchos::rcp(new Image(file_name.c_str(),node_offset_x,node_offset_y,node_width,node_height,read_params));
+      status[1] = node_img->has_gradients() ? 1 : 0;
+      status[2] = node_img->has_gauss_filter() ? 1 : 0;
+    }
+    catch(std::exception &){
+      status[0] = 0;
+    }
+  }
+  MPI_Bcast(status,3,MPI_INT,0,node_comm_);
+  TEUCHOS_TEST_FOR_EXCEPTION(status[0]==0,std::runtime_error,"Error, image file read failure on the first process of the node: " << file_name);
+
+  // only the first process allocates, the others map its segment
+  Teuchos::RCP<Shared_Window> window = Teuchos::rcp(new Shared_Window());
+  const MPI_Aint num_bytes = node_rank_==0 ? static_cast<MPI_Aint>(num_px)*(3*sizeof(scalar_t)+sizeof(intensity_t)) : 0;
+  void * base = NULL;
+  MPI_Win_allocate_shared(num_bytes,1,MPI_INFO_NULL,node_comm_,&base,&window->win);
+  MPI_Aint segment_size = 0;
+  int disp_unit = 0;
+  MPI_Win_shared_query(window->win,0,&segment_size,&disp_unit,&base);
+  // the scalar arrays go first so the intensities stay aligned if they are a narrower type
+  scalar_t * grad_x = static_cast<scalar_t*>(base);
+  scalar_t * grad_y = grad_x + num_px;
+  scalar_t * mask = grad_y + num_px;
+  intensity_t * intensities = reinterpret_cast<intensity_t*>(mask + num_px);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK,window->win);
+  if(node_rank_==0){
+    Teuchos::ArrayRCP<intensity_t> node_intensities = node_img->intensities();
+    Teuchos::ArrayRCP<scalar_t> node_grad_x = node_img->grad_x_array();
+    Teuchos::ArrayRCP<scalar_t> node_grad_y = node_img->grad_y_array();
+    for(int_t i=0;i<num_px;++i){
+      intensities[i] = node_intensities[i];
+      grad_x[i] = node_grad_x[i];
+      grad_y[i] = node_grad_y[i];
+    }
+    for(int_t y=0;y<node_height;++y)
+      for(int_t x=0;x<node_width;++x)
+        mask[y*node_width+x] = node_img->mask(x,y);
+    node_img = Teuchos::null;
+  }
+  // make the values written by the first process visible to the rest of the node
+  MPI_Win_sync(window->win);
+  MPI_Barrier(node_comm_);
+  MPI_Win_sync(window->win);
+  MPI_Win_unlock_all(window->win);
+
+  window->num_views = 4;
+  windows_.push_back(window);
+  return Teuchos::rcp(new Image(node_width,node_height,
+    Teuchos::arcp(intensities,0,num_px,Shared_Window_Dealloc<intensity_t>(window),true),
+    Teuchos::arcp(grad_x,0,num_px,Shared_Window_Dealloc<scalar_t>(window),true),
+    Teuchos::arcp(grad_y,0,num_px,Shared_Window_Dealloc<scalar_t>(window),true),
+    Teuchos::arcp(mask,0,num_px,Shared_Window_Dealloc<scalar_t>(window),true),
+    status[1]!=0,status[2]!=0,params,node_offset_x,node_offset_y,file_name));
+#else
+  return Teuchos::null;
+#endif
+}
+
+}// End DICe Namespace
@@ -0,0 +1,141 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#ifndef DICE_NODEIMAGEREADER_H
+#define DICE_NODEIMAGEREADER_H
+
+#include <DICe.h>
+#include <DICe_Image.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <string>
+#include <vector>
+
+#if DICE_MPI
+#  include <mpi.h>
+#endif
+
+namespace DICe {
+
+/// \brief returns the number of processes on this compute node (the processes that can share memory with this one)
+///
+/// Collective over all the processes, returns 1 without MPI (or with MPI older than version 3)
+DICE_LIB_DLL_EXPORT
+int_t num_processes_on_node();
+
+/// \class DICe::Node_Image_Reader
+/// \brief Reads each image once per compute node into shared memory so that all of the processes
+/// on the node use the same copy of the intensities and gradients
+///
+/// The processes that can share memory are grouped into a node communicator (MPI-3). Every call to read()
+/// is collective over the node: the windows requested by the processes are merged, the first process on the
+/// node reads the merged window (including the filter and gradients) and copies the intensities, gradients and
+/// mask into an MPI shared memory window, then every process gets an image that points directly into it.
+/// A shared window is freed at the start of a later read() once every process on the node has released
+/// its image. Without MPI (or with MPI older than version 3) each process reads its own window.
+class DICE_LIB_DLL_EXPORT
+Node_Image_Reader{
+public:
+  /// constructor, creates the node communicator
+  Node_Image_Reader();
+
+  /// destructor, frees the shared windows (the images that were read must not be used after this)
+  ~Node_Image_Reader();
+
+  /// \brief reads a window of an image, collective over the processes on the node
+  /// \param file_name the name of the image file (must be the same on every process of the node)
+  /// \param offset_x upper left corner x-coordinate of the window this process needs
+  /// \param offset_y upper left corner y-coordinate of the window this process needs
+  /// \param width width of the window this process needs
+  /// \param height height of the window this process needs
+  /// \param params image parameters (filtering, gradients, etc.)
+  /// The image returned covers the windows of all the processes on the node
+  Teuchos::RCP<Image> read(const std::string & file_name,
+    const int_t offset_x,
+    const int_t offset_y,
+    const int_t width,
+    const int_t height,
+    const Teuchos::RCP<Teuchos::ParameterList> & params=Teuchos::null);
+
+  /// returns the rank of this process on the node
+  int_t node_rank()const{
+    return node_rank_;
+  }
+
+  /// returns the number of processes on the node
+  int_t node_size()const{
+    return node_size_;
+  }
+
+  /// returns the number of shared windows that have not been freed
+  int_t num_shared_windows()const{
+    return windows_.size();
+  }
+
+  /// forward declaration of a shared memory window
+  struct Shared_Window;
+
+private:
+  /// copy constructor not allowed
+  Node_Image_Reader(const Node_Image_Reader &);
+  /// assignment not allowed
+  Node_Image_Reader & operator=(const Node_Image_Reader &);
+  /// frees the windows that every process on the node has released (collective over the node)
+  void free_released_windows();
+#if DICE_MPI
+  /// communicator of the processes on this node
+  MPI_Comm node_comm_;
+#endif
+  /// true if the images are shared through MPI shared memory windows
+  bool use_shared_memory_;
+  /// rank of this process on the node
+  int_t node_rank_;
+  /// number of processes on the node
+  int_t node_size_;
+  /// the shared windows that have not been freed, in the same order on every process of the node
+  std::vector<Teuchos::RCP<Shared_Window> > windows_;
+};
+
+}// End DICe Namespace
+
+#endif
@@ -41,10 +41,9 @@
 
 #include <DICe_Objective.h>
 #include <DICe_ImageUtils.h>
+#include <DICe_Matrix.h>
 #include <DICe_Simplex.h>
-
-#include <Teuchos_LAPACK.hpp>
-#include <Teuchos_SerialDenseMatrix.hpp>
+#include <DICe_Profiler.h>
 
 #include <iostream>
 #include <iomanip>
@@ -57,6 +56,12 @@ using namespace field_enums;
 
 scalar_t
 Objective::gamma( Teuchos::RCP<Local_Shape_Function> shape_function) const {
+  return gamma(shape_function,schema_->normalize_gamma_with_active_pixels());
+}
+
+scalar_t
+Objective::gamma( Teuchos::RCP<Local_Shape_Function> shape_function,
+  const bool normalize_with_active_pixels) const {
   try{
     subset_->initialize(schema_->def_img(subset_->sub_image_id()),DEF_INTENSITIES,shape_function,schema_->interpolation_method());
   }
@@ -64,7 +69,7 @@ Objective::gamma( Teuchos::RCP<Local_Shape_Function> shape_function) const {
     return -1.0;
   }
   scalar_t gamma = subset_->gamma();
-  if(schema_->normalize_gamma_with_active_pixels()){
+  if(normalize_with_active_pixels){
     int_t num_active_pixels = 0;
     for(int_t i=0;i<subset_->num_pixels();++i)
       if(subset_->is_active(i)) num_active_pixels++;
@@ -78,9 +83,8 @@ scalar_t
 Objective::beta(Teuchos::RCP<Local_Shape_Function> shape_function) const {
   // for now return -1 for beta if affine shape functions are used
 
-  // for beta we don't want the gamma values normalized by the number of pixels:
-  const bool original_normalize_flag = schema_->normalize_gamma_with_active_pixels();
-  schema_->set_normalize_gamma_with_active_pixels(false);
+  // for beta we don't want the gamma values normalized by the number of pixels
+  // (the schema flag is left alone since other threads may be reading it)
   std::vector<scalar_t> epsilon(3);
   epsilon[0] = 1.0E-1;
   epsilon[1] = 1.0E-1;
@@ -90,7 +94,7 @@ Objective::beta(Teuchos::RCP<Local_Shape_Function> shape_function) const {
   factor[1] = 1.0E-3;
   factor[2] = 1.0E-1;
   scalar_t temp_u=0.0,temp_v=0.0,temp_t=0.0;
-  const scalar_t gamma_0 = gamma(shape_function);
+  const scalar_t gamma_0 = gamma(shape_function,false);
   std::vector<scalar_t> dir_beta(3,0.0);
   Teuchos::RCP<Local_Shape_Function> temp_lsf = shape_function_factory(schema_);
   for(size_t i=0;i<3;++i){
@@ -105,7 +109,7 @@ Objective::beta(Teuchos::RCP<Local_Shape_Function> shape_function) const {
       temp_t += epsilon[i];
     }
     temp_lsf->insert_motion(temp_u,temp_v,temp_t);
-    const scalar_t gamma_p = gamma(temp_lsf);
+    const scalar_t gamma_p = gamma(temp_lsf,false);
     if(i==0){
       temp_u -= 2*epsilon[i];
     }else if(i==1){
@@ -115,12 +119,10 @@ Objective::beta(Teuchos::RCP<Local_Shape_Function> shape_function) const {
     }
     temp_lsf->insert_motion(temp_u,temp_v,temp_t);
     // mod the def vector -
-    const scalar_t gamma_m = gamma(temp_lsf);
+    const scalar_t gamma_m = gamma(temp_lsf,false);
     if(std::abs(gamma_m - gamma_0)<1.0E-10||std::abs(gamma_p - gamma_0)<1.0E-10){
       // abort because the slope is so bad that beta is infinite
       DEBUG_MSG("Objective::beta(): return value -1.0");
-      // replace the correct normalization flag:
-      schema_->set_normalize_gamma_with_active_pixels(original_normalize_flag);
       // re-initialize the subset with the original deformation solution
       subset_->initialize(schema_->def_img(subset_->sub_image_id()),DEF_INTENSITIES,shape_function,schema_->interpolation_method());
       return -1.0;
@@ -138,9 +140,6 @@ Objective::beta(Teuchos::RCP<Local_Shape_Function> shape_function) const {
   mag_dir_beta = std::sqrt(mag_dir_beta);
   DEBUG_MSG("Objective::beta(): return value " << mag_dir_beta);
 
-  // replace the correct normalization flag:
-  schema_->set_normalize_gamma_with_active_pixels(original_normalize_flag);
-
   // re-initialize the subset with the original deformation solution
   subset_->initialize(schema_->def_img(subset_->sub_image_id()),DEF_INTENSITIES,shape_function,schema_->interpolation_method());
   return mag_dir_beta;
@@ -280,6 +279,7 @@ Status_Flag
 Objective::computeUpdateRobust(Teuchos::RCP<Local_Shape_Function> shape_function,
   int_t & num_iterations,
   const scalar_t & override_tol){
+  profiler::Scope optimization_scope(profiler::SIMPLEX_OPTIMIZATION);
 
   const scalar_t skip_threshold = override_tol==-1 ? schema_->skip_solve_gamma_threshold() : override_tol;
 
@@ -297,26 +297,130 @@ Objective::computeUpdateRobust(Teuchos::RCP<Local_Shape_Function> shape_function
   return status_flag;
 }
 
+namespace {
+
+/// accumulate the upper triangle of the Gauss-Newton Hessian, the right hand side
+/// and the residual sums over the active pixels of a subset using a compile time
+/// residual kernel with N parameters (see Residual_Kernel in DICe_LocalShapeFunction.h)
+template<int_t N, typename Kernel>
+void accumulate_gauss_newton_sums(const Kernel & kernel,
+  Subset * subset,
+  const scalar_t * grad_x,
+  const scalar_t * grad_y,
+  Matrix<double> & H,
+  double * q,
+  double * sum_residuals,
+  double & sum_G,
+  int_t & num_active){
+  double H_local[N*N] = {};
+  double q_local[N] = {};
+  double sum_r_local[N] = {};
+  scalar_t residuals[N];
+  for(int_t index=0;index<subset->num_pixels();++index){
+    if(subset->is_deactivated_this_step(index)||!subset->is_active(index)) continue;
+    const scalar_t G = subset->def_intensities(index);
+    sum_G += G;
+    num_active++;
+    const double GmF = G - subset->ref_intensities(index);
+    kernel(subset->x(index),subset->y(index),grad_x[index],grad_y[index],residuals);
+    for(int_t i=0;i<N;++i){
+      q_local[i] += GmF*residuals[i];
+      sum_r_local[i] += residuals[i];
+      for(int_t j=i;j<N;++j)
+        H_local[i*N+j] += residuals[i]*residuals[j];
+    }
+  }
+  for(int_t i=0;i<N;++i){
+    q[i] += q_local[i];
+    sum_residuals[i] += sum_r_local[i];
+    for(int_t j=i;j<N;++j)
+      H(i,j) += H_local[i*N+j];
+  }
+}
+
+/// dispatch the affine kernel on the number of active parameters, returns false if not handled
+bool
+accumulate_affine_gauss_newton_sums(Affine_Shape_Function & shape_function,
+  const scalar_t & cx,
+  const scalar_t & cy,
+  const bool use_ref_grads,
+  Subset * subset,
+  const scalar_t * grad_x,
+  const scalar_t * grad_y,
+  Matrix<double> & H,
+  double * q,
+  double * sum_residuals,
+  double & sum_G,
+  int_t & num_active){
+  switch(shape_function.num_params()){
+  case 2: accumulate_gauss_newton_sums<2>(Residual_Kernel<Affine_Shape_Function,2>(shape_function,cx,cy,use_ref_grads),
+    subset,grad_x,grad_y,H,q,sum_residuals,sum_G,num_active); return true;
+  case 3: accumulate_gauss_newton_sums<3>(Residual_Kernel<Affine_Shape_Function,3>(shape_function,cx,cy,use_ref_grads),
+    subset,grad_x,grad_y,H,q,sum_residuals,sum_G,num_active); return true;
+  case 4: accumulate_gauss_newton_sums<4>(Residual_Kernel<Affine_Shape_Function,4>(shape_function,cx,cy,use_ref_grads),
+    subset,grad_x,grad_y,H,q,sum_residuals,sum_G,num_active); return true;
+  case 5: accumulate_gauss_newton_sums<5>(Residual_Kernel<Affine_Shape_Function,5>(shape_function,cx,cy,use_ref_grads),
+    subset,grad_x,grad_y,H,q,sum_residuals,sum_G,num_active); return true;
+  case 6: accumulate_gauss_newton_sums<6>(Residual_Kernel<Affine_Shape_Function,6>(shape_function,cx,cy,use_ref_grads),
+    subset,grad_x,grad_y,H,q,sum_residuals,sum_G,num_active); return true;
+  default: return false;
+  }
+}
+
+/// factor the symmetric Gauss-Newton hessian in place on the stack, Cholesky is tried first
+/// since H = J^T J is positive definite for a well conditioned subset and LDL^T is the fallback
+/// if roundoff spoils that, returns false if neither factorization succeeds
+bool
+factor_hessian(Matrix<double> & H,
+  bool & use_ldlt){
+  const size_t n = H.rows();
+  std::array<double,MAX_MATRIX_DIM> diag;
+  for(size_t i=0;i<n;++i)
+    diag[i] = H(i,i);
+  use_ldlt = false;
+  if(H.cholesky()) return true;
+  // cholesky() only overwrites the diagonal and lower triangle, restore them from the upper triangle
+  for(size_t i=0;i<n;++i){
+    H(i,i) = diag[i];
+    for(size_t j=0;j<i;++j)
+      H(i,j) = H(j,i);
+  }
+  use_ldlt = true;
+  return H.ldlt();
+}
+
+/// solve H x = b in place using the factors from factor_hessian()
+void
+solve_hessian(const Matrix<double> & H,
+  const bool use_ldlt,
+  Vector<double> & b){
+  if(use_ldlt)
+    H.ldlt_solve(b);
+  else
+    H.cholesky_solve(b);
+}
+
+} // namespace
+
 Status_Flag
 Objective_ZNSSD::computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_function,
   int_t & num_iterations){
+  profiler::Scope optimization_scope(profiler::GRADIENT_OPTIMIZATION);
   TEUCHOS_TEST_FOR_EXCEPTION(!subset_->has_gradients(),std::runtime_error,"Error, image gradients have not been computed but are needed here.");
   // TODO catch the case where the initial gamma is good enough (possibly do this at the image level, not subset?):
   int_t N = shape_function->num_params(); // one degree of freedom for each shape function parameter
   assert(N>=2);
+  TEUCHOS_TEST_FOR_EXCEPTION(N>MAX_MATRIX_DIM,std::runtime_error,"Error, too many shape function parameters: " << N);
   scalar_t tolerance = schema_->fast_solver_tolerance();
   const int_t max_solve_its = schema_->max_solver_iterations_fast();
-  int *IPIV = new int[N+1];
-  int LWORK = N*N;
-  int INFO = 0;
-  // using type double here because LAPACK doesn't support float.
-  double *WORK = new double[LWORK];
-  Teuchos::LAPACK<int_t,double> lapack;
-
-  // Initialize storage:
-  Teuchos::SerialDenseMatrix<int_t,double> H(N,N, true);
+
+  // Initialize storage (the hessian and the update are solved in double precision on the stack):
+  Matrix<double> H(N,N);
+  Vector<double> update(N);
+  bool use_ldlt = false;
   Teuchos::ArrayRCP<double> q(N,0.0);
   std::vector<scalar_t> residuals(N,0.0);
+  std::vector<double> sum_residuals(N,0.0);
   std::vector<scalar_t> def_old(N,0.0);    // save off the previous value to test for convergence
   std::vector<scalar_t> def_update(N,0.0); // save off the previous value to test for convergence
 
@@ -328,6 +432,11 @@ Objective_ZNSSD::computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_func
   const scalar_t cy = subset_->centroid_y();
   const scalar_t meanF = subset_->mean(REF_INTENSITIES);
 
+  // resolve the concrete shape function once per subset so the pixel loop below
+  // can use a compile time residual kernel rather than a virtual call per pixel
+  Affine_Shape_Function * affine_shape_function = dynamic_cast<Affine_Shape_Function*>(shape_function.get());
+  Quadratic_Shape_Function * quadratic_shape_function = dynamic_cast<Quadratic_Shape_Function*>(shape_function.get());
+
   scalar_t old_u=0.0,old_v=0.0,old_t=0.0;
   shape_function->map_to_u_v_theta(cx,cy,old_u,old_v,old_t);
   DEBUG_MSG(std::setw(5) << "Iter" <<
@@ -354,24 +463,52 @@ Objective_ZNSSD::computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_func
     catch (...) {
       return SUBSET_CONSTRUCTION_FAILED;
     }
-    // compute the mean value of the subsets:
-    const scalar_t meanG = subset_->mean(DEF_INTENSITIES);
     // the gradients are taken from the def images rather than the ref
     const bool use_ref_grads = schema_->def_img()->has_gradients() ? false : true;
 
-    scalar_t GmF = 0.0;
-    for(int_t index=0;index<subset_->num_pixels();++index){
-      if(subset_->is_deactivated_this_step(index)||!subset_->is_active(index)) continue;
-      GmF = (subset_->def_intensities(index) - meanG) - (subset_->ref_intensities(index) - meanF);
-      for(int_t i=0;i<N;++i)
-        residuals[i] = 0.0;
-      shape_function->residuals(subset_->x(index),subset_->y(index),cx,cy,gradGx[index],gradGy[index],residuals,use_ref_grads);
-      for(int_t i=0;i<N;++i){
-        q[i] += GmF*residuals[i];
-        for(int_t j=0;j<N;++j)
-          H(i,j) += residuals[i]*residuals[j];
+    // single pass over the active pixels: the mean of the deformed intensities is not known until the
+    // end of the pass so it is folded into q afterwards using
+    // q_i = sum((G-meanG)-(F-meanF))r_i = sum(G-F)r_i - (meanG-meanF)sum(r_i)
+    // only the upper triangle of H is accumulated (H is symmetric)
+    double sum_G = 0.0;
+    int_t num_active = 0;
+    for(int_t i=0;i<N;++i)
+      sum_residuals[i] = 0.0;
+    bool accumulated = false;
+    if(affine_shape_function){
+      accumulated = accumulate_affine_gauss_newton_sums(*affine_shape_function,cx,cy,use_ref_grads,subset_.get(),
+        gradGx.getRawPtr(),gradGy.getRawPtr(),H,q.getRawPtr(),&sum_residuals[0],sum_G,num_active);
+    }
+    else if(quadratic_shape_function&&N==12){
+      accumulate_gauss_newton_sums<12>(Residual_Kernel<Quadratic_Shape_Function,12>(*quadratic_shape_function,cx,cy,use_ref_grads),
+        subset_.get(),gradGx.getRawPtr(),gradGy.getRawPtr(),H,q.getRawPtr(),&sum_residuals[0],sum_G,num_active);
+      accumulated = true;
+    }
+    // generic path for the other shape functions (virtual residuals call per pixel)
+    if(!accumulated){
+      for(int_t index=0;index<subset_->num_pixels();++index){
+        if(subset_->is_deactivated_this_step(index)||!subset_->is_active(index)) continue;
+        const scalar_t G = subset_->def_intensities(index);
+        sum_G += G;
+        num_active++;
+        const double GmF = G - subset_->ref_intensities(index);
+        for(int_t i=0;i<N;++i)
+          residuals[i] = 0.0;
+        shape_function->residuals(subset_->x(index),subset_->y(index),cx,cy,gradGx[index],gradGy[index],residuals,use_ref_grads);
+        for(int_t i=0;i<N;++i){
+          q[i] += GmF*residuals[i];
+          sum_residuals[i] += residuals[i];
+          for(int_t j=i;j<N;++j)
+            H(i,j) += residuals[i]*residuals[j];
+        }
       }
     }
+    const double meanG = num_active > 0 ? sum_G/num_active : 0.0;
+    for(int_t i=0;i<N;++i){
+      q[i] -= (meanG - meanF)*sum_residuals[i];
+      for(int_t j=0;j<i;++j)
+        H(i,j) = H(j,i);
+    }
 
     if(schema_->use_objective_regularization()){ // TODO test for affine shape functions too
       // add the penalty terms
@@ -391,37 +528,19 @@ Objective_ZNSSD::computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_func
       cond_2x2 = norm_H * norm_Hi;
     }
 
-    // clear temp storage
-    for(int_t i=0;i<LWORK;++i) WORK[i] = 0.0;
-    for(int_t i=0;i<N+1;++i) {IPIV[i] = 0;}
-    try
-    {
-      lapack.GETRF(N,N,H.values(),N,IPIV,&INFO);
-      if(correlation_point_global_id_>=0)
-        schema_->global_field_value(correlation_point_global_id_,CONDITION_NUMBER_FS) = cond_2x2;
-      if(cond_2x2 > 1.0E12) return HESSIAN_SINGULAR;
-    }
-    catch(std::exception &e){
-      std::cout << e.what() << '\n';
-      return LINEAR_SOLVE_FAILED;
-    }
-    for(int_t i=0;i<LWORK;++i) WORK[i] = 0.0;
-    try
-    {
-      lapack.GETRI(N,H.values(),N,IPIV,WORK,LWORK,&INFO);
-    }
-    catch(std::exception &e){
-      std::cout << e.what() << '\n';
-      return LINEAR_SOLVE_FAILED;
-    }
+    if(correlation_point_global_id_>=0)
+      schema_->global_field_value(correlation_point_global_id_,CONDITION_NUMBER_FS) = cond_2x2;
+    if(cond_2x2 > 1.0E12) return HESSIAN_SINGULAR;
+    if(!factor_hessian(H,use_ldlt)) return HESSIAN_SINGULAR;
+
     // save off last step
     for(int_t i=0;i<N;++i)
       def_old[i] = (*shape_function)(i);
     for(int_t i=0;i<N;++i)
-      def_update[i] = 0.0;
+      update(i) = -q[i];
+    solve_hessian(H,use_ldlt,update);
     for(int_t i=0;i<N;++i)
-      for(int_t j=0;j<N;++j)
-        def_update[i] += H(i,j)*(-1.0)*q[j];
+      def_update[i] = update(i);
     shape_function->update(def_update);
 
     scalar_t guess_u = 0.0,guess_v=0.0,guess_t=0.0;
@@ -447,14 +566,149 @@ Objective_ZNSSD::computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_func
     }
 
     // zero out the storage
-    H.putScalar(0.0);
+    H.put_value(0.0);
     for(int_t i=0;i<N;++i)
       q[i] = 0.0;
   } // end solve iteration loop
 
-  // clean up storage for lapack:
-  delete [] WORK;
-  delete [] IPIV;
+  if(solve_it>max_solve_its){
+    return MAX_ITERATIONS_REACHED;
+  }
+  else return CORRELATION_SUCCESSFUL;
+}
+
+Status_Flag
+Objective_ZNSSD::computeUpdateInverseCompositional(Teuchos::RCP<Local_Shape_Function> shape_function,
+  int_t & num_iterations){
+  // the inverse compositional update needs to be able to invert and compose the warp,
+  // for the shape functions that can't do this, fall back to the forward additive method
+  if(!shape_function->has_inverse_compositional_update()){
+    DEBUG_MSG("Subset " << correlation_point_global_id_ << " shape function does not support the inverse compositional update, using computeUpdateFast()");
+    return computeUpdateFast(shape_function,num_iterations);
+  }
+  profiler::Scope optimization_scope(profiler::GRADIENT_OPTIMIZATION);
+  Teuchos::RCP<Image> ref_img = schema_->ref_img();
+  TEUCHOS_TEST_FOR_EXCEPTION(!ref_img->has_gradients(),std::runtime_error,"Error, reference image gradients have not been computed but are needed here.");
+  const int_t N = shape_function->num_params();
+  assert(N>=2);
+  const scalar_t tolerance = schema_->fast_solver_tolerance();
+  const int_t max_solve_its = schema_->max_solver_iterations_fast();
+  const int_t num_pixels = subset_->num_pixels();
+  const scalar_t cx = subset_->centroid_x();
+  const scalar_t cy = subset_->centroid_y();
+  const int_t offset_x = ref_img->offset_x();
+  const int_t offset_y = ref_img->offset_y();
+  const scalar_t meanF = subset_->mean(REF_INTENSITIES);
+
+  // steepest descent images: the reference gradients times the jacobian of the warp evaluated at zero parameters
+  Teuchos::RCP<Local_Shape_Function> zero_shape_function = shape_function_factory(schema_);
+  zero_shape_function->clear();
+  std::vector<scalar_t> steepest_descent(num_pixels*N,0.0);
+  std::vector<scalar_t> residuals(N,0.0);
+  for(int_t index=0;index<num_pixels;++index){
+    for(int_t i=0;i<N;++i)
+      residuals[i] = 0.0;
+    zero_shape_function->residuals(subset_->x(index),subset_->y(index),cx,cy,
+      ref_img->grad_x(subset_->x(index)-offset_x,subset_->y(index)-offset_y),
+      ref_img->grad_y(subset_->x(index)-offset_x,subset_->y(index)-offset_y),residuals,false);
+    for(int_t i=0;i<N;++i)
+      steepest_descent[index*N+i] = residuals[i];
+  }
+
+  TEUCHOS_TEST_FOR_EXCEPTION(N>MAX_MATRIX_DIM,std::runtime_error,"Error, too many shape function parameters: " << N);
+  // the hessian is factored once and the factors are reused for every solve
+  Matrix<double> H(N,N);
+  Vector<double> q(N);
+  bool use_ldlt = false;
+  std::vector<scalar_t> def_old(N,0.0);
+  std::vector<scalar_t> def_update(N,0.0);
+  // the hessian only has to be assembled and inverted again if the set of active pixels changes
+  std::vector<bool> hessian_pixels(num_pixels,false);
+  bool hessian_valid = false;
+
+  int_t solve_it = 0;
+  for(;solve_it<=max_solve_its;++solve_it){
+    num_iterations = solve_it;
+
+    // update the deformed image with the new deformation:
+    try{
+      subset_->initialize(schema_->def_img(subset_->sub_image_id()),DEF_INTENSITIES,shape_function,schema_->interpolation_method());
+    }
+    catch (...) {
+      return SUBSET_CONSTRUCTION_FAILED;
+    }
+    const scalar_t meanG = subset_->mean(DEF_INTENSITIES);
+
+    for(int_t index=0;index<num_pixels;++index){
+      const bool use_pixel = !subset_->is_deactivated_this_step(index)&&subset_->is_active(index);
+      if(use_pixel!=hessian_pixels[index]){
+        hessian_valid = false;
+        hessian_pixels[index] = use_pixel;
+      }
+    }
+
+    if(!hessian_valid){
+      H.put_value(0.0);
+      for(int_t index=0;index<num_pixels;++index){
+        if(!hessian_pixels[index]) continue;
+        const scalar_t * sd = &steepest_descent[index*N];
+        for(int_t i=0;i<N;++i)
+          for(int_t j=0;j<N;++j)
+            H(i,j) += sd[i]*sd[j];
+      }
+      if(schema_->use_objective_regularization()){
+        const scalar_t alpha = schema_->levenberg_marquardt_regularization_factor();
+        H(0,0) += alpha;
+        H(1,1) += alpha;
+      }
+      // see computeUpdateFast() for the condition number estimate
+      const scalar_t det_h = H(0,0)*H(1,1) - H(1,0)*H(0,1);
+      const scalar_t norm_H = std::sqrt(H(0,0)*H(0,0) + H(0,1)*H(0,1) + H(1,0)*H(1,0) + H(1,1)*H(1,1));
+      scalar_t cond_2x2 = -1.0;
+      if(det_h !=0.0){
+        const scalar_t norm_Hi = std::sqrt((1.0/(det_h*det_h))*(H(0,0)*H(0,0) + H(0,1)*H(0,1) + H(1,0)*H(1,0) + H(1,1)*H(1,1)));
+        cond_2x2 = norm_H * norm_Hi;
+      }
+      if(correlation_point_global_id_>=0)
+        schema_->global_field_value(correlation_point_global_id_,CONDITION_NUMBER_FS) = cond_2x2;
+      if(cond_2x2 > 1.0E12) return HESSIAN_SINGULAR;
+      if(!factor_hessian(H,use_ldlt)) return HESSIAN_SINGULAR;
+      hessian_valid = true;
+    }
+
+    for(int_t i=0;i<N;++i)
+      q(i) = 0.0;
+    for(int_t index=0;index<num_pixels;++index){
+      if(!hessian_pixels[index]) continue;
+      const scalar_t GmF = (subset_->def_intensities(index) - meanG) - (subset_->ref_intensities(index) - meanF);
+      const scalar_t * sd = &steepest_descent[index*N];
+      for(int_t i=0;i<N;++i)
+        q(i) += GmF*sd[i];
+    }
+
+    // save off last step
+    for(int_t i=0;i<N;++i)
+      def_old[i] = (*shape_function)(i);
+    solve_hessian(H,use_ldlt,q);
+    for(int_t i=0;i<N;++i)
+      def_update[i] = q(i);
+    // the incremental warp is applied to the reference subset so the
+    // current warp is composed with its inverse
+    try{
+      shape_function->inverse_compositional_update(def_update);
+    }
+    catch(...){
+      return LINEAR_SOLVE_FAILED;
+    }
+
+    const bool converged = shape_function->test_for_convergence(def_old,tolerance);
+    if(converged){
+      DEBUG_MSG("Subset " << correlation_point_global_id_ << " ** CONVERGED SOLUTION (inverse compositional) ");
+      shape_function->print_parameters();
+      computeUncertaintyFields(shape_function);
+      break;
+    }
+  } // end solve iteration loop
 
   if(solve_it>max_solve_its){
     return MAX_ITERATIONS_REACHED;
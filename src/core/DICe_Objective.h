@@ -49,6 +49,7 @@
 #include <DICe_Image.h>
 #include <DICe_Subset.h>
 #include <DICe_Schema.h>
+#include <DICe_Profiler.h>
 
 #include <cassert>
 
@@ -84,6 +85,7 @@ public:
     correlation_point_global_id_(correlation_point_global_id)
 {
     if(correlation_point_global_id==-1)return;
+    profiler::Scope construction_scope(profiler::SUBSET_CONSTRUCTION);
     assert(schema_->is_initialized());
     // create the refSubset as member data
     // check to see if the schema has multishapes:
@@ -113,6 +115,7 @@ const int_t y):
     schema_(schema),
     correlation_point_global_id_(-1)
 {
+    profiler::Scope construction_scope(profiler::SUBSET_CONSTRUCTION);
     // create the refSubset as member data from x/y and w/h:
     assert(schema_->is_initialized());
     assert(schema_->subset_dim()>0);
@@ -129,6 +132,12 @@ const int_t y):
   /// \param shape_function pointer to the class that holds the deformation parameter values
   scalar_t gamma( Teuchos::RCP<Local_Shape_Function> shape_function) const;
 
+  /// \brief Correlation criteria with explicit control of the active pixel normalization
+  /// \param shape_function pointer to the class that holds the deformation parameter values
+  /// \param normalize_with_active_pixels divide gamma by the number of active pixels in the subset
+  scalar_t gamma( Teuchos::RCP<Local_Shape_Function> shape_function,
+    const bool normalize_with_active_pixels) const;
+
   /// \brief Uncertainty measure for solution
   /// \param shape_function [out] pointer to the class that holds the deformation parameter values
   /// \param noise_level [out] Returned as the standard deviation estimate of the image noise sigma_g from Sutton et.al.
@@ -145,6 +154,16 @@ const int_t y):
   virtual Status_Flag computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_function,
     int_t & num_iterations) = 0;
 
+  /// \brief Inverse compositional Gauss-Newton optimization algorithm
+  ///
+  /// The steepest descent images and the inverse of the Hessian are computed once from the
+  /// reference subset, each iteration only re-interpolates the deformed subset and composes
+  /// the current warp with the inverse of the incremental warp
+  /// \param shape_function pointer to the class that holds the deformation parameter values
+  /// \param num_iterations [out] The number of interations a particular frame took to execute
+  virtual Status_Flag computeUpdateInverseCompositional(Teuchos::RCP<Local_Shape_Function> shape_function,
+    int_t & num_iterations) = 0;
+
   /// \brief Simplex based optimization algorithm
   /// \param shape_function pointer to the class that holds the deformation parameter values
   /// \param num_iterations [out] The number of interations a particular frame took to execute
@@ -235,6 +254,10 @@ public:
   virtual Status_Flag computeUpdateFast(Teuchos::RCP<Local_Shape_Function> shape_function,
     int_t & num_iterations);
 
+  /// See base class documentation
+  virtual Status_Flag computeUpdateInverseCompositional(Teuchos::RCP<Local_Shape_Function> shape_function,
+    int_t & num_iterations);
+
   /// See base class documentation
   using Objective::computeUpdateRobust;
 
@@ -133,6 +133,16 @@ const std::string to_string(Interpolation_Method in){
   return interpolationMethodStrings[in];
 }
 DICE_LIB_DLL_EXPORT
+const std::string to_string(Subset_Execution_Order in){
+  assert(in < MAX_SUBSET_EXECUTION_ORDER);
+  return subsetExecutionOrderStrings[in];
+}
+DICE_LIB_DLL_EXPORT
+const std::string to_string(Decomposition_Method in){
+  assert(in < MAX_DECOMPOSITION_METHOD);
+  return decompositionMethodStrings[in];
+}
+DICE_LIB_DLL_EXPORT
 const std::string to_string(Gradient_Method in){
   assert(in < MAX_GRADIENT_METHOD);
   return gradientMethodStrings[in];
@@ -256,6 +266,28 @@ Interpolation_Method string_to_interpolation_method(std::string & in){
   TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"");
   return NO_SUCH_INTERPOLATION_METHOD; // prevent no return errors
 }
+DICE_LIB_DLL_EXPORT
+Subset_Execution_Order string_to_subset_execution_order(std::string & in){
+  // convert the string to uppercase
+  stringToUpper(in);
+  for(int_t i=0;i<MAX_SUBSET_EXECUTION_ORDER;++i){
+    if(subsetExecutionOrderStrings[i]==in) return static_cast<Subset_Execution_Order>(i);
+  }
+  std::cout << "Error: Subset_Execution_Order " << in << " does not exist." << std::endl;
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"");
+  return NO_SUCH_SUBSET_EXECUTION_ORDER; // prevent no return errors
+}
+DICE_LIB_DLL_EXPORT
+Decomposition_Method string_to_decomposition_method(std::string & in){
+  // convert the string to uppercase
+  stringToUpper(in);
+  for(int_t i=0;i<MAX_DECOMPOSITION_METHOD;++i){
+    if(decompositionMethodStrings[i]==in) return static_cast<Decomposition_Method>(i);
+  }
+  std::cout << "Error: Decomposition_Method " << in << " does not exist." << std::endl;
+  TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"");
+  return NO_SUCH_DECOMPOSITION_METHOD; // prevent no return errors
+}
 
 DICE_LIB_DLL_EXPORT
 Gradient_Method string_to_gradient_method(std::string & in){
@@ -351,6 +383,9 @@ DICE_LIB_DLL_EXPORT void tracking_default_params(Teuchos::ParameterList *  defau
   defaultParams->set(DICe::num_image_integration_points,20);
   defaultParams->set(DICe::write_exodus_output,true);
   defaultParams->set(DICe::threshold_block_size,-1);
+  defaultParams->set(DICe::num_threads,1);
+  defaultParams->set(DICe::write_binary_output,false);
+  defaultParams->set(DICe::compress_binary_output,false);
 }
 
 DICE_LIB_DLL_EXPORT void dice_default_params(Teuchos::ParameterList *  defaultParams){
@@ -410,6 +445,9 @@ DICE_LIB_DLL_EXPORT void dice_default_params(Teuchos::ParameterList *  defaultPa
   defaultParams->set(DICe::num_image_integration_points,20);
   defaultParams->set(DICe::write_exodus_output,true);
   defaultParams->set(DICe::threshold_block_size,-1);
+  defaultParams->set(DICe::num_threads,1);
+  defaultParams->set(DICe::write_binary_output,false);
+  defaultParams->set(DICe::compress_binary_output,false);
 }
 
 }// End DICe Namespace
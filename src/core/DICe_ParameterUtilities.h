@@ -83,6 +83,14 @@ const std::string to_string(Initialization_Method in);
 DICE_LIB_DLL_EXPORT
 const std::string to_string(Optimization_Method in);
 
+/// Convert a DICe::Subset_Execution_Order to string
+DICE_LIB_DLL_EXPORT
+const std::string to_string(Subset_Execution_Order in);
+
+/// Convert a DICe::Decomposition_Method to string
+DICE_LIB_DLL_EXPORT
+const std::string to_string(Decomposition_Method in);
+
 /// Convert a DICe::Shape_Function_Type to string
 DICE_LIB_DLL_EXPORT
 const std::string to_string(Shape_Function_Type in);
@@ -127,6 +135,14 @@ Initialization_Method string_to_initialization_method(std::string & in);
 DICE_LIB_DLL_EXPORT
 Interpolation_Method string_to_interpolation_method(std::string & in);
 
+/// Convert a string to a DICe::Subset_Execution_Order
+DICE_LIB_DLL_EXPORT
+Subset_Execution_Order string_to_subset_execution_order(std::string & in);
+
+/// Convert a string to a DICe::Decomposition_Method
+DICE_LIB_DLL_EXPORT
+Decomposition_Method string_to_decomposition_method(std::string & in);
+
 /// Convert a string to a DICe::Interpolation_Method
 DICE_LIB_DLL_EXPORT
 Gradient_Method string_to_gradient_method(std::string & in);
@@ -383,6 +383,14 @@ Teuchos::RCP<Teuchos::ParameterList> read_correlation_params(const std::string &
         diceParams->set(DICe::interpolation_method,DICe::string_to_interpolation_method(
           stringParams->get<std::string>(it->first)));
       }
+      else if(paramName == DICe::subset_execution_order){
+        diceParams->set(DICe::subset_execution_order,DICe::string_to_subset_execution_order(
+          stringParams->get<std::string>(it->first)));
+      }
+      else if(paramName == DICe::decomposition_method){
+        diceParams->set(DICe::decomposition_method,DICe::string_to_decomposition_method(
+          stringParams->get<std::string>(it->first)));
+      }
       else if(paramName == DICe::shape_function_type){
         diceParams->set(DICe::shape_function_type,DICe::string_to_shape_function_type(
           stringParams->get<std::string>(it->first)));
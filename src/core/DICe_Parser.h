@@ -110,6 +110,12 @@ const char* const print_stats = "print_stats";
 const char* const output_stereo_files = "output_stereo_files";
 /// Input parameter
 const char* const no_text_output_files = "no_text_output_files";
+/// Input parameter, number of frames to read ahead on a background thread while the current frame is correlated (0 turns prefetching off,
+/// not valid with motion windows)
+const char* const prefetch_images = "prefetch_images";
+/// Input parameter, name of the per-phase performance report written to the output folder (.csv for comma separated records, otherwise JSON),
+/// the phases are only timed if this parameter is set
+const char* const performance_report_file = "performance_report_file";
 /// Input parameter
 const char* const correlation_parameters_file = "correlation_parameters_file";
 /// Input parameter
@@ -70,6 +70,8 @@ Post_Processor::initialize(Teuchos::RCP<DICe::mesh::Mesh> & mesh){
   assert(overlap_num_points_>0);
   for(size_t i=0;i<field_specs_.size();++i)
     mesh_->create_field(field_specs_[i]);
+  // the neighborhoods have to be rebuilt if a new mesh is given (i.e. the subsets were rebalanced)
+  neighborhood_initialized_ = false;
 }
 
 void
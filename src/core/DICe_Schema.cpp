@@ -46,6 +46,8 @@
 #include <DICe_ParameterUtilities.h>
 #include <DICe_ImageUtils.h>
 #include <DICe_ImageIO.h>
+#include <DICe_Profiler.h>
+#include <DICe_BufferPool.h>
 #include <DICe_FFT.h>
 #include <DICe_Triangulation.h>
 #include <DICe_Simplex.h>
@@ -70,6 +72,15 @@
 
 #include <cassert>
 #include <set>
+#include <queue>
+#include <functional>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+#if DICE_MPI
+  #include <mpi.h>
+#endif
 
 namespace DICe {
 
@@ -157,21 +168,96 @@ Schema::rotate_def_image(){
   }
 }
 
-void
-Schema::set_def_image(const std::string & defName){
-  DEBUG_MSG("Schema: Resetting the deformed image");
-  assert(def_imgs_.size()>0);
+Teuchos::RCP<Teuchos::ParameterList>
+Schema::def_image_params()const{
   Teuchos::RCP<Teuchos::ParameterList> imgParams = Teuchos::rcp(new Teuchos::ParameterList());
   imgParams->set(DICe::compute_image_gradients,compute_def_gradients_);
   imgParams->set(DICe::gauss_filter_images,gauss_filter_images_);
   imgParams->set(DICe::gauss_filter_mask_size,gauss_filter_mask_size_);
   imgParams->set(DICe::gradient_method,gradient_method_);
   imgParams->set(DICe::filter_failed_cine_pixels,filter_failed_cine_pixels_);
+  imgParams->set(DICe::compact_image_storage,compact_image_storage_);
+  imgParams->set(DICe::tiled_image_layout,tiled_image_layout_);
+  imgParams->set(DICe::num_threads,num_threads_);
+  // the B-spline coefficients are computed when the image is read (for prefetched images this is off the main thread)
+  imgParams->set(DICe::interpolation_method,interpolation_method_);
   if(init_params_!=Teuchos::null){
     if(init_params_->isSublist(undistort_images)){
       imgParams->set(undistort_images,init_params_->sublist(undistort_images));
     }
   }
+  return imgParams;
+}
+
+void
+Schema::image_window(const std::vector<int_t> & extents,
+  const int_t full_width,
+  const int_t full_height,
+  const int_t margin,
+  int_t & offset_x,
+  int_t & offset_y,
+  int_t & width,
+  int_t & height)const{
+  TEUCHOS_TEST_FOR_EXCEPTION(extents.size()!=4,std::runtime_error,"");
+  // pad the extents so that the pixels used by the subsets are not affected by the edge of the window
+  // (the filter is not applied near the edges and the gradients are one sided there)
+  const int_t pad = margin + std::max(subset_dim_,0)/2 + (gauss_filter_images_ ? gauss_filter_mask_size_/2 + 1 : 0) + 4;
+  const int_t buffer = 100; // if the extents are within 100 pixels of the image boundary use the whole image
+  const int_t start_x = extents[0] - pad;
+  const int_t start_y = extents[2] - pad;
+  const int_t stop_x = extents[1] + pad;
+  const int_t stop_y = extents[3] + pad;
+  offset_x = start_x > buffer && start_x < full_width - buffer ? start_x : 0;
+  offset_y = start_y > buffer && start_y < full_height - buffer ? start_y : 0;
+  const int_t end_x = stop_x > buffer && stop_x < full_width - buffer ? stop_x : full_width;
+  const int_t end_y = stop_y > buffer && stop_y < full_height - buffer ? stop_y : full_height;
+  width = end_x - offset_x;
+  height = end_y - offset_y;
+}
+
+bool
+Schema::def_image_window(const std::string & file_name,
+  const int_t margin,
+  int_t & offset_x,
+  int_t & offset_y,
+  int_t & width,
+  int_t & height)const{
+  if(!has_extents_||motion_window_params_->size()>0||def_image_rotation_!=ZERO_DEGREES)
+    return false;
+  int_t w = 0, h = 0;
+  utils::read_image_dimensions(file_name.c_str(),w,h);
+  image_window(def_extents_,w,h,margin,offset_x,offset_y,width,height);
+  return true;
+}
+
+void
+Schema::set_prefetched_def_image(Teuchos::RCP<Image> img,
+  const std::string & defName){
+  TEUCHOS_TEST_FOR_EXCEPTION(img==Teuchos::null,std::runtime_error,"");
+  // only the first deformed image is replaced, the motion window sub-images would keep the previous frame
+  TEUCHOS_TEST_FOR_EXCEPTION(motion_window_params_->size()>0,std::runtime_error,
+    "Error, prefetched images cannot be used with motion windows");
+  int_t offset_x = 0, offset_y = 0, width = 0, height = 0;
+  if(def_image_window(defName,0,offset_x,offset_y,width,height)){
+    if(img->offset_x()>offset_x||img->offset_y()>offset_y||
+        img->offset_x()+img->width()<offset_x+width||img->offset_y()+img->height()<offset_y+height){
+      DEBUG_MSG("Schema::set_prefetched_def_image(): the extents moved outside the prefetched window, reading " << defName << " again");
+      set_def_image(defName);
+      return;
+    }
+  }
+  set_def_image(img);
+  def_imgs_[0]->set_file_name(defName);
+}
+
+void
+Schema::set_def_image(const std::string & defName){
+  DEBUG_MSG("Schema: Resetting the deformed image");
+  assert(def_imgs_.size()>0);
+  Teuchos::RCP<Teuchos::ParameterList> imgParams = def_image_params();
+  // the shared images are not modified in place, so the gradients needed when the image becomes the reference are computed up front
+  if(node_image_reader_!=Teuchos::null&&use_incremental_formulation_&&compute_ref_gradients_)
+    imgParams->set(DICe::compute_image_gradients,true);
   const bool has_motion_window = motion_window_params_->size()>0;
   // query the image dimensions:
   for(size_t id=0;id<def_imgs_.size();++id){
@@ -197,18 +283,23 @@ Schema::set_def_image(const std::string & defName){
           TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,
             "No motion window found for this sub image id, if motion windows are used, one must be set for each subset");
         }
+        sub_width = end_x - offset_x;
+        sub_height = end_y - offset_y;
       }else{
-        const int_t buffer = 100; // if the extents are within 100 pixels of the image boundary use the whole image
-        offset_x = def_extents_[0] > buffer && def_extents_[0] < w - buffer ? def_extents_[0] : 0;
-        offset_y = def_extents_[2] > buffer && def_extents_[2] < h - buffer ? def_extents_[2] : 0;
-        end_x = def_extents_[1] > buffer && def_extents_[1] < w - buffer ? def_extents_[1] : w;
-        end_y = def_extents_[3] > buffer && def_extents_[3] < h - buffer ? def_extents_[3] : h;
+        image_window(def_extents_,w,h,0,offset_x,offset_y,sub_width,sub_height);
+        end_x = offset_x + sub_width;
+        end_y = offset_y + sub_height;
       }
-      sub_width = end_x - offset_x;
-      sub_height = end_y - offset_y;
       DEBUG_MSG("Setting the deformed image using extents x: " << offset_x << " to " << end_x <<
         " y: " << offset_y << " to " << end_y << " width " << sub_width << " height " << sub_height);
-      def_imgs_[id] = Teuchos::rcp( new Image(defName.c_str(),offset_x,offset_y,sub_width,sub_height,imgParams));
+      if(node_image_reader_!=Teuchos::null&&!has_motion_window)
+        def_imgs_[id] = node_image_reader_->read(defName,offset_x,offset_y,sub_width,sub_height,imgParams);
+      else
+        def_imgs_[id] = Teuchos::rcp( new Image(defName.c_str(),offset_x,offset_y,sub_width,sub_height,imgParams));
+    }else if(node_image_reader_!=Teuchos::null){
+      int_t w = 0, h = 0;
+      utils::read_image_dimensions(defName.c_str(),w,h);
+      def_imgs_[id] = node_image_reader_->read(defName,0,0,w,h,imgParams);
     }else{
       // see if the image has already been allocated:
       if(def_imgs_[id]==Teuchos::null)
@@ -230,16 +321,21 @@ Schema::set_def_image(Teuchos::RCP<Image> img,
   assert(def_imgs_.size()>0);
   assert(id<(int_t)def_imgs_.size());
   def_imgs_[id] = img;
-  if(gauss_filter_images_&&!def_imgs_[id]->has_gauss_filter()){ // the filter may have alread been applied to the image
-      def_imgs_[id]->gauss_filter(gauss_filter_mask_size_);
-  }
-  if(compute_def_gradients_&&!def_imgs_[id]->has_gradients()){
-    def_imgs_[id]->compute_gradients();
-  }
+  def_imgs_[id]->set_num_threads(num_threads_);
+  // the filter and gradients may have already been applied to the image
+  def_imgs_[id]->filter_and_compute_gradients(gauss_filter_images_&&!def_imgs_[id]->has_gauss_filter(),
+    compute_def_gradients_&&!def_imgs_[id]->has_gradients(),gauss_filter_mask_size_);
+  if(interpolation_method_==BSPLINE_CUBIC&&!def_imgs_[id]->has_bspline_coefficients())
+    def_imgs_[id]->compute_bspline_coefficients();
+  if(tiled_image_layout_&&!compact_image_storage_&&!def_imgs_[id]->has_tiled_layout())
+    def_imgs_[id]->compute_tiled_layout();
+  if(compact_image_storage_)
+    def_imgs_[id]->compact();
   if(def_image_rotation_!=ZERO_DEGREES){
     Teuchos::RCP<Teuchos::ParameterList> imgParams = Teuchos::rcp(new Teuchos::ParameterList());
     imgParams->set(DICe::compute_image_gradients,true); // automatically compute the gradients if the ref image is changed
     imgParams->set(DICe::gradient_method,gradient_method_);
+    imgParams->set(DICe::num_threads,num_threads_);
     def_imgs_[id] = def_imgs_[id]->apply_rotation(def_image_rotation_,imgParams);
   }
 }
@@ -260,6 +356,7 @@ Schema::set_def_image(const int_t img_width,
   imgParams->set(DICe::gauss_filter_mask_size,gauss_filter_mask_size_);
   imgParams->set(DICe::gradient_method,gradient_method_);
   imgParams->set(DICe::filter_failed_cine_pixels,filter_failed_cine_pixels_);
+  imgParams->set(DICe::num_threads,num_threads_);
   def_imgs_[id] = Teuchos::rcp( new Image(img_width,img_height,defRCP,imgParams));
   if(def_image_rotation_!=ZERO_DEGREES){
     def_imgs_[id] = def_imgs_[id]->apply_rotation(def_image_rotation_);
@@ -285,6 +382,8 @@ Schema::set_ref_image(const std::string & refName){
   imgParams->set(DICe::gradient_method,gradient_method_);
   imgParams->set(DICe::compute_laplacian_image,compute_laplacian_image_);
   imgParams->set(DICe::filter_failed_cine_pixels,filter_failed_cine_pixels_);
+  imgParams->set(DICe::compact_image_storage,compact_image_storage_);
+  imgParams->set(DICe::num_threads,num_threads_);
   if(init_params_!=Teuchos::null){
     if(init_params_->isSublist(undistort_images)){
       imgParams->set(undistort_images,init_params_->sublist(undistort_images));
@@ -292,15 +391,17 @@ Schema::set_ref_image(const std::string & refName){
   }
   if(has_extents_){
     utils::read_image_dimensions(refName.c_str(),full_ref_img_width_,full_ref_img_height_);
-    const int_t buffer = 100; // if the extents are within 100 pixels of the image boundary use the whole image
-    const int_t offset_x = ref_extents_[0] > buffer && ref_extents_[0] < full_ref_img_width_ - buffer ? ref_extents_[0] : 0;
-    const int_t offset_y = ref_extents_[2] > buffer && ref_extents_[2] < full_ref_img_height_ - buffer ? ref_extents_[2] : 0;
-    const int_t end_x = ref_extents_[1] > buffer && ref_extents_[1] < full_ref_img_width_ - buffer ? ref_extents_[1] : full_ref_img_width_;
-    const int_t end_y = ref_extents_[3] > buffer && ref_extents_[3] < full_ref_img_height_ - buffer ? ref_extents_[3] : full_ref_img_height_;
-    const int_t width = end_x - offset_x;
-    const int_t height = end_y - offset_y;
-    DEBUG_MSG("Setting the reference image using extents x: " << offset_x << " to " << end_x << " y: " << offset_y << " to " << end_y);
-    ref_img_ = Teuchos::rcp( new Image(refName.c_str(),offset_x,offset_y,width,height,imgParams));
+    int_t offset_x = 0, offset_y = 0, width = 0, height = 0;
+    image_window(ref_extents_,full_ref_img_width_,full_ref_img_height_,0,offset_x,offset_y,width,height);
+    DEBUG_MSG("Setting the reference image using extents x: " << offset_x << " to " << offset_x + width << " y: " << offset_y << " to " << offset_y + height);
+    if(node_image_reader_!=Teuchos::null)
+      ref_img_ = node_image_reader_->read(refName,offset_x,offset_y,width,height,imgParams);
+    else
+      ref_img_ = Teuchos::rcp( new Image(refName.c_str(),offset_x,offset_y,width,height,imgParams));
+  }
+  else if(node_image_reader_!=Teuchos::null){
+    utils::read_image_dimensions(refName.c_str(),full_ref_img_width_,full_ref_img_height_);
+    ref_img_ = node_image_reader_->read(refName,0,0,full_ref_img_width_,full_ref_img_height_,imgParams);
   }
   else
     ref_img_ = Teuchos::rcp( new Image(refName.c_str(),imgParams));
@@ -308,7 +409,13 @@ Schema::set_ref_image(const std::string & refName){
     ref_img_ = ref_img_->apply_rotation(ref_image_rotation_,imgParams);
   }
   if(prev_imgs_[0]==Teuchos::null){
-    prev_imgs_[0] = Teuchos::rcp( new Image(refName.c_str(),imgParams));
+    if(node_image_reader_!=Teuchos::null){
+      int_t w = 0, h = 0;
+      utils::read_image_dimensions(refName.c_str(),w,h);
+      prev_imgs_[0] = node_image_reader_->read(refName,0,0,w,h,imgParams);
+    }
+    else
+      prev_imgs_[0] = Teuchos::rcp( new Image(refName.c_str(),imgParams));
     if(ref_image_rotation_!=ZERO_DEGREES){
       prev_imgs_[0] = prev_imgs_[0]->apply_rotation(ref_image_rotation_,imgParams);
     }
@@ -328,6 +435,7 @@ Schema::set_ref_image(const int_t img_width,
   imgParams->set(DICe::gauss_filter_mask_size,gauss_filter_mask_size_);
   imgParams->set(DICe::gradient_method,gradient_method_);
   imgParams->set(DICe::filter_failed_cine_pixels,filter_failed_cine_pixels_);
+  imgParams->set(DICe::num_threads,num_threads_);
   ref_img_ = Teuchos::rcp( new Image(img_width,img_height,refRCP,imgParams));
   if(ref_image_rotation_!=ZERO_DEGREES){
     ref_img_ = ref_img_->apply_rotation(ref_image_rotation_,imgParams);
@@ -345,17 +453,17 @@ void
 Schema::set_ref_image(Teuchos::RCP<Image> img){
   DEBUG_MSG("Schema::set_ref_image() Resetting the reference image");
   ref_img_ = img;
-  if(gauss_filter_images_){
-    if(!ref_img_->has_gauss_filter()) // the filter may have alread been applied to the image
-      ref_img_->gauss_filter(gauss_filter_mask_size_);
-  }
-  if(compute_ref_gradients_&&!ref_img_->has_gradients()){
-    ref_img_->compute_gradients();
-  }
+  ref_img_->set_num_threads(num_threads_);
+  // the filter and gradients may have already been applied to the image
+  ref_img_->filter_and_compute_gradients(gauss_filter_images_&&!ref_img_->has_gauss_filter(),
+    compute_ref_gradients_&&!ref_img_->has_gradients(),gauss_filter_mask_size_);
+  if(compact_image_storage_)
+    ref_img_->compact();
   if(ref_image_rotation_!=ZERO_DEGREES){
     Teuchos::RCP<Teuchos::ParameterList> imgParams = Teuchos::rcp(new Teuchos::ParameterList());
     imgParams->set(DICe::compute_image_gradients,true); // automatically compute the gradients if the ref image is changed
     imgParams->set(DICe::gradient_method,gradient_method_);
+    imgParams->set(DICe::num_threads,num_threads_);
     ref_img_ = ref_img_->apply_rotation(ref_image_rotation_,imgParams);
   }
   if(prev_imgs_[0]==Teuchos::null){
@@ -380,6 +488,10 @@ Schema::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & p
   normalize_gamma_with_active_pixels_ = false;
   gauss_filter_images_ = false;
   gauss_filter_mask_size_ = 7;
+  compact_image_storage_ = false;
+  tiled_image_layout_ = false;
+  subset_execution_order_ = INPUT_ORDER;
+  interpolation_method_ = KEYS_FOURTH;
   init_params_ = params==Teuchos::null ? Teuchos::rcp(new Teuchos::ParameterList()):
     Teuchos::rcp(new Teuchos::ParameterList(*params));
   comm_ = Teuchos::rcp(new MultiField_Comm());
@@ -395,6 +507,11 @@ Schema::default_constructor_tasks(const Teuchos::RCP<Teuchos::ParameterList> & p
   use_nonlinear_projection_ = false;
   sort_txt_output_ = false;
   threshold_block_size_ = -1;
+  num_threads_ = 1;
+  write_binary_output_ = false;
+  compress_binary_output_ = false;
+  rebalance_interval_ = 0;
+  frame_parallel_ = false;
   set_params(params);
   prev_imgs_.push_back(Teuchos::null);
   def_imgs_.push_back(Teuchos::null);
@@ -543,6 +660,17 @@ Schema::set_params(const Teuchos::RCP<Teuchos::ParameterList> & params){
   compute_ref_gradients_ = diceParams->get<bool>(DICe::compute_ref_gradients,true);
   compute_def_gradients_ = diceParams->get<bool>(DICe::compute_def_gradients,false);
   compute_laplacian_image_ = diceParams->get<bool>(DICe::compute_laplacian_image,false);
+  compact_image_storage_ = diceParams->get<bool>(DICe::compact_image_storage,false);
+  tiled_image_layout_ = diceParams->get<bool>(DICe::tiled_image_layout,false);
+  subset_execution_order_ = diceParams->get<Subset_Execution_Order>(DICe::subset_execution_order,INPUT_ORDER);
+  // the buffer pool is shared by all schemas so this is only ever turned on
+  if(diceParams->get<bool>(DICe::use_huge_pages,false))
+    buffer_pool::use_huge_pages(true);
+  if(diceParams->isParameter(DICe::buffer_pool_megabytes)){
+    const int_t pool_megabytes = diceParams->get<int_t>(DICe::buffer_pool_megabytes);
+    TEUCHOS_TEST_FOR_EXCEPTION(pool_megabytes<0,std::invalid_argument,"Error, buffer_pool_megabytes cannot be negative");
+    buffer_pool::set_max_cached_bytes((size_t)pool_megabytes<<20);
+  }
   if(diceParams->get<bool>(DICe::compute_image_gradients,false)) { // this flag turns them both on
     compute_ref_gradients_ = true;
     compute_def_gradients_ = true;
@@ -623,6 +751,73 @@ Schema::set_params(const Teuchos::RCP<Teuchos::ParameterList> & params){
   TEUCHOS_TEST_FOR_EXCEPTION(!diceParams->isParameter(DICe::write_exodus_output),std::runtime_error,"");
   write_exodus_output_ = diceParams->get<bool>(DICe::write_exodus_output);
   threshold_block_size_ = diceParams->get<int>(DICe::threshold_block_size,-1);
+  num_threads_ = diceParams->get<int>(DICe::num_threads,1);
+  TEUCHOS_TEST_FOR_EXCEPTION(num_threads_<0,std::invalid_argument,"Error, num_threads cannot be negative");
+  const bool auto_num_threads = num_threads_==0;
+  if(auto_num_threads){
+    // hybrid mode, the cores of the node are split evenly between the processes on the node
+#ifdef _OPENMP
+    num_threads_ = std::max(1,omp_get_num_procs()/num_processes_on_node());
+#else
+    num_threads_ = 1;
+#endif
+    DEBUG_MSG("[PROC " << proc_rank << "] Schema::set_params(): using " << num_threads_ << " thread(s) per process");
+  }
+#ifndef _OPENMP
+  if(num_threads_>1){
+    if(proc_rank == 0) std::cout << "Warning, num_threads > 1 was requested, but DICe was not compiled with OpenMP, using one thread per process" << std::endl;
+    num_threads_ = 1;
+  }
+#elif !defined(HAVE_TEUCHOS_THREAD_SAFE)
+  // the reference counts of the Teuchos::RCPs shared between subsets (images, fields) are not atomic
+  if(num_threads_>1){
+    if(proc_rank == 0) std::cout << "Warning, num_threads > 1 was requested, but Trilinos was not built with Teuchos_ENABLE_THREAD_SAFE, using one thread per process" << std::endl;
+    num_threads_ = 1;
+  }
+#endif
+  write_binary_output_ = diceParams->get<bool>(DICe::write_binary_output,false);
+  compress_binary_output_ = diceParams->get<bool>(DICe::compress_binary_output,false);
+  rebalance_interval_ = diceParams->get<int>(DICe::rebalance_interval,0);
+  TEUCHOS_TEST_FOR_EXCEPTION(rebalance_interval_<0,std::invalid_argument,"Error, rebalance_interval cannot be negative");
+  if(rebalance_interval_>0&&analysis_type_==LOCAL_DIC){
+    TEUCHOS_TEST_FOR_EXCEPTION(correlation_routine_!=GENERIC_ROUTINE,std::invalid_argument,
+      "Error, rebalance_interval is only available for the GENERIC_ROUTINE");
+    TEUCHOS_TEST_FOR_EXCEPTION(initialization_method_==USE_NEIGHBOR_VALUES||initialization_method_==USE_NEIGHBOR_VALUES_FIRST_STEP_ONLY,
+      std::invalid_argument,"Error, rebalance_interval cannot be used with neighbor value initialization (a subset and its neighbor "
+      "have to stay on the same process)");
+    TEUCHOS_TEST_FOR_EXCEPTION(use_incremental_formulation_,std::invalid_argument,
+      "Error, rebalance_interval cannot be used with the incremental formulation");
+    TEUCHOS_TEST_FOR_EXCEPTION(write_binary_output_||write_exodus_output_,std::invalid_argument,
+      "Error, rebalance_interval cannot be used with binary or exodus output (the files are written per process)");
+  }
+  frame_parallel_ = diceParams->get<bool>(DICe::frame_parallel,false);
+  if(frame_parallel_){
+    // each frame has to be correlated without the solution from the previous frame since it may be on another process
+    TEUCHOS_TEST_FOR_EXCEPTION(analysis_type_!=LOCAL_DIC||correlation_routine_!=GENERIC_ROUTINE,std::invalid_argument,
+      "Error, frame_parallel is only available for local DIC with the GENERIC_ROUTINE");
+    TEUCHOS_TEST_FOR_EXCEPTION(use_incremental_formulation_,std::invalid_argument,
+      "Error, frame_parallel cannot be used with the incremental formulation");
+    TEUCHOS_TEST_FOR_EXCEPTION(initialization_method_!=USE_ZEROS&&initialization_method_!=USE_FFT_CROSS_CORRELATION
+      &&initialization_method_!=USE_IMAGE_PYRAMID,std::invalid_argument,
+      "Error, frame_parallel requires an initialization method that does not use the previous frame "
+      "(USE_ZEROS, USE_FFT_CROSS_CORRELATION or USE_IMAGE_PYRAMID)");
+    TEUCHOS_TEST_FOR_EXCEPTION(use_subset_evolution_,std::invalid_argument,
+      "Error, frame_parallel cannot be used with subset evolution");
+    TEUCHOS_TEST_FOR_EXCEPTION(write_binary_output_||write_exodus_output_,std::invalid_argument,
+      "Error, frame_parallel cannot be used with binary or exodus output (all frames go to one file)");
+    TEUCHOS_TEST_FOR_EXCEPTION(rebalance_interval_>0,std::invalid_argument,
+      "Error, frame_parallel cannot be used with rebalance_interval (each process owns all the subsets)");
+  }
+  if(diceParams->get<bool>(DICe::share_images_on_node,false)){
+    TEUCHOS_TEST_FOR_EXCEPTION(frame_parallel_,std::invalid_argument,
+      "Error, share_images_on_node cannot be used with frame_parallel (the processes read different frames)");
+    TEUCHOS_TEST_FOR_EXCEPTION(compact_image_storage_,std::invalid_argument,
+      "Error, share_images_on_node cannot be used with compact_image_storage (the shared arrays are full precision)");
+    if(node_image_reader_==Teuchos::null)
+      node_image_reader_ = Teuchos::rcp(new Node_Image_Reader());
+  }
+  else
+    node_image_reader_ = Teuchos::null;
   TEUCHOS_TEST_FOR_EXCEPTION(!diceParams->isParameter(DICe::use_search_initialization_for_failed_steps),std::runtime_error,"");
   use_search_initialization_for_failed_steps_ = diceParams->get<bool>(DICe::use_search_initialization_for_failed_steps);
   TEUCHOS_TEST_FOR_EXCEPTION(!diceParams->isParameter(DICe::normalize_gamma_with_active_pixels),std::runtime_error,"");
@@ -776,8 +971,11 @@ Schema::update_extents(const bool use_transformation_augmentation){
     Teuchos::RCP<MultiField> disp_y = mesh_->get_field(SUBSET_DISPLACEMENT_Y_FS);
     disp = Teuchos::rcp( new MultiField(map,1,true));
     for(int_t i=0;i<local_num_subsets_;++i){
-      disp->local_value(i*spa_dim+0) = disp_x->local_value(i);
-      disp->local_value(i*spa_dim+1) = disp_y->local_value(i);
+      // distributed frames start from the reference configuration (see execute_correlation())
+      if(!frame_parallel_){
+        disp->local_value(i*spa_dim+0) = disp_x->local_value(i);
+        disp->local_value(i*spa_dim+1) = disp_y->local_value(i);
+      }
       if(use_nonlinear_projection_){
         aug->local_value(i*spa_dim+0) = proj_aug_x->local_value(i);
         aug->local_value(i*spa_dim+1) = proj_aug_y->local_value(i);
@@ -1168,6 +1366,8 @@ Schema::initialize(Teuchos::RCP<Decomp> decomp,
       const int_t olid = mesh_->get_scalar_node_overlap_map()->get_local_element(gid);
       local_field_value(i,NEIGHBOR_ID_FS) = (*decomp->neighbor_ids())[olid];
     }
+  // the neighbor ids have to be in place before reordering since they constrain the order
+  apply_subset_execution_order();
 
   DEBUG_MSG("[PROC " << mesh_->get_comm()->get_rank() << "] schema initialized");
 }
@@ -1188,16 +1388,13 @@ Schema::create_mesh(Teuchos::RCP<Decomp> decomp){
   // the overlap map for is dictated by which neighbors are needed to access
   Teuchos::ArrayRCP<int_t> connectivity(num_coords,0);
   Teuchos::ArrayRCP<int_t> elem_map(num_coords,0);
-  // note: this assumes the elements are contiguous in terms of ids and that the overlap ids
-  // are in ascending order
-  int_t overlap_offset = 0;
-  for(int_t i=0;i<node_map.size();++i){
-    if(decomp->id_decomp_map()->get_global_element_list()[0] <= node_map[i]) break;
-    overlap_offset++;
-  }
+  // the owned ids do not have to be contiguous in the overlap list (seeds, obstructions, the Hilbert
+  // decomposition and rebalancing all give each processor a scattered set of ids)
   for(int_t i=0;i<num_coords;++i){
-    connectivity[i] = overlap_offset + i + 1; // + 1 because exodus elem ids are 1-based
     elem_map[i] = decomp->id_decomp_map()->get_global_element_list()[i];
+    const int_t overlap_lid = decomp->id_decomp_overlap_map()->get_local_element(elem_map[i]);
+    TEUCHOS_TEST_FOR_EXCEPTION(overlap_lid<0,std::runtime_error,"Error, owned subset " << elem_map[i] << " is not in the overlap map");
+    connectivity[i] = overlap_lid + 1; // + 1 because exodus elem ids are 1-based
   }
   // filename for output
   std::stringstream exo_name;
@@ -1288,6 +1485,9 @@ Schema::create_mesh_fields(){
     mesh_->create_field(field_enums::ACCUMULATED_DISP_FS);
     mesh_->get_field(field_enums::ACCUMULATED_DISP_FS)->put_scalar(0.0);
   }
+  // the costs start over whenever the mesh is created (including after the subsets are rebalanced)
+  subset_costs_ = Teuchos::rcp(new MultiField(mesh_->get_scalar_node_dist_map(),1,true));
+  subset_fallbacks_ = Teuchos::rcp(new MultiField(mesh_->get_scalar_node_dist_map(),2,true));
 
   // fill the subset coordinates field:
   Teuchos::RCP<MultiField> coords = mesh_->get_field(field_enums::INITIAL_COORDINATES_FS);
@@ -1306,6 +1506,166 @@ Schema::post_execution_tasks(){
   }
 }
 
+bool
+Schema::rebalance_subsets(){
+  if(rebalance_interval_<=0||analysis_type_!=LOCAL_DIC||!is_initialized_) return false;
+  const int_t proc_id = comm_->get_rank();
+  const int_t num_procs = comm_->get_size();
+  if(num_procs==1||global_num_subsets_<num_procs) return false;
+  const int_t num_frames_done = frame_id_ - first_frame_id_;
+  if(num_frames_done<=0||num_frames_done%rebalance_interval_!=0) return false;
+  TEUCHOS_TEST_FOR_EXCEPTION(obstructing_subset_ids_!=Teuchos::null&&obstructing_subset_ids_->size()>0,std::runtime_error,
+    "Error, rebalance_interval cannot be used with obstructions (the blocking subsets have to stay on the same process)");
+  TEUCHOS_TEST_FOR_EXCEPTION(subset_costs_==Teuchos::null,std::runtime_error,"");
+  DEBUG_MSG("[PROC " << proc_id << "] Schema::rebalance_subsets(): checking the load balance after " << num_frames_done << " frames");
+
+  // processor 0 gathers the coordinates and cost of every subset along with its current owner
+  Teuchos::RCP<MultiField_Map> dist_map = mesh_->get_scalar_node_dist_map();
+  Teuchos::Array<int_t> zero_owned_ids;
+  if(proc_id==0){
+    zero_owned_ids = Teuchos::Array<int_t>(global_num_subsets_);
+    for(int_t i=0;i<global_num_subsets_;++i)
+      zero_owned_ids[i] = i;
+  }
+  Teuchos::RCP<MultiField_Map> zero_map = Teuchos::rcp (new MultiField_Map(-1, zero_owned_ids,0,*comm_));
+  // fields are 0: coord_x, 1: coord_y, 2: cost, 3: owner
+  Teuchos::RCP<MultiField> cost_data = Teuchos::rcp(new MultiField(dist_map,4,true));
+  Teuchos::RCP<MultiField> cost_zero_data = Teuchos::rcp(new MultiField(zero_map,4,true));
+  Teuchos::RCP<MultiField> coords = mesh_->get_field(INITIAL_COORDINATES_FS);
+  for(int_t i=0;i<local_num_subsets_;++i){
+    cost_data->local_value(i,0) = coords->local_value(i*2+0);
+    cost_data->local_value(i,1) = coords->local_value(i*2+1);
+    cost_data->local_value(i,2) = subset_costs_->local_value(i);
+    cost_data->local_value(i,3) = proc_id;
+  }
+  MultiField_Exporter cost_exporter(*zero_map,*dist_map);
+  cost_zero_data->do_import(cost_data,cost_exporter,INSERT);
+
+  // processor 0 splits a Hilbert curve through the subsets into stretches of equal cost so each
+  // process keeps a compact region of the image, then decides if the move is worth it
+  Teuchos::RCP<MultiField> owner_zero_data = Teuchos::rcp(new MultiField(zero_map,1,true));
+  Teuchos::Array<int_t> flag_zero_ids;
+  if(proc_id==0){
+    for(int_t i=0;i<num_procs;++i)
+      flag_zero_ids.push_back(i);
+  }
+  Teuchos::Array<int_t> flag_owned_ids(1,proc_id);
+  Teuchos::RCP<MultiField_Map> flag_zero_map = Teuchos::rcp (new MultiField_Map(-1, flag_zero_ids,0,*comm_));
+  Teuchos::RCP<MultiField_Map> flag_map = Teuchos::rcp (new MultiField_Map(-1, flag_owned_ids,0,*comm_));
+  Teuchos::RCP<MultiField> flag_zero_data = Teuchos::rcp(new MultiField(flag_zero_map,1,true));
+  Teuchos::RCP<MultiField> flag_data = Teuchos::rcp(new MultiField(flag_map,1,true));
+  if(proc_id==0){
+    std::vector<std::pair<uint64_t,int_t> > curve(global_num_subsets_);
+    std::vector<scalar_t> old_load(num_procs,0.0);
+    scalar_t total_cost = 0.0;
+    for(int_t gid=0;gid<global_num_subsets_;++gid){
+      const scalar_t x = cost_zero_data->local_value(gid,0);
+      const scalar_t y = cost_zero_data->local_value(gid,1);
+      curve[gid] = std::pair<uint64_t,int_t>(hilbert_key(x > 0.0 ? (uint32_t)(x + 0.5) : 0,y > 0.0 ? (uint32_t)(y + 0.5) : 0),gid);
+      old_load[(int_t)cost_zero_data->local_value(gid,3)] += cost_zero_data->local_value(gid,2);
+      total_cost += cost_zero_data->local_value(gid,2);
+    }
+    std::sort(curve.begin(),curve.end());
+    // index along the curve of the first subset for each process, a process starts where the
+    // cost before the middle of a subset reaches its share of the total
+    std::vector<int_t> first(num_procs+1,global_num_subsets_);
+    first[0] = 0;
+    int_t proc = 1;
+    scalar_t prefix_cost = 0.0;
+    for(int_t k=0;k<global_num_subsets_;++k){
+      const scalar_t cost = cost_zero_data->local_value(curve[k].second,2);
+      while(proc<num_procs&&prefix_cost + 0.5*cost >= total_cost*proc/num_procs)
+        first[proc++] = k;
+      prefix_cost += cost;
+    }
+    // every process has to own at least one subset
+    for(proc=1;proc<num_procs;++proc)
+      first[proc] = std::max(first[proc],first[proc-1]+1);
+    for(proc=num_procs-1;proc>=1;--proc)
+      first[proc] = std::min(first[proc],first[proc+1]-1);
+    std::vector<scalar_t> new_load(num_procs,0.0);
+    for(proc=0;proc<num_procs;++proc){
+      for(int_t k=first[proc];k<first[proc+1];++k){
+        owner_zero_data->local_value(curve[k].second) = proc;
+        new_load[proc] += cost_zero_data->local_value(curve[k].second,2);
+      }
+    }
+    const scalar_t old_max = *std::max_element(old_load.begin(),old_load.end());
+    const scalar_t new_max = *std::max_element(new_load.begin(),new_load.end());
+    // moving the subsets means building a new mesh and reading the reference image again, so small imbalances are left alone
+    const scalar_t imbalance_tol = 1.05;
+    const bool rebalance = total_cost > 0.0 && old_max > imbalance_tol*total_cost/num_procs && new_max*imbalance_tol < old_max;
+    DEBUG_MSG("Schema::rebalance_subsets(): largest load " << old_max << " balanced load " << new_max << " average " << total_cost/num_procs <<
+      (rebalance ? ", moving the subsets" : ", keeping the current owners"));
+    for(proc=0;proc<num_procs;++proc)
+      flag_zero_data->local_value(proc) = rebalance ? 1.0 : 0.0;
+  }
+  MultiField_Exporter flag_exporter(*flag_map,*flag_zero_map);
+  flag_data->do_import(flag_zero_data,flag_exporter,INSERT);
+  if(flag_data->local_value(0) <= 0.0) return false;
+
+  // each process finds out the new owner of its subsets
+  Teuchos::RCP<MultiField> owner_data = Teuchos::rcp(new MultiField(dist_map,1,true));
+  MultiField_Exporter owner_exporter(*dist_map,*zero_map);
+  owner_data->do_import(owner_zero_data,owner_exporter,INSERT);
+  // fields are 0: x, 1: y, 2: gid, 3: neighbor id (see Decomp)
+  Teuchos::RCP<MultiField> decomp_data = Teuchos::rcp(new MultiField(dist_map,4,true));
+  std::vector<int_t> dest_procs(local_num_subsets_,proc_id);
+  for(int_t i=0;i<local_num_subsets_;++i){
+    decomp_data->local_value(i,0) = coords->local_value(i*2+0);
+    decomp_data->local_value(i,1) = coords->local_value(i*2+1);
+    decomp_data->local_value(i,2) = subset_global_id(i);
+    decomp_data->local_value(i,3) = local_field_value(i,NEIGHBOR_ID_FS);
+    dest_procs[i] = (int_t)owner_data->local_value(i);
+  }
+  Teuchos::RCP<Decomp> decomp = Teuchos::rcp(new Decomp(decomp_data,dest_procs,init_params_));
+
+  // build the mesh for the new owners and move the field values over by gid
+  Teuchos::RCP<DICe::mesh::Mesh> old_mesh = mesh_;
+  create_mesh(decomp);
+  for(size_t i=0;i<post_processors_.size();++i)
+    post_processors_[i]->initialize(mesh_);
+  DICe::mesh::field_registry * old_fields = old_mesh->get_field_registry();
+  for(DICe::mesh::field_registry::iterator it=old_fields->begin();it!=old_fields->end();++it){
+    mesh_->create_field(it->first);
+    Teuchos::RCP<MultiField> field = mesh_->get_field(it->first);
+    MultiField_Exporter field_exporter(*field->get_map(),*it->second->get_map());
+    field->do_import(it->second,field_exporter,INSERT);
+  }
+  this_proc_gid_order_ = decomp->this_proc_gid_order();
+  apply_subset_execution_order();
+  // anything that refers to the subsets by local id is rebuilt for the new set of subsets
+  obj_vec_.clear();
+  opt_initializers_.clear();
+  guided_initializer_ = Teuchos::null;
+  reliability_guided_neighbors_.clear();
+  reliability_guided_parents_.clear();
+  DEBUG_MSG("[PROC " << proc_id << "] Schema::rebalance_subsets(): now owns " << local_num_subsets_ << " subsets");
+  return true;
+}
+
+void
+Schema::record_subset_costs(){
+  if(subset_costs_==Teuchos::null) return;
+  // rough cost of the fallbacks in terms of solver iterations
+  const scalar_t search_cost = 25.0;
+  const scalar_t backup_opt_cost = 10.0;
+  for(int_t i=0;i<local_num_subsets_;++i){
+    // every subset pays for setting up the objective and the initialization, even if it fails
+    scalar_t cost = 1.0;
+    if(local_field_value(i,ITERATIONS_FS) > 0.0)
+      cost += local_field_value(i,ITERATIONS_FS);
+    // the fallbacks are counted by generic_correlation_routine() for every correlation routine
+    if(subset_fallbacks_!=Teuchos::null){
+      cost += search_cost*subset_fallbacks_->local_value(i,0);
+      cost += backup_opt_cost*subset_fallbacks_->local_value(i,1);
+    }
+    subset_costs_->local_value(i) += cost;
+  }
+  if(subset_fallbacks_!=Teuchos::null)
+    subset_fallbacks_->put_scalar(0.0);
+}
+
 void
 Schema::project_right_image_into_left_frame(Teuchos::RCP<Triangulation> tri,
   const bool reference){
@@ -1362,7 +1722,7 @@ Schema::execute_cross_correlation(){
 
   // change the parameters for cross-correlation
   initialization_method_ = USE_FIELD_VALUES; //USE_FEATURE_MATCHING;
-  if(optimization_method_==GRADIENT_BASED||optimization_method_==GRADIENT_BASED_THEN_SIMPLEX)
+  if(optimization_method_==GRADIENT_BASED||optimization_method_==GRADIENT_BASED_THEN_SIMPLEX||optimization_method_==INVERSE_COMPOSITIONAL)
     optimization_method_=GRADIENT_THEN_SEARCH;
 
   // project the right image onto the left if requested
@@ -1492,6 +1852,18 @@ Schema::execute_correlation(){
     it->second->reset();
   }
 
+  // the spline coefficients are computed up front so the threads below only ever read them
+  if(interpolation_method_==BSPLINE_CUBIC){
+    if(ref_img_!=Teuchos::null&&!ref_img_->has_bspline_coefficients())
+      ref_img_->compute_bspline_coefficients();
+    for(size_t i=0;i<def_imgs_.size();++i)
+      if(def_imgs_[i]!=Teuchos::null&&!def_imgs_[i]->has_bspline_coefficients())
+        def_imgs_[i]->compute_bspline_coefficients();
+    for(size_t i=0;i<prev_imgs_.size();++i)
+      if(prev_imgs_[i]!=Teuchos::null&&!prev_imgs_[i]->has_bspline_coefficients())
+        prev_imgs_[i]->compute_bspline_coefficients();
+  }
+
 #ifdef DICE_DEBUG_MSG
   std::stringstream message;
   message << std::endl;
@@ -1506,6 +1878,13 @@ Schema::execute_correlation(){
     mesh_->get_field(SUBSET_DISPLACEMENT_X_FS)->put_scalar(0.0);
     mesh_->get_field(SUBSET_DISPLACEMENT_Y_FS)->put_scalar(0.0);
   }
+  // if the frames are distributed, every frame starts from the reference configuration so the
+  // results do not depend on which frame this process correlated last
+  if(frame_parallel_){
+    mesh_->get_field(SUBSET_DISPLACEMENT_X_FS)->put_scalar(0.0);
+    mesh_->get_field(SUBSET_DISPLACEMENT_Y_FS)->put_scalar(0.0);
+    mesh_->get_field(ROTATION_Z_FS)->put_scalar(0.0);
+  }
 #ifdef DICE_ENABLE_GLOBAL
   if(has_initial_condition_file()&&frame_id_==first_frame_id_){
     TEUCHOS_TEST_FOR_EXCEPTION(initialization_method_!=USE_FIELD_VALUES,std::runtime_error,
@@ -1539,16 +1918,21 @@ Schema::execute_correlation(){
     TEUCHOS_TEST_FOR_EXCEPTION(motion_window_params_->size()!=0,std::runtime_error,
       "Error, motion windows are intended only for the TRACKING_ROUTINE");
     prepare_optimization_initializers();
-    for(int_t subset_index=0;subset_index<local_num_subsets_;++subset_index){
-      DEBUG_MSG("Schema::execute_correlation(): creating Objective for subset " << this_proc_gid_order_[subset_index]);
-      try{
-        Teuchos::RCP<Objective> obj = Teuchos::rcp(new Objective_ZNSSD(this,this_proc_gid_order_[subset_index]));
-        DEBUG_MSG("Schema::execute_correlation(): Objective creation successful");
-        generic_correlation_routine(obj);
-      }
-      catch(...){
-        DEBUG_MSG("Schema::execute_correlation(): subset " << this_proc_gid_order_[subset_index] << " failed");
-        record_failed_step(this_proc_gid_order_[subset_index],static_cast<int_t>(INITIALIZE_FAILED_BY_EXCEPTION),-1);
+    if(num_threads_>1){
+      threaded_generic_correlation();
+    }
+    else{
+      for(int_t subset_index=0;subset_index<local_num_subsets_;++subset_index){
+        DEBUG_MSG("Schema::execute_correlation(): creating Objective for subset " << this_proc_gid_order_[subset_index]);
+        try{
+          Teuchos::RCP<Objective> obj = Teuchos::rcp(new Objective_ZNSSD(this,this_proc_gid_order_[subset_index]));
+          DEBUG_MSG("Schema::execute_correlation(): Objective creation successful");
+          generic_correlation_routine(obj);
+        }
+        catch(...){
+          DEBUG_MSG("Schema::execute_correlation(): subset " << this_proc_gid_order_[subset_index] << " failed");
+          record_failed_step(this_proc_gid_order_[subset_index],static_cast<int_t>(INITIALIZE_FAILED_BY_EXCEPTION),-1);
+        }
       }
     }
   }
@@ -1587,6 +1971,12 @@ Schema::execute_correlation(){
     for(size_t i=0;i<prev_imgs_.size();++i)
       prev_imgs_[i]=def_imgs_[i];
   }
+  else if(correlation_routine_==RELIABILITY_GUIDED_ROUTINE){
+    TEUCHOS_TEST_FOR_EXCEPTION(motion_window_params_->size()!=0,std::runtime_error,
+      "Error, motion windows are intended only for the TRACKING_ROUTINE");
+    prepare_optimization_initializers();
+    reliability_guided_correlation();
+  }
   else
     TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"ERROR: unknown correlation routine.");
 
@@ -1597,6 +1987,8 @@ Schema::execute_correlation(){
       local_field_value(subset_index,GAMMA_FS) << " beta: " << local_field_value(subset_index,BETA_FS) << " omega: " << local_field_value(subset_index,OMEGA_FS));
   }
 
+  record_subset_costs();
+
   // accumulate the displacements
   if(use_incremental_formulation_){
     const int_t spa_dim = mesh_->spatial_dimension();
@@ -1610,6 +2002,290 @@ Schema::execute_correlation(){
   return 0;
 };
 
+void
+Schema::subset_execution_waves(std::vector<std::vector<int_t> > & waves){
+  waves.clear();
+  const bool use_neighbor_values = initialization_method_==USE_NEIGHBOR_VALUES ||
+      (initialization_method_==USE_NEIGHBOR_VALUES_FIRST_STEP_ONLY && frame_id_==first_frame_id_);
+  if(!use_neighbor_values){
+    // every subset is initialized from its own values so they are all independent
+    waves.push_back(std::vector<int_t>(local_num_subsets_,0));
+    for(int_t i=0;i<local_num_subsets_;++i)
+      waves[0][i] = i;
+    return;
+  }
+  // position of each local subset in the execution order
+  std::vector<int_t> order_pos(local_num_subsets_,-1);
+  for(int_t i=0;i<local_num_subsets_;++i)
+    order_pos[subset_local_id(this_proc_gid_order_[i])] = i;
+  std::vector<int_t> wave_id(local_num_subsets_,0);
+  // lowest wave a subset can be assigned to (set when an earlier subset reads this subset's values from the previous frame)
+  std::vector<int_t> min_wave(local_num_subsets_,0);
+  int_t num_waves = 0;
+  for(int_t i=0;i<local_num_subsets_;++i){
+    const int_t subset_gid = this_proc_gid_order_[i];
+    const int_t neigh_gid = global_field_value(subset_gid,NEIGHBOR_ID_FS);
+    int_t wave = min_wave[i];
+    int_t neigh_pos = -1;
+    if(neigh_gid>=0&&neigh_gid!=subset_gid&&subset_local_id(neigh_gid)>=0)
+      neigh_pos = order_pos[subset_local_id(neigh_gid)];
+    // the neighbor comes first in the order so it has to be solved before this subset
+    if(neigh_pos>=0&&neigh_pos<i)
+      wave = std::max(wave,wave_id[neigh_pos]+1);
+    wave_id[i] = wave;
+    // the neighbor comes later in the order, so this subset uses the neighbor's previous values,
+    // the neighbor can't be solved until this subset has been initialized
+    if(neigh_pos>i)
+      min_wave[neigh_pos] = std::max(min_wave[neigh_pos],wave+1);
+    num_waves = std::max(num_waves,wave+1);
+  }
+  waves.resize(num_waves);
+  for(int_t i=0;i<local_num_subsets_;++i)
+    waves[wave_id[i]].push_back(i);
+}
+
+void
+Schema::apply_subset_execution_order(){
+  if(subset_execution_order_==INPUT_ORDER||local_num_subsets_<=1) return;
+  // the blocking subsets have to come before the subsets they block, leave the order alone
+  if(obstructing_subset_ids_!=Teuchos::null&&obstructing_subset_ids_->size()>0){
+    DEBUG_MSG("[PROC " << comm_->get_rank() << "] Schema::apply_subset_execution_order(): obstructions are defined, keeping the input order");
+    return;
+  }
+  DEBUG_MSG("[PROC " << comm_->get_rank() << "] Schema::apply_subset_execution_order(): sorting " << local_num_subsets_ <<
+    " subsets in " << to_string(subset_execution_order_));
+  const int_t num_subsets = local_num_subsets_;
+  // position of each local subset in the input order and its index along the curve
+  std::vector<int_t> order_pos(num_subsets,-1);
+  std::vector<uint64_t> keys(num_subsets,0);
+  for(int_t i=0;i<num_subsets;++i){
+    const int_t subset_lid = subset_local_id(this_proc_gid_order_[i]);
+    order_pos[subset_lid] = i;
+    const scalar_t x = std::max((scalar_t)0.0,std::min((scalar_t)65535.0,local_field_value(subset_lid,SUBSET_COORDINATES_X_FS)));
+    const scalar_t y = std::max((scalar_t)0.0,std::min((scalar_t)65535.0,local_field_value(subset_lid,SUBSET_COORDINATES_Y_FS)));
+    keys[i] = subset_execution_order_==MORTON_ORDER ? morton_key((uint32_t)x,(uint32_t)y) : hilbert_key((uint32_t)x,(uint32_t)y);
+  }
+  // a subset initialized from a neighbor must stay on the same side of the neighbor, otherwise
+  // it would pick up the neighbor's values from the other frame (same test as subset_execution_waves)
+  std::vector<std::vector<int_t> > successors(num_subsets);
+  std::vector<int_t> num_predecessors(num_subsets,0);
+  for(int_t i=0;i<num_subsets;++i){
+    const int_t subset_gid = this_proc_gid_order_[i];
+    const int_t neigh_gid = global_field_value(subset_gid,NEIGHBOR_ID_FS);
+    if(neigh_gid<0||neigh_gid==subset_gid||subset_local_id(neigh_gid)<0) continue;
+    const int_t neigh_pos = order_pos[subset_local_id(neigh_gid)];
+    const int_t first = std::min(i,neigh_pos);
+    const int_t second = std::max(i,neigh_pos);
+    successors[first].push_back(second);
+    num_predecessors[second]++;
+  }
+  // topological sort that always takes the available subset lowest on the curve
+  typedef std::pair<uint64_t,int_t> key_pos;
+  std::priority_queue<key_pos,std::vector<key_pos>,std::greater<key_pos> > available;
+  for(int_t i=0;i<num_subsets;++i)
+    if(num_predecessors[i]==0)
+      available.push(key_pos(keys[i],i));
+  std::vector<int_t> new_order;
+  new_order.reserve(num_subsets);
+  while(!available.empty()){
+    const int_t pos = available.top().second;
+    available.pop();
+    new_order.push_back(this_proc_gid_order_[pos]);
+    for(size_t j=0;j<successors[pos].size();++j){
+      if(--num_predecessors[successors[pos][j]]==0)
+        available.push(key_pos(keys[successors[pos][j]],successors[pos][j]));
+    }
+  }
+  // every edge points forward in the input order so there can't be a cycle
+  TEUCHOS_TEST_FOR_EXCEPTION((int_t)new_order.size()!=num_subsets,std::runtime_error,
+    "Error, the subset dependencies could not be ordered");
+  this_proc_gid_order_ = new_order;
+}
+
+void
+Schema::threaded_generic_correlation(){
+  std::vector<std::vector<int_t> > waves;
+  subset_execution_waves(waves);
+  DEBUG_MSG("[PROC " << comm_->get_rank() << "] Schema::threaded_generic_correlation(): " << local_num_subsets_ << " subsets in " <<
+    waves.size() << " wave(s) using " << num_threads_ << " threads");
+  for(size_t wave=0;wave<waves.size();++wave){
+    const std::vector<int_t> & wave_indices = waves[wave];
+    const int_t wave_size = wave_indices.size();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads_)
+#endif
+    for(int_t i=0;i<wave_size;++i){
+      const int_t subset_gid = this_proc_gid_order_[wave_indices[i]];
+      // the objective is the per-thread scratch space (the subset and its intensity arrays)
+      try{
+        Teuchos::RCP<Objective> obj = Teuchos::rcp(new Objective_ZNSSD(this,subset_gid));
+        generic_correlation_routine(obj);
+      }
+      catch(...){
+        DEBUG_MSG("Schema::threaded_generic_correlation(): subset " << subset_gid << " failed");
+        record_failed_step(subset_gid,static_cast<int_t>(INITIALIZE_FAILED_BY_EXCEPTION),-1);
+      }
+    }
+  }
+}
+
+void
+Schema::reliability_guided_correlation(){
+  const int_t num_subsets = local_num_subsets_;
+  if(num_subsets==0) return;
+  // number of different solved neighbors a failed subset is tried from before giving up on it
+  const int_t max_attempts = 3;
+  // the adjacency only depends on the subset coordinates so it is only built once
+  if((int_t)reliability_guided_neighbors_.size()!=num_subsets){
+    Teuchos::RCP<Point_Cloud_2D<scalar_t> > point_cloud = Teuchos::rcp(new Point_Cloud_2D<scalar_t>());
+    point_cloud->pts.resize(num_subsets);
+    for(int_t i=0;i<num_subsets;++i){
+      point_cloud->pts[i].x = local_field_value(i,SUBSET_COORDINATES_X_FS);
+      point_cloud->pts[i].y = local_field_value(i,SUBSET_COORDINATES_Y_FS);
+    }
+    Teuchos::RCP<kd_tree_2d_t> kd_tree = Teuchos::rcp(new kd_tree_2d_t(2 /*dim*/, *point_cloud.get(), nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */) ) );
+    kd_tree->buildIndex();
+    // the (up to) eight closest subsets that are within about one step of the grid (including the diagonals)
+    const int_t num_neigh = std::min(num_subsets,9);
+    std::vector<size_t> ret_index(num_neigh);
+    std::vector<scalar_t> out_dist_sqr(num_neigh);
+    std::vector<std::set<int_t> > adjacency(num_subsets);
+    scalar_t query_pt[2];
+    for(int_t i=0;i<num_subsets;++i){
+      query_pt[0] = point_cloud->pts[i].x;
+      query_pt[1] = point_cloud->pts[i].y;
+      kd_tree->knnSearch(&query_pt[0],num_neigh,&ret_index[0],&out_dist_sqr[0]);
+      scalar_t min_dist_sqr = -1.0;
+      for(int_t j=0;j<num_neigh;++j)
+        if((int_t)ret_index[j]!=i&&(min_dist_sqr<0.0||out_dist_sqr[j]<min_dist_sqr))
+          min_dist_sqr = out_dist_sqr[j];
+      for(int_t j=0;j<num_neigh;++j){
+        if((int_t)ret_index[j]==i||out_dist_sqr[j]>2.5*min_dist_sqr) continue;
+        adjacency[i].insert(ret_index[j]);
+        adjacency[ret_index[j]].insert(i);
+      }
+    }
+    reliability_guided_neighbors_.assign(num_subsets,std::vector<int_t>());
+    for(int_t i=0;i<num_subsets;++i)
+      reliability_guided_neighbors_[i].assign(adjacency[i].begin(),adjacency[i].end());
+  }
+
+  // position of each local subset in the execution order (used to break ties in the queue)
+  std::vector<int_t> order_pos(num_subsets,-1);
+  for(int_t i=0;i<num_subsets;++i)
+    order_pos[subset_local_id(this_proc_gid_order_[i])] = i;
+  std::vector<bool> is_seed(num_subsets,false);
+  std::vector<bool> solved(num_subsets,false);
+  std::vector<int_t> attempts(num_subsets,0);
+  // the neighbor each subset is initialized from (the NEIGHBOR_ID field is only read to find the seeds)
+  reliability_guided_parents_.assign(num_subsets,-1);
+  // candidates are (gamma of the solved neighbor, order position, local id, global id of the solved neighbor)
+  typedef std::tuple<scalar_t,int_t,int_t,int_t> candidate;
+  std::priority_queue<candidate,std::vector<candidate>,std::greater<candidate> > candidates;
+  const int_t batch_size = num_threads_>1 ? num_threads_ : 1;
+  std::vector<int_t> batch;
+
+  // the seeds do not depend on each other so they all go in the first batch
+  for(int_t i=0;i<num_subsets;++i){
+    const int_t subset_gid = this_proc_gid_order_[i];
+    const int_t neigh_gid = global_field_value(subset_gid,NEIGHBOR_ID_FS);
+    if(neigh_gid<0||neigh_gid==subset_gid||subset_local_id(neigh_gid)<0){
+      is_seed[subset_local_id(subset_gid)] = true;
+      batch.push_back(subset_local_id(subset_gid));
+    }
+  }
+  // without seed points none of the subsets has a neighbor, only the first subset in the execution order
+  // is a seed and the rest are reached through the queue
+  if((int_t)batch.size()==num_subsets&&num_subsets>1){
+    for(size_t i=1;i<batch.size();++i)
+      is_seed[batch[i]] = false;
+    batch.resize(1);
+  }
+  DEBUG_MSG("[PROC " << comm_->get_rank() << "] Schema::reliability_guided_correlation(): " << num_subsets << " subsets, " <<
+    batch.size() << " seed(s), batch size " << batch_size);
+  std::vector<bool> in_batch(num_subsets,false);
+  int_t next_unvisited = 0;
+  int_t num_batches = 0;
+  bool done = false;
+  // one team of threads for all of the batches, the batch selection and the queue updates are done by one thread
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads_) if(num_threads_>1)
+#endif
+  {
+    while(true){
+#ifdef _OPENMP
+#pragma omp single
+#endif
+      {
+        // take the most reliable candidates that have not been solved yet
+        if(batch.empty()){
+          while(!candidates.empty()&&(int_t)batch.size()<batch_size){
+            const int_t subset_lid = std::get<2>(candidates.top());
+            const int_t guide_gid = std::get<3>(candidates.top());
+            candidates.pop();
+            if(solved[subset_lid]||in_batch[subset_lid]||attempts[subset_lid]>=max_attempts) continue;
+            reliability_guided_parents_[subset_lid] = guide_gid;
+            in_batch[subset_lid] = true;
+            batch.push_back(subset_lid);
+          }
+        }
+        // nothing is connected to a solved subset, start again from the next subset that has not been tried
+        // (from its own previous solution)
+        if(batch.empty()){
+          while(next_unvisited<num_subsets&&attempts[subset_local_id(this_proc_gid_order_[next_unvisited])]>0)
+            next_unvisited++;
+          if(next_unvisited==num_subsets)
+            done = true;
+          else{
+            const int_t subset_lid = subset_local_id(this_proc_gid_order_[next_unvisited]);
+            reliability_guided_parents_[subset_lid] = -1;
+            batch.push_back(subset_lid);
+          }
+        }
+      } // implicit barrier, every thread sees the same batch and done flag
+      if(done) break;
+      const int_t num_in_batch = batch.size();
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for(int_t i=0;i<num_in_batch;++i){
+        const int_t subset_gid = subset_global_id(batch[i]);
+        try{
+          Teuchos::RCP<Objective> obj = Teuchos::rcp(new Objective_ZNSSD(this,subset_gid));
+          generic_correlation_routine(obj);
+        }
+        catch(...){
+          DEBUG_MSG("Schema::reliability_guided_correlation(): subset " << subset_gid << " failed");
+          record_failed_step(subset_gid,static_cast<int_t>(INITIALIZE_FAILED_BY_EXCEPTION),-1);
+        }
+      }
+#ifdef _OPENMP
+#pragma omp single
+#endif
+      {
+        num_batches++;
+        // queue up the neighbors of the subsets that were solved
+        for(int_t i=0;i<num_in_batch;++i){
+          const int_t subset_lid = batch[i];
+          in_batch[subset_lid] = false;
+          attempts[subset_lid]++;
+          if(local_field_value(subset_lid,SIGMA_FS)<0.0) continue;
+          solved[subset_lid] = true;
+          const scalar_t gamma = local_field_value(subset_lid,GAMMA_FS);
+          const std::vector<int_t> & neighbors = reliability_guided_neighbors_[subset_lid];
+          for(size_t j=0;j<neighbors.size();++j){
+            const int_t neigh_lid = neighbors[j];
+            if(solved[neigh_lid]||is_seed[neigh_lid]||attempts[neigh_lid]>=max_attempts) continue;
+            candidates.push(candidate(gamma,order_pos[neigh_lid],neigh_lid,subset_global_id(subset_lid)));
+          }
+        }
+        batch.clear();
+      } // implicit barrier
+    }
+  }
+  DEBUG_MSG("[PROC " << comm_->get_rank() << "] Schema::reliability_guided_correlation(): completed in " << num_batches << " batches");
+}
+
 void
 Schema::save_cross_correlation_fields(){
   Teuchos::RCP<MultiField> ux = mesh_->get_field(SUBSET_DISPLACEMENT_X_FS);
@@ -1640,6 +2316,7 @@ Schema::save_cross_correlation_fields(){
 
 void
 Schema::execute_post_processors(){
+  profiler::Scope post_scope(profiler::POST_PROCESSING);
   // compute post-processed quantities
   for(size_t i=0;i<post_processors_.size();++i){
     post_processors_[i]->execute();
@@ -1649,6 +2326,8 @@ Schema::execute_post_processors(){
 
 void
 Schema::prepare_optimization_initializers(){
+  // the pre-execution tasks are where the image-wide work is done for most initializers
+  profiler::Scope init_scope(initialization_method_);
   // method only needs to be called once, return if the pointers are alread addressed
   if(opt_initializers_.size()>0){
     DEBUG_MSG("Repeat call to prepare_optimization_initializers(), calling pre_execution_tasks");
@@ -1682,6 +2361,14 @@ Schema::prepare_optimization_initializers(){
     DEBUG_MSG("Default initializer is image registration initializer");
     default_initializer = Teuchos::rcp(new Image_Registration_Initializer(this));
   }
+  else if(initialization_method_==USE_IMAGE_PYRAMID){
+    DEBUG_MSG("Default initializer is image pyramid initializer");
+    default_initializer = Teuchos::rcp(new Image_Pyramid_Initializer(this));
+  }
+  else if(initialization_method_==USE_FFT_CROSS_CORRELATION){
+    DEBUG_MSG("Default initializer is fft cross-correlation initializer");
+    default_initializer = Teuchos::rcp(new Cross_Correlation_Initializer(this));
+  }
   else if(initialization_method_==USE_OPTICAL_FLOW){
     // make syre tga the correlation routine is tracking routine
     TEUCHOS_TEST_FOR_EXCEPTION(correlation_routine_!=TRACKING_ROUTINE,std::invalid_argument,"Error, USE_OPTICAL_FLOW "
@@ -1736,6 +2423,8 @@ Schema::prepare_optimization_initializers(){
       TEUCHOS_TEST_FOR_EXCEPTION(true,std::invalid_argument,"Error, path files cannot be used with the GENERIC_ROUTINE correlation routine");
     }
     opt_initializers_.insert(std::pair<int_t,Teuchos::RCP<Initializer> >(0,default_initializer));
+    if(correlation_routine_==RELIABILITY_GUIDED_ROUTINE)
+      guided_initializer_ = Teuchos::rcp(new Field_Value_Initializer(this));
   }
 
   // call pre-correlation tasks for initializers
@@ -1788,6 +2477,7 @@ Schema::record_failed_step(const int_t subset_gid,
   global_field_value(subset_gid,ACTIVE_PIXELS_FS) = -1.0;
   global_field_value(subset_gid,STATUS_FLAG_FS) = status;
   global_field_value(subset_gid,ITERATIONS_FS) = num_iterations;
+  profiler::record_step(status,num_iterations);
 }
 
 void
@@ -1814,6 +2504,7 @@ Schema::record_step(Teuchos::RCP<Objective> obj,
   global_field_value(subset_gid,ACTIVE_PIXELS_FS) = active_pixels;
   global_field_value(subset_gid,STATUS_FLAG_FS) = status;
   global_field_value(subset_gid,ITERATIONS_FS) = num_iterations;
+  profiler::record_step(status,num_iterations);
 }
 
 Status_Flag
@@ -1825,16 +2516,29 @@ Schema::initial_guess(const int_t subset_gid,
   if(correlation_routine_==TRACKING_ROUTINE){
     sid = subset_gid;
   }
+  // the reliability guided routine initializes a subset reached from a solved neighbor with the neighbor's values
+  if(correlation_routine_==RELIABILITY_GUIDED_ROUTINE&&guided_initializer_!=Teuchos::null){
+    const int_t neigh_gid = reliability_guided_parent(subset_gid);
+    if(neigh_gid>=0&&neigh_gid!=subset_gid){
+      profiler::Scope init_scope(guided_initializer_->method());
+      return guided_initializer_->initial_guess(subset_gid,shape_function);
+    }
+  }
   TEUCHOS_TEST_FOR_EXCEPTION(opt_initializers_.find(sid)==opt_initializers_.end(),std::runtime_error,
     "Initializer does not exist, but should here");
-  return opt_initializers_.find(sid)->second->initial_guess(subset_gid,shape_function);
+  // the time is charged to the initializer that runs (which may not be the requested method, for example a path file or optical flow
+  // initializer for a single subset in the tracking routine, or the field value initializer for the neighbor methods)
+  Teuchos::RCP<Initializer> initializer = opt_initializers_.find(sid)->second;
+  profiler::Scope init_scope(initializer->method());
+  return initializer->initial_guess(subset_gid,shape_function);
 }
 
 void
 Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
 
   const int_t subset_gid = obj->correlation_point_global_id();
-  TEUCHOS_TEST_FOR_EXCEPTION(subset_local_id(subset_gid)==-1,std::runtime_error,
+  const int_t subset_lid = subset_local_id(subset_gid);
+  TEUCHOS_TEST_FOR_EXCEPTION(subset_lid==-1,std::runtime_error,
     "Error: subset id is not local to this process.");
   DEBUG_MSG("[PROC " << comm_->get_rank() << "] SUBSET " << subset_gid << " (" << global_field_value(subset_gid,SUBSET_COORDINATES_X_FS) <<
     "," << global_field_value(subset_gid,SUBSET_COORDINATES_Y_FS) << ")");
@@ -1897,11 +2601,15 @@ Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
   //  check if initialization was successful
   //
   if(init_status==INITIALIZE_FAILED){
-    // try again with a search initializer
-    if(correlation_routine_==TRACKING_ROUTINE && use_search_initialization_for_failed_steps_){
+    // try again with a search initializer (not for the image pyramid or the cross-correlation initializer,
+    // they have already searched a much larger window)
+    if(correlation_routine_==TRACKING_ROUTINE && use_search_initialization_for_failed_steps_ && initialization_method_!=USE_IMAGE_PYRAMID
+        && initialization_method_!=USE_FFT_CROSS_CORRELATION){
       TEUCHOS_TEST_FOR_EXCEPTION(shape_function_type_==DICe::RIGID_BODY_SF,std::runtime_error,
         "error, cannot use search initialization with rigid body shape function");
       stat_container_->register_search_call(subset_gid,frame_id_);
+      // each subset is only touched by the thread correlating it
+      if(subset_fallbacks_!=Teuchos::null) subset_fallbacks_->local_value(subset_lid,0) += 1.0;
       // before giving up, try a search initialization, then simplex, then give up if it still can't track:
       const scalar_t search_step_xy = 1.0; // pixels
       const scalar_t search_dim_xy = 10.0; // pixels
@@ -1912,6 +2620,7 @@ Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
       shape_function->insert_motion(global_field_value(subset_gid,SUBSET_DISPLACEMENT_X_FS),global_field_value(subset_gid,SUBSET_DISPLACEMENT_Y_FS),
         global_field_value(subset_gid,ROTATION_Z_FS));
       Search_Initializer searcher(this,obj->subset(),search_step_xy,search_dim_xy,search_step_xy,search_dim_xy,search_step_theta,search_dim_theta);
+      profiler::Scope search_scope(searcher.method());
       init_status = searcher.initial_guess(subset_gid,shape_function);
     }
     if(init_status==INITIALIZE_FAILED){
@@ -2014,6 +2723,14 @@ Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
       corr_status = CORRELATION_FAILED_BY_EXCEPTION;
     };
   }
+  else if(optimization_method_==DICe::INVERSE_COMPOSITIONAL){
+    try{
+      corr_status = obj->computeUpdateInverseCompositional(shape_function,num_iterations);
+    }
+    catch (...) { //a non-graceful exception occurred
+      corr_status = CORRELATION_FAILED_BY_EXCEPTION;
+    };
+  }
   //
   //  test for the jump tolerances here:
   //
@@ -2033,11 +2750,14 @@ Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
   DEBUG_MSG("Subset " << subset_gid << " jump pass: " << jump_pass);
   if(corr_status!=CORRELATION_SUCCESSFUL||!jump_pass){
     bool second_attempt_failed = false;
-    if(optimization_method_==DICe::SIMPLEX||optimization_method_==DICe::GRADIENT_BASED||force_simplex){
+    // the reliability guided routine tries a failed subset again from a different solved neighbor instead
+    if(optimization_method_==DICe::SIMPLEX||optimization_method_==DICe::GRADIENT_BASED||
+        optimization_method_==DICe::INVERSE_COMPOSITIONAL||force_simplex||correlation_routine_==RELIABILITY_GUIDED_ROUTINE){
       second_attempt_failed = true;
     }
     else if(optimization_method_==DICe::GRADIENT_BASED_THEN_SIMPLEX||optimization_method_==DICe::GRADIENT_THEN_SEARCH){
       if(correlation_routine_==TRACKING_ROUTINE) stat_container_->register_backup_opt_call(subset_gid,frame_id_);
+      if(subset_fallbacks_!=Teuchos::null) subset_fallbacks_->local_value(subset_lid,1) += 1.0;
       // try again using simplex
       init_status = initial_guess(subset_gid,shape_function);
       if(optimization_method_==DICe::GRADIENT_BASED_THEN_SIMPLEX){
@@ -2053,7 +2773,10 @@ Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
         const scalar_t search_step_u = 1.0; // pixels
         const scalar_t search_dim_u = 50.0; // pixels
         Search_Initializer searcher(this,obj->subset(),search_step_u,search_dim_u,-1.0,0.0,-1.0,0.0);
-        init_status = searcher.initial_guess(subset_gid,shape_function);
+        {
+          profiler::Scope search_scope(searcher.method());
+          init_status = searcher.initial_guess(subset_gid,shape_function);
+        }
         scalar_t min_u = 0.0,min_v = 0.0, min_t = 0.0;
         shape_function->map_to_u_v_theta(global_field_value(subset_gid,SUBSET_COORDINATES_X_FS),global_field_value(subset_gid,SUBSET_COORDINATES_Y_FS),
           min_u,min_v,min_t);
@@ -2070,6 +2793,7 @@ Schema::generic_correlation_routine(Teuchos::RCP<Objective> obj){
     }
     else if(optimization_method_==DICe::SIMPLEX_THEN_GRADIENT_BASED){
       if(correlation_routine_==TRACKING_ROUTINE) stat_container_->register_backup_opt_call(subset_gid,frame_id_);
+      if(subset_fallbacks_!=Teuchos::null) subset_fallbacks_->local_value(subset_lid,1) += 1.0;
       // try again using gradient based
       init_status = initial_guess(subset_gid,shape_function);
       try{
@@ -3083,6 +3807,7 @@ Schema::write_output(const std::string & output_folder,
   if(analysis_type_==GLOBAL_DIC){
     return;
   }
+  profiler::Scope output_scope(profiler::WRITE_OUTPUT);
   TEUCHOS_TEST_FOR_EXCEPTION(output_spec_==Teuchos::null,std::runtime_error,"");
   int_t my_proc = comm_->get_rank();
   int_t proc_size = comm_->get_size();
@@ -3100,11 +3825,31 @@ Schema::write_output(const std::string & output_folder,
   }
 #endif
 
-  if(no_text_output) return;
+  if(!write_binary_output_&&no_text_output) return;
 
   // populate the RCP vector of fields in the output spec
   output_spec_->gather_fields();
 
+  if(write_binary_output_){
+    if(binary_output_writer_==Teuchos::null){
+      // one file per process, all frames in the same file
+      std::stringstream binName;
+      binName << output_folder << prefix;
+      if(proc_size>1)
+        binName << "." << proc_size << "." << my_proc;
+      binName << ".dbin";
+      std::vector<int_t> subset_ids(local_num_subsets_);
+      for(int_t i=0;i<local_num_subsets_;++i)
+        subset_ids[i] = subset_global_id(i);
+      binary_output_writer_ = Teuchos::rcp(new Binary_Output_Writer(binName.str(),output_spec_->field_names(),subset_ids,compress_binary_output_));
+    }
+    std::vector<scalar_t> values;
+    output_spec_->frame_values(local_num_subsets_,values);
+    binary_output_writer_->write_frame(frame_id_-1,values); // frame is decremented because write gets called after update_frame
+  }
+
+  if(no_text_output) return;
+
   // only process 0 actually writes the output
   //if(my_proc!=0) return;
 
@@ -3537,6 +4282,17 @@ Output_Spec::gather_fields(){
   }
 }
 
+void
+Output_Spec::frame_values(const int_t num_values,
+  std::vector<scalar_t> & values){
+  values.assign(field_names_.size()*num_values,0.0);
+  for(size_t i=0;i<field_names_.size();++i){
+    if(field_vec_[i]==Teuchos::null) continue;
+    for(int_t j=0;j<num_values;++j)
+      values[i*num_values+j] = field_vec_[i]->local_value(j);
+  }
+}
+
 void
 Output_Spec::write_info(std::FILE * file,
   const bool include_time_of_day){
@@ -3707,6 +4463,7 @@ bool frame_should_be_skipped(const int_t trigger_based_frame_index,
 void
 Stat_Container::register_backup_opt_call(const int_t subset_id,
   const int_t frame_id){
+  std::lock_guard<std::mutex> lock(mutex_);
   if(backup_optimization_call_frames_.find(subset_id) == backup_optimization_call_frames_.end()){
     std::vector<int_t> frames;
     frames.push_back(frame_id);
@@ -3719,6 +4476,7 @@ Stat_Container::register_backup_opt_call(const int_t subset_id,
 void
 Stat_Container::register_search_call(const int_t subset_id,
   const int_t frame_id){
+  std::lock_guard<std::mutex> lock(mutex_);
   if(search_call_frames_.find(subset_id) == search_call_frames_.end()){
     std::vector<int_t> frames;
     frames.push_back(frame_id);
@@ -3731,6 +4489,7 @@ Stat_Container::register_search_call(const int_t subset_id,
 void
 Stat_Container::register_jump_exceeded(const int_t subset_id,
   const int_t frame_id){
+  std::lock_guard<std::mutex> lock(mutex_);
   if(jump_tol_exceeded_frames_.find(subset_id) == jump_tol_exceeded_frames_.end()){
     std::vector<int_t> frames;
     frames.push_back(frame_id);
@@ -3740,9 +4499,65 @@ Stat_Container::register_jump_exceeded(const int_t subset_id,
     jump_tol_exceeded_frames_.find(subset_id)->second.push_back(frame_id);
 }
 
+void
+Stat_Container::event_histograms(std::map<std::string,std::map<int_t,int_t> > & histograms)const{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::map<int_t,std::vector<int_t> > * events[] = {&backup_optimization_call_frames_,&search_call_frames_,
+      &jump_tol_exceeded_frames_,&failed_init_frames_};
+  const char * names[] = {"backup_optimization_calls","search_calls","jump_tolerance_exceeded","failed_initializations"};
+  for(int_t i=0;i<4;++i){
+    // make sure the entry exists even if there were no events so all processors report the same histograms
+    std::map<int_t,int_t> & histogram = histograms[names[i]];
+    for(std::map<int_t,std::vector<int_t> >::const_iterator it=events[i]->begin();it!=events[i]->end();++it)
+      histogram[it->second.size()]++;
+  }
+}
+
+void
+Stat_Container::gather_events(){
+#if DICE_MPI
+  std::lock_guard<std::mutex> lock(mutex_);
+  int num_procs = 1, rank = 0;
+  MPI_Comm_size(MPI_COMM_WORLD,&num_procs);
+  MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+  if(num_procs==1) return;
+  std::map<int_t,std::vector<int_t> > * events[] = {&backup_optimization_call_frames_,&search_call_frames_,
+      &jump_tol_exceeded_frames_,&failed_init_frames_};
+  // each event is packed as (type, subset id, frame id)
+  std::vector<int_t> local_data;
+  for(int_t i=0;i<4;++i){
+    for(std::map<int_t,std::vector<int_t> >::const_iterator it=events[i]->begin();it!=events[i]->end();++it){
+      for(size_t j=0;j<it->second.size();++j){
+        local_data.push_back(i);
+        local_data.push_back(it->first);
+        local_data.push_back(it->second[j]);
+      }
+    }
+  }
+  int local_size = local_data.size();
+  std::vector<int> sizes(num_procs,0);
+  MPI_Gather(&local_size,1,MPI_INT,&sizes[0],1,MPI_INT,0,MPI_COMM_WORLD);
+  std::vector<int> displs(num_procs,0);
+  int total_size = 0;
+  for(int_t i=0;i<num_procs;++i){
+    displs[i] = total_size;
+    total_size += sizes[i];
+  }
+  std::vector<int_t> all_data(std::max(total_size,1),0);
+  MPI_Gatherv(local_data.empty()?NULL:&local_data[0],local_size,MPI_INT,&all_data[0],&sizes[0],&displs[0],MPI_INT,0,MPI_COMM_WORLD);
+  for(int_t i=0;i<4;++i)
+    events[i]->clear();
+  if(rank!=0) return;
+  // the processors are in order so the frames of each subset stay in order when the blocks are contiguous
+  for(int_t i=0;i+2<total_size;i+=3)
+    (*events[all_data[i]])[all_data[i+1]].push_back(all_data[i+2]);
+#endif
+}
+
 void
 Stat_Container::register_failed_init(const int_t subset_id,
   const int_t frame_id){
+  std::lock_guard<std::mutex> lock(mutex_);
   if(failed_init_frames_.find(subset_id) == failed_init_frames_.end()){
     std::vector<int_t> frames;
     frames.push_back(frame_id);
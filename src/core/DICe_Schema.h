@@ -53,6 +53,8 @@
 #include <DICe_Mesh.h>
 #include <DICe_FieldEnums.h>
 #include <DICe_Decomp.h>
+#include <DICe_BinaryOutput.h>
+#include <DICe_NodeImageReader.h>
 #include <DICe_LocalShapeFunction.h>
 
 #ifdef DICE_TPETRA
@@ -65,6 +67,7 @@
 #include <Teuchos_SerialDenseMatrix.hpp>
 
 #include <map>
+#include <mutex>
 
 namespace DICe {
 
@@ -85,6 +88,7 @@ class Image_Deformer;
 
 
 /// container class that holds information about a tracking analysis
+/// (the events can be registered from more than one thread at a time)
 class
 DICE_LIB_DLL_EXPORT
 Stat_Container{
@@ -140,6 +144,7 @@ public:
 
   /// returns the number of occurrances for this subset
   const int_t num_backup_opts(const int_t subset_id){
+    std::lock_guard<std::mutex> lock(mutex_);
     if(backup_optimization_call_frames_.find(subset_id)!=backup_optimization_call_frames_.end()){
       return backup_optimization_call_frames_.find(subset_id)->second.size();
     }
@@ -149,6 +154,7 @@ public:
 
   /// returns the number of occurrances for this subset
   const int_t num_jump_fails(const int_t subset_id){
+    std::lock_guard<std::mutex> lock(mutex_);
     if(jump_tol_exceeded_frames_.find(subset_id)!=jump_tol_exceeded_frames_.end()){
       return jump_tol_exceeded_frames_.find(subset_id)->second.size();
     }
@@ -158,6 +164,7 @@ public:
 
   /// returns the number of occurrances for this subset
   const int_t num_searches(const int_t subset_id){
+    std::lock_guard<std::mutex> lock(mutex_);
     if(search_call_frames_.find(subset_id)!=search_call_frames_.end()){
       return search_call_frames_.find(subset_id)->second.size();
     }
@@ -167,6 +174,7 @@ public:
 
   /// returns the number of occurrances for this subset
   const int_t num_failed_inits(const int_t subset_id){
+    std::lock_guard<std::mutex> lock(mutex_);
     if(failed_init_frames_.find(subset_id)!=failed_init_frames_.end()){
       return failed_init_frames_.find(subset_id)->second.size();
     }
@@ -174,6 +182,17 @@ public:
       return 0;
   }
 
+  /// collect a histogram for each type of event where the key is the number of occurrences
+  /// for a subset and the value is the number of subsets with that many occurrences
+  /// (subsets with no occurrences are not included)
+  /// \param histograms the histograms are added to this map, one entry per type of event
+  void event_histograms(std::map<std::string,std::map<int_t,int_t> > & histograms)const;
+
+  /// collect the events from all processors onto processor 0, this is a collective call when MPI is enabled
+  /// (for the frame parallel mode where each processor registers the events for its own block of frames).
+  /// Afterwards processor 0 holds all of the events and the other processors hold none.
+  void gather_events();
+
 private:
   /// number of times backup optimization routine had to be used
   std::map<int_t,std::vector<int_t> > backup_optimization_call_frames_;
@@ -183,6 +202,8 @@ private:
   std::map<int_t,std::vector<int_t> > jump_tol_exceeded_frames_;
   /// failed initialization frames
   std::map<int_t,std::vector<int_t> > failed_init_frames_;
+  /// guards the event maps when the subsets are correlated on more than one thread
+  mutable std::mutex mutex_;
 };
 
 /// \class DICe::Schema
@@ -301,9 +322,35 @@ public:
     return def_extents_;
   }
 
+  /// \brief the window of a deformed image (offset and size in pixels) that is read for the current deformed extents
+  /// returns false if the whole image is needed (no extents, motion windows or a rotated deformed image)
+  /// \param file_name the name of an image in the sequence (only the header is read to get the full dimensions)
+  /// \param margin additional pixels on each side of the window (for example to cover motion in frames that are read ahead)
+  /// \param offset_x [out] upper left x coordinate of the window
+  /// \param offset_y [out] upper left y coordinate of the window
+  /// \param width [out] width of the window
+  /// \param height [out] height of the window
+  bool def_image_window(const std::string & file_name,
+    const int_t margin,
+    int_t & offset_x,
+    int_t & offset_y,
+    int_t & width,
+    int_t & height)const;
+
   /// Replace the deformed image for this Schema
   void set_def_image(const std::string & defName);
 
+  /// \brief Replace the deformed image with a frame that was read ahead of time (possibly only a window of
+  /// the frame). If the image does not cover the current deformed extents the frame is read again from file.
+  /// Not valid with motion windows (throws).
+  /// \param img the image read ahead of time
+  /// \param defName the file name of the frame
+  void set_prefetched_def_image(Teuchos::RCP<Image> img,
+    const std::string & defName);
+
+  /// returns the image parameters (filtering, gradients, etc.) used when this schema reads a deformed image from file
+  Teuchos::RCP<Teuchos::ParameterList> def_image_params()const;
+
   /// Replace the deformed image using an intensity array
   void set_def_image(const int_t img_width,
     const int_t img_height,
@@ -373,6 +420,20 @@ public:
   /// do clean up tasks
   void post_execution_tasks();
 
+  /// \brief Move subsets between processes to balance the measured cost of correlating them (called between frames)
+  ///
+  /// Every rebalance_interval frames, processor 0 collects the cost of each subset since the last rebalance
+  /// (see record_subset_costs()) and splits a Hilbert curve through the subsets into stretches of equal cost.
+  /// If that lowers the largest load by more than a few percent, the subsets move to their new owners along with
+  /// all of their field values. Returns true if the subsets moved, in which case the image extents have changed
+  /// and the reference image has to be set again.
+  bool rebalance_subsets();
+
+  /// returns a pointer to the cost of each local subset accumulated since the last rebalance
+  Teuchos::RCP<MultiField> subset_costs(){
+    return subset_costs_;
+  }
+
   /// Returns if the field storage is initilaized
   int_t is_initialized()const{
     return is_initialized_;
@@ -537,7 +598,8 @@ public:
     const DICe::field_enums::Field_Spec spec){
     assert(local_id<local_num_subsets_);
     assert(local_id>=0);
-    return mesh_->get_field(spec)->local_value(local_id);
+    // the field RCP is not copied since this is called from every thread in the subset loops
+    return mesh_->get_field_ref(spec).local_value(local_id);
   }
 
   /// \brief Save off the current solution into the storage for frame n - 1 (only used if projection_method is VELOCITY_BASED)
@@ -689,6 +751,47 @@ public:
   /// \param obj A single DICe::Objective that has a DICe::subset as part of its member data
   void generic_correlation_routine(Teuchos::RCP<Objective> obj);
 
+  /// \brief Execute the generic correlation routine for all the local subsets using multiple threads
+  ///
+  /// Each subset gets its own objective and shape function so there is no scratch storage shared
+  /// between threads. The subsets are grouped into waves that respect the order given by
+  /// this_proc_gid_order_: if the initialization method uses neighbor values, a subset is only
+  /// correlated after the neighbor it is initialized from has been solved for this frame.
+  void threaded_generic_correlation();
+
+  /// \brief Group the local subsets into waves that can be correlated concurrently
+  /// \param waves [out] each entry is a list of subset indices (into this_proc_gid_order_)
+  /// that do not depend on each other. All the subsets in a wave must be complete before the next wave starts.
+  void subset_execution_waves(std::vector<std::vector<int_t> > & waves);
+
+  /// \brief Reorder this_proc_gid_order_ along a space filling curve (if requested by the subset_execution_order parameter)
+  ///
+  /// Consecutive subsets then read nearby pixels, so the working set of the interpolation stays in cache.
+  /// A subset that is initialized from a neighbor stays on the same side of that neighbor as in the input order
+  /// so the results do not change. The order is left as is if there are obstructions.
+  void apply_subset_execution_order();
+
+  /// \brief Execute the reliability guided correlation routine for the local subsets
+  ///
+  /// The seeds (subsets without a neighbor to initialize from) are correlated first. If no seeds were defined
+  /// (no subset has a neighbor) the first subset in the execution order is the only seed. After that
+  /// the neighbors of the solved subsets are taken from a priority queue ordered by the gamma value of the
+  /// solved neighbor, so the subset is always initialized from the most reliable neighbor available
+  /// (see reliability_guided_parent(), the NEIGHBOR_ID field is left as it was). A subset that fails is tried
+  /// again from the next solved neighbor instead of falling back to a search or the backup optimizer.
+  /// A subset that cannot be reached from a solved subset starts from its own previous solution.
+  /// With more than one thread the best num_threads candidates are correlated concurrently as a wavefront.
+  void reliability_guided_correlation();
+
+  /// Returns the global id of the solved neighbor a subset was last initialized from by the reliability
+  /// guided routine, or -1 if it started from its own previous solution (seeds and restarts)
+  /// \param subset_gid the global id of the subset
+  int_t reliability_guided_parent(const int_t subset_gid){
+    const int_t subset_lid = subset_local_id(subset_gid);
+    if(subset_lid<0||subset_lid>=(int_t)reliability_guided_parents_.size()) return -1;
+    return reliability_guided_parents_[subset_lid];
+  }
+
   /// Returns true if the user has requested testing for motion in the frame
   /// and the motion was detected by diffing pixel values:
   /// \param subset_gid the global id of the subset to test for motion
@@ -736,6 +839,17 @@ public:
     return use_incremental_formulation_;
   }
 
+  /// Returns true if the frames are distributed across the processes instead of the subsets
+  /// (each frame is then correlated independently of the previous one)
+  bool frame_parallel()const{
+    return frame_parallel_;
+  }
+
+  /// Returns true if the images are read once per compute node and shared between the processes on the node
+  bool share_images_on_node()const{
+    return node_image_reader_!=Teuchos::null;
+  }
+
   /// returns true if the nonlinear projection is used
   bool use_nonlinear_projection()const{
     return use_nonlinear_projection_;
@@ -797,6 +911,16 @@ public:
     return skip_all_solves_;
   }
 
+  /// Returns the number of threads used to correlate subsets on this process
+  int_t num_threads()const{
+    return num_threads_;
+  }
+
+  /// Returns true if the binary output file should be written
+  bool write_binary_output()const{
+    return write_binary_output_;
+  }
+
   /// True if the gamma values should be normalized by the number of active pixels
   bool normalize_gamma_with_active_pixels()const{
     return normalize_gamma_with_active_pixels_;
@@ -857,6 +981,14 @@ public:
     num_frames_ = num_frames;
   }
 
+  /// \brief Sets the current frame's index (to start part of the way through the sequence)
+  /// \param frame_id the index of the next frame to correlate
+  void set_frame_id(const int_t frame_id){
+    TEUCHOS_TEST_FOR_EXCEPTION(frame_id<first_frame_id_,std::invalid_argument,"Error, frame id " << frame_id <<
+      " is before the first frame " << first_frame_id_);
+    frame_id_ = frame_id;
+  }
+
   /// Returns the number of images in the set (-1 if it has not been set)
   int_t num_frames() const{
     return num_frames_;
@@ -989,7 +1121,7 @@ public:
   /// Return the local id of a subset global id
   /// \param global_id the input global id to tranlate to local
   int_t subset_local_id(const int_t global_id){
-    return mesh_->get_scalar_node_dist_map()->get_local_element(global_id);
+    return mesh_->get_scalar_node_dist_map_ref().get_local_element(global_id);
   }
 
   /// Returns a pointer to the params that were used to construct this schema
@@ -1023,6 +1155,26 @@ public:
   }
 
 private:
+  /// \brief the window of an image to read for the given extents, the extents are padded by the
+  /// subset, filter and gradient stencils so the subsets never touch the unfiltered border of the window
+  /// (the whole image is used in a direction if the window comes within 100 pixels of the boundary)
+  /// \param extents the x and y extents (x_start, x_end, y_start, y_end)
+  /// \param full_width the width of the full image
+  /// \param full_height the height of the full image
+  /// \param margin additional pixels on each side of the window
+  /// \param offset_x [out] upper left x coordinate of the window
+  /// \param offset_y [out] upper left y coordinate of the window
+  /// \param width [out] width of the window
+  /// \param height [out] height of the window
+  void image_window(const std::vector<int_t> & extents,
+    const int_t full_width,
+    const int_t full_height,
+    const int_t margin,
+    int_t & offset_x,
+    int_t & offset_y,
+    int_t & width,
+    int_t & height)const;
+
   /// \brief Initializes the data structures for the schema
   /// \param input_params pointer to the initialization parameters
   /// \param correlation_params pointer to the correlation parameters
@@ -1062,6 +1214,10 @@ private:
   /// create all of the fields necessary on the mesh
   void create_mesh_fields();
 
+  /// add the cost of correlating each local subset in the current frame to subset_costs_
+  /// (one for the setup plus the solver iterations and a penalty for any search or backup optimization)
+  void record_subset_costs();
+
   /// Pointer to communicator (can be serial)
   comm_rcp comm_;
   /// The mesh holds the fields and subsets or elements and nodes
@@ -1096,6 +1252,13 @@ private:
   bool has_post_processor_;
   /// map of pointers to initializers (used to initialize first guess for optimization routine)
   std::map<int_t,Teuchos::RCP<Initializer> > opt_initializers_;
+  /// initializer used by the reliability guided routine for subsets reached from a solved neighbor
+  Teuchos::RCP<Initializer> guided_initializer_;
+  /// local ids of the adjacent subsets for each local subset (reliability guided routine only)
+  std::vector<std::vector<int_t> > reliability_guided_neighbors_;
+  /// global id of the solved neighbor each local subset is initialized from, -1 for its own previous solution
+  /// (reliability guided routine only)
+  std::vector<int_t> reliability_guided_parents_;
   /// vector of pointers to motion detectors for a specific subset
   std::map<int_t,Teuchos::RCP<Motion_Test_Utility> > motion_detectors_;
   /// For constrained optimiation, this lists the owning element global id for each pixel:
@@ -1265,8 +1428,32 @@ private:
   Teuchos::RCP<Image_Deformer> image_deformer_;
   /// true if the laplacian images should be computed
   bool compute_laplacian_image_;
+  /// true if the images should use compact 8/16 bit storage
+  bool compact_image_storage_;
+  /// true if the deformed images should keep a tiled copy of the intensities and gradients
+  bool tiled_image_layout_;
+  /// order in which the local subsets are executed
+  Subset_Execution_Order subset_execution_order_;
   /// size of threshold to use for feature matching when thresholding is included
   int_t threshold_block_size_;
+  /// number of threads to use in the generic correlation routine
+  int_t num_threads_;
+  /// true if the fields should be written to a binary output file
+  bool write_binary_output_;
+  /// true if the binary output should be compressed
+  bool compress_binary_output_;
+  /// writer for the binary output file (created when the first frame is written)
+  Teuchos::RCP<Binary_Output_Writer> binary_output_writer_;
+  /// number of frames between rebalancing the subsets across processes (0 turns rebalancing off)
+  int_t rebalance_interval_;
+  /// cost of each local subset since the last rebalance (on the scalar node dist map)
+  Teuchos::RCP<MultiField> subset_costs_;
+  /// number of search initializations (field 0) and backup optimizations (field 1) for each local subset in the current frame
+  Teuchos::RCP<MultiField> subset_fallbacks_;
+  /// true if the frames are distributed across the processes instead of the subsets
+  bool frame_parallel_;
+  /// reads the images once per compute node and shares them between the processes on the node (null if not shared)
+  Teuchos::RCP<Node_Image_Reader> node_image_reader_;
 };
 
 /// \class DICe::Output_Spec
@@ -1315,6 +1502,17 @@ public:
     const int_t row_index,
     const int_t field_value_index);
 
+  /// \brief Gathers the values of all the output fields for the current frame (fields that do not exist are zero)
+  /// \param num_values the number of values per field (the number of local subsets)
+  /// \param values the output values ordered [field][subset] (resized)
+  void frame_values(const int_t num_values,
+    std::vector<scalar_t> & values);
+
+  /// returns the names of the output fields
+  const std::vector<std::string> & field_names()const{
+    return field_names_;
+  }
+
   /// provide access to the field_vec
   std::vector<Teuchos::RCP<MultiField> > * field_vec(){
     return &field_vec_;
@@ -933,6 +933,16 @@ public:
     return field_registry_.find(field_spec)->second;
   }
 
+  /// returns a reference to an existing field without copying the RCP, so the reference count
+  /// is not touched when many threads look up fields at the same time
+  /// \param field_spec The field_spec that defines the sought field
+  MultiField & get_field_ref(const field_enums::Field_Spec & field_spec){
+    field_registry::const_iterator it = field_registry_.find(field_spec);
+    TEUCHOS_TEST_FOR_EXCEPTION(it==field_registry_.end(),
+      std::invalid_argument,"Requested field is not in the registry." + field_spec.get_name_label());
+    return *it->second;
+  }
+
   /// Return a pointer to the field based on the name alone
   /// \param field_name The string name of the field
   std::pair<field_enums::Field_Spec,Teuchos::RCP<MultiField> > get_field(const std::string & field_name);
@@ -1038,6 +1048,11 @@ public:
     return scalar_node_dist_map_;
   }
 
+  /// Returns a reference to the communication map (the RCP is not copied)
+  const MultiField_Map & get_scalar_node_dist_map_ref()const{
+    return *scalar_node_dist_map_;
+  }
+
   /// Returns a pointer to the communication map
   Teuchos::RCP<MultiField_Map> get_vector_node_dist_map(){
     return vector_node_dist_map_;
@@ -146,7 +146,7 @@ void match_features(Teuchos::RCP<Image> left_image,
 }
 
 void opencv_8UC1(Teuchos::RCP<Image> image, unsigned char * array){
-  Teuchos::ArrayRCP<intensity_t> intensities = image->intensities();
+  Teuchos::ArrayRCP<const intensity_t> intensities = image->decoded_intensities();
   // need to scale the vaues to 0-255
   const int_t w = image->width();
   const int_t h = image->height();
@@ -41,6 +41,9 @@
 
 #include <cassert>
 #include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstdint>
 #include <ctype.h>
 
 #include <DICe_ImageIO.h>
@@ -170,6 +173,88 @@ Image_File_Type image_file_type(const char * file_name){
   return file_type;
 }
 
+/// read an unsigned integer of num_bytes bytes from a buffer
+/// \param buffer pointer to the first byte
+/// \param num_bytes the number of bytes (2 or 4)
+/// \param big_endian true if the most significant byte is first
+static uint32_t header_uint(const unsigned char * buffer,
+  const int_t num_bytes,
+  const bool big_endian){
+  uint32_t value = 0;
+  for(int_t i=0;i<num_bytes;++i)
+    value |= static_cast<uint32_t>(buffer[big_endian ? i : num_bytes-1-i]) << (8*(num_bytes-1-i));
+  return value;
+}
+
+/// read the image dimensions from the header of a tiff, png, jpeg, or bmp file without decoding the pixels
+/// (returns false if the header could not be parsed, for example for a BigTIFF file)
+/// \param file_name the name of the file
+/// \param file_type the type of the file
+/// \param width [out] the width of the image
+/// \param height [out] the height of the image
+static bool read_header_dimensions(const char * file_name,
+  const Image_File_Type file_type,
+  int_t & width,
+  int_t & height){
+  std::ifstream file(file_name,std::ios::in|std::ios::binary);
+  if(!file.is_open()) return false;
+  unsigned char buffer[26];
+  if(file_type==TIFF){
+    if(!file.read(reinterpret_cast<char*>(buffer),8)) return false;
+    const bool big_endian = buffer[0]=='M'&&buffer[1]=='M';
+    if(!big_endian&&!(buffer[0]=='I'&&buffer[1]=='I')) return false;
+    if(header_uint(&buffer[2],2,big_endian)!=42) return false; // BigTIFF or not a tiff
+    file.seekg(header_uint(&buffer[4],4,big_endian));
+    if(!file.read(reinterpret_cast<char*>(buffer),2)) return false;
+    const int_t num_entries = header_uint(buffer,2,big_endian);
+    width = 0;
+    height = 0;
+    for(int_t i=0;i<num_entries;++i){
+      // each directory entry: tag, type, count, value (short values are left justified in the value field)
+      if(!file.read(reinterpret_cast<char*>(buffer),12)) return false;
+      const uint32_t tag = header_uint(buffer,2,big_endian);
+      const uint32_t type = header_uint(&buffer[2],2,big_endian);
+      const uint32_t value = type==3 ? header_uint(&buffer[8],2,big_endian) : header_uint(&buffer[8],4,big_endian);
+      if(tag==256) width = value;
+      else if(tag==257) height = value;
+    }
+    return width>0&&height>0;
+  }
+  else if(file_type==PNG){
+    // the IHDR chunk is always first: 8 byte signature, chunk length, chunk type, width, height
+    if(!file.read(reinterpret_cast<char*>(buffer),24)) return false;
+    if(buffer[1]!='P'||buffer[2]!='N'||buffer[3]!='G') return false;
+    width = header_uint(&buffer[16],4,true);
+    height = header_uint(&buffer[20],4,true);
+    return width>0&&height>0;
+  }
+  else if(file_type==BMP){
+    if(!file.read(reinterpret_cast<char*>(buffer),26)) return false;
+    if(buffer[0]!='B'||buffer[1]!='M') return false;
+    width = static_cast<int32_t>(header_uint(&buffer[18],4,false));
+    height = std::abs(static_cast<int32_t>(header_uint(&buffer[22],4,false))); // negative for top down images
+    return width>0&&height>0;
+  }
+  else if(file_type==JPEG){
+    if(!file.read(reinterpret_cast<char*>(buffer),2)) return false;
+    if(buffer[0]!=0xFF||buffer[1]!=0xD8) return false;
+    // walk the markers until the start of frame marker that holds the dimensions
+    while(file.read(reinterpret_cast<char*>(buffer),4)){
+      if(buffer[0]!=0xFF) return false;
+      const unsigned char marker = buffer[1];
+      const int_t length = header_uint(&buffer[2],2,true);
+      if(marker>=0xC0&&marker<=0xCF&&marker!=0xC4&&marker!=0xC8&&marker!=0xCC){
+        if(!file.read(reinterpret_cast<char*>(buffer),5)) return false;
+        height = header_uint(&buffer[1],2,true);
+        width = header_uint(&buffer[3],2,true);
+        return width>0&&height>0;
+      }
+      file.seekg(length-2,std::ios::cur);
+    }
+  }
+  return false;
+}
+
 DICE_LIB_DLL_EXPORT
 void read_image_dimensions(const char * file_name,
   int_t & width,
@@ -188,8 +273,10 @@ void read_image_dimensions(const char * file_name,
   else if(file_type==CINE){
     const std::string cine_file = cine_file_name(file_name);
     DEBUG_MSG("read_image_dimensions(): cine file name: " << cine_file);
-    width = Image_Reader_Cache::instance().cine_reader(cine_file)->width();
-    height = Image_Reader_Cache::instance().cine_reader(cine_file)->height();
+    // one lookup so the cache lock is only taken once
+    Teuchos::RCP<DICe::cine::Cine_Reader> reader = Image_Reader_Cache::instance().cine_reader(cine_file);
+    width = reader->width();
+    height = reader->height();
     assert(width>0);
     assert(height>0);
   }
@@ -202,6 +289,9 @@ void read_image_dimensions(const char * file_name,
     netcdf_reader.get_image_dimensions(netcdf_file,width,height,num_time_steps);
   }
 #endif
+  else if(read_header_dimensions(file_name,file_type,width,height)){
+    DEBUG_MSG("read_image_dimensions(): (header) file name: " << file_name);
+  }
   else{
     DEBUG_MSG("read_image_dimensions(): (opencv) file name: " << file_name);
     cv::Mat image = cv::imread(file_name, cv::ImreadModes::IMREAD_GRAYSCALE);
@@ -268,15 +358,26 @@ void read_image(const char * file_name,
     if(params!=Teuchos::null){
       reinit = params->get(reinitialize_cine_reader_conversion_factor,false);
     }
-    reader->initialize_filter(filter_failed_pixels,convert_to_8_bit,0,reinit);
-    width = sub_w==0?reader->width():sub_w;
-    height = sub_h==0?reader->height():sub_h;
-    if(is_avg){
-      reader->get_average_frame(start_index-reader->first_image_number(),end_index-reader->first_image_number(),
-        sub_offset_x,sub_offset_y,width,height,intensities,layout_right);
-    }else{
-      reader->get_frame(sub_offset_x,sub_offset_y,width,height,intensities,layout_right,start_index-reader->first_image_number());
+    // the reader is shared by the threads of the process: the filter set up (the first read or a reinit) waits for the
+    // reads in progress and finishes its own frame before any other read starts, so no frame sees a partial set up
+    const bool exclusive = reader->begin_filter_access(reinit);
+    try{
+      if(exclusive)
+        reader->initialize_filter(filter_failed_pixels,convert_to_8_bit,0,reinit);
+      width = sub_w==0?reader->width():sub_w;
+      height = sub_h==0?reader->height():sub_h;
+      if(is_avg){
+        reader->get_average_frame(start_index-reader->first_image_number(),end_index-reader->first_image_number(),
+          sub_offset_x,sub_offset_y,width,height,intensities,layout_right);
+      }else{
+        reader->get_frame(sub_offset_x,sub_offset_y,width,height,intensities,layout_right,start_index-reader->first_image_number());
+      }
     }
+    catch(...){
+      reader->end_filter_access(exclusive);
+      throw;
+    }
+    reader->end_filter_access(exclusive);
   }
 #ifdef DICE_ENABLE_NETCDF
   /// check if the file is a netcdf file
@@ -397,6 +498,9 @@ void undistort_intensities(const int_t width,
   static bool first_run = true;
   static cv::Mat intrinsics = cv::Mat(3, 3, CV_32FC1);
   static cv::Mat dist_coeffs = cv::Mat(1,4,CV_32FC1);
+  // images may be read on background threads so the one-time set up of the camera parameters is guarded
+  static std::mutex setup_mutex;
+  std::unique_lock<std::mutex> setup_lock(setup_mutex);
   if(first_run){
     DEBUG_MSG("utils::undistort_intensities(): manually undistorting images");
     // This param must exist, otherwise this method would not be called
@@ -427,6 +531,7 @@ void undistort_intensities(const int_t width,
     dist_coeffs.at<float>(0,3) = 0.0;
   }
   first_run = false;
+  setup_lock.unlock();
   // convert intensity values to an opencv Mat
   cv::Mat img(height,width,CV_8UC1,cv::Scalar(0));
   cv::Mat out_img(height,width,CV_8UC1,cv::Scalar(0));
@@ -497,8 +602,8 @@ DICE_LIB_DLL_EXPORT
 void write_color_overlap_image(const char * file_name,
   const int_t width,
   const int_t height,
-  intensity_t * bottom_intensities,
-  intensity_t * top_intensities){
+  const intensity_t * bottom_intensities,
+  const intensity_t * top_intensities){
 
   intensity_t bot_max_intensity = -1.0E10;
   intensity_t bot_min_intensity = 1.0E10;
@@ -532,7 +637,7 @@ DICE_LIB_DLL_EXPORT
 void write_image(const char * file_name,
   const int_t width,
   const int_t height,
-  intensity_t * intensities,
+  const intensity_t * intensities,
   const bool is_layout_right){
   // determine the file type based on the file_name
   Image_File_Type file_type = image_file_type(file_name);
@@ -572,6 +677,7 @@ void write_image(const char * file_name,
 
 Teuchos::RCP<DICe::cine::Cine_Reader>
 Image_Reader_Cache::cine_reader(const std::string & id){
+  std::lock_guard<std::mutex> lock(mutex_);
   if(cine_reader_map_.find(id)==cine_reader_map_.end()){
     Teuchos::RCP<DICe::cine::Cine_Reader> cine_reader = Teuchos::rcp(new DICe::cine::Cine_Reader(id,NULL));
     cine_reader_map_.insert(std::pair<std::string,Teuchos::RCP<DICe::cine::Cine_Reader> >(id,cine_reader));
@@ -56,6 +56,7 @@
 
 #include <string>
 #include <map>
+#include <mutex>
 
 namespace DICe{
 /*!
@@ -183,7 +184,7 @@ DICE_LIB_DLL_EXPORT
 void write_image(const char * file_name,
   const int_t width,
   const int_t height,
-  intensity_t * intensities,
+  const intensity_t * intensities,
   const bool is_layout_right = true);
 
 
@@ -197,8 +198,8 @@ DICE_LIB_DLL_EXPORT
 void write_color_overlap_image(const char * file_name,
   const int_t width,
   const int_t height,
-  intensity_t * bottom_intensities,
-  intensity_t * top_intensities);
+  const intensity_t * bottom_intensities,
+  const intensity_t * top_intensities);
 
 /// Read an image into the host memory returning an opencv Mat object
 /// \param file_name the name of the file
@@ -208,6 +209,8 @@ cv::Mat read_image(const char * file_name);
 // singleton class to keep track of image readers from high speed video or netcdf files:
 /// \class Image_Reader_Cache
 /// used for file reads and getting image dimensions without having to reload the header every time
+/// (there is one cache per process, the readers are shared by all the threads of the process, the
+/// lookups are guarded by the cache mutex and each reader guards its own filter set up)
 DICE_LIB_DLL_EXPORT
 class Image_Reader_Cache{
 public:
@@ -221,6 +224,11 @@ public:
   /// \param id the string name of the reader in case multiple headers are loaded (for example in stereo)
   /// if the reader doesn't exist, it gets created
   Teuchos::RCP<DICe::cine::Cine_Reader> cine_reader(const std::string & id);
+
+  /// mutex that guards the cached readers when images are read from more than one thread
+  std::mutex & mutex(){
+    return mutex_;
+  }
 private:
   /// constructor
   Image_Reader_Cache(){};
@@ -230,6 +238,8 @@ private:
   void operator=(Image_Reader_Cache const &);
   /// map of cine readers
   std::map<std::string,Teuchos::RCP<DICe::cine::Cine_Reader> > cine_reader_map_;
+  /// guards the reader map
+  std::mutex mutex_;
 };
 
 
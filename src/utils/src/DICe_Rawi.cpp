@@ -112,7 +112,7 @@ DICE_LIB_DLL_EXPORT
 void write_rawi_image(const char * file_name,
   const int_t width,
   const int_t height,
-  intensity_t * intensities,
+  const intensity_t * intensities,
   const bool is_layout_right){
   assert(width > 0);
   assert(height > 0);
@@ -136,12 +136,12 @@ void write_rawi_image(const char * file_name,
   for (int_t y=0; y<height; ++y) {
     if(is_layout_right){
       for (int_t x=0; x<width;++x){
-        rawi_file.write(reinterpret_cast<char*>(&intensities[y*width + x]),sizeof(intensity_t));
+        rawi_file.write(reinterpret_cast<const char*>(&intensities[y*width + x]),sizeof(intensity_t));
       }
     }
     else // otherwise assume layout left
       for (int_t x=0; x<width;++x){
-        rawi_file.write(reinterpret_cast<char*>(&intensities[x*height+y]),sizeof(intensity_t));
+        rawi_file.write(reinterpret_cast<const char*>(&intensities[x*height+y]),sizeof(intensity_t));
       }
   }
   rawi_file.close();
@@ -68,7 +68,7 @@ void read_rawi_image_dimensions(const char * file_name,
 /// \param is_layout_right [optional] memory layout is LayoutRight (row-major)
 DICE_LIB_DLL_EXPORT
 void read_rawi_image(const char * file_name,
-  intensity_t * intensities,
+  const intensity_t * intensities,
   const bool is_layout_right = true);
 
 /// write an image to disk
@@ -81,7 +81,7 @@ DICE_LIB_DLL_EXPORT
 void write_rawi_image(const char * file_name,
   const int_t width,
   const int_t height,
-  intensity_t * intensities,
+  const intensity_t * intensities,
   const bool is_layout_right = true);
 
 } // end namespace utils
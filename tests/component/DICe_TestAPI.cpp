@@ -53,7 +53,9 @@
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_RCP.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 int main(int argc, char *argv[]) {
 
@@ -236,6 +238,83 @@ int main(int argc, char *argv[]) {
 
   } // image loop
 
+  // test the batched api, the frames are split into two calls to check that the context keeps the solution between calls
+  *outStream << "testing the batched correlation context" << std::endl;
+  for(int_t subsetIt=0;subsetIt<num_subsets;++subsetIt){
+    for(int_t i=2;i<DICE_API_STRIDE;++i){
+      pointsParams[subsetIt*DICE_API_STRIDE+i] = 0.0;
+    }
+  }
+  dice_context context = dice_create_context(pointsParams,num_subsets,subset_size,ref_img.get(),ref_w,ref_h,params.getRawPtr());
+  if(context==0){
+    *outStream << "Error, the correlation context could not be created" << std::endl;
+    errorFlag++;
+  }
+  else{
+    std::vector<Teuchos::ArrayRCP<intensity_t> > def_intensities;
+    std::vector<intensity_t*> def_ptrs;
+    for(size_t img=0;img<def_names.size();++img){
+      Teuchos::RCP<DICe::Image> defImg = Teuchos::rcp( new DICe::Image(def_names[img].c_str()));
+      def_intensities.push_back(defImg->intensities());
+      def_ptrs.push_back(def_intensities[img].get());
+    }
+    const int_t num_frames = def_names.size();
+    const int_t first_batch = num_frames/2;
+    const int_t img_size = ref_w*ref_h;
+    std::vector<scalar_t> results(num_frames*num_subsets*DICE_API_STRIDE,-1.0);
+    // the first batch is passed in scratch copies that are overwritten once the call returns,
+    // the context must not hold on to the caller's buffers between calls
+    std::vector<std::vector<intensity_t> > scratch(first_batch+1);
+    std::vector<intensity_t*> scratch_ptrs(first_batch+1,(intensity_t*)0);
+    for(int_t frame=0;frame<=first_batch;++frame){
+      scratch[frame].assign(def_ptrs[frame],def_ptrs[frame]+img_size);
+      scratch_ptrs[frame] = &scratch[frame][0];
+    }
+    int_t batch_error = dice_correlate_frames(context,&scratch_ptrs[0],first_batch,ref_w,ref_h,&results[0]);
+    // a batch with a missing frame after a valid one should fail without correlating anything
+    std::vector<scalar_t> failed_results(2*num_subsets*DICE_API_STRIDE,-1.0);
+    std::vector<intensity_t*> failed_ptrs(2,(intensity_t*)0);
+    failed_ptrs[0] = scratch_ptrs[first_batch];
+    if(dice_correlate_frames(context,&failed_ptrs[0],2,ref_w,ref_h,&failed_results[0])!=-1){
+      *outStream << "Error, Batched, a null frame should return an error" << std::endl;
+      errorFlag++;
+    }
+    for(size_t i=0;i<scratch.size();++i){
+      std::fill(scratch[i].begin(),scratch[i].end(),0.0);
+      std::vector<intensity_t>().swap(scratch[i]);
+    }
+    batch_error += dice_correlate_frames(context,&def_ptrs[first_batch],num_frames-first_batch,ref_w,ref_h,
+      &results[first_batch*num_subsets*DICE_API_STRIDE]);
+    if(batch_error!=0){
+      *outStream << "Error, the batched correlation returned an error " << batch_error << std::endl;
+      errorFlag++;
+    }
+    for(int_t frame=0;frame<num_frames;++frame){
+      for(int_t i=0;i<num_subsets;++i){
+        const scalar_t * result = &results[(frame*num_subsets+i)*DICE_API_STRIDE];
+        *outStream << "     frame " << frame << " subset " << i << " x " << result[0] << " y " << result[1] <<
+            " u " << result[2] << " v " << result[3] << " theta " << result[4] << " gamma " << result[6] << std::endl;
+        if(std::abs(result[0] - subset_centroids_x[i]) > errtol || std::abs(result[1] - subset_centroids_y[i]) > errtol){
+          *outStream << "Error, Batched, coordinates are not correct for frame: " << frame << std::endl;
+          errorFlag++;
+        }
+        if(std::abs(result[2] - frame) > errtol || std::abs(result[3] - frame) > errtol){
+          *outStream << "Error, Batched, displacement is not correct for frame: " << frame << std::endl;
+          errorFlag++;
+        }
+        if(std::abs(result[4]) > errtol || std::abs(result[6]) > errtol){
+          *outStream << "Error, Batched, theta or gamma is not correct for frame: " << frame << std::endl;
+          errorFlag++;
+        }
+      }
+    }
+    // mismatched image dimensions should be rejected
+    if(dice_correlate_frames(context,&def_ptrs[0],1,ref_w+1,ref_h,&results[0])!=-1){
+      *outStream << "Error, Batched, invalid image dimensions should return an error" << std::endl;
+      errorFlag++;
+    }
+    dice_destroy_context(context);
+  }
 
   if (errorFlag != 0)
     std::cout << "End Result: TEST FAILED\n";
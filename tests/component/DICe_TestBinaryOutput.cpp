@@ -0,0 +1,168 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe.h>
+#include <DICe_BinaryOutput.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+
+#include <cstring>
+#include <iostream>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  int_t errorFlag  = 0;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  const int_t num_subsets = 57;
+  const int_t num_frames = 23;
+  const int_t first_frame_id = 4;
+  std::vector<std::string> field_names;
+  field_names.push_back("COORDINATE_X");
+  field_names.push_back("DISPLACEMENT_X");
+  field_names.push_back("SIGMA");
+  const int_t num_fields = field_names.size();
+  std::vector<int_t> subset_ids(num_subsets);
+  for(int_t i=0;i<num_subsets;++i)
+    subset_ids[i] = 3*i + 1;
+  // one slowly changing, one constant and one noisy field
+  std::vector<std::vector<scalar_t> > frame_values(num_frames,std::vector<scalar_t>(num_fields*num_subsets,0.0));
+  for(int_t frame=0;frame<num_frames;++frame){
+    for(int_t i=0;i<num_subsets;++i){
+      frame_values[frame][i] = 10.0*i;
+      frame_values[frame][num_subsets+i] = 0.0125*frame*(i%7);
+      frame_values[frame][2*num_subsets+i] = i%11==0 ? -1.0 : std::sin(1.3*i+0.7*frame);
+    }
+  }
+
+  const std::string file_names[2] = {"binary_output.dbin","binary_output_compressed.dbin"};
+  for(int_t c=0;c<2;++c){
+    const bool compress = c==1;
+    *outStream << "writing binary output " << file_names[c] << std::endl;
+    {
+      // chunk size chosen so the last chunk is partially full
+      Binary_Output_Writer writer(file_names[c],field_names,subset_ids,compress,5);
+      for(int_t frame=0;frame<num_frames;++frame)
+        writer.write_frame(first_frame_id+frame,frame_values[frame]);
+    } // the destructor writes the last chunk
+
+    *outStream << "reading binary output " << file_names[c] << std::endl;
+    Binary_Output_Reader reader(file_names[c]);
+    if(reader.num_fields()!=num_fields||reader.num_subsets()!=num_subsets||reader.num_frames()!=num_frames){
+      *outStream << "Error, the binary output has the wrong dimensions" << std::endl;
+      errorFlag++;
+      continue;
+    }
+    if(reader.field_names()!=field_names||reader.subset_ids()!=subset_ids){
+      *outStream << "Error, the binary output field names or subset ids are wrong" << std::endl;
+      errorFlag++;
+    }
+    if(reader.frame_ids()[0]!=first_frame_id||reader.frame_ids()[num_frames-1]!=first_frame_id+num_frames-1){
+      *outStream << "Error, the binary output frame ids are wrong" << std::endl;
+      errorFlag++;
+    }
+    // read a slice that spans parts of several chunks
+    const int_t slice_first = 3;
+    const int_t slice_frames = 14;
+    int_t num_mismatch = 0;
+    for(int_t field=0;field<num_fields;++field){
+      std::vector<scalar_t> values;
+      reader.read_field(field,slice_first,slice_frames,values);
+      for(int_t frame=0;frame<slice_frames;++frame)
+        for(int_t i=0;i<num_subsets;++i)
+          if(values[frame*num_subsets+i]!=(scalar_t)(float)frame_values[slice_first+frame][field*num_subsets+i])
+            num_mismatch++;
+    }
+    *outStream << "number of values that differ: " << num_mismatch << std::endl;
+    if(num_mismatch>0){
+      *outStream << "Error, the values read from the binary output do not match the values written" << std::endl;
+      errorFlag++;
+    }
+    if(reader.field_index("SIGMA")!=2||reader.field_index("NO_SUCH_FIELD")!=-1){
+      *outStream << "Error, field_index() returned the wrong index" << std::endl;
+      errorFlag++;
+    }
+  }
+
+  *outStream << "testing the block compression with incompressible values" << std::endl;
+  std::vector<float> noise(num_frames*num_subsets);
+  uint32_t state = 12345;
+  for(size_t i=0;i<noise.size();++i){
+    state = state*1664525u + 1013904223u;
+    std::memcpy(&noise[i],&state,sizeof(float));
+  }
+  std::vector<char> compressed;
+  binary_output::compress_block(num_frames,num_subsets,&noise[0],compressed);
+  std::vector<float> decompressed(noise.size());
+  binary_output::decompress_block(num_frames,num_subsets,&compressed[0],compressed.size(),&decompressed[0]);
+  if(std::memcmp(&noise[0],&decompressed[0],noise.size()*sizeof(float))!=0){
+    *outStream << "Error, the block compression is not lossless" << std::endl;
+    errorFlag++;
+  }
+  *outStream << "compressed size " << compressed.size() << " raw size " << noise.size()*sizeof(float) << std::endl;
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
+
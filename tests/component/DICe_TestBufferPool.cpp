@@ -0,0 +1,199 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe.h>
+#include <DICe_BufferPool.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+
+#include <iostream>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  int_t errorFlag  = 0;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  buffer_pool::clear();
+  const size_t num_values = 2*buffer_pool::min_pooled_bytes/sizeof(scalar_t);
+
+  *outStream << "testing that a released buffer is reused" << std::endl;
+  const size_t reused_before = buffer_pool::num_reused();
+  scalar_t * first_ptr = NULL;
+  {
+    Teuchos::ArrayRCP<scalar_t> first = buffer_pool::array<scalar_t>(num_values,1.0);
+    first_ptr = first.getRawPtr();
+    if(first.size()!=(int_t)num_values||first[0]!=1.0||first[num_values-1]!=1.0){
+      *outStream << "Error, the pooled array was not initialized" << std::endl;
+      errorFlag++;
+    }
+    first[10] = 5.0;
+  }
+  if(buffer_pool::cached_bytes()!=num_values*sizeof(scalar_t)){
+    *outStream << "Error, the released buffer should be cached, cached bytes " << buffer_pool::cached_bytes() << std::endl;
+    errorFlag++;
+  }
+  Teuchos::ArrayRCP<scalar_t> second = buffer_pool::array<scalar_t>(num_values,0.0);
+  if(second.getRawPtr()!=first_ptr||buffer_pool::num_reused()!=reused_before+1){
+    *outStream << "Error, the cached buffer was not reused" << std::endl;
+    errorFlag++;
+  }
+  if(second[10]!=0.0){
+    *outStream << "Error, the reused buffer was not re-initialized" << std::endl;
+    errorFlag++;
+  }
+  if(buffer_pool::cached_bytes()!=0){
+    *outStream << "Error, the cache should be empty while the buffer is in use" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing that small arrays are not pooled" << std::endl;
+  {
+    Teuchos::ArrayRCP<scalar_t> small = buffer_pool::array<scalar_t>(16,2.0);
+    if(small.size()!=16||small[15]!=2.0){
+      *outStream << "Error, small array was not initialized" << std::endl;
+      errorFlag++;
+    }
+  }
+  if(buffer_pool::cached_bytes()!=0){
+    *outStream << "Error, small arrays should not be cached" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing the cache limit" << std::endl;
+  buffer_pool::set_max_cached_bytes(num_values*sizeof(scalar_t));
+  {
+    Teuchos::ArrayRCP<scalar_t> a = buffer_pool::array<scalar_t>(num_values,0.0);
+    Teuchos::ArrayRCP<scalar_t> b = buffer_pool::array<scalar_t>(num_values,0.0);
+  }
+  if(buffer_pool::cached_bytes()!=num_values*sizeof(scalar_t)){
+    *outStream << "Error, the cache should be limited to one buffer, cached bytes " << buffer_pool::cached_bytes() << std::endl;
+    errorFlag++;
+  }
+  buffer_pool::set_max_cached_bytes(0);
+  if(buffer_pool::cached_bytes()!=0){
+    *outStream << "Error, lowering the limit should free the cached buffers" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing the size classes" << std::endl;
+  const size_t class_bytes = num_values*sizeof(scalar_t);
+  if(buffer_pool::size_class(class_bytes)!=class_bytes||buffer_pool::size_class(class_bytes+1)!=class_bytes+class_bytes/4
+      ||buffer_pool::size_class(16)!=16){
+    *outStream << "Error, unexpected size class " << buffer_pool::size_class(class_bytes+1) << std::endl;
+    errorFlag++;
+  }
+  buffer_pool::set_max_cached_bytes(buffer_pool::default_max_cached_bytes);
+  scalar_t * class_ptr = NULL;
+  {
+    Teuchos::ArrayRCP<scalar_t> a = buffer_pool::array<scalar_t>(num_values,0.0);
+    class_ptr = a.getRawPtr();
+  }
+  {
+    // a slightly smaller image falls in the same size class
+    Teuchos::ArrayRCP<scalar_t> b = buffer_pool::array<scalar_t>(num_values-100,0.0);
+    if(b.getRawPtr()!=class_ptr||b.size()!=(int_t)num_values-100){
+      *outStream << "Error, a request in the same size class should reuse the cached buffer" << std::endl;
+      errorFlag++;
+    }
+  }
+  buffer_pool::clear();
+
+  *outStream << "testing that the least recently released buffer is evicted" << std::endl;
+  const size_t larger_values = num_values + num_values/4;
+  buffer_pool::set_max_cached_bytes(class_bytes + larger_values*sizeof(scalar_t));
+  scalar_t * recent_ptr = NULL;
+  {
+    Teuchos::ArrayRCP<scalar_t> oldest = buffer_pool::array<scalar_t>(num_values,0.0);
+    Teuchos::ArrayRCP<scalar_t> larger = buffer_pool::array<scalar_t>(larger_values,0.0);
+    Teuchos::ArrayRCP<scalar_t> recent = buffer_pool::array<scalar_t>(num_values,0.0);
+    recent_ptr = recent.getRawPtr();
+    oldest = Teuchos::null;
+    larger = Teuchos::null;
+    recent = Teuchos::null;
+  }
+  if(buffer_pool::cached_bytes()!=class_bytes + larger_values*sizeof(scalar_t)){
+    *outStream << "Error, the oldest buffer should have been evicted, cached bytes " << buffer_pool::cached_bytes() << std::endl;
+    errorFlag++;
+  }
+  {
+    Teuchos::ArrayRCP<scalar_t> again = buffer_pool::array<scalar_t>(num_values,0.0);
+    if(again.getRawPtr()!=recent_ptr){
+      *outStream << "Error, the most recently released buffer should have been kept" << std::endl;
+      errorFlag++;
+    }
+  }
+  buffer_pool::set_max_cached_bytes(buffer_pool::default_max_cached_bytes);
+
+  {
+    Teuchos::ArrayRCP<scalar_t> cached = buffer_pool::array<scalar_t>(num_values,0.0);
+  }
+  buffer_pool::clear();
+  if(buffer_pool::cached_bytes()!=0){
+    *outStream << "Error, clear() should free the cached buffers" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
@@ -48,6 +48,8 @@
 #include <Teuchos_ParameterList.hpp>
 
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 using namespace DICe;
 
@@ -266,6 +268,74 @@ int main(int argc, char *argv[]) {
   }
   *outStream << "16 bit motion window values have been checked" << std::endl;
 
+  *outStream << "testing memory mapped frame access against stream access" << std::endl;
+  bool mapped_value_error = false;
+  for(size_t i=0;i<cine_files.size();++i){
+    std::stringstream full_name;
+    full_name << "./images/" << cine_files[i] << ".cine";
+    DICe::cine::Cine_Reader mapped_reader(full_name.str(),outStream.getRawPtr(),true);
+    DICe::cine::Cine_Reader stream_reader(full_name.str(),outStream.getRawPtr(),false);
+    *outStream << "cine file: " << full_name.str() << " memory mapped: " << mapped_reader.is_memory_mapped() << std::endl;
+    if(stream_reader.is_memory_mapped()){
+      *outStream << "Error, the stream reader should not be memory mapped" << std::endl;
+      errorFlag++;
+    }
+    const int_t mw = mapped_reader.width();
+    const int_t mh = mapped_reader.height();
+    // full frames and a sub window for every frame
+    const int_t win_x = 16, win_y = 30, win_w = 40, win_h = 24;
+    Teuchos::ArrayRCP<intensity_t> mapped_intens(mw*mh,0.0);
+    Teuchos::ArrayRCP<intensity_t> stream_intens(mw*mh,0.0);
+    for(int_t frame=0;frame<mapped_reader.num_frames();++frame){
+      mapped_reader.get_frame(0,0,mw,mh,mapped_intens.getRawPtr(),true,frame);
+      stream_reader.get_frame(0,0,mw,mh,stream_intens.getRawPtr(),true,frame);
+      for(int_t j=0;j<mw*mh;++j)
+        if(mapped_intens[j]!=stream_intens[j]) mapped_value_error = true;
+      mapped_reader.get_frame(win_x,win_y,win_w,win_h,mapped_intens.getRawPtr(),true,frame);
+      stream_reader.get_frame(win_x,win_y,win_w,win_h,stream_intens.getRawPtr(),true,frame);
+      for(int_t j=0;j<win_w*win_h;++j)
+        if(mapped_intens[j]!=stream_intens[j]) mapped_value_error = true;
+    }
+  }
+  if(mapped_value_error){
+    *outStream << "Error, the memory mapped intensity values do not match the stream values" << std::endl;
+    errorFlag++;
+  }
+  *outStream << "memory mapped frame values have been checked" << std::endl;
+
+  // the readers in the cache are shared by the threads, frames read while another thread reinitializes
+  // the conversion factor have to come out the same as a serial read
+  *outStream << "testing threaded cine reads with a reinitialization in between" << std::endl;
+  std::stringstream threaded_name;
+  threaded_name << "./images/phantom_v1610_16bpp_" << 3 + cine_reader_16.first_image_number() << ".cine";
+  Teuchos::RCP<Teuchos::ParameterList> reinit_params = Teuchos::rcp(new Teuchos::ParameterList());
+  reinit_params->set(DICe::filter_failed_cine_pixels,false);
+  reinit_params->set(DICe::convert_cine_to_8_bit,true);
+  reinit_params->set(DICe::reinitialize_cine_reader_conversion_factor,true);
+  Teuchos::RCP<Teuchos::ParameterList> read_params = Teuchos::rcp(new Teuchos::ParameterList(*reinit_params));
+  read_params->set(DICe::reinitialize_cine_reader_conversion_factor,false);
+  const int_t threaded_w = cine_reader_16.width();
+  const int_t threaded_h = cine_reader_16.height();
+  std::vector<intensity_t> threaded_exact(threaded_w*threaded_h,0.0);
+  DICe::utils::read_image(threaded_name.str().c_str(),&threaded_exact[0],reinit_params);
+  const int_t num_threaded_reads = 32;
+  std::vector<int_t> threaded_read_errors(num_threaded_reads,0);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(4) schedule(dynamic)
+#endif
+  for(int_t i=0;i<num_threaded_reads;++i){
+    std::vector<intensity_t> intensities(threaded_w*threaded_h,0.0);
+    DICe::utils::read_image(threaded_name.str().c_str(),&intensities[0],i%4==0 ? reinit_params : read_params);
+    for(int_t j=0;j<threaded_w*threaded_h;++j)
+      if(intensities[j]!=threaded_exact[j]) threaded_read_errors[i] = 1;
+  }
+  for(int_t i=0;i<num_threaded_reads;++i){
+    if(threaded_read_errors[i]!=0){
+      *outStream << "Error, threaded cine read " << i << " does not match the serial read" << std::endl;
+      errorFlag++;
+    }
+  }
+
 
   int_t test_w = 0;
   int_t test_h = 0;
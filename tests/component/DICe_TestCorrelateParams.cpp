@@ -133,6 +133,7 @@ int main(int argc, char *argv[]) {
   opt_methods.push_back(DICe::SIMPLEX_THEN_GRADIENT_BASED);
   opt_methods.push_back(DICe::GRADIENT_BASED);
   opt_methods.push_back(DICe::GRADIENT_BASED_THEN_SIMPLEX);
+  opt_methods.push_back(DICe::INVERSE_COMPOSITIONAL);
 
   std::vector<DICe::Interpolation_Method> interp_methods;
   interp_methods.push_back(DICe::BILINEAR);
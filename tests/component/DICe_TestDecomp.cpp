@@ -46,11 +46,14 @@
 #include <DICe.h>
 #include <DICe_Decomp.h>
 #include <DICe_Parser.h>
+#include <DICe_PostProcessor.h>
 
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_XMLParameterListHelpers.hpp>
 
 #include <iostream>
+#include <algorithm>
+#include <vector>
 
 using namespace DICe;
 
@@ -118,6 +121,156 @@ int main(int argc, char *argv[]) {
     *outStream << "Error, wrong number of global subsets" << std::endl;
   }
 
+  *outStream << "testing the space filling curve keys" << std::endl;
+  if(morton_key(3,5)!=39){
+    errorFlag++;
+    *outStream << "Error, wrong Morton key" << std::endl;
+  }
+  // the first 64x64 keys of the Hilbert curve fill the 64x64 block at the origin and each step moves one pixel
+  const int_t block = 64;
+  std::vector<int_t> curve_x(block*block,-1), curve_y(block*block,-1);
+  bool hilbert_error = false;
+  for(int_t y=0;y<block;++y){
+    for(int_t x=0;x<block;++x){
+      const uint64_t key = hilbert_key(x,y);
+      if(key>=(uint64_t)(block*block)||curve_x[key]>=0){
+        hilbert_error = true;
+        continue;
+      }
+      curve_x[key] = x;
+      curve_y[key] = y;
+    }
+  }
+  for(int_t i=1;i<block*block&&!hilbert_error;++i){
+    if(std::abs(curve_x[i]-curve_x[i-1]) + std::abs(curve_y[i]-curve_y[i-1])!=1)
+      hilbert_error = true;
+  }
+  if(hilbert_error){
+    errorFlag++;
+    *outStream << "Error, the Hilbert keys do not form a continuous curve" << std::endl;
+  }
+
+  *outStream << "testing the Hilbert curve decomposition" << std::endl;
+  const int_t num_grid_pts = 20;
+  Teuchos::ArrayRCP<scalar_t> grid_x(num_grid_pts*num_grid_pts,0.0);
+  Teuchos::ArrayRCP<scalar_t> grid_y(num_grid_pts*num_grid_pts,0.0);
+  Teuchos::RCP<std::vector<int_t> > grid_neighbor_ids = Teuchos::rcp(new std::vector<int_t>(num_grid_pts*num_grid_pts,-1));
+  for(int_t i=0;i<num_grid_pts*num_grid_pts;++i){
+    grid_x[i] = 20 + 15*(i%num_grid_pts);
+    grid_y[i] = 20 + 15*(i/num_grid_pts);
+    if(i>0) (*grid_neighbor_ids)[i] = i-1;
+  }
+  Teuchos::RCP<Teuchos::ParameterList> hilbertParams = Teuchos::rcp(new Teuchos::ParameterList());
+  hilbertParams->set(DICe::decomposition_method,HILBERT_CURVE_DECOMPOSITION);
+  Teuchos::ParameterList vsg_sublist;
+  vsg_sublist.set(DICe::strain_window_size_in_pixels,31);
+  hilbertParams->set(DICe::post_process_vsg_strain,vsg_sublist);
+  Teuchos::RCP<Decomp> hilbert_decomp = Teuchos::rcp(new Decomp(grid_x,grid_y,grid_neighbor_ids,Teuchos::null,hilbertParams));
+  // every subset is owned by exactly one processor and the overlap coordinates follow the gids
+  const int_t num_local_grid_pts = hilbert_decomp->id_decomp_map()->get_num_local_elements();
+  const int_t num_overlap_grid_pts = hilbert_decomp->id_decomp_overlap_map()->get_num_local_elements();
+  if(hilbert_decomp->num_global_subsets()!=num_grid_pts*num_grid_pts||num_overlap_grid_pts<num_local_grid_pts
+      ||(int_t)hilbert_decomp->this_proc_gid_order().size()!=num_local_grid_pts){
+    errorFlag++;
+    *outStream << "Error, wrong number of subsets in the Hilbert curve decomposition" << std::endl;
+  }
+  for(int_t i=0;i<num_overlap_grid_pts;++i){
+    const int_t gid = hilbert_decomp->id_decomp_overlap_map()->get_global_element(i);
+    if(hilbert_decomp->overlap_coords_x()[i]!=grid_x[gid]||hilbert_decomp->overlap_coords_y()[i]!=grid_y[gid]
+        ||(*hilbert_decomp->neighbor_ids())[i]!=(*grid_neighbor_ids)[gid]){
+      errorFlag++;
+      *outStream << "Error, wrong overlap coordinates for subset " << gid << " in the Hilbert curve decomposition" << std::endl;
+      break;
+    }
+  }
+
+  // with the gids scattered over the grid the even split gives each processor points from all over the image,
+  // the Hilbert curve should give each processor a compact block and a smaller overlap
+  MultiField_Comm comm;
+  if(comm.get_size()>1){
+    *outStream << "comparing the compactness of the Hilbert curve and even split decompositions" << std::endl;
+    const int_t num_scattered_pts = num_grid_pts*num_grid_pts;
+    const int_t stride = 7; // relatively prime to the number of points so every grid position is used once
+    Teuchos::ArrayRCP<scalar_t> scattered_x(num_scattered_pts,0.0);
+    Teuchos::ArrayRCP<scalar_t> scattered_y(num_scattered_pts,0.0);
+    for(int_t i=0;i<num_scattered_pts;++i){
+      const int_t pos = (i*stride)%num_scattered_pts;
+      scattered_x[i] = 20 + 15*(pos%num_grid_pts);
+      scattered_y[i] = 20 + 15*(pos/num_grid_pts);
+    }
+    Teuchos::RCP<Teuchos::ParameterList> evenParams = Teuchos::rcp(new Teuchos::ParameterList());
+    evenParams->set(DICe::post_process_vsg_strain,vsg_sublist);
+    Teuchos::RCP<Decomp> even_decomp = Teuchos::rcp(new Decomp(scattered_x,scattered_y,Teuchos::null,Teuchos::null,evenParams));
+    Teuchos::RCP<Decomp> compact_decomp = Teuchos::rcp(new Decomp(scattered_x,scattered_y,Teuchos::null,Teuchos::null,hilbertParams));
+    // area of the bounding box of the points owned by this processor
+    scalar_t box_area[2] = {0.0,0.0};
+    Teuchos::RCP<Decomp> decomps[2] = {even_decomp,compact_decomp};
+    for(int_t d=0;d<2;++d){
+      const int_t num_owned = decomps[d]->id_decomp_map()->get_num_local_elements();
+      if(num_owned==0) continue;
+      scalar_t min_x = scattered_x[decomps[d]->id_decomp_map()->get_global_element(0)];
+      scalar_t min_y = scattered_y[decomps[d]->id_decomp_map()->get_global_element(0)];
+      scalar_t max_x = min_x, max_y = min_y;
+      for(int_t i=1;i<num_owned;++i){
+        const int_t gid = decomps[d]->id_decomp_map()->get_global_element(i);
+        min_x = std::min(min_x,scattered_x[gid]);
+        max_x = std::max(max_x,scattered_x[gid]);
+        min_y = std::min(min_y,scattered_y[gid]);
+        max_y = std::max(max_y,scattered_y[gid]);
+      }
+      box_area[d] = (max_x-min_x)*(max_y-min_y);
+    }
+    const int_t num_compact_owned = compact_decomp->id_decomp_map()->get_num_local_elements();
+    const scalar_t grid_area = 15.0*15.0*(num_grid_pts-1)*(num_grid_pts-1);
+    // a stretch of the curve covers a few times its share of the grid at most
+    if(num_compact_owned>0&&(box_area[1]>=box_area[0]||box_area[1]>4.0*grid_area*num_compact_owned/num_scattered_pts)){
+      errorFlag++;
+      *outStream << "Error, the Hilbert curve subsets are not spatially compact on this processor, bounding box area "
+          << box_area[1] << " even split area " << box_area[0] << std::endl;
+    }
+    if(compact_decomp->id_decomp_overlap_map()->get_num_local_elements()>=even_decomp->id_decomp_overlap_map()->get_num_local_elements()){
+      errorFlag++;
+      *outStream << "Error, the Hilbert curve overlap map (" << compact_decomp->id_decomp_overlap_map()->get_num_local_elements()
+          << " subsets) should be smaller than the even split overlap map ("
+          << even_decomp->id_decomp_overlap_map()->get_num_local_elements() << " subsets)" << std::endl;
+    }
+  }
+
+  *outStream << "testing the decomposition that moves subsets to new owners" << std::endl;
+  // deal the subsets out round robin starting from the Hilbert curve ownership
+  Teuchos::RCP<MultiField> moving_data = Teuchos::rcp(new MultiField(hilbert_decomp->id_decomp_map(),4,true));
+  std::vector<int_t> dest_procs(num_local_grid_pts,0);
+  for(int_t i=0;i<num_local_grid_pts;++i){
+    const int_t gid = hilbert_decomp->id_decomp_map()->get_global_element(i);
+    moving_data->local_value(i,0) = grid_x[gid];
+    moving_data->local_value(i,1) = grid_y[gid];
+    moving_data->local_value(i,2) = gid;
+    moving_data->local_value(i,3) = (*grid_neighbor_ids)[gid];
+    dest_procs[i] = gid % comm.get_size();
+  }
+  Teuchos::RCP<Decomp> moved_decomp = Teuchos::rcp(new Decomp(moving_data,dest_procs,hilbertParams));
+  const int_t num_moved_pts = moved_decomp->id_decomp_map()->get_num_local_elements();
+  if(moved_decomp->num_global_subsets()!=num_grid_pts*num_grid_pts||(int_t)moved_decomp->this_proc_gid_order().size()!=num_moved_pts){
+    errorFlag++;
+    *outStream << "Error, wrong number of subsets after moving them to new owners" << std::endl;
+  }
+  for(int_t i=0;i<num_moved_pts;++i){
+    if(moved_decomp->id_decomp_map()->get_global_element(i) % comm.get_size()!=comm.get_rank()){
+      errorFlag++;
+      *outStream << "Error, subset " << moved_decomp->id_decomp_map()->get_global_element(i) << " did not move to the right owner" << std::endl;
+      break;
+    }
+  }
+  for(int_t i=0;i<moved_decomp->id_decomp_overlap_map()->get_num_local_elements();++i){
+    const int_t gid = moved_decomp->id_decomp_overlap_map()->get_global_element(i);
+    if(moved_decomp->overlap_coords_x()[i]!=grid_x[gid]||moved_decomp->overlap_coords_y()[i]!=grid_y[gid]
+        ||(*moved_decomp->neighbor_ids())[i]!=(*grid_neighbor_ids)[gid]){
+      errorFlag++;
+      *outStream << "Error, wrong overlap coordinates for subset " << gid << " after moving the subsets" << std::endl;
+      break;
+    }
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
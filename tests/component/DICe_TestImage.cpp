@@ -41,14 +41,17 @@
 
 #include <DICe.h>
 #include <DICe_Image.h>
+#include <DICe_ImageIO.h>
 #include <DICe_Shape.h>
 #include <DICe_LocalShapeFunction.h>
+#include <DICe_NodeImageReader.h>
 
 #include <Teuchos_RCP.hpp>
 #include <Teuchos_oblackholestream.hpp>
 #include <Teuchos_ParameterList.hpp>
 
 #include <iostream>
+#include <vector>
 
 using namespace DICe;
 
@@ -442,6 +445,188 @@ int main(int argc, char *argv[]) {
   }
   *outStream << "hierarchical image filter has been checked" << std::endl;
 
+#if !DICE_KOKKOS
+  *outStream << "comparing the single sweep filter and gradients to a direct convolution reference" << std::endl;
+  Teuchos::RCP<Teuchos::ParameterList> fused_params = rcp(new Teuchos::ParameterList());
+  fused_params->set(DICe::gauss_filter_images,true);
+  fused_params->set(DICe::gauss_filter_mask_size,7);
+  fused_params->set(DICe::compute_image_gradients,true);
+  fused_params->set(DICe::gradient_method,DICe::CONVOLUTION_5_POINT);
+  Image fused_img("./images/ImageB.tif",fused_params);
+  // independent reference: a plain 2D convolution with the 7 point Gauss mask, fourth order finite difference
+  // gradients and the 5 point smoothing convolution, written out directly so it shares no code with the image filters
+  Image raw_img("./images/ImageB.tif");
+  const int_t ref_w = raw_img.width();
+  const int_t ref_h = raw_img.height();
+  const scalar_t ref_gauss[] = {0.0060, 0.0606, 0.2418, 0.3831, 0.2418, 0.0606, 0.0060};
+  const int_t ref_half_mask = 7/2+1;
+  std::vector<scalar_t> ref_int(ref_w*ref_h,0.0);
+  for(int_t y=0;y<ref_h;++y){
+    for(int_t x=0;x<ref_w;++x){
+      if(x>=ref_half_mask&&x<ref_w-ref_half_mask&&y>=ref_half_mask&&y<ref_h-ref_half_mask){
+        scalar_t value = 0.0;
+        for(int_t i=0;i<7;++i)
+          for(int_t j=0;j<7;++j)
+            value += ref_gauss[i]*ref_gauss[j]*raw_img(x+i-3,y+j-3);
+        ref_int[y*ref_w+x] = value;
+      }
+      else
+        ref_int[y*ref_w+x] = raw_img(x,y);
+    }
+  }
+  const scalar_t ref_c1 = 1.0/12.0;
+  const scalar_t ref_c2 = -8.0/12.0;
+  std::vector<scalar_t> ref_gx(ref_w*ref_h,0.0);
+  std::vector<scalar_t> ref_gy(ref_w*ref_h,0.0);
+  for(int_t y=0;y<ref_h;++y){
+    for(int_t x=0;x<ref_w;++x){
+      const int_t p = y*ref_w+x;
+      if(x<2) ref_gx[p] = ref_int[p+1] - ref_int[p];
+      else if(x>=ref_w-2) ref_gx[p] = ref_int[p] - ref_int[p-1];
+      else ref_gx[p] = ref_c1*ref_int[p-2] + ref_c2*ref_int[p-1] - ref_c2*ref_int[p+1] - ref_c1*ref_int[p+2];
+      if(y<2) ref_gy[p] = ref_int[p+ref_w] - ref_int[p];
+      else if(y>=ref_h-2) ref_gy[p] = ref_int[p] - ref_int[p-ref_w];
+      else ref_gy[p] = ref_c1*ref_int[p-2*ref_w] + ref_c2*ref_int[p-ref_w] - ref_c2*ref_int[p+ref_w] - ref_c1*ref_int[p+2*ref_w];
+    }
+  }
+  const scalar_t ref_smooth[] = {0.0625, 0.25, 0.375, 0.25, 0.0625};
+  std::vector<scalar_t> ref_sgx(ref_gx);
+  std::vector<scalar_t> ref_sgy(ref_gy);
+  for(int_t y=2;y<ref_h-2;++y){
+    for(int_t x=2;x<ref_w-2;++x){
+      scalar_t value_x = 0.0, value_y = 0.0;
+      for(int_t i=0;i<5;++i){
+        for(int_t j=0;j<5;++j){
+          value_x += ref_smooth[i]*ref_smooth[j]*ref_gx[(y+i-2)*ref_w+x+j-2];
+          value_y += ref_smooth[i]*ref_smooth[j]*ref_gy[(y+i-2)*ref_w+x+j-2];
+        }
+      }
+      ref_sgx[y*ref_w+x] = value_x;
+      ref_sgy[y*ref_w+x] = value_y;
+    }
+  }
+  bool fused_error = false;
+  for(int_t y=0;y<fused_img.height();++y){
+    for(int_t x=0;x<fused_img.width();++x){
+      if(std::abs(fused_img(x,y) - ref_int[y*ref_w+x]) > grad_tol)
+        fused_error = true;
+      if(std::abs(fused_img.grad_x(x,y) - ref_sgx[y*ref_w+x]) > grad_tol)
+        fused_error = true;
+      if(std::abs(fused_img.grad_y(x,y) - ref_sgy[y*ref_w+x]) > grad_tol)
+        fused_error = true;
+    }
+  }
+  if(!fused_img.has_gauss_filter()||!fused_img.has_gradients())
+    fused_error = true;
+  if(fused_error){
+    *outStream << "Error, the single sweep filter and gradients do not match the direct convolution reference" << std::endl;
+    errorFlag++;
+  }
+  *outStream << "single sweep filter and gradients have been checked" << std::endl;
+
+  *outStream << "comparing compact image storage to full precision" << std::endl;
+  bool compact_error = false;
+  for(int_t filter=0;filter<2;++filter){
+    Teuchos::RCP<Teuchos::ParameterList> full_params = rcp(new Teuchos::ParameterList());
+    full_params->set(DICe::gauss_filter_images,filter==1);
+    full_params->set(DICe::compute_image_gradients,true);
+    Teuchos::RCP<Teuchos::ParameterList> compact_params = rcp(new Teuchos::ParameterList(*full_params));
+    compact_params->set(DICe::compact_image_storage,true);
+    Image full_img("./images/ImageB.tif",full_params);
+    Image compact_img("./images/ImageB.tif",compact_params);
+    if(!compact_img.is_compact()){
+      *outStream << "Error, the image should be using compact storage" << std::endl;
+      compact_error = true;
+    }
+    // the unfiltered image is stored exactly (8 bit), the filtered one is quantized to 16 bits
+    const scalar_t intensity_tol = filter==1 ? 0.01 : 1.0E-3;
+    const scalar_t compact_grad_tol = 0.05;
+    for(int_t y=0;y<full_img.height();++y){
+      for(int_t x=0;x<full_img.width();++x){
+        if(std::abs(full_img(x,y) - compact_img(x,y)) > intensity_tol)
+          compact_error = true;
+        if(std::abs(full_img.grad_x(x,y) - compact_img.grad_x(x,y)) > compact_grad_tol)
+          compact_error = true;
+      }
+    }
+    const DICe::Interpolation_Method methods[] = {DICe::BILINEAR,DICe::BICUBIC,DICe::KEYS_FOURTH};
+    for(int_t m=0;m<3;++m){
+      for(scalar_t y=0.25;y<full_img.height()-1.0;y+=3.7){
+        for(scalar_t x=0.5;x<full_img.width()-1.0;x+=2.3){
+          intensity_t full_val = 0.0, compact_val = 0.0;
+          scalar_t full_gx = 0.0, full_gy = 0.0, compact_gx = 0.0, compact_gy = 0.0;
+          full_img.interpolate_all(1,&x,&y,NULL,&full_val,&full_gx,&full_gy,true,methods[m]);
+          compact_img.interpolate_all(1,&x,&y,NULL,&compact_val,&compact_gx,&compact_gy,true,methods[m]);
+          if(std::abs(full_val - compact_val) > intensity_tol||std::abs(full_gx - compact_gx) > compact_grad_tol
+              ||std::abs(full_gy - compact_gy) > compact_grad_tol){
+            *outStream << "Error, compact interpolation " << methods[m] << " at " << x << " " << y << " full " << full_val
+                << " " << full_gx << " " << full_gy << " compact " << compact_val << " " << compact_gx << " " << compact_gy << std::endl;
+            compact_error = true;
+          }
+        }
+      }
+    }
+    // the decoded arrays are read-only, the mutable accessors refuse compact images
+    Teuchos::ArrayRCP<const intensity_t> decoded = compact_img.decoded_intensities();
+    if(std::abs(decoded[10*full_img.width()+10] - full_img(10,10)) > intensity_tol)
+      compact_error = true;
+    bool mutable_access_thrown = false;
+    try{
+      compact_img.intensities();
+    }
+    catch(std::exception &){
+      mutable_access_thrown = true;
+    }
+    if(!mutable_access_thrown){
+      *outStream << "Error, the mutable intensity accessor should throw for a compact image" << std::endl;
+      compact_error = true;
+    }
+    compact_img.expand();
+    if(compact_img.is_compact()||std::abs(full_img(10,10) - compact_img(10,10)) > intensity_tol){
+      *outStream << "Error, the compact image was not expanded correctly" << std::endl;
+      compact_error = true;
+    }
+  }
+  if(compact_error){
+    *outStream << "Error, compact image storage does not match full precision" << std::endl;
+    errorFlag++;
+  }
+  *outStream << "compact image storage has been checked" << std::endl;
+
+  *outStream << "comparing the tiled image layout to the row major layout" << std::endl;
+  {
+    Teuchos::RCP<Teuchos::ParameterList> row_params = rcp(new Teuchos::ParameterList());
+    row_params->set(DICe::compute_image_gradients,true);
+    Teuchos::RCP<Teuchos::ParameterList> tiled_params = rcp(new Teuchos::ParameterList(*row_params));
+    tiled_params->set(DICe::tiled_image_layout,true);
+    Image row_img("./images/ImageB.tif",row_params);
+    Image tiled_img("./images/ImageB.tif",tiled_params);
+    bool tiled_error = !tiled_img.has_tiled_layout()||row_img.has_tiled_layout();
+    for(scalar_t y=0.25;y<row_img.height()-1.0;y+=1.7){
+      for(scalar_t x=0.5;x<row_img.width()-1.0;x+=1.3){
+        intensity_t row_val = 0.0, tiled_val = 0.0;
+        scalar_t row_gx = 0.0, row_gy = 0.0, tiled_gx = 0.0, tiled_gy = 0.0;
+        row_img.interpolate_all(1,&x,&y,NULL,&row_val,&row_gx,&row_gy,true,DICe::KEYS_FOURTH);
+        tiled_img.interpolate_all(1,&x,&y,NULL,&tiled_val,&tiled_gx,&tiled_gy,true,DICe::KEYS_FOURTH);
+        if(std::abs(row_val - tiled_val) > 1.0E-4||std::abs(row_gx - tiled_gx) > 1.0E-4||std::abs(row_gy - tiled_gy) > 1.0E-4){
+          *outStream << "Error, tiled interpolation at " << x << " " << y << " row major " << row_val
+              << " " << row_gx << " " << row_gy << " tiled " << tiled_val << " " << tiled_gx << " " << tiled_gy << std::endl;
+          tiled_error = true;
+        }
+      }
+    }
+    // changing the gradients in place has to discard the tiles
+    tiled_img.compute_gradients();
+    if(tiled_img.has_tiled_layout())
+      tiled_error = true;
+    if(tiled_error){
+      *outStream << "Error, the tiled image layout does not match the row major layout" << std::endl;
+      errorFlag++;
+    }
+  }
+  *outStream << "tiled image layout has been checked" << std::endl;
+#endif
+
   // create an image from jpeg file:
   *outStream << "creating an image from a jpeg file " << std::endl;
   Teuchos::RCP<Image> img_jpg = Teuchos::rcp(new Image("./images/ImageB.jpg"));
@@ -533,6 +718,98 @@ int main(int argc, char *argv[]) {
     errorFlag++;
   }
 
+  // the dimensions are read from the file headers without decoding the images
+  *outStream << "reading image dimensions from the headers" << std::endl;
+  const int_t num_dim_files = 4;
+  const std::string dim_files[num_dim_files] = {"./images/ImageB.tif","./images/ImageB.png","./images/ImageB.jpg","./images/ImageA.tif"};
+  const int_t dim_widths[num_dim_files] = {240,240,240,2048};
+  const int_t dim_heights[num_dim_files] = {161,161,161,589};
+  for(int_t i=0;i<num_dim_files;++i){
+    int_t dim_w = 0, dim_h = 0;
+    DICe::utils::read_image_dimensions(dim_files[i].c_str(),dim_w,dim_h);
+    if(dim_w!=dim_widths[i]||dim_h!=dim_heights[i]){
+      *outStream << "Error, the dimensions read for " << dim_files[i] << " are not correct: " << dim_w << " x " << dim_h << std::endl;
+      errorFlag++;
+    }
+  }
+
+  // an image can adopt arrays that already hold the intensities and gradients (used for the node shared images)
+  *outStream << "creating an image from precomputed arrays" << std::endl;
+  Teuchos::RCP<Teuchos::ParameterList> shared_params = rcp(new Teuchos::ParameterList());
+  shared_params->set(DICe::compute_image_gradients,true);
+  Teuchos::RCP<Image> shared_src = Teuchos::rcp(new Image("./images/ImageB.tif",20,10,100,80,shared_params));
+  Teuchos::ArrayRCP<scalar_t> shared_mask(shared_src->num_pixels(),1.0);
+  Teuchos::RCP<Image> adopted = Teuchos::rcp(new Image(shared_src->width(),shared_src->height(),shared_src->intensities(),
+    shared_src->grad_x_array(),shared_src->grad_y_array(),shared_mask,true,false,Teuchos::null,20,10,"./images/ImageB.tif"));
+  if(adopted->intensities().getRawPtr()!=shared_src->intensities().getRawPtr()||adopted->offset_x()!=20||adopted->offset_y()!=10
+      ||!adopted->has_gradients()||!adopted->has_file_name()){
+    *outStream << "Error, the image did not adopt the arrays" << std::endl;
+    errorFlag++;
+  }
+  if(adopted->diff(shared_src) > 1.0E-5||std::abs(adopted->grad_x(50,40)-shared_src->grad_x(50,40)) > 1.0E-5){
+    *outStream << "Error, the adopted image values are not correct" << std::endl;
+    errorFlag++;
+  }
+  // the arrays belong to another image so the in place operations have to throw and leave the values alone
+  if(!adopted->is_adopted()||shared_src->is_adopted()){
+    *outStream << "Error, only the adopting image should be flagged as adopted" << std::endl;
+    errorFlag++;
+  }
+  const intensity_t adopted_value = (*adopted)(50,40);
+  const scalar_t adopted_grad = adopted->grad_x(50,40);
+  for(int_t op=0;op<3;++op){
+    bool in_place_thrown = false;
+    try{
+      if(op==0) adopted->gauss_filter();
+      else if(op==1) adopted->compute_gradients();
+      else adopted->apply_mask(false);
+    }
+    catch(std::exception &){
+      in_place_thrown = true;
+    }
+    if(!in_place_thrown){
+      *outStream << "Error, in place operation " << op << " should have thrown for an adopted image" << std::endl;
+      errorFlag++;
+    }
+  }
+  if((*adopted)(50,40)!=adopted_value||adopted->grad_x(50,40)!=adopted_grad){
+    *outStream << "Error, the adopted image values were modified" << std::endl;
+    errorFlag++;
+  }
+
+  // reading through the node reader gives the same image as a direct read (the window can grow to cover the other processes on the node)
+  *outStream << "reading an image shared between the processes on the node" << std::endl;
+  Teuchos::RCP<Node_Image_Reader> node_reader = Teuchos::rcp(new Node_Image_Reader());
+  Teuchos::RCP<Image> node_img = node_reader->read("./images/ImageB.tif",20,10,100,80,shared_params);
+  if(node_img->offset_x()>20||node_img->offset_y()>10||node_img->offset_x()+node_img->width()<120||node_img->offset_y()+node_img->height()<90){
+    *outStream << "Error, the shared image does not cover the requested window" << std::endl;
+    errorFlag++;
+  }
+  Teuchos::RCP<Image> node_exact = Teuchos::rcp(new Image("./images/ImageB.tif",node_img->offset_x(),node_img->offset_y(),
+    node_img->width(),node_img->height(),shared_params));
+  if(node_exact->diff(node_img) > 1.0E-5){
+    *outStream << "Error, the shared image intensities are not correct" << std::endl;
+    errorFlag++;
+  }
+  for(int_t y=5;y<node_img->height()-5;y+=7){
+    for(int_t x=5;x<node_img->width()-5;x+=7){
+      if(std::abs(node_img->grad_x(x,y)-node_exact->grad_x(x,y)) > 1.0E-5||std::abs(node_img->grad_y(x,y)-node_exact->grad_y(x,y)) > 1.0E-5){
+        *outStream << "Error, the shared image gradients are not correct at " << x << " " << y << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+  // the window is freed at the next read once every process on the node has released the image
+  const int_t num_windows = node_reader->num_shared_windows();
+  node_img = Teuchos::null;
+  node_img = node_reader->read("./images/ImageB.tif",0,0,240,161,shared_params);
+  if(node_reader->num_shared_windows()>num_windows){
+    *outStream << "Error, the released shared window was not freed" << std::endl;
+    errorFlag++;
+  }
+  node_img = Teuchos::null;
+  node_reader = Teuchos::null;
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
@@ -0,0 +1,177 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe.h>
+#include <DICe_Image.h>
+#include <DICe_ImagePrefetcher.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <iostream>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  int_t errorFlag  = 0;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  std::vector<std::string> image_files;
+  image_files.push_back("./images/defSyntheticSpeckled0.tif");
+  image_files.push_back("./images/defSyntheticSpeckled1.tif");
+  image_files.push_back("./images/defSyntheticSpeckled2.tif");
+  image_files.push_back("./images/defSyntheticSpeckled3.tif");
+  image_files.push_back("./images/defSyntheticSpeckled4.tif");
+  image_files.push_back("./images/defSyntheticSpeckled5.tif");
+  const int_t num_frames = image_files.size()-1;
+
+  Teuchos::RCP<Teuchos::ParameterList> imgParams = Teuchos::rcp(new Teuchos::ParameterList());
+  imgParams->set(DICe::compute_image_gradients,true);
+  imgParams->set(DICe::gauss_filter_images,true);
+
+  // the prefetched images should be identical to images read directly
+  const int_t num_depths = 2;
+  const int_t depths[num_depths] = {1,3};
+  for(int_t d=0;d<num_depths;++d){
+    *outStream << "testing prefetch depth " << depths[d] << std::endl;
+    Image_Prefetcher prefetcher(image_files,imgParams,1,num_frames,depths[d]);
+    for(int_t frame=1;frame<=num_frames;++frame){
+      Teuchos::RCP<Image> prefetched = prefetcher.image(frame);
+      Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList(*imgParams));
+      Teuchos::RCP<Image> direct = Teuchos::rcp(new Image(image_files[frame].c_str(),params));
+      if(prefetched->file_name()!=image_files[frame]){
+        *outStream << "Error, prefetched frame " << frame << " has the wrong file name " << prefetched->file_name() << std::endl;
+        errorFlag++;
+      }
+      if(!prefetched->has_gradients()||!prefetched->has_gauss_filter()){
+        *outStream << "Error, prefetched frame " << frame << " was not filtered or the gradients were not computed" << std::endl;
+        errorFlag++;
+      }
+      const scalar_t diff = prefetched->diff(direct);
+      *outStream << "frame " << frame << " diff between prefetched and direct read: " << diff << std::endl;
+      if(diff > 1.0E-4){
+        *outStream << "Error, the prefetched image does not match the image read directly" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  *outStream << "testing a prefetch window" << std::endl;
+  {
+    std::vector<int_t> window(4,0);
+    window[0] = 10; window[1] = 20; window[2] = 60; window[3] = 50;
+    Image_Prefetcher prefetcher(image_files,imgParams,1,num_frames,2,window);
+    for(int_t frame=1;frame<=num_frames;++frame){
+      Teuchos::RCP<Image> prefetched = prefetcher.image(frame);
+      Teuchos::RCP<Teuchos::ParameterList> params = Teuchos::rcp(new Teuchos::ParameterList(*imgParams));
+      Teuchos::RCP<Image> direct = Teuchos::rcp(new Image(image_files[frame].c_str(),window[0],window[1],window[2],window[3],params));
+      if(prefetched->offset_x()!=window[0]||prefetched->offset_y()!=window[1]||
+          prefetched->width()!=window[2]||prefetched->height()!=window[3]){
+        *outStream << "Error, prefetched frame " << frame << " does not have the requested window" << std::endl;
+        errorFlag++;
+        continue;
+      }
+      const scalar_t diff = prefetched->diff(direct);
+      *outStream << "frame " << frame << " diff between windowed prefetch and direct read: " << diff << std::endl;
+      if(diff > 1.0E-4){
+        *outStream << "Error, the windowed prefetch image does not match the image read directly" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  *outStream << "testing that a frame requested out of order throws an exception" << std::endl;
+  bool exception_thrown = false;
+  try{
+    Image_Prefetcher prefetcher(image_files,imgParams,1,num_frames,2);
+    prefetcher.image(2);
+  }
+  catch(...){
+    exception_thrown = true;
+  }
+  if(!exception_thrown){
+    *outStream << "Error, an exception should have been thrown for an out of order frame" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing that a read error is passed to the consumer" << std::endl;
+  exception_thrown = false;
+  std::vector<std::string> bad_files = image_files;
+  bad_files[2] = "./images/no_such_image.tif";
+  try{
+    Image_Prefetcher prefetcher(bad_files,imgParams,1,num_frames,2);
+    prefetcher.image(1);
+    prefetcher.image(2);
+  }
+  catch(...){
+    exception_thrown = true;
+  }
+  if(!exception_thrown){
+    *outStream << "Error, an exception should have been thrown for the missing image" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
+
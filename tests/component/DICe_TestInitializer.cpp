@@ -56,6 +56,7 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <vector>
 
 using namespace DICe;
 using namespace DICe::field_enums;
@@ -198,6 +199,8 @@ int main(int argc, char *argv[]) {
   std::vector<Initialization_Method> init_methods;
   init_methods.push_back(USE_PHASE_CORRELATION);
   init_methods.push_back(USE_FIELD_VALUES);
+  init_methods.push_back(USE_IMAGE_PYRAMID);
+  init_methods.push_back(USE_FFT_CROSS_CORRELATION);
   init_methods.push_back(INITIALIZATION_METHOD_NOT_APPLICABLE); // use this one for path file test
   std::vector<Correlation_Routine> corr_routines;
   corr_routines.push_back(TRACKING_ROUTINE);
@@ -223,6 +226,16 @@ int main(int argc, char *argv[]) {
           schema->local_field_value(i,SUBSET_DISPLACEMENT_X_FS) = u_exact;
           schema->local_field_value(i,SUBSET_DISPLACEMENT_Y_FS) = v_exact;
         }
+        else if(init_methods[init_i] == USE_IMAGE_PYRAMID){
+          // start well outside the range a search or the optimizer alone could recover from
+          schema->local_field_value(i,SUBSET_DISPLACEMENT_X_FS) = u_exact - 40.0;
+          schema->local_field_value(i,SUBSET_DISPLACEMENT_Y_FS) = v_exact + 35.0;
+        }
+        else if(init_methods[init_i] == USE_FFT_CROSS_CORRELATION){
+          // each subset starts from a different guess inside the default search radius
+          schema->local_field_value(i,SUBSET_DISPLACEMENT_X_FS) = u_exact - 20.0 + 3.0*i;
+          schema->local_field_value(i,SUBSET_DISPLACEMENT_Y_FS) = v_exact + 18.0 - 5.0*i;
+        }
       }
       bool exception_thrown = false;
       try{
@@ -256,6 +269,90 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // the pyramid guess alone (without the optimizer) should be refined to within a pixel on the full resolution images
+  *outStream << "testing the full resolution refinement of the image pyramid initializer" << std::endl;
+  params->set(DICe::initialization_method,USE_IMAGE_PYRAMID);
+  params->set(DICe::correlation_routine,GENERIC_ROUTINE);
+  Teuchos::RCP<DICe::Schema> pyramid_schema = Teuchos::rcp(new DICe::Schema(coords_x,coords_y,subset_size,Teuchos::null,neighbor_ids,params));
+  pyramid_schema->set_ref_image("./images/InitRef.tif");
+  pyramid_schema->set_def_image("./images/InitDef.tif");
+  Image_Pyramid_Initializer pyramid_init(pyramid_schema.get());
+  pyramid_init.pre_execution_tasks();
+  for(int_t i=0;i<pyramid_schema->local_num_subsets();++i){
+    pyramid_schema->local_field_value(i,SUBSET_DISPLACEMENT_X_FS) = u_exact - 40.0;
+    pyramid_schema->local_field_value(i,SUBSET_DISPLACEMENT_Y_FS) = v_exact + 35.0;
+    Teuchos::RCP<Local_Shape_Function> shape_function = shape_function_factory(pyramid_schema.get());
+    const Status_Flag status = pyramid_init.initial_guess(pyramid_schema->subset_global_id(i),shape_function);
+    scalar_t u = 0.0, v = 0.0, t = 0.0;
+    shape_function->map_to_u_v_theta(coords_x[i],coords_y[i],u,v,t);
+    *outStream << i << " pyramid guess u: " << u << " v: " << v << std::endl;
+    if(status!=INITIALIZE_SUCCESSFUL||std::abs(u-u_exact) > 1.0 || std::abs(v-v_exact) > 1.0){
+      *outStream << "Error, the pyramid guess is not within a pixel of the solution" << std::endl;
+      errorFlag++;
+    }
+  }
+
+  // a synthetic pair of images where each quadrant moves by a different integer shift (one of them
+  // close to the edge of the search window), the cross-correlation peak has to find each one exactly
+  *outStream << "testing the cross-correlation initializer with a different shift for each subset" << std::endl;
+  const int_t cc_dim = 240;
+  const int_t cc_block = cc_dim/2;
+  const int_t cc_search_radius = 24;
+  const int_t cc_num_subsets = 4;
+  const int_t cc_shift_x[] = {3,-7,11,-(cc_search_radius-1)};
+  const int_t cc_shift_y[] = {-2,5,8,cc_search_radius-2};
+  Teuchos::ArrayRCP<intensity_t> cc_ref(cc_dim*cc_dim,0.0);
+  Teuchos::ArrayRCP<intensity_t> cc_def(cc_dim*cc_dim,0.0);
+  // smoothed pseudo-random speckle (a fixed linear congruential sequence so the test is repeatable)
+  std::vector<scalar_t> noise(cc_dim*cc_dim,0.0);
+  unsigned int seed = 12345;
+  for(int_t i=0;i<cc_dim*cc_dim;++i){
+    seed = 1103515245u*seed + 12345u;
+    noise[i] = static_cast<scalar_t>((seed>>16)&0x7fff)/32767.0;
+  }
+  for(int_t y=0;y<cc_dim;++y){
+    for(int_t x=0;x<cc_dim;++x){
+      scalar_t value = 0.0;
+      for(int_t j=-1;j<=1;++j)
+        for(int_t i=-1;i<=1;++i)
+          value += noise[std::min(std::max(y+j,0),cc_dim-1)*cc_dim + std::min(std::max(x+i,0),cc_dim-1)];
+      cc_ref[y*cc_dim+x] = 255.0*value/9.0;
+    }
+  }
+  Teuchos::ArrayRCP<scalar_t> cc_coords_x(cc_num_subsets,0.0);
+  Teuchos::ArrayRCP<scalar_t> cc_coords_y(cc_num_subsets,0.0);
+  for(int_t i=0;i<cc_num_subsets;++i){
+    cc_coords_x[i] = (i%2)*cc_block + cc_block/2;
+    cc_coords_y[i] = (i/2)*cc_block + cc_block/2;
+  }
+  for(int_t y=0;y<cc_dim;++y){
+    for(int_t x=0;x<cc_dim;++x){
+      const int_t block = (y/cc_block)*2 + x/cc_block;
+      const int_t ref_x = std::min(std::max(x-cc_shift_x[block],0),cc_dim-1);
+      const int_t ref_y = std::min(std::max(y-cc_shift_y[block],0),cc_dim-1);
+      cc_def[y*cc_dim+x] = cc_ref[ref_y*cc_dim+ref_x];
+    }
+  }
+  params->set(DICe::initialization_method,USE_FFT_CROSS_CORRELATION);
+  params->set(DICe::correlation_routine,GENERIC_ROUTINE);
+  Teuchos::RCP<DICe::Schema> cc_schema = Teuchos::rcp(new DICe::Schema(cc_coords_x,cc_coords_y,subset_size,Teuchos::null,Teuchos::null,params));
+  cc_schema->set_ref_image(cc_dim,cc_dim,cc_ref);
+  cc_schema->set_def_image(cc_dim,cc_dim,cc_def);
+  Cross_Correlation_Initializer cc_init(cc_schema.get(),cc_search_radius);
+  cc_init.pre_execution_tasks();
+  for(int_t i=0;i<cc_schema->local_num_subsets();++i){
+    const int_t gid = cc_schema->subset_global_id(i);
+    Teuchos::RCP<Local_Shape_Function> shape_function = shape_function_factory(cc_schema.get());
+    const Status_Flag status = cc_init.initial_guess(gid,shape_function);
+    scalar_t u = 0.0, v = 0.0, t = 0.0;
+    shape_function->map_to_u_v_theta(cc_coords_x[gid],cc_coords_y[gid],u,v,t);
+    *outStream << gid << " cross-correlation guess u: " << u << " v: " << v << " peak " << cc_init.peak_ncc(i) << std::endl;
+    if(status!=INITIALIZE_SUCCESSFUL||std::abs(u-cc_shift_x[gid])>errorTol||std::abs(v-cc_shift_y[gid])>errorTol||cc_init.peak_ncc(i)<0.99){
+      *outStream << "Error, the cross-correlation peak should be at u " << cc_shift_x[gid] << " v " << cc_shift_y[gid] << std::endl;
+      errorFlag++;
+    }
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
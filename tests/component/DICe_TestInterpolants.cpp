@@ -90,6 +90,7 @@ int main(int argc, char *argv[]) {
   *outStream << "creating a subset" << std::endl;
   Subset subset_bi(cx,cy,10,10);
   Subset subset_keys(cx,cy,10,10);
+  Subset subset_bspline(cx,cy,10,10);
   Teuchos::RCP<Local_Shape_Function> shape_function = shape_function_factory();
   const scalar_t u = 0.3589;
   const scalar_t v = -2.89478;
@@ -97,10 +98,12 @@ int main(int argc, char *argv[]) {
   shape_function->insert_motion(u,v,t);
   subset_bi.initialize(array_img,DEF_INTENSITIES,shape_function,BILINEAR);
   subset_keys.initialize(array_img,DEF_INTENSITIES,shape_function,KEYS_FOURTH);
+  subset_bspline.initialize(array_img,DEF_INTENSITIES,shape_function,BSPLINE_CUBIC);
 
   *outStream << "testing the intensity values" << std::endl;
   scalar_t error_bi = 0.0;
   scalar_t error_keys = 0.0;
+  scalar_t error_bspline = 0.0;
   scalar_t px=0.0,py=0.0;
   for(int_t i=0;i<subset_bi.num_pixels();++i){
     shape_function->map(subset_bi.x(i),subset_bi.y(i),cx,cy,px,py);
@@ -109,6 +112,7 @@ int main(int argc, char *argv[]) {
     const scalar_t exact = x_val*y_val;
     error_bi += std::abs(subset_bi.def_intensities(i) - exact);
     error_keys += std::abs(subset_keys.def_intensities(i) - exact);
+    error_bspline += std::abs(subset_bspline.def_intensities(i) - exact);
     //std::cout << " x " << subset_bi.x(i) << " y " << subset_bi.y(i) <<
     //    " exact " << exact << " bi " << subset_bi.def_intensities(i) <<
     //    " keys " << subset_keys.def_intensities(i) << std::endl;
@@ -117,6 +121,7 @@ int main(int argc, char *argv[]) {
   }
   *outStream << "bilinear interp error: " << error_bi << std::endl;
   *outStream << "keys interp error: " << error_keys << std::endl;
+  *outStream << "B-spline interp error: " << error_bspline << std::endl;
   if(error_bi > 1.0){
     *outStream << "Error, bilinear interpolation failed simple translation" << std::endl;
     errorFlag++;
@@ -125,6 +130,70 @@ int main(int argc, char *argv[]) {
     *outStream << "Error, keys fourth interpolation failed simple translation" << std::endl;
     errorFlag++;
   }
+  if(error_bspline > 2.0){
+    *outStream << "Error, cubic B-spline interpolation failed simple translation" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing the cubic B-spline gradients" << std::endl;
+  // the spline gradients are exact for this image away from the edges: d/dx = (255/w)*y_val, d/dy = x_val*(255/h)
+  scalar_t error_bspline_grad = 0.0;
+  for(scalar_t y=8.3;y<array_h-8.0;y+=1.7){
+    for(scalar_t x=8.6;x<array_w-8.0;x+=2.1){
+      intensity_t intens = 0.0;
+      scalar_t gx = 0.0, gy = 0.0;
+      array_img->interpolate_bspline_all(intens,gx,gy,true,x,y);
+      error_bspline_grad += std::abs(gx - 255.0/array_w*255.0*y/array_h) + std::abs(gy - 255.0*x/array_w*255.0/array_h);
+    }
+  }
+  *outStream << "B-spline gradient error: " << error_bspline_grad << std::endl;
+  if(error_bspline_grad > 5.0){ // high error in case float is used vs. double
+    *outStream << "Error, cubic B-spline gradients are not correct" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "testing the batched interpolation against the point-wise interpolants" << std::endl;
+  array_img->compute_gradients();
+  const int_t num_points = 25;
+  std::vector<scalar_t> batch_x(num_points,0.0);
+  std::vector<scalar_t> batch_y(num_points,0.0);
+  for(int_t i=0;i<num_points;++i){
+    batch_x[i] = 4.2 + 1.23*i;
+    batch_y[i] = 3.7 + 0.91*i;
+  }
+  // include points near and past the border to exercise the bilinear fallback
+  batch_x[num_points-1] = 1.5;
+  batch_y[num_points-2] = array_h - 1.25;
+  const int_t num_interps = 4;
+  const Interpolation_Method interps[num_interps] = {BILINEAR,BICUBIC,KEYS_FOURTH,BSPLINE_CUBIC};
+  for(int_t m=0;m<num_interps;++m){
+    std::vector<intensity_t> batch_intens(num_points,0.0);
+    std::vector<scalar_t> batch_gx(num_points,0.0);
+    std::vector<scalar_t> batch_gy(num_points,0.0);
+    array_img->interpolate_all(num_points,&batch_x[0],&batch_y[0],NULL,&batch_intens[0],&batch_gx[0],&batch_gy[0],true,interps[m]);
+    scalar_t batch_error = 0.0;
+    for(int_t i=0;i<num_points;++i){
+      intensity_t intens = 0.0;
+      scalar_t gx = 0.0, gy = 0.0;
+      if(interps[m]==BILINEAR)
+        array_img->interpolate_bilinear_all(intens,gx,gy,true,batch_x[i],batch_y[i]);
+      else if(interps[m]==BICUBIC)
+        array_img->interpolate_bicubic_all(intens,gx,gy,true,batch_x[i],batch_y[i]);
+      else if(interps[m]==BSPLINE_CUBIC)
+        array_img->interpolate_bspline_all(intens,gx,gy,true,batch_x[i],batch_y[i]);
+      else{
+        intens = array_img->interpolate_keys_fourth(batch_x[i],batch_y[i]);
+        gx = array_img->interpolate_grad_x_keys_fourth(batch_x[i],batch_y[i]);
+        gy = array_img->interpolate_grad_y_keys_fourth(batch_x[i],batch_y[i]);
+      }
+      batch_error += std::abs(intens - batch_intens[i]) + std::abs(gx - batch_gx[i]) + std::abs(gy - batch_gy[i]);
+    }
+    *outStream << "batched interpolation error for method " << interpolationMethodStrings[interps[m]] << ": " << batch_error << std::endl;
+    if(batch_error > 1.0E-2){
+      *outStream << "Error, batched interpolation does not match the point-wise interpolant" << std::endl;
+      errorFlag++;
+    }
+  }
 
   *outStream << "--- End test ---" << std::endl;
 
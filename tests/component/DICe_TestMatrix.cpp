@@ -296,6 +296,82 @@ int main(int argc, char *argv[]) {
     error_flag++;
   }
 
+  *outStream << "testing the Cholesky and LDLT solves" << std::endl;
+  Matrix<double,4> spd = {{4.0,1.0,0.5,0.2},
+    {1.0,5.0,0.3,0.1},
+    {0.5,0.3,3.0,0.4},
+    {0.2,0.1,0.4,2.0}};
+  Vector<double,4> spd_x_gold = {{1.0},{-2.0},{0.5},{3.0}};
+  Vector<double,4> spd_b = spd*spd_x_gold;
+  Matrix<double,4> chol_factor = spd;
+  Vector<double,4> chol_x = spd_b;
+  if(!chol_factor.cholesky()){
+    *outStream << "***error: cholesky() failed for a positive definite matrix" << std::endl;
+    error_flag++;
+  }
+  chol_factor.cholesky_solve(chol_x);
+  *outStream << chol_x << std::endl;
+  if(norm(chol_x - spd_x_gold)>error_tol){
+    *outStream << "***error: cholesky_solve() incorrect" << std::endl;
+    error_flag++;
+  }
+  Matrix<double,4> ldlt_factor = spd;
+  Vector<double,4> ldlt_x = spd_b;
+  if(!ldlt_factor.ldlt()){
+    *outStream << "***error: ldlt() failed for a positive definite matrix" << std::endl;
+    error_flag++;
+  }
+  ldlt_factor.ldlt_solve(ldlt_x);
+  if(norm(ldlt_x - spd_x_gold)>error_tol){
+    *outStream << "***error: ldlt_solve() incorrect" << std::endl;
+    error_flag++;
+  }
+  // symmetric indefinite: cholesky has to fail, ldlt should still solve it
+  Matrix<double,3> indefinite = {{1.0,2.0,0.0},
+    {2.0,1.0,1.0},
+    {0.0,1.0,-3.0}};
+  Vector<double,3> indefinite_x_gold = {{2.0},{-1.0},{0.5}};
+  Vector<double,3> indefinite_b = indefinite*indefinite_x_gold;
+  Matrix<double,3> indefinite_chol = indefinite;
+  if(indefinite_chol.cholesky()){
+    *outStream << "***error: cholesky() should fail for an indefinite matrix" << std::endl;
+    error_flag++;
+  }
+  if(!indefinite.ldlt()){
+    *outStream << "***error: ldlt() failed for a symmetric indefinite matrix" << std::endl;
+    error_flag++;
+  }
+  indefinite.ldlt_solve(indefinite_b);
+  if(norm(indefinite_b - indefinite_x_gold)>error_tol){
+    *outStream << "***error: ldlt_solve() incorrect for an indefinite matrix" << std::endl;
+    error_flag++;
+  }
+  // run-time sized system (as used in the subset optimization)
+  Matrix<double> runtime_spd(3,3);
+  Vector<double> runtime_b(3);
+  for(size_t i=0;i<3;++i){
+    runtime_b(i) = 1.0;
+    for(size_t j=0;j<3;++j)
+      runtime_spd(i,j) = spd(i,j);
+  }
+  if(!runtime_spd.cholesky()){
+    *outStream << "***error: cholesky() failed for a run-time sized matrix" << std::endl;
+    error_flag++;
+  }
+  runtime_spd.cholesky_solve(runtime_b);
+  double runtime_residual = 0.0;
+  for(size_t i=0;i<3;++i){
+    double row = -1.0;
+    for(size_t j=0;j<3;++j)
+      row += spd(i,j)*runtime_b(j);
+    runtime_residual += row*row;
+  }
+  *outStream << "run-time sized cholesky residual: " << runtime_residual << std::endl;
+  if(runtime_residual>error_tol){
+    *outStream << "***error: cholesky_solve() incorrect for a run-time sized matrix" << std::endl;
+    error_flag++;
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
@@ -0,0 +1,178 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+#include <DICe.h>
+#include <DICe_Profiler.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  // only print output if args are given (for testing the output is quiet)
+  int_t iprint     = argc - 1;
+  int_t errorFlag  = 0;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  *outStream << "timing scopes with the instrumentation off" << std::endl;
+  {
+    profiler::Scope scope(profiler::IMAGE_READ);
+  }
+  profiler::enable();
+
+  *outStream << "timing scopes on several threads" << std::endl;
+  const int_t num_threads = 4;
+  const int_t num_steps = 50;
+  std::vector<std::thread> threads;
+  for(int_t t=0;t<num_threads;++t){
+    threads.push_back(std::thread([](){
+      for(int_t i=0;i<num_steps;++i){
+        profiler::Scope scope(profiler::GRADIENT_OPTIMIZATION);
+        profiler::record_step(i%5==0 ? static_cast<int_t>(MAX_ITERATIONS_REACHED) : static_cast<int_t>(CORRELATION_SUCCESSFUL),i%3);
+      }
+      profiler::Scope init_scope(USE_FIELD_VALUES);
+      // the search and path file initializers do not have a method of their own
+      profiler::Scope search_scope(INITIALIZATION_METHOD_NOT_APPLICABLE);
+    }));
+  }
+  for(size_t t=0;t<threads.size();++t)
+    threads[t].join();
+
+  std::map<std::string,std::map<int_t,int_t> > extra_histograms;
+  extra_histograms["search_calls"][2] = 3;
+
+  *outStream << "writing the JSON report" << std::endl;
+  profiler::write_report("profiler_test_report.json",extra_histograms);
+  std::ifstream json_file("profiler_test_report.json");
+  std::stringstream json;
+  json << json_file.rdbuf();
+  json_file.close();
+  *outStream << json.str();
+  std::stringstream expected_calls;
+  expected_calls << "{\"name\": \"GRADIENT_OPTIMIZATION\", \"calls\": " << num_threads*num_steps << ",";
+  if(json.str().find(expected_calls.str())==std::string::npos){
+    *outStream << "Error, the gradient optimization call count is wrong" << std::endl;
+    errorFlag++;
+  }
+  if(json.str().find("{\"name\": \"IMAGE_READ\", \"calls\": 0,")==std::string::npos){
+    *outStream << "Error, a scope was timed with the instrumentation off" << std::endl;
+    errorFlag++;
+  }
+  std::stringstream expected_init;
+  expected_init << "{\"name\": \"INITIALIZE_USE_FIELD_VALUES\", \"calls\": " << num_threads << ",";
+  if(json.str().find(expected_init.str())==std::string::npos){
+    *outStream << "Error, the initializer was not timed" << std::endl;
+    errorFlag++;
+  }
+  std::stringstream expected_search;
+  expected_search << "{\"name\": \"INITIALIZE_SEARCH_OR_PATH\", \"calls\": " << num_threads << ",";
+  if(json.str().find(expected_search.str())==std::string::npos){
+    *outStream << "Error, the search initializer was not timed" << std::endl;
+    errorFlag++;
+  }
+  // 10 of every 50 steps hit the max iterations on each thread
+  std::stringstream expected_status;
+  expected_status << "\"status\": {\"" << CORRELATION_SUCCESSFUL << "\": " << num_threads*40 << ", \""
+      << MAX_ITERATIONS_REACHED << "\": " << num_threads*10 << "}";
+  if(json.str().find(expected_status.str())==std::string::npos){
+    *outStream << "Error, the status histogram is wrong" << std::endl;
+    errorFlag++;
+  }
+  if(json.str().find("\"search_calls\": {\"2\": 3}")==std::string::npos){
+    *outStream << "Error, the extra histogram is missing" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "writing the CSV report" << std::endl;
+  profiler::write_report("profiler_test_report.csv",extra_histograms);
+  std::ifstream csv_file("profiler_test_report.csv");
+  std::stringstream csv;
+  csv << csv_file.rdbuf();
+  csv_file.close();
+  std::stringstream expected_csv;
+  expected_csv << "\nGRADIENT_OPTIMIZATION," << num_threads*num_steps << ",";
+  if(csv.str().find(expected_csv.str())==std::string::npos||csv.str().find("\nsearch_calls,2,3\n")==std::string::npos){
+    *outStream << "Error, the CSV report is wrong" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "resetting the counters" << std::endl;
+  profiler::reset();
+  profiler::write_report("profiler_test_report.json");
+  std::ifstream reset_file("profiler_test_report.json");
+  std::stringstream reset_json;
+  reset_json << reset_file.rdbuf();
+  if(reset_json.str().find("GRADIENT_OPTIMIZATION\", \"calls\": 0,")==std::string::npos){
+    *outStream << "Error, the counters were not reset" << std::endl;
+    errorFlag++;
+  }
+  profiler::enable(false);
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
+
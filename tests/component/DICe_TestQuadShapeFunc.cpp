@@ -49,6 +49,8 @@
 #include <Teuchos_ParameterList.hpp>
 
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 using namespace DICe;
 
@@ -157,6 +159,73 @@ int main(int argc, char *argv[]) {
     rot += 0.785398;
   }
 
+  // the compile time residual kernels should give the same residuals as the virtual residuals() method
+  *outStream << "testing the residual kernels against the virtual residuals" << std::endl;
+  Teuchos::RCP<Quadratic_Shape_Function> quad_func = Teuchos::rcp(new Quadratic_Shape_Function());
+  quad_func->insert_motion(2.5,-1.5,0.3);
+  Teuchos::RCP<Affine_Shape_Function> affine_func = Teuchos::rcp(new Affine_Shape_Function(true,true,true));
+  affine_func->insert_motion(2.5,-1.5,0.3);
+  (*affine_func)(DICe::field_enums::NORMAL_STRETCH_XX_FS) = 0.01;
+  (*affine_func)(DICe::field_enums::SHEAR_STRETCH_XY_FS) = -0.02;
+  Teuchos::RCP<Affine_Shape_Function> disp_func = Teuchos::rcp(new Affine_Shape_Function(false,false,false));
+  disp_func->insert_motion(2.5,-1.5);
+  std::vector<scalar_t> quad_residuals(12,0.0);
+  std::vector<scalar_t> affine_residuals(6,0.0);
+  std::vector<scalar_t> disp_residuals(2,0.0);
+  scalar_t quad_kernel_residuals[12];
+  scalar_t affine_kernel_residuals[6];
+  scalar_t disp_kernel_residuals[2];
+  scalar_t max_kernel_diff = 0.0;
+  for(int_t ref_grads=0;ref_grads<2;++ref_grads){
+    const Residual_Kernel<Quadratic_Shape_Function,12> quad_kernel(*quad_func,cx,cy,ref_grads==1);
+    const Residual_Kernel<Affine_Shape_Function,6> affine_kernel(*affine_func,cx,cy,ref_grads==1);
+    const Residual_Kernel<Affine_Shape_Function,2> disp_kernel(*disp_func,cx,cy,ref_grads==1);
+    for(int_t i=0;i<5;++i){
+      const scalar_t x = cx - 7 + 4*i;
+      const scalar_t y = cy + 5 - 3*i;
+      const scalar_t gx = 0.5 + 0.25*i;
+      const scalar_t gy = -1.0 + 0.5*i;
+      quad_func->residuals(x,y,cx,cy,gx,gy,quad_residuals,ref_grads==1);
+      quad_kernel(x,y,gx,gy,quad_kernel_residuals);
+      for(int_t j=0;j<12;++j)
+        max_kernel_diff = std::max(max_kernel_diff,std::abs(quad_residuals[j]-quad_kernel_residuals[j]));
+      affine_func->residuals(x,y,cx,cy,gx,gy,affine_residuals,ref_grads==1);
+      affine_kernel(x,y,gx,gy,affine_kernel_residuals);
+      for(int_t j=0;j<6;++j)
+        max_kernel_diff = std::max(max_kernel_diff,std::abs(affine_residuals[j]-affine_kernel_residuals[j]));
+      disp_func->residuals(x,y,cx,cy,gx,gy,disp_residuals,ref_grads==1);
+      disp_kernel(x,y,gx,gy,disp_kernel_residuals);
+      for(int_t j=0;j<2;++j)
+        max_kernel_diff = std::max(max_kernel_diff,std::abs(disp_residuals[j]-disp_kernel_residuals[j]));
+    }
+  }
+  *outStream << "max difference between the kernel and virtual residuals: " << max_kernel_diff << std::endl;
+  if(max_kernel_diff > 1.0E-4){
+    *outStream << "Error, residual kernels do not match the virtual residuals" << std::endl;
+    errorFlag++;
+  }
+
+  *outStream << "comparing the map kernels to the virtual map" << std::endl;
+  const Map_Kernel<Quadratic_Shape_Function> quad_map_kernel(*quad_func,cx,cy);
+  const Map_Kernel<Affine_Shape_Function> affine_map_kernel(*affine_func,cx,cy);
+  scalar_t max_map_diff = 0.0;
+  for(int_t i=0;i<5;++i){
+    const scalar_t x = cx - 7 + 4*i;
+    const scalar_t y = cy + 5 - 3*i;
+    scalar_t map_x = 0.0, map_y = 0.0, kernel_x = 0.0, kernel_y = 0.0;
+    quad_func->map(x,y,cx,cy,map_x,map_y);
+    quad_map_kernel(x,y,kernel_x,kernel_y);
+    max_map_diff = std::max(max_map_diff,std::max(std::abs(map_x-kernel_x),std::abs(map_y-kernel_y)));
+    affine_func->map(x,y,cx,cy,map_x,map_y);
+    affine_map_kernel(x,y,kernel_x,kernel_y);
+    max_map_diff = std::max(max_map_diff,std::max(std::abs(map_x-kernel_x),std::abs(map_y-kernel_y)));
+  }
+  *outStream << "max difference between the kernel and virtual map: " << max_map_diff << std::endl;
+  if(max_map_diff > 1.0E-4){
+    *outStream << "Error, map kernels do not match the virtual map" << std::endl;
+    errorFlag++;
+  }
+
   *outStream << "--- End test ---" << std::endl;
 
   DICe::finalize();
@@ -243,6 +243,41 @@ int main(int argc, char *argv[]) {
     errorFlag++;
   }
   *outStream << "the mean values and mean sum values have been checked" << std::endl;
+
+  *outStream << "checking gamma with some of the pixels deactivated" << std::endl;
+  for(int_t i=0;i<square.num_pixels();i+=7)
+    square.is_deactivated_this_step(i) = true;
+  scalar_t act_ref_mean = 0.0, act_def_mean = 0.0;
+  int_t num_act = 0;
+  for(int_t i=0;i<square.num_pixels();++i){
+    if(square.is_deactivated_this_step(i)) continue;
+    act_ref_mean += square.ref_intensities(i);
+    act_def_mean += square.def_intensities(i);
+    num_act++;
+  }
+  act_ref_mean /= num_act;
+  act_def_mean /= num_act;
+  scalar_t act_ref_sum = 0.0, act_def_sum = 0.0;
+  for(int_t i=0;i<square.num_pixels();++i){
+    if(square.is_deactivated_this_step(i)) continue;
+    act_ref_sum += (square.ref_intensities(i)-act_ref_mean)*(square.ref_intensities(i)-act_ref_mean);
+    act_def_sum += (square.def_intensities(i)-act_def_mean)*(square.def_intensities(i)-act_def_mean);
+  }
+  act_ref_sum = std::sqrt(act_ref_sum);
+  act_def_sum = std::sqrt(act_def_sum);
+  scalar_t act_gamma = 0.0;
+  for(int_t i=0;i<square.num_pixels();++i){
+    if(square.is_deactivated_this_step(i)) continue;
+    const scalar_t value = (square.def_intensities(i)-act_def_mean)/act_def_sum - (square.ref_intensities(i)-act_ref_mean)/act_ref_sum;
+    act_gamma += value*value;
+  }
+  const scalar_t func_gamma = square.gamma();
+  *outStream << "gamma " << func_gamma << " expected " << act_gamma << std::endl;
+  if(std::abs(func_gamma - act_gamma)>errorTol||std::abs(square.mean(DEF_INTENSITIES) - act_def_mean)>errorTol){
+    *outStream << "Error, gamma or the mean is not correct with deactivated pixels" << std::endl;
+    errorFlag++;
+  }
+  square.reset_is_deactivated_this_step();
   // TODO come up with a complex mapping and check the values
 
   *outStream << "creating a conformal subset" << std::endl;
@@ -0,0 +1,485 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+/*! \file  DICe_TestThreadedCorrelation.cpp
+    \brief Test that the threaded generic correlation routine gives the same results as the serial one
+*/
+
+#include <DICe.h>
+#include <DICe_Schema.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_ArrayRCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <iostream>
+#include <cstdio>
+#include <vector>
+
+#include <cassert>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  DICe::initialize(argc, argv);
+
+  int_t iprint     = argc - 1;
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (iprint > 0)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+  int_t errorFlag  = 0;
+  const scalar_t errorTol = 1.0E-4;
+
+  *outStream << "--- Begin test ---" << std::endl;
+
+  Image img("./images/refSpeckled.tif");
+  const int_t roi_w = img.width();
+  const int_t roi_h = img.height();
+  const int_t step_size = 25;
+  const int_t subset_size = 31;
+
+  const int_t num_init_methods = 2;
+  const Initialization_Method init_methods[num_init_methods] = {USE_FIELD_VALUES,USE_NEIGHBOR_VALUES};
+
+  for(int_t method=0;method<num_init_methods;++method){
+    *outStream << "testing initialization method " << initializationMethodStrings[init_methods[method]] << std::endl;
+    Teuchos::RCP<Teuchos::ParameterList> params = rcp(new Teuchos::ParameterList());
+    params->set(DICe::initialization_method,init_methods[method]);
+    params->set(DICe::interpolation_method,DICe::KEYS_FOURTH);
+    params->set(DICe::robust_solver_tolerance,1.0E-4);
+
+    Teuchos::RCP<DICe::Schema> serial_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,params));
+    serial_schema->set_ref_image("./images/refSpeckled.tif");
+    serial_schema->set_def_image("./images/defSpeckled.tif");
+    serial_schema->execute_correlation();
+
+    // the cost of each subset is recorded for rebalancing (one for the setup plus the iterations)
+    for(int_t i=0;i<serial_schema->local_num_subsets();++i){
+      const scalar_t iterations = serial_schema->local_field_value(i,DICe::field_enums::ITERATIONS_FS);
+      const scalar_t expected_cost = 1.0 + (iterations > 0.0 ? iterations : 0.0);
+      if(serial_schema->subset_costs()->local_value(i)!=expected_cost){
+        *outStream << "Error, subset " << i << " cost " << serial_schema->subset_costs()->local_value(i) << " should be " << expected_cost << std::endl;
+        errorFlag++;
+      }
+    }
+    // a jump tolerance this small sends every subset that moves to the backup optimization, which is
+    // counted in the cost even though the generic routine does not record it in the stat container
+    Teuchos::RCP<Teuchos::ParameterList> backup_params = rcp(new Teuchos::ParameterList(*params));
+    backup_params->set(DICe::optimization_method,DICe::GRADIENT_BASED_THEN_SIMPLEX);
+    backup_params->set(DICe::disp_jump_tol,1.0E-3);
+    Teuchos::RCP<DICe::Schema> backup_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,backup_params));
+    backup_schema->set_ref_image("./images/refSpeckled.tif");
+    backup_schema->set_def_image("./images/defSpeckled.tif");
+    backup_schema->execute_correlation();
+    int_t num_backups = 0;
+    for(int_t i=0;i<backup_schema->local_num_subsets();++i){
+      const scalar_t u = backup_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+      const scalar_t v = backup_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+      if(backup_schema->local_field_value(i,DICe::field_enums::SIGMA_FS)<0.0||(std::abs(u)<=1.0E-3&&std::abs(v)<=1.0E-3)) continue;
+      num_backups++;
+      const scalar_t iterations = backup_schema->local_field_value(i,DICe::field_enums::ITERATIONS_FS);
+      const scalar_t solve_cost = 1.0 + (iterations > 0.0 ? iterations : 0.0);
+      if(backup_schema->subset_costs()->local_value(i)<solve_cost+10.0){
+        *outStream << "Error, subset " << i << " cost " << backup_schema->subset_costs()->local_value(i) << " does not include the backup optimization" << std::endl;
+        errorFlag++;
+      }
+    }
+    if(num_backups==0){
+      *outStream << "Error, the backup optimization should have been used" << std::endl;
+      errorFlag++;
+    }
+    // rebalancing needs the subsets to be independent of each other
+    Teuchos::RCP<Teuchos::ParameterList> rebalance_params = rcp(new Teuchos::ParameterList(*params));
+    rebalance_params->set(DICe::rebalance_interval,1);
+    bool rebalance_error = false;
+    try{
+      Teuchos::RCP<DICe::Schema> rebalance_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,rebalance_params));
+      // a single process has nothing to rebalance
+      rebalance_error = rebalance_schema->rebalance_subsets() || init_methods[method]==USE_NEIGHBOR_VALUES;
+    }
+    catch(std::exception &){
+      rebalance_error = init_methods[method]!=USE_NEIGHBOR_VALUES;
+    }
+    if(rebalance_error){
+      *outStream << "Error, rebalancing should only be allowed without neighbor value initialization" << std::endl;
+      errorFlag++;
+    }
+
+    params->set(DICe::num_threads,4);
+    Teuchos::RCP<DICe::Schema> threaded_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,params));
+    *outStream << "number of threads: " << threaded_schema->num_threads() << std::endl;
+    threaded_schema->set_ref_image("./images/refSpeckled.tif");
+    threaded_schema->set_def_image("./images/defSpeckled.tif");
+
+    // every subset should be in exactly one wave
+    std::vector<std::vector<int_t> > waves;
+    threaded_schema->subset_execution_waves(waves);
+    std::vector<int_t> wave_count(threaded_schema->local_num_subsets(),0);
+    for(size_t i=0;i<waves.size();++i)
+      for(size_t j=0;j<waves[i].size();++j)
+        wave_count[waves[i][j]]++;
+    for(size_t i=0;i<wave_count.size();++i){
+      if(wave_count[i]!=1){
+        *outStream << "Error, subset index " << i << " appears in " << wave_count[i] << " waves" << std::endl;
+        errorFlag++;
+      }
+    }
+    *outStream << "number of waves: " << waves.size() << std::endl;
+
+    threaded_schema->execute_correlation();
+
+    if(serial_schema->local_num_subsets()!=threaded_schema->local_num_subsets()){
+      *outStream << "Error, the number of subsets is not the same" << std::endl;
+      errorFlag++;
+      continue;
+    }
+    for(int_t i=0;i<serial_schema->local_num_subsets();++i){
+      const scalar_t diff_x = serial_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS)
+          - threaded_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+      const scalar_t diff_y = serial_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS)
+          - threaded_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+      const scalar_t diff_sigma = serial_schema->local_field_value(i,DICe::field_enums::SIGMA_FS)
+          - threaded_schema->local_field_value(i,DICe::field_enums::SIGMA_FS);
+      if(std::abs(diff_x)>errorTol||std::abs(diff_y)>errorTol||std::abs(diff_sigma)>errorTol){
+        *outStream << "Error, subset " << i << " threaded result does not match serial, diff x " << diff_x <<
+            " diff y " << diff_y << " diff sigma " << diff_sigma << std::endl;
+        errorFlag++;
+      }
+    }
+
+    // executing the subsets along a Hilbert curve (with the tiled image layout) must not change the results
+    params->set(DICe::num_threads,1);
+    params->set(DICe::subset_execution_order,DICe::HILBERT_ORDER);
+    params->set(DICe::tiled_image_layout,true);
+    Teuchos::RCP<DICe::Schema> ordered_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,params));
+    if(ordered_schema->this_proc_gid_order()==serial_schema->this_proc_gid_order()){
+      *outStream << "Error, the Hilbert execution order should differ from the input order" << std::endl;
+      errorFlag++;
+    }
+    ordered_schema->set_ref_image("./images/refSpeckled.tif");
+    ordered_schema->set_def_image("./images/defSpeckled.tif");
+    ordered_schema->execute_correlation();
+    for(int_t i=0;i<serial_schema->local_num_subsets();++i){
+      const scalar_t diff_x = serial_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS)
+          - ordered_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+      const scalar_t diff_y = serial_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS)
+          - ordered_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+      if(std::abs(diff_x)>errorTol||std::abs(diff_y)>errorTol){
+        *outStream << "Error, subset " << i << " spatially ordered result does not match serial, diff x " << diff_x <<
+            " diff y " << diff_y << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  // with the frames distributed, a process that starts part of the way through the sequence
+  // has to get the same result as one that correlated the earlier frames first
+  *outStream << "testing the frame parallel mode" << std::endl;
+  Teuchos::RCP<Teuchos::ParameterList> fp_params = rcp(new Teuchos::ParameterList());
+  fp_params->set(DICe::initialization_method,DICe::USE_FFT_CROSS_CORRELATION);
+  fp_params->set(DICe::interpolation_method,DICe::KEYS_FOURTH);
+  fp_params->set(DICe::frame_parallel,true);
+  Teuchos::RCP<DICe::Schema> all_frames_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,fp_params));
+  all_frames_schema->set_frame_range(0,2);
+  all_frames_schema->set_ref_image("./images/refSpeckled.tif");
+  all_frames_schema->set_def_image("./images/defSpeckled.tif");
+  all_frames_schema->execute_correlation();
+  all_frames_schema->set_def_image("./images/refSpeckled.tif");
+  all_frames_schema->execute_correlation();
+  Teuchos::RCP<DICe::Schema> second_frame_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,fp_params));
+  second_frame_schema->set_frame_range(0,2);
+  second_frame_schema->set_frame_id(1);
+  second_frame_schema->set_ref_image("./images/refSpeckled.tif");
+  second_frame_schema->set_def_image("./images/refSpeckled.tif");
+  second_frame_schema->execute_correlation();
+  if(all_frames_schema->frame_id()!=second_frame_schema->frame_id()){
+    *outStream << "Error, the frame ids do not match after the last frame" << std::endl;
+    errorFlag++;
+  }
+  for(int_t i=0;i<all_frames_schema->local_num_subsets();++i){
+    const scalar_t diff_x = all_frames_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS)
+        - second_frame_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+    const scalar_t diff_y = all_frames_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS)
+        - second_frame_schema->local_field_value(i,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+    if(std::abs(diff_x)>errorTol||std::abs(diff_y)>errorTol){
+      *outStream << "Error, subset " << i << " result depends on the previous frame, diff x " << diff_x <<
+          " diff y " << diff_y << std::endl;
+      errorFlag++;
+    }
+  }
+  // field value initialization chains the frames together
+  fp_params->set(DICe::initialization_method,DICe::USE_FIELD_VALUES);
+  bool fp_exception = false;
+  try{
+    Teuchos::RCP<DICe::Schema> chained_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,fp_params));
+  }
+  catch(std::exception &){
+    fp_exception = true;
+  }
+  if(!fp_exception){
+    *outStream << "Error, frame_parallel should not be allowed with field value initialization" << std::endl;
+    errorFlag++;
+  }
+
+  // the reliability guided routine propagates from a single seed, compare it to the generic routine with the same seed
+  *outStream << "testing the reliability guided routine" << std::endl;
+  const int_t num_points_x = (roi_w - 2*subset_size)/step_size + 1;
+  const int_t num_points_y = (roi_h - 2*subset_size)/step_size + 1;
+  const int_t num_points = num_points_x*num_points_y;
+  Teuchos::ArrayRCP<scalar_t> coords_x(num_points,0.0);
+  Teuchos::ArrayRCP<scalar_t> coords_y(num_points,0.0);
+  Teuchos::RCP<std::vector<int_t> > neighbor_ids = Teuchos::rcp(new std::vector<int_t>(num_points,-1));
+  for(int_t i=0;i<num_points;++i){
+    const int_t y_it = i / num_points_x;
+    const int_t x_it = i - y_it*num_points_x;
+    coords_x[i] = subset_size + x_it*step_size - 1;
+    coords_y[i] = subset_size + y_it*step_size - 1;
+    // the first subset is the seed, the rest are initialized along the rows
+    if(i>0)
+      (*neighbor_ids)[i] = x_it > 0 ? i - 1 : i - num_points_x;
+  }
+  Teuchos::RCP<Teuchos::ParameterList> rg_params = rcp(new Teuchos::ParameterList());
+  rg_params->set(DICe::initialization_method,DICe::USE_NEIGHBOR_VALUES);
+  rg_params->set(DICe::interpolation_method,DICe::KEYS_FOURTH);
+  Teuchos::RCP<DICe::Schema> generic_schema = Teuchos::rcp(new DICe::Schema(coords_x,coords_y,subset_size,Teuchos::null,neighbor_ids,rg_params));
+  generic_schema->set_ref_image("./images/refSpeckled.tif");
+  generic_schema->set_def_image("./images/defSpeckled.tif");
+  generic_schema->execute_correlation();
+  for(int_t num_threads=1;num_threads<=4;num_threads+=3){
+    rg_params->set(DICe::correlation_routine,DICe::RELIABILITY_GUIDED_ROUTINE);
+    rg_params->set(DICe::num_threads,num_threads);
+    Teuchos::RCP<DICe::Schema> rg_schema = Teuchos::rcp(new DICe::Schema(coords_x,coords_y,subset_size,Teuchos::null,neighbor_ids,rg_params));
+    rg_schema->set_ref_image("./images/refSpeckled.tif");
+    rg_schema->set_def_image("./images/defSpeckled.tif");
+    rg_schema->execute_correlation();
+    for(int_t i=0;i<generic_schema->local_num_subsets();++i){
+      const int_t gid = generic_schema->subset_global_id(i);
+      const scalar_t diff_x = generic_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS)
+          - rg_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+      const scalar_t diff_y = generic_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS)
+          - rg_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+      if(rg_schema->global_field_value(gid,DICe::field_enums::SIGMA_FS)<0.0||std::abs(diff_x)>1.0E-2||std::abs(diff_y)>1.0E-2){
+        *outStream << "Error, subset " << gid << " reliability guided result (" << num_threads << " threads) does not match the generic routine, diff x " << diff_x <<
+            " diff y " << diff_y << " sigma " << rg_schema->global_field_value(gid,DICe::field_enums::SIGMA_FS) << std::endl;
+        errorFlag++;
+      }
+      // the neighbor ids from the input are left alone
+      if(rg_schema->global_field_value(gid,DICe::field_enums::NEIGHBOR_ID_FS)!=(*neighbor_ids)[gid]){
+        *outStream << "Error, subset " << gid << " neighbor id was overwritten" << std::endl;
+        errorFlag++;
+      }
+      // every subset except the seed should have been initialized from an adjacent subset
+      const int_t neigh_gid = rg_schema->reliability_guided_parent(gid);
+      if(gid==0) continue;
+      const scalar_t dx = neigh_gid>=0 ? coords_x[gid] - coords_x[neigh_gid] : 0.0;
+      const scalar_t dy = neigh_gid>=0 ? coords_y[gid] - coords_y[neigh_gid] : 0.0;
+      if(neigh_gid<0||neigh_gid==gid||dx*dx+dy*dy>2.0*step_size*step_size+1.0){
+        *outStream << "Error, subset " << gid << " was not initialized from an adjacent subset (neighbor id " << neigh_gid << ")" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  // two seeds (opposite corners) and an extra subset past the right edge of the image that always fails,
+  // the failure must not stop the propagation or change the other subsets
+  *outStream << "testing the reliability guided routine with more than one seed and a failing subset" << std::endl;
+  const int_t failing_gid = num_points;
+  Teuchos::ArrayRCP<scalar_t> ms_coords_x(num_points+1,0.0);
+  Teuchos::ArrayRCP<scalar_t> ms_coords_y(num_points+1,0.0);
+  Teuchos::RCP<std::vector<int_t> > ms_neighbor_ids = Teuchos::rcp(new std::vector<int_t>(*neighbor_ids));
+  for(int_t i=0;i<num_points;++i){
+    ms_coords_x[i] = coords_x[i];
+    ms_coords_y[i] = coords_y[i];
+  }
+  ms_coords_x[failing_gid] = roi_w - 3;
+  ms_coords_y[failing_gid] = coords_y[num_points-1];
+  (*ms_neighbor_ids)[num_points-1] = -1;
+  ms_neighbor_ids->push_back(num_points-1);
+  for(int_t num_threads=1;num_threads<=4;num_threads+=3){
+    rg_params->set(DICe::num_threads,num_threads);
+    Teuchos::RCP<DICe::Schema> ms_schema = Teuchos::rcp(new DICe::Schema(ms_coords_x,ms_coords_y,subset_size,Teuchos::null,ms_neighbor_ids,rg_params));
+    ms_schema->set_ref_image("./images/refSpeckled.tif");
+    ms_schema->set_def_image("./images/defSpeckled.tif");
+    ms_schema->execute_correlation();
+    if(ms_schema->global_field_value(failing_gid,DICe::field_enums::SIGMA_FS)>=0.0){
+      *outStream << "Error, the subset outside of the image should have failed" << std::endl;
+      errorFlag++;
+    }
+    if(ms_schema->reliability_guided_parent(0)!=-1||ms_schema->reliability_guided_parent(num_points-1)!=-1){
+      *outStream << "Error, the seeds should start from their own values" << std::endl;
+      errorFlag++;
+    }
+    for(int_t gid=0;gid<num_points;++gid){
+      const scalar_t diff_x = generic_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS)
+          - ms_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+      const scalar_t diff_y = generic_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS)
+          - ms_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+      if(ms_schema->global_field_value(gid,DICe::field_enums::SIGMA_FS)<0.0||std::abs(diff_x)>1.0E-2||std::abs(diff_y)>1.0E-2){
+        *outStream << "Error, subset " << gid << " multi-seed result (" << num_threads << " threads) does not match the generic routine, diff x " << diff_x <<
+            " diff y " << diff_y << " sigma " << ms_schema->global_field_value(gid,DICe::field_enums::SIGMA_FS) << std::endl;
+        errorFlag++;
+      }
+      if(ms_schema->reliability_guided_parent(gid)==failing_gid){
+        *outStream << "Error, subset " << gid << " was initialized from the failed subset" << std::endl;
+        errorFlag++;
+      }
+    }
+  }
+
+  // without seed points the routine has to pick its own seed and propagate from it instead of
+  // correlating every subset from its own values
+  *outStream << "testing the reliability guided routine without seeds" << std::endl;
+  Teuchos::RCP<Teuchos::ParameterList> ns_params = rcp(new Teuchos::ParameterList());
+  ns_params->set(DICe::initialization_method,DICe::USE_FIELD_VALUES);
+  ns_params->set(DICe::interpolation_method,DICe::KEYS_FOURTH);
+  ns_params->set(DICe::correlation_routine,DICe::RELIABILITY_GUIDED_ROUTINE);
+  for(int_t num_threads=1;num_threads<=4;num_threads+=3){
+    ns_params->set(DICe::num_threads,num_threads);
+    Teuchos::RCP<DICe::Schema> ns_schema = Teuchos::rcp(new DICe::Schema(coords_x,coords_y,subset_size,Teuchos::null,Teuchos::null,ns_params));
+    ns_schema->set_ref_image("./images/refSpeckled.tif");
+    ns_schema->set_def_image("./images/defSpeckled.tif");
+    ns_schema->execute_correlation();
+    int_t num_seeds = 0;
+    for(int_t gid=0;gid<num_points;++gid){
+      const scalar_t diff_x = generic_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS)
+          - ns_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_X_FS);
+      const scalar_t diff_y = generic_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS)
+          - ns_schema->global_field_value(gid,DICe::field_enums::SUBSET_DISPLACEMENT_Y_FS);
+      if(ns_schema->global_field_value(gid,DICe::field_enums::SIGMA_FS)<0.0||std::abs(diff_x)>1.0E-2||std::abs(diff_y)>1.0E-2){
+        *outStream << "Error, subset " << gid << " result without seeds (" << num_threads << " threads) does not match the generic routine, diff x " << diff_x <<
+            " diff y " << diff_y << " sigma " << ns_schema->global_field_value(gid,DICe::field_enums::SIGMA_FS) << std::endl;
+        errorFlag++;
+      }
+      const int_t neigh_gid = ns_schema->reliability_guided_parent(gid);
+      if(neigh_gid<0){
+        num_seeds++;
+        continue;
+      }
+      const scalar_t dx = coords_x[gid] - coords_x[neigh_gid];
+      const scalar_t dy = coords_y[gid] - coords_y[neigh_gid];
+      if(neigh_gid==gid||dx*dx+dy*dy>2.0*step_size*step_size+1.0){
+        *outStream << "Error, subset " << gid << " without seeds was not initialized from an adjacent subset (neighbor id " << neigh_gid << ")" << std::endl;
+        errorFlag++;
+      }
+    }
+    if(num_seeds!=1){
+      *outStream << "Error, without seeds there should be exactly one subset that starts from its own values, not " << num_seeds << std::endl;
+      errorFlag++;
+    }
+  }
+
+  // hybrid mode: num_threads 0 splits the cores of the node between its processes
+  *outStream << "testing the automatic number of threads per process" << std::endl;
+  Teuchos::RCP<Teuchos::ParameterList> auto_params = rcp(new Teuchos::ParameterList());
+  auto_params->set(DICe::initialization_method,DICe::USE_FIELD_VALUES);
+  auto_params->set(DICe::interpolation_method,DICe::KEYS_FOURTH);
+  auto_params->set(DICe::num_threads,0);
+  Teuchos::RCP<DICe::Schema> auto_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,auto_params));
+  *outStream << "automatic number of threads: " << auto_schema->num_threads() << std::endl;
+  if(auto_schema->num_threads()<1){
+    *outStream << "Error, the automatic number of threads should be at least one" << std::endl;
+    errorFlag++;
+  }
+  // the pool size goes to the image kernels of each schema, the thread count of the process is left alone
+#ifdef _OPENMP
+  const int_t process_max_threads = omp_get_max_threads();
+#endif
+  for(int_t num_threads=4;num_threads>=1;num_threads-=3){
+    Teuchos::RCP<Teuchos::ParameterList> pool_params = rcp(new Teuchos::ParameterList(*auto_params));
+    pool_params->set(DICe::num_threads,num_threads);
+    Teuchos::RCP<DICe::Schema> pool_schema = Teuchos::rcp(new DICe::Schema(roi_w,roi_h,step_size,step_size,subset_size,pool_params));
+    pool_schema->set_ref_image("./images/refSpeckled.tif");
+    pool_schema->set_def_image("./images/defSpeckled.tif");
+    if(pool_schema->ref_img()->num_threads()!=pool_schema->num_threads()||pool_schema->def_img()->num_threads()!=pool_schema->num_threads()){
+      *outStream << "Error, the images should use the thread pool of the schema (" << pool_schema->num_threads() << " threads), not " <<
+          pool_schema->ref_img()->num_threads() << " and " << pool_schema->def_img()->num_threads() << std::endl;
+      errorFlag++;
+    }
+#ifdef _OPENMP
+    if(omp_get_max_threads()!=process_max_threads){
+      *outStream << "Error, creating a schema changed the thread count of the process to " << omp_get_max_threads() << std::endl;
+      errorFlag++;
+    }
+#endif
+  }
+
+  // the events are registered from the threads that correlate the subsets
+  *outStream << "testing the stat container from more than one thread" << std::endl;
+  Stat_Container stats;
+  const int_t num_stat_subsets = 16;
+  const int_t num_stat_frames = 200;
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(4)
+#endif
+  for(int_t i=0;i<num_stat_subsets*num_stat_frames;++i){
+    stats.register_search_call(i%num_stat_subsets,i/num_stat_subsets);
+    stats.register_failed_init(i%num_stat_subsets,i/num_stat_subsets);
+  }
+  for(int_t i=0;i<num_stat_subsets;++i){
+    if(stats.num_searches(i)!=num_stat_frames||stats.num_failed_inits(i)!=num_stat_frames){
+      *outStream << "Error, subset " << i << " has " << stats.num_searches(i) << " search calls and " << stats.num_failed_inits(i) <<
+          " failed inits, should be " << num_stat_frames << std::endl;
+      errorFlag++;
+    }
+  }
+
+  *outStream << "--- End test ---" << std::endl;
+
+  DICe::finalize();
+
+  if (errorFlag != 0)
+    std::cout << "End Result: TEST FAILED\n";
+  else
+    std::cout << "End Result: TEST PASSED\n";
+
+  return 0;
+
+}
+
@@ -0,0 +1,190 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+/*! \file  DICe_PerformanceHybrid.cpp
+    \brief Times the correlation for different numbers of threads per process to compare
+    processes x threads configurations (run with mpirun to vary the number of processes)
+*/
+
+#include <DICe.h>
+#include <DICe_Schema.h>
+#include <DICe_NodeImageReader.h>
+#include <DICe_ImageIO.h>
+
+#include <Teuchos_RCP.hpp>
+#include <Teuchos_oblackholestream.hpp>
+#include <Teuchos_ParameterList.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#if DICE_MPI
+#  include <mpi.h>
+#endif
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  if(argc<5||argc>6){
+    std::cerr << "Usage: DICe_PerformanceHybrid <ref_image> <def_image> <max_threads> <1 or 0> [share_images_on_node (1 or 0)], (1=verbose)" << std::endl;
+    return 1;
+  }
+
+  DICe::initialize(argc, argv);
+
+  Teuchos::RCP<std::ostream> outStream;
+  Teuchos::oblackholestream bhs; // outputs nothing
+  if (std::strtol(argv[4],NULL,0) == 1)
+    outStream = Teuchos::rcp(&std::cout, false);
+  else
+    outStream = Teuchos::rcp(&bhs, false);
+
+  int num_procs = 1, rank = 0;
+#if DICE_MPI
+  MPI_Comm_size(MPI_COMM_WORLD,&num_procs);
+  MPI_Comm_rank(MPI_COMM_WORLD,&rank);
+#endif
+  // only the first process prints the table
+  if(rank!=0)
+    outStream = Teuchos::rcp(&bhs, false);
+  const int_t procs_per_node = num_processes_on_node();
+
+  *outStream << "--- Begin performance test ---" << std::endl;
+
+  const std::string ref_file = argv[1];
+  const std::string def_file = argv[2];
+  const int_t max_threads = std::strtol(argv[3],NULL,0);
+  const bool share_images = argc==6 && std::strtol(argv[5],NULL,0) == 1;
+  TEUCHOS_TEST_FOR_EXCEPTION(max_threads<1,std::invalid_argument,"Error, max_threads must be greater than zero");
+
+  int_t img_w = 0, img_h = 0;
+  utils::read_image_dimensions(ref_file.c_str(),img_w,img_h);
+  const int_t step_size = 10;
+  const int_t subset_size = 31;
+  const int_t num_reps = 3;
+  const int_t num_nodes = std::max(1,num_procs/procs_per_node);
+
+  *outStream << "images:              " << ref_file << " " << def_file << " (" << img_w << " x " << img_h << ")" << std::endl;
+  *outStream << "processes:           " << num_procs << " (" << procs_per_node << " per node)" << std::endl;
+  *outStream << "share images on node " << share_images << std::endl;
+  *outStream << "image MB/node is summed over the distinct images the processes hold after the correlation" << std::endl;
+  *outStream << "(the windows actually read, with the intensities, two gradients and the mask of each pixel," << std::endl;
+  *outStream << "a shared image is counted once per node)" << std::endl;
+  *outStream << std::endl;
+  *outStream << std::setw(10) << "processes" << std::setw(10) << "threads" << std::setw(14) << "cores/node" << std::setw(12) << "subsets" <<
+    std::setw(14) << "time (s)" << std::setw(14) << "subsets/s" << std::setw(16) << "image MB/node" << std::endl;
+
+  for(int_t num_threads=1;num_threads<=max_threads;num_threads*=2){
+    Teuchos::RCP<Teuchos::ParameterList> params = rcp(new Teuchos::ParameterList());
+    params->set(DICe::initialization_method,USE_FIELD_VALUES);
+    params->set(DICe::interpolation_method,DICe::KEYS_FOURTH);
+    params->set(DICe::num_threads,num_threads);
+    params->set(DICe::share_images_on_node,share_images);
+    Teuchos::RCP<DICe::Schema> schema;
+    bool threads_available = true;
+    double elapsed = 0.0;
+    for(int_t rep=0;rep<num_reps;++rep){
+      // a new schema for every repetition so each one starts from the same (zero) initial guess
+      // instead of the converged solution of the previous repetition
+      schema = Teuchos::rcp(new DICe::Schema(img_w,img_h,step_size,step_size,subset_size,params));
+      // the number of threads is reduced if OpenMP or a thread safe Trilinos is not available
+      if(schema->num_threads()!=num_threads){
+        threads_available = false;
+        break;
+      }
+#if DICE_MPI
+      MPI_Barrier(MPI_COMM_WORLD);
+#endif
+      const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      schema->set_ref_image(ref_file);
+      schema->set_def_image(def_file);
+      schema->execute_correlation();
+      const std::chrono::duration<double> rep_time = std::chrono::steady_clock::now() - start;
+      elapsed += rep_time.count();
+    }
+    if(!threads_available){
+      *outStream << "only " << schema->num_threads() << " thread(s) per process are available, stopping" << std::endl;
+      break;
+    }
+    elapsed /= num_reps;
+    // the slowest process sets the pace
+    double max_elapsed = elapsed;
+#if DICE_MPI
+    MPI_Allreduce(&elapsed,&max_elapsed,1,MPI_DOUBLE,MPI_MAX,MPI_COMM_WORLD);
+#endif
+    // memory of the images this process holds, the previous image may be the reference image and a shared
+    // image is the same window on every process of the node so each process counts its share of it
+    std::vector<Teuchos::RCP<Image> > images;
+    images.push_back(schema->ref_img());
+    images.push_back(schema->def_img());
+    images.push_back(schema->prev_img());
+    double image_bytes = 0.0;
+    for(size_t i=0;i<images.size();++i){
+      if(images[i]==Teuchos::null) continue;
+      bool counted = false;
+      for(size_t j=0;j<i;++j)
+        counted = counted || images[j].get()==images[i].get();
+      if(counted) continue;
+      const double bytes = (double)images[i]->width()*images[i]->height()*(sizeof(intensity_t)+3*sizeof(scalar_t));
+      image_bytes += images[i]->is_adopted() ? bytes/procs_per_node : bytes;
+    }
+    double total_image_bytes = image_bytes;
+#if DICE_MPI
+    MPI_Allreduce(&image_bytes,&total_image_bytes,1,MPI_DOUBLE,MPI_SUM,MPI_COMM_WORLD);
+#endif
+    const double image_mb_per_node = total_image_bytes/num_nodes/(1024.0*1024.0);
+    const int_t num_subsets = schema->global_num_subsets();
+    *outStream << std::setw(10) << num_procs << std::setw(10) << num_threads << std::setw(14) << procs_per_node*num_threads <<
+      std::setw(12) << num_subsets << std::setw(14) << std::setprecision(4) << max_elapsed <<
+      std::setw(14) << std::setprecision(6) << num_subsets/max_elapsed <<
+      std::setw(16) << std::setprecision(4) << image_mb_per_node << std::endl;
+  }
+
+  *outStream << "--- End performance test ---" << std::endl;
+
+  DICe::finalize();
+
+  return 0;
+}
@@ -0,0 +1,179 @@
+// @HEADER
+// ************************************************************************
+//
+//               Digital Image Correlation Engine (DICe)
+//                 Copyright 2015 National Technology & Engineering Solutions of Sandia, LLC (NTESS).
+//
+// Under the terms of Contract DE-NA0003525 with NTESS,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY NTESS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL NTESS OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact: Dan Turner (dzturne@sandia.gov)
+//
+// ************************************************************************
+// @HEADER
+
+/*! \file  DICe_BinaryToText.cpp
+    \brief Utility for slicing fields, subsets or frames out of a binary output file and writing them as text
+*/
+
+#include <DICe.h>
+#include <DICe_BinaryOutput.h>
+
+#include <Teuchos_RCP.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace DICe;
+
+int main(int argc, char *argv[]) {
+
+  /// usage ./DICe_BinaryToText <binary_file_name> [-info] [-fields name,name,...] [-frames first last] [-subsets first last] [-o output_file]
+
+  DICe::initialize(argc, argv);
+
+  if(argc<2||std::string(argv[1])=="-h"){
+    std::cout << " DICe_BinaryToText (writes the contents of a binary output file as text) " << std::endl;
+    std::cout << " Syntax: DICe_BinaryToText <binary_file_name> [-info] [-fields name,name,...] "
+        "[-frames first_frame_id last_frame_id] [-subsets first_subset_id last_subset_id] [-o output_file]" << std::endl;
+    exit(0);
+  }
+
+  DEBUG_MSG("User specified " << argc << " arguments");
+  for(int_t i=0;i<argc;++i){
+    DEBUG_MSG(argv[i]);
+  }
+  const std::string file_name = argv[1];
+  bool info_only = false;
+  std::string fields_arg = "";
+  std::string output_file = "";
+  int_t first_frame_id = std::numeric_limits<int_t>::min();
+  int_t last_frame_id = std::numeric_limits<int_t>::max();
+  int_t first_subset_id = std::numeric_limits<int_t>::min();
+  int_t last_subset_id = std::numeric_limits<int_t>::max();
+  for(int_t i=2;i<argc;++i){
+    const std::string arg = argv[i];
+    if(arg=="-info"){
+      info_only = true;
+    }
+    else if(arg=="-fields"&&i+1<argc){
+      fields_arg = argv[++i];
+    }
+    else if(arg=="-frames"&&i+2<argc){
+      first_frame_id = std::stoi(argv[++i]);
+      last_frame_id = std::stoi(argv[++i]);
+    }
+    else if(arg=="-subsets"&&i+2<argc){
+      first_subset_id = std::stoi(argv[++i]);
+      last_subset_id = std::stoi(argv[++i]);
+    }
+    else if(arg=="-o"&&i+1<argc){
+      output_file = argv[++i];
+    }
+    else{
+      TEUCHOS_TEST_FOR_EXCEPTION(true,std::runtime_error,"Error, invalid argument " << arg << " (use -h for the syntax)");
+    }
+  }
+
+  DICe::Binary_Output_Reader reader(file_name);
+
+  if(info_only){
+    std::cout << "File:       " << file_name << std::endl;
+    std::cout << "Num fields: " << reader.num_fields() << std::endl;
+    for(int_t i=0;i<reader.num_fields();++i)
+      std::cout << "  " << reader.field_names()[i] << std::endl;
+    std::cout << "Num subsets: " << reader.num_subsets() << std::endl;
+    std::cout << "Num frames:  " << reader.num_frames() << std::endl;
+    if(reader.num_frames()>0)
+      std::cout << "Frame ids:   " << reader.frame_ids()[0] << " to " << reader.frame_ids()[reader.num_frames()-1] << std::endl;
+    DICe::finalize();
+    return 0;
+  }
+
+  // determine which fields to write
+  std::vector<int_t> fields;
+  if(fields_arg.empty()){
+    for(int_t i=0;i<reader.num_fields();++i)
+      fields.push_back(i);
+  }
+  else{
+    std::stringstream ss(fields_arg);
+    std::string name;
+    while(std::getline(ss,name,',')){
+      const int_t index = reader.field_index(name);
+      TEUCHOS_TEST_FOR_EXCEPTION(index<0,std::runtime_error,"Error, field " << name << " is not in file " << file_name);
+      fields.push_back(index);
+    }
+  }
+
+  // the frames are stored in order so the requested range is contiguous
+  int_t first_frame = reader.num_frames();
+  int_t num_frames = 0;
+  for(int_t i=0;i<reader.num_frames();++i){
+    if(reader.frame_ids()[i]<first_frame_id||reader.frame_ids()[i]>last_frame_id) continue;
+    if(i<first_frame) first_frame = i;
+    num_frames = i - first_frame + 1;
+  }
+  std::vector<int_t> subsets;
+  for(int_t i=0;i<reader.num_subsets();++i)
+    if(reader.subset_ids()[i]>=first_subset_id&&reader.subset_ids()[i]<=last_subset_id)
+      subsets.push_back(i);
+
+  std::vector<std::vector<scalar_t> > values(fields.size());
+  for(size_t i=0;i<fields.size();++i)
+    reader.read_field(fields[i],first_frame,num_frames,values[i]);
+
+  std::FILE * file = stdout;
+  if(!output_file.empty()){
+    file = fopen(output_file.c_str(),"w");
+    TEUCHOS_TEST_FOR_EXCEPTION(file==NULL,std::runtime_error,"Error, could not open output file " << output_file);
+  }
+  fprintf(file,"FRAME SUBSET_ID");
+  for(size_t i=0;i<fields.size();++i)
+    fprintf(file," %s",reader.field_names()[fields[i]].c_str());
+  fprintf(file,"\n");
+  const int_t num_subsets = reader.num_subsets();
+  for(int_t frame=0;frame<num_frames;++frame){
+    for(size_t j=0;j<subsets.size();++j){
+      fprintf(file,"%i %i",reader.frame_ids()[first_frame+frame],reader.subset_ids()[subsets[j]]);
+      for(size_t i=0;i<fields.size();++i)
+        fprintf(file," %4.4E",values[i][frame*num_subsets+subsets[j]]);
+      fprintf(file,"\n");
+    }
+  }
+  if(file!=stdout)
+    fclose(file);
+
+  DICe::finalize();
+
+  return 0;
+}